@@ -26,6 +26,7 @@
 namespace process {
 
 // Forward declarations.
+class EventQueue;
 class ProcessBase;
 struct MessageEvent;
 struct DispatchEvent;
@@ -81,6 +82,12 @@ struct Event
     }
     return *result;
   }
+
+private:
+  friend class EventQueue;
+
+  // Links the event into the `EventQueue` of the receiving process.
+  Event* next = nullptr;
 };
 
 
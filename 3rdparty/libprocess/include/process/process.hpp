@@ -15,6 +15,7 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <map>
 #include <queue>
 #include <vector>
@@ -40,6 +41,7 @@
 namespace process {
 
 // Forward declaration.
+class EventQueue;
 class Logging;
 class Sequence;
 
@@ -379,17 +381,15 @@ protected:
   /**
    * Returns the number of events of the given type currently on the event
    * queue.
+   *
+   * **NOTE**: This must be called from within the process itself (e.g.,
+   * via `defer(self(), ...)`), since only the process can safely look at
+   * its queued events.
    */
   template <typename T>
   size_t eventCount()
   {
-    size_t count = 0U;
-
-    synchronized (mutex) {
-      count = std::count_if(events.begin(), events.end(), isEventType<T>);
-    }
-
-    return count;
+    return countEvents(isEventType<T>);
   }
 
 private:
@@ -399,7 +399,7 @@ private:
   friend void* schedule(void*);
 
   // Process states.
-  enum
+  enum class ProcessState
   {
     BOTTOM,
     READY,
@@ -407,7 +407,9 @@ private:
     BLOCKED,
     TERMINATING,
     TERMINATED
-  } state;
+  };
+
+  std::atomic<ProcessState> state;
 
   template <typename T>
   static bool isEventType(const Event* event)
@@ -415,9 +417,8 @@ private:
     return event->is<T>();
   }
 
-  // Mutex protecting internals.
-  // TODO(benh): Consider replacing with a spinlock, on multi-core systems.
-  std::recursive_mutex mutex;
+  // Returns the number of queued events matching the predicate.
+  size_t countEvents(bool (*predicate)(const Event*));
 
   // Enqueue the specified message, request, or function call.
   void enqueue(Event* event, bool inject = false);
@@ -475,12 +476,18 @@ private:
   // Static assets(s) to provide.
   std::map<std::string, Asset> assets;
 
-  // Queue of received events, requires lock()ed access!
-  std::deque<Event*> events;
+  // Queue of received events, see `EventQueue` for which functions
+  // may be called from threads other than the one running this process.
+  Owned<EventQueue> events;
 
   // Active references.
   std::atomic_long refs;
 
+  // Index of the worker thread that last ran this process, or -1 if
+  // it has not been run by a worker yet. Used to put the process
+  // back on the run queue of that worker, see `ProcessManager`.
+  std::atomic_long worker;
+
   // Process PID.
   UPID pid;
 };
@@ -153,6 +153,31 @@ public:
   virtual Future<size_t> send(const char* data, size_t size) = 0;
   virtual Future<size_t> sendfile(int_fd fd, off_t offset, size_t size) = 0;
 
+  /**
+   * A contiguous region of data to send.
+   */
+  struct Buffer
+  {
+    const char* data;
+    size_t size;
+  };
+
+  /**
+   * An overload of `send`, which sends the data of the specified
+   * buffers in order, as if they were a single buffer. Like `send`
+   * above, this might send fewer bytes than the buffers hold.
+   *
+   * The default implementation sends (part of) the first non-empty
+   * buffer, implementations override this to gather the buffers in
+   * a single system call.
+   *
+   * NOTE: The buffers must stay valid until the returned future
+   * completes.
+   *
+   * @return The number of bytes sent.
+   */
+  virtual Future<size_t> send(const Buffer* buffers, size_t count);
+
   /**
    * An overload of `recv`, which receives data based on the specified
    * 'size' parameter.
@@ -377,6 +402,11 @@ public:
     return impl->sendfile(fd, offset, size);
   }
 
+  Future<size_t> send(const SocketImpl::Buffer* buffers, size_t count) const
+  {
+    return impl->send(buffers, count);
+  }
+
   Future<std::string> recv(const Option<ssize_t>& size = None())
   {
     return impl->recv(size);
@@ -18,22 +18,40 @@
 
 #include <limits>
 #include <map>
+#include <memory>
 #include <sstream>
+#include <string>
+
+#include <boost/functional/hash.hpp>
 
 #include <process/http.hpp>
+#include <process/pid.hpp>
 #include <process/process.hpp>
+#include <process/socket.hpp>
 
+#include <stout/cache.hpp>
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
+#include <stout/stringify.hpp>
+#include <stout/thread_local.hpp>
 
 
 namespace process {
 
 const uint32_t GZIP_MINIMUM_BODY_LENGTH = 1024;
 
+// The number of request headers that each thread caches for encoding
+// messages, see `MessageEncoder`.
+const size_t MESSAGE_HEADER_CACHE_CAPACITY = 1024;
+
+// The end of the headers of a message without a body, and the end of
+// the body's chunk followed by the last (empty) chunk otherwise.
+const char MESSAGE_HEADER_END[] = "\r\n";
+const char MESSAGE_TRAILER[] = "\r\n0\r\n\r\n";
+
 // Forward declarations.
 class Encoder;
 
@@ -44,7 +62,8 @@ public:
   enum Kind
   {
     DATA,
-    FILE
+    FILE,
+    MESSAGE
   };
 
   Encoder() = default;
@@ -98,57 +117,220 @@ private:
 };
 
 
-class MessageEncoder : public DataEncoder
+// Encodes a message as an HTTP request without copying its body: the
+// request is sent from a few buffers, which `next` returns, pointing
+// at the (cached) request line and headers, the chunked framing, and
+// the body of the message itself.
+class MessageEncoder : public Encoder
 {
 public:
+  typedef network::internal::SocketImpl::Buffer Buffer;
+
   MessageEncoder(Message* _message)
-    : DataEncoder(encode(_message)), message(_message) {}
+    : message(CHECK_NOTNULL(_message)),
+      header(encodeHeader(*message)),
+      count(0),
+      size(0),
+      index(0)
+  {
+    add(header->data(), header->size());
+
+    if (message->body.size() > 0) {
+      // The body is sent as a single chunk.
+      char length[sizeof(size_t) * 2 + 1];
+      int written =
+        ::snprintf(length, sizeof(length), "%zx", message->body.size());
+
+      CHECK(written > 0 && static_cast<size_t>(written) < sizeof(length));
+
+      framing.reserve(64);
+      framing += "Transfer-Encoding: chunked\r\n\r\n";
+      framing.append(length, written);
+      framing += "\r\n";
+
+      add(framing.data(), framing.size());
+      add(message->body.data(), message->body.size());
+      add(MESSAGE_TRAILER, sizeof(MESSAGE_TRAILER) - 1);
+    } else {
+      add(MESSAGE_HEADER_END, sizeof(MESSAGE_HEADER_END) - 1);
+    }
+  }
 
   virtual ~MessageEncoder()
   {
-    if (message != nullptr) {
-      delete message;
+    delete message;
+  }
+
+  virtual Kind kind() const
+  {
+    return Encoder::MESSAGE;
+  }
+
+  // Returns the buffers with the data that remains to be sent, and
+  // sets `length` to their total size.
+  virtual const Buffer* next(size_t* _count, size_t* length)
+  {
+    // Skip the buffers which have been sent completely.
+    size_t offset = index;
+    size_t i = 0;
+    while (offset >= buffers[i].size) {
+      offset -= buffers[i].size;
+      i++;
+      CHECK_LT(i, count);
     }
+
+    *_count = 0;
+    for (; i < count; i++) {
+      remainder[(*_count)++] =
+        {buffers[i].data + offset, buffers[i].size - offset};
+      offset = 0;
+    }
+
+    *length = size - index;
+    index = size;
+
+    return remainder;
   }
 
+  virtual void backup(size_t length)
+  {
+    if (index >= length) {
+      index -= length;
+    }
+  }
+
+  virtual size_t remaining() const
+  {
+    return size - index;
+  }
+
+  // Returns the encoded message as a single string, which copies the
+  // body. Used for sending messages via `Socket::send(std::string)`.
   static std::string encode(Message* message)
   {
-    std::ostringstream out;
+    if (message == nullptr) {
+      return "";
+    }
 
-    if (message != nullptr) {
-      out << "POST ";
-      // Nothing keeps the 'id' component of a PID from being an empty
-      // string which would create a malformed path that has two
-      // '//' unless we check for it explicitly.
-      // TODO(benh): Make the 'id' part of a PID optional so when it's
-      // missing it's clear that we're simply addressing an ip:port.
-      if (message->to.id != "") {
-        out << "/" << message->to.id;
-      }
+    // The encoder takes ownership of the message.
+    MessageEncoder encoder(new Message(*message));
 
-      out << "/" << message->name << " HTTP/1.1\r\n"
-          << "User-Agent: libprocess/" << message->from << "\r\n"
-          << "Libprocess-From: " << message->from << "\r\n"
-          << "Connection: Keep-Alive\r\n"
-          << "Host: \r\n";
-
-      if (message->body.size() > 0) {
-        out << "Transfer-Encoding: chunked\r\n\r\n"
-            << std::hex << message->body.size() << "\r\n";
-        out.write(message->body.data(), message->body.size());
-        out << "\r\n"
-            << "0\r\n"
-            << "\r\n";
-      } else {
-        out << "\r\n";
-      }
+    std::string result;
+    result.reserve(encoder.size);
+
+    for (size_t i = 0; i < encoder.count; i++) {
+      result.append(encoder.buffers[i].data, encoder.buffers[i].size);
     }
 
-    return out.str();
+    return result;
   }
 
 private:
+  // We cache the request line and headers for the most recently used
+  // combinations of sender, receiver and message name, since a
+  // process usually sends the same few kinds of messages to the same
+  // few processes. The cache is per thread, so it needs no locking.
+  struct Key
+  {
+    bool operator==(const Key& that) const
+    {
+      return from == that.from && to == that.to && name == that.name;
+    }
+
+    UPID from;
+    std::string to; // Only the ID of the receiver is part of the header.
+    std::string name;
+  };
+
+  struct KeyHash
+  {
+    size_t operator()(const Key& key) const
+    {
+      size_t seed = 0;
+      boost::hash_combine(seed, std::hash<UPID>()(key.from));
+      boost::hash_combine(seed, key.to);
+      boost::hash_combine(seed, key.name);
+      return seed;
+    }
+  };
+
+  typedef Cache<Key, std::shared_ptr<const std::string>, KeyHash> HeaderCache;
+
+  static std::shared_ptr<const std::string> encodeHeader(
+      const Message& message)
+  {
+    static THREAD_LOCAL HeaderCache* cache = nullptr;
+
+    if (cache == nullptr) {
+      cache = new HeaderCache(MESSAGE_HEADER_CACHE_CAPACITY);
+    }
+
+    Key key{message.from, message.to.id, message.name};
+
+    Option<std::shared_ptr<const std::string>> cached = cache->get(key);
+    if (cached.isSome()) {
+      return cached.get();
+    }
+
+    const std::string from = stringify(message.from);
+
+    std::string header;
+    header.reserve(
+        128 + message.to.id.size() + message.name.size() + 2 * from.size());
+
+    header += "POST ";
+
+    // Nothing keeps the 'id' component of a PID from being an empty
+    // string which would create a malformed path that has two
+    // '//' unless we check for it explicitly.
+    // TODO(benh): Make the 'id' part of a PID optional so when it's
+    // missing it's clear that we're simply addressing an ip:port.
+    if (message.to.id != "") {
+      header += "/";
+      header += message.to.id;
+    }
+
+    header += "/";
+    header += message.name;
+    header += " HTTP/1.1\r\n";
+    header += "User-Agent: libprocess/" + from + "\r\n";
+    header += "Libprocess-From: " + from + "\r\n";
+    header += "Connection: Keep-Alive\r\n";
+    header += "Host: \r\n";
+
+    std::shared_ptr<const std::string> result =
+      std::make_shared<const std::string>(std::move(header));
+
+    cache->put(key, result);
+
+    return result;
+  }
+
+  void add(const char* data, size_t length)
+  {
+    CHECK_LT(count, sizeof(buffers) / sizeof(buffers[0]));
+
+    buffers[count++] = {data, length};
+    size += length;
+  }
+
   Message* message;
+
+  // The request line and headers, shared with the cache.
+  const std::shared_ptr<const std::string> header;
+
+  // The size of the body's chunk, or the end of the headers.
+  std::string framing;
+
+  Buffer buffers[4];
+  size_t count;
+
+  // The buffers returned by `next`, the first one of which might
+  // have been sent partially.
+  Buffer remainder[4];
+
+  size_t size;
+  size_t index;
 };
 
 
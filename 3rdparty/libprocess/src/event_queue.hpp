@@ -0,0 +1,193 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __EVENT_QUEUE_HPP__
+#define __EVENT_QUEUE_HPP__
+
+#include <atomic>
+
+#include <process/event.hpp>
+
+namespace process {
+
+// The queue of events of a process: a lock-free, intrusive,
+// multi-producer single-consumer queue.
+//
+// Producers (any thread) push events onto one of two lock-free
+// stacks, `incoming` for regular events and `injected` for events
+// that must be delivered before any other pending event. The consumer
+// (the thread currently running the process) moves the stacks into a
+// private FIFO list with a single atomic exchange, so producers never
+// block and never contend with the consumer beyond that exchange.
+//
+// Events are linked through `Event::next`, so queueing an event does
+// not allocate.
+//
+// NOTE: `enqueue()`, `inject()` and `pending()` can be called from any
+// thread, all other functions must only be called by the consumer.
+class EventQueue
+{
+public:
+  EventQueue()
+    : incoming(nullptr),
+      injected(nullptr),
+      head(nullptr),
+      tail(nullptr) {}
+
+  ~EventQueue()
+  {
+    // Delete the events that were enqueued after the process was
+    // cleaned up, see `ProcessManager::cleanup()`.
+    while (Event* event = dequeue()) {
+      delete event;
+    }
+  }
+
+  // Appends the event to the queue.
+  void enqueue(Event* event)
+  {
+    push(&incoming, event);
+  }
+
+  // Puts the event at the front of the queue.
+  void inject(Event* event)
+  {
+    push(&injected, event);
+  }
+
+  // Returns true if events were enqueued or injected since the
+  // consumer last looked at the queue.
+  bool pending() const
+  {
+    return incoming.load() != nullptr || injected.load() != nullptr;
+  }
+
+  bool empty() const
+  {
+    return head == nullptr && !pending();
+  }
+
+  // Removes and returns the event at the front of the queue, or
+  // nullptr if the queue is empty.
+  Event* dequeue()
+  {
+    take();
+
+    Event* event = head;
+    if (event != nullptr) {
+      head = event->next;
+      if (head == nullptr) {
+        tail = nullptr;
+      }
+      event->next = nullptr;
+    }
+
+    return event;
+  }
+
+  // Visits each queued event, front to back.
+  void visit(EventVisitor* visitor)
+  {
+    take();
+
+    for (Event* event = head; event != nullptr; event = event->next) {
+      event->visit(visitor);
+    }
+  }
+
+  // Returns the number of queued events matching the predicate.
+  size_t count(bool (*predicate)(const Event*))
+  {
+    take();
+
+    size_t count = 0u;
+    for (Event* event = head; event != nullptr; event = event->next) {
+      if (predicate(event)) {
+        count++;
+      }
+    }
+
+    return count;
+  }
+
+private:
+  EventQueue(const EventQueue&) = delete;
+  EventQueue& operator=(const EventQueue&) = delete;
+
+  // NOTE: The push is sequentially consistent so that it can not be
+  // reordered with the subsequent check of the process state, see
+  // `ProcessBase::enqueue()`.
+  static void push(std::atomic<Event*>* stack, Event* event)
+  {
+    event->next = stack->load(std::memory_order_relaxed);
+
+    while (!stack->compare_exchange_weak(
+               event->next,
+               event,
+               std::memory_order_seq_cst,
+               std::memory_order_relaxed)) {}
+  }
+
+  // Moves the injected and incoming events into the private list.
+  void take()
+  {
+    // Injected events go in front of all other events, the most
+    // recently injected one first, which is the order of the stack.
+    if (injected.load(std::memory_order_relaxed) != nullptr) {
+      Event* first = injected.exchange(nullptr, std::memory_order_acquire);
+
+      Event* last = first;
+      while (last->next != nullptr) {
+        last = last->next;
+      }
+
+      last->next = head;
+      if (head == nullptr) {
+        tail = last;
+      }
+      head = first;
+    }
+
+    // Incoming events are on the stack in reverse order.
+    if (incoming.load(std::memory_order_relaxed) != nullptr) {
+      Event* event = incoming.exchange(nullptr, std::memory_order_acquire);
+      Event* last = event;
+      Event* first = nullptr;
+
+      while (event != nullptr) {
+        Event* next = event->next;
+        event->next = first;
+        first = event;
+        event = next;
+      }
+
+      if (tail == nullptr) {
+        head = first;
+      } else {
+        tail->next = first;
+      }
+      tail = last;
+    }
+  }
+
+  // Stacks that producers push events onto.
+  std::atomic<Event*> incoming;
+  std::atomic<Event*> injected;
+
+  // Private FIFO list of the consumer.
+  Event* head;
+  Event* tail;
+};
+
+} // namespace process {
+
+#endif // __EVENT_QUEUE_HPP__
@@ -1474,6 +1474,12 @@ Future<Nothing> send(network::Socket socket, Encoder* encoder)
             int_fd fd = static_cast<FileEncoder*>(encoder)->next(&offset, size);
             return socket.sendfile(fd, offset, *size);
           }
+          case Encoder::MESSAGE: {
+            size_t count = 0;
+            const MessageEncoder::Buffer* buffers =
+              static_cast<MessageEncoder*>(encoder)->next(&count, size);
+            return socket.send(buffers, count);
+          }
         }
         UNREACHABLE();
       },
@@ -44,6 +44,11 @@ public:
   Future<size_t> recv(char* data, size_t size) override;
   // Send does not currently support discard. See implementation.
   Future<size_t> send(const char* data, size_t size) override;
+
+  // The other overloads of 'send' (e.g., sending buffers) are not
+  // overridden, they build on the one above.
+  using SocketImpl::send;
+
   Future<size_t> sendfile(int_fd fd, off_t offset, size_t size) override;
   Try<Nothing> listen(int backlog) override;
   Future<std::shared_ptr<SocketImpl>> accept() override;
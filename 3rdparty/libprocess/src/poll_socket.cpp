@@ -14,9 +14,13 @@
 #ifdef __WINDOWS__
 #include <stout/windows.hpp>
 #else
+#include <limits.h>
 #include <netinet/tcp.h>
+#include <sys/uio.h>
 #endif // __WINDOWS__
 
+#include <algorithm>
+
 #include <process/io.hpp>
 #include <process/network.hpp>
 #include <process/socket.hpp>
@@ -221,6 +225,63 @@ Future<size_t> socket_send_data(
 }
 
 
+#ifndef __WINDOWS__
+Future<size_t> socket_send_buffers(
+    const std::shared_ptr<PollSocketImpl>& impl,
+    const SocketImpl::Buffer* buffers,
+    size_t count)
+{
+  CHECK(count > 0);
+
+  // We do not copy the data but only describe the buffers, so that
+  // we can send all of them with a single system call.
+  struct iovec iov[IOV_MAX];
+
+  size_t iovcnt = std::min(count, static_cast<size_t>(IOV_MAX));
+  for (size_t i = 0; i < iovcnt; i++) {
+    iov[i].iov_base = const_cast<char*>(buffers[i].data);
+    iov[i].iov_len = buffers[i].size;
+  }
+
+  struct msghdr message = {};
+  message.msg_iov = iov;
+  message.msg_iovlen = iovcnt;
+
+  while (true) {
+    // NOTE: We use `sendmsg` rather than `writev` for MSG_NOSIGNAL.
+    ssize_t length = ::sendmsg(impl->get(), &message, MSG_NOSIGNAL);
+
+    if (length < 0 && net::is_restartable_error(errno)) {
+      // Interrupted, try again now.
+      continue;
+    } else if (length < 0 && net::is_retryable_error(errno)) {
+      // Might block, try again later.
+      return io::poll(impl->get(), io::WRITE)
+        .then(lambda::bind(
+            &internal::socket_send_buffers,
+            impl,
+            buffers,
+            count));
+    } else if (length <= 0) {
+      // Socket error or closed.
+      if (length < 0) {
+        const string error = os::strerror(errno);
+        VLOG(1) << "Socket error while sending: " << error;
+        return Failure(ErrnoError("Socket send failed"));
+      } else {
+        VLOG(1) << "Socket closed while sending";
+        return length;
+      }
+    } else {
+      CHECK(length > 0);
+
+      return length;
+    }
+  }
+}
+#endif // __WINDOWS__
+
+
 Future<size_t> socket_send_file(
     const std::shared_ptr<PollSocketImpl>& impl,
     int_fd fd,
@@ -287,6 +348,21 @@ Future<size_t> PollSocketImpl::sendfile(int_fd fd, off_t offset, size_t size)
         size));
 }
 
+
+Future<size_t> PollSocketImpl::send(const Buffer* buffers, size_t count)
+{
+#ifdef __WINDOWS__
+  return SocketImpl::send(buffers, count);
+#else
+  return io::poll(get(), io::WRITE)
+    .then(lambda::bind(
+        &internal::socket_send_buffers,
+        shared(this),
+        buffers,
+        count));
+#endif // __WINDOWS__
+}
+
 } // namespace internal {
 } // namespace network {
 } // namespace process {
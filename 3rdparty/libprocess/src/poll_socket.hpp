@@ -36,6 +36,7 @@ public:
   virtual Future<size_t> recv(char* data, size_t size);
   virtual Future<size_t> send(const char* data, size_t size);
   virtual Future<size_t> sendfile(int_fd fd, off_t offset, size_t size);
+  virtual Future<size_t> send(const Buffer* buffers, size_t count);
   virtual Kind kind() const { return SocketImpl::Kind::POLL; }
 };
 
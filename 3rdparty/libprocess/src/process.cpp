@@ -63,6 +63,7 @@
 #include <process/address.hpp>
 #include <process/check.hpp>
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
@@ -114,8 +115,10 @@
 #include "decoder.hpp"
 #include "encoder.hpp"
 #include "event_loop.hpp"
+#include "event_queue.hpp"
 #include "gate.hpp"
 #include "process_reference.hpp"
+#include "run_queue.hpp"
 
 using process::wait; // Necessary on some OS's to disambiguate.
 
@@ -538,13 +541,29 @@ private:
   // Gates for waiting threads (protected by processes_mutex).
   map<ProcessBase*, Gate*> gates;
 
-  // Queue of runnable processes (implemented using list).
-  list<ProcessBase*> runq;
-  std::recursive_mutex runq_mutex;
+  // Returns the run queue of the worker thread that should run the
+  // process next, see `ProcessManager::enqueue()`.
+  RunQueue* runq(ProcessBase* process);
 
-  // Number of running processes, to support Clock::settle operation.
+  // Queues of runnable processes, one per worker thread. Workers
+  // take processes from their own queue first and steal from the
+  // other queues when theirs is empty.
+  vector<Owned<RunQueue>> runqs;
+
+  // Used to spread processes that have never run across the workers.
+  std::atomic_ulong next_runq;
+
+  // Number of processes that are either in the run queue or running,
+  // to support Clock::settle operation. A process is counted from
+  // when it gets enqueued until it is done being resumed, so there
+  // is no window in which a runnable process is not accounted for.
   std::atomic_long running;
 
+  // Total number of times a process has been enqueued. Since `running`
+  // can go up and back down between two reads, Clock::settle uses
+  // this to detect that work was enqueued while it was checking.
+  std::atomic_ulong enqueued;
+
   // Stores the thread handles so that we can join during shutdown.
   vector<std::thread*> threads;
 
@@ -569,6 +588,10 @@ static std::atomic_bool initialize_complete(false);
 // Server socket listen backlog.
 static const int LISTEN_BACKLOG = 500000;
 
+// How long the /__processes__ endpoint waits for each process to
+// describe itself, before reporting it as unresponsive instead.
+static const Duration PROCESSES_DESCRIBE_TIMEOUT = Seconds(5);
+
 // Local server socket.
 static Socket* __s__ = nullptr;
 
@@ -623,6 +646,10 @@ THREAD_LOCAL ProcessBase* __process__ = nullptr;
 // Per thread executor pointer.
 THREAD_LOCAL Executor* _executor_ = nullptr;
 
+// Per thread index of the worker, -1 for threads that are not
+// libprocess worker threads.
+static THREAD_LOCAL long __worker__ = -1;
+
 namespace metrics {
 namespace internal {
 
@@ -2053,6 +2080,20 @@ void send(Encoder* encoder, Socket socket)
             size));
       break;
     }
+    case Encoder::MESSAGE: {
+      size_t count;
+      size_t size;
+      const MessageEncoder::Buffer* buffers =
+        static_cast<MessageEncoder*>(encoder)->next(&count, &size);
+      socket.send(buffers, count)
+        .onAny(lambda::bind(
+            &internal::_send,
+            lambda::_1,
+            socket,
+            encoder,
+            size));
+      break;
+    }
   }
 }
 
@@ -2641,7 +2682,9 @@ void SocketManager::swap_implementing_socket(
 
 ProcessManager::ProcessManager(const Option<string>& _delegate)
   : delegate(_delegate),
+    next_runq(0),
     running(0),
+    enqueued(0),
     joining_threads(false),
     finalizing(false) {}
 
@@ -2762,10 +2805,19 @@ long ProcessManager::init_threads()
 
   threads.reserve(num_worker_threads + 1);
 
+  // NOTE: The run queues must exist before the worker threads are
+  // created, and can not change afterwards.
+  runqs.reserve(num_worker_threads);
+  for (long i = 0; i < num_worker_threads; i++) {
+    runqs.push_back(Owned<RunQueue>(new RunQueue()));
+  }
+
   struct
   {
-    void operator()() const
+    void operator()(long index) const
     {
+      __worker__ = index;
+
       do {
         ProcessBase* process = process_manager->dequeue();
         if (process == nullptr) {
@@ -2798,7 +2850,7 @@ long ProcessManager::init_threads()
   // Create processing threads.
   for (long i = 0; i < num_worker_threads; i++) {
     // Retain the thread handles so that we can join when shutting down.
-    threads.emplace_back(new std::thread(worker));
+    threads.emplace_back(new std::thread(worker, i));
   }
 
   // Create a thread for the event loop.
@@ -3111,30 +3163,47 @@ void ProcessManager::resume(ProcessBase* process)
   bool terminate = false;
   bool blocked = false;
 
-  CHECK(process->state == ProcessBase::BOTTOM ||
-        process->state == ProcessBase::READY);
+  ProcessBase::ProcessState state = process->state.load();
+
+  CHECK(state == ProcessBase::ProcessState::BOTTOM ||
+        state == ProcessBase::ProcessState::READY);
+
+  process->state.store(ProcessBase::ProcessState::RUNNING);
+
+  // Remember this worker so that the process gets run here again,
+  // where its state is likely still in the cache. Threads donated
+  // while waiting are not workers, see `ProcessManager::wait()`.
+  if (__worker__ >= 0) {
+    process->worker.store(__worker__, std::memory_order_relaxed);
+  }
 
-  if (process->state == ProcessBase::BOTTOM) {
-    process->state = ProcessBase::RUNNING;
+  if (state == ProcessBase::ProcessState::BOTTOM) {
     try { process->initialize(); }
     catch (...) { terminate = true; }
   }
 
   while (!terminate && !blocked) {
-    Event* event = nullptr;
-
-    synchronized (process->mutex) {
-      if (process->events.size() > 0) {
-        event = process->events.front();
-        process->events.pop_front();
-        process->state = ProcessBase::RUNNING;
-      } else {
-        process->state = ProcessBase::BLOCKED;
-        blocked = true;
+    Event* event = process->events->dequeue();
+
+    if (event == nullptr) {
+      // Block the process. An event that gets enqueued after we
+      // dequeued but before we blocked was enqueued while the process
+      // was still running, so the enqueuer did not add the process
+      // to the run queue. We check for such events after blocking and
+      // unblock the process again, unless an enqueuer has already
+      // done so, in which case the process is back in the run queue.
+      process->state.store(ProcessBase::ProcessState::BLOCKED);
+
+      if (process->events->pending()) {
+        ProcessBase::ProcessState expected = ProcessBase::ProcessState::BLOCKED;
+        if (process->state.compare_exchange_strong(
+                expected, ProcessBase::ProcessState::RUNNING)) {
+          continue;
+        }
       }
-    }
 
-    if (!blocked) {
+      blocked = true;
+    } else {
       CHECK(event != nullptr);
 
       // Determine if we should filter this event.
@@ -3223,18 +3292,14 @@ void ProcessManager::cleanup(ProcessBase* process)
   // the process we are cleaning up will get dropped (since it's
   // terminating) and eliminates the potential of enqueueing them on
   // another process that gets spawned with the same PID.
-  deque<Event*> events;
-
-  synchronized (process->mutex) {
-    process->state = ProcessBase::TERMINATING;
-    events = process->events;
-    process->events.clear();
-  }
+  //
+  // NOTE: An enqueuer that saw the process before it was terminating
+  // might still add an event after we have deleted the pending ones.
+  // Such events are deleted along with the process, see `EventQueue`.
+  process->state.store(ProcessBase::ProcessState::TERMINATING);
 
   // Delete pending events.
-  while (!events.empty()) {
-    Event* event = events.front();
-    events.pop_front();
+  while (Event* event = process->events->dequeue()) {
     delete event;
   }
 
@@ -3253,23 +3318,19 @@ void ProcessManager::cleanup(ProcessBase* process)
 #endif
     }
 
-    synchronized (process->mutex) {
-      CHECK(process->events.empty());
-
-      processes.erase(process->pid.id);
+    processes.erase(process->pid.id);
 
-      // Lookup gate to wake up waiting threads.
-      map<ProcessBase*, Gate*>::iterator it = gates.find(process);
-      if (it != gates.end()) {
-        gate = it->second;
-        // N.B. The last thread that leaves the gate also free's it.
-        gates.erase(it);
-      }
-
-      CHECK(process->refs.load() == 0);
-      process->state = ProcessBase::TERMINATED;
+    // Lookup gate to wake up waiting threads.
+    map<ProcessBase*, Gate*>::iterator it = gates.find(process);
+    if (it != gates.end()) {
+      gate = it->second;
+      // N.B. The last thread that leaves the gate also free's it.
+      gates.erase(it);
     }
 
+    CHECK(process->refs.load() == 0);
+    process->state.store(ProcessBase::ProcessState::TERMINATED);
+
     // Note that we don't remove the process from the clock during
     // cleanup, but rather the clock is reset for a process when it is
     // created (see ProcessBase::ProcessBase). We do this so that
@@ -3372,7 +3433,7 @@ bool ProcessManager::wait(const UPID& pid)
   synchronized (processes_mutex) {
     if (processes.count(pid.id) > 0) {
       process = processes[pid.id];
-      CHECK(process->state != ProcessBase::TERMINATED);
+      CHECK(process->state.load() != ProcessBase::ProcessState::TERMINATED);
 
       // Check and see if a gate already exists.
       if (gates.find(process) == gates.end()) {
@@ -3383,26 +3444,24 @@ bool ProcessManager::wait(const UPID& pid)
       old = gate->approach();
 
       // Check if it is runnable in order to donate this thread.
-      if (process->state == ProcessBase::BOTTOM ||
-          process->state == ProcessBase::READY) {
-        synchronized (runq_mutex) {
-          list<ProcessBase*>::iterator it =
-            find(runq.begin(), runq.end(), process);
-          if (it != runq.end()) {
-            // Found it! Remove it from the run queue since we'll be
-            // donating our thread and also increment 'running' before
-            // leaving this 'runq' protected critical section so that
-            // everyone that is waiting for the processes to settle
-            // continue to wait (otherwise they could see nothing in
-            // 'runq' and 'running' equal to 0 between when we exit
-            // this critical section and increment 'running').
-            runq.erase(it);
-            running.fetch_add(1);
-          } else {
-            // Another thread has resumed the process ...
-            process = nullptr;
+      ProcessBase::ProcessState state = process->state.load();
+      if (state == ProcessBase::ProcessState::BOTTOM ||
+          state == ProcessBase::ProcessState::READY) {
+        // Remove it from the run queue since we'll be donating our
+        // thread. Note that the process stays accounted for in
+        // 'running' (see `ProcessManager::enqueue`).
+        bool extracted = false;
+        foreach (const Owned<RunQueue>& runq, runqs) {
+          if (runq->extract(process)) {
+            extracted = true;
+            break;
           }
         }
+
+        if (!extracted) {
+          // Another thread has resumed the process ...
+          process = nullptr;
+        }
       } else {
         // Process is not runnable, so no need to donate ...
         process = nullptr;
@@ -3488,40 +3547,58 @@ void ProcessManager::enqueue(ProcessBase* process)
     return;
   }
 
-  // TODO(benh): Check and see if this process has its own thread. If
-  // it does, push it on that threads runq, and wake up that thread if
-  // it's not running. Otherwise, check and see which thread this
-  // process was last running on, and put it on that threads runq.
+  // Increment the running count of processes in order to support
+  // the Clock::settle() operation (this must be done before adding
+  // the process to the run queue, see `ProcessManager::settle`).
+  running.fetch_add(1);
+  enqueued.fetch_add(1);
 
-  synchronized (runq_mutex) {
-    CHECK(find(runq.begin(), runq.end(), process) == runq.end());
-    runq.push_back(process);
-  }
+  runq(process)->enqueue(process);
 
-  // Wake up the processing thread if necessary.
+  // Wake up the processing threads if necessary, idle workers will
+  // steal the process if its worker is busy.
+  //
+  // TODO(benh): Consider waking up only the worker of the process.
   gate->open();
 }
 
 
-ProcessBase* ProcessManager::dequeue()
+RunQueue* ProcessManager::runq(ProcessBase* process)
 {
-  // TODO(benh): Remove a process from this thread's runq. If there
-  // are no processes to run, and this is not a dedicated thread, then
-  // steal one from another threads runq.
-
-  ProcessBase* process = nullptr;
-
-  synchronized (runq_mutex) {
-    if (!runq.empty()) {
-      process = runq.front();
-      runq.pop_front();
-      // Increment the running count of processes in order to support
-      // the Clock::settle() operation (this must be done atomically
-      // with removing the process from the runq).
-      running.fetch_add(1);
+  // Put the process on the run queue of the worker that last ran it.
+  long index = process->worker.load(std::memory_order_relaxed);
+
+  if (index < 0) {
+    // The process has not run yet. If it was spawned (or is being
+    // woken up) by a worker, keep it on that worker, since the two
+    // processes are likely to communicate. Otherwise, spread such
+    // processes across the workers.
+    if (__worker__ >= 0) {
+      index = __worker__;
+    } else {
+      index = next_runq.fetch_add(1) % runqs.size();
     }
   }
 
+  return runqs[index].get();
+}
+
+
+ProcessBase* ProcessManager::dequeue()
+{
+  CHECK_GE(__worker__, 0) << "Only worker threads can dequeue processes";
+
+  const size_t size = runqs.size();
+  const size_t index = static_cast<size_t>(__worker__);
+
+  ProcessBase* process = runqs[index]->dequeue();
+
+  // Steal a process from the other workers, starting with the next
+  // one so that not all idle workers go after the same queue.
+  for (size_t i = 1; process == nullptr && i < size; i++) {
+    process = runqs[(index + i) % size]->dequeue();
+  }
+
   return process;
 }
 
@@ -3532,21 +3609,27 @@ void ProcessManager::settle()
   do {
     done = true; // Assume to start that we are settled.
 
-    synchronized (runq_mutex) {
-      if (!runq.empty()) {
-        done = false;
-        continue;
-      }
+    const unsigned long count = enqueued.load();
 
-      if (running.load() > 0) {
-        done = false;
-        continue;
-      }
+    // NOTE: Processes are accounted for in 'running' from before they
+    // are added to the run queue until after they are done running,
+    // so there are no runnable processes when it drops to 0.
+    if (running.load() > 0) {
+      done = false;
+      continue;
+    }
 
-      if (!Clock::settled()) {
-        done = false;
-        continue;
-      }
+    if (!Clock::settled()) {
+      done = false;
+      continue;
+    }
+
+    // An expired timer might have enqueued a process (which might
+    // even be done running already) after we checked 'running' but
+    // before the clock settled, in which case we need to check again.
+    if (enqueued.load() != count) {
+      done = false;
+      continue;
     }
   } while (!done);
 }
@@ -3554,94 +3637,132 @@ void ProcessManager::settle()
 
 Future<Response> ProcessManager::__processes__(const Request&)
 {
-  JSON::Array array;
+  // Only a process itself can look at its queued events (see
+  // `EventQueue`), so we ask each process to describe itself.
+  list<Future<JSON::Object>> futures;
 
   synchronized (processes_mutex) {
     foreachvalue (ProcessBase* process, process_manager->processes) {
-      JSON::Object object;
-      object.values["id"] = process->pid.id;
+      // The dispatch gets dropped if the process terminates before
+      // running it, in which case we fail the promise when the last
+      // reference to it goes away so that we don't wait forever.
+      std::shared_ptr<Promise<JSON::Object>> promise(
+          new Promise<JSON::Object>(),
+          [](Promise<JSON::Object>* promise) {
+            promise->fail("Process terminated");
+            delete promise;
+          });
+
+      // A process that is stuck (or just busy) running a handler
+      // would otherwise hold up the whole response, so we only report
+      // its ID once the timeout expires.
+      const string id = process->pid.id;
+
+      futures.push_back(promise->future()
+        .after(PROCESSES_DESCRIBE_TIMEOUT,
+               [id](const Future<JSON::Object>&) -> Future<JSON::Object> {
+                 JSON::Object object;
+                 object.values["id"] = id;
+                 object.values["unresponsive"] = true;
+                 return object;
+               }));
+
+      dispatch(process->self(), [=]() {
+        JSON::Object object;
+        object.values["id"] = process->pid.id;
+
+        JSON::Array events;
+
+        struct JSONVisitor : EventVisitor
+        {
+          explicit JSONVisitor(JSON::Array* _events) : events(_events) {}
 
-      JSON::Array events;
+          virtual void visit(const MessageEvent& event)
+          {
+            JSON::Object object;
+            object.values["type"] = "MESSAGE";
 
-      struct JSONVisitor : EventVisitor
-      {
-        explicit JSONVisitor(JSON::Array* _events) : events(_events) {}
+            const Message& message = *event.message;
 
-        virtual void visit(const MessageEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "MESSAGE";
+            object.values["name"] = message.name;
+            object.values["from"] = string(message.from);
+            object.values["to"] = string(message.to);
+            object.values["body"] = message.body;
 
-          const Message& message = *event.message;
+            events->values.push_back(object);
+          }
 
-          object.values["name"] = message.name;
-          object.values["from"] = string(message.from);
-          object.values["to"] = string(message.to);
-          object.values["body"] = message.body;
+          virtual void visit(const HttpEvent& event)
+          {
+            JSON::Object object;
+            object.values["type"] = "HTTP";
 
-          events->values.push_back(object);
-        }
+            const Request& request = *event.request;
 
-        virtual void visit(const HttpEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "HTTP";
+            object.values["method"] = request.method;
+            object.values["url"] = stringify(request.url);
 
-          const Request& request = *event.request;
+            events->values.push_back(object);
+          }
 
-          object.values["method"] = request.method;
-          object.values["url"] = stringify(request.url);
+          virtual void visit(const DispatchEvent& event)
+          {
+            JSON::Object object;
+            object.values["type"] = "DISPATCH";
+            events->values.push_back(object);
+          }
 
-          events->values.push_back(object);
-        }
+          virtual void visit(const ExitedEvent& event)
+          {
+            JSON::Object object;
+            object.values["type"] = "EXITED";
+            events->values.push_back(object);
+          }
 
-        virtual void visit(const DispatchEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "DISPATCH";
-          events->values.push_back(object);
-        }
+          virtual void visit(const TerminateEvent& event)
+          {
+            JSON::Object object;
+            object.values["type"] = "TERMINATE";
+            events->values.push_back(object);
+          }
 
-        virtual void visit(const ExitedEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "EXITED";
-          events->values.push_back(object);
-        }
+          JSON::Array* events;
+        } visitor(&events);
 
-        virtual void visit(const TerminateEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "TERMINATE";
-          events->values.push_back(object);
-        }
+        process->events->visit(&visitor);
 
-        JSON::Array* events;
-      } visitor(&events);
+        object.values["events"] = events;
+        promise->set(object);
+      });
+    }
+  }
 
-      synchronized (process->mutex) {
-        foreach (Event* event, process->events) {
-          event->visit(&visitor);
+  return await(futures)
+    .then([](const list<Future<JSON::Object>>& futures) -> Response {
+      JSON::Array array;
+
+      foreach (const Future<JSON::Object>& future, futures) {
+        if (future.isReady()) {
+          array.values.push_back(future.get());
         }
       }
 
-      object.values["events"] = events;
-      array.values.push_back(object);
-    }
-  }
-
-  return OK(array);
+      return OK(array);
+    });
 }
 
 
 ProcessBase::ProcessBase(const string& id)
+  : events(new EventQueue())
 {
   process::initialize();
 
-  state = ProcessBase::BOTTOM;
+  state = ProcessBase::ProcessState::BOTTOM;
 
   refs = 0;
 
+  worker = -1;
+
   pid.id = id != "" ? id : ID::generate();
   pid.address = __address__;
 
@@ -3661,26 +3782,35 @@ void ProcessBase::enqueue(Event* event, bool inject)
 {
   CHECK(event != nullptr);
 
-  synchronized (mutex) {
-    if (state != TERMINATING && state != TERMINATED) {
-      if (!inject) {
-        events.push_back(event);
-      } else {
-        events.push_front(event);
-      }
+  ProcessState old = state.load();
 
-      if (state == BLOCKED) {
-        state = READY;
-        process_manager->enqueue(this);
-      }
+  if (old == ProcessState::TERMINATING || old == ProcessState::TERMINATED) {
+    delete event;
+    return;
+  }
 
-      CHECK(state == BOTTOM ||
-            state == READY ||
-            state == RUNNING);
-    } else {
-      delete event;
-    }
+  if (!inject) {
+    events->enqueue(event);
+  } else {
+    events->inject(event);
   }
+
+  // If the process is blocked we need to add it to the run queue.
+  // This must happen after the event was queued, since the process
+  // checks for events after it blocks (see `ProcessManager::resume`).
+  // Only one of the concurrent enqueuers (or the process itself)
+  // manages to change the state, so the process gets added to the
+  // run queue at most once.
+  ProcessState expected = ProcessState::BLOCKED;
+  if (state.compare_exchange_strong(expected, ProcessState::READY)) {
+    process_manager->enqueue(this);
+  }
+}
+
+
+size_t ProcessBase::countEvents(bool (*predicate)(const Event*))
+{
+  return events->count(predicate);
 }
 
 
@@ -0,0 +1,213 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __RUN_QUEUE_HPP__
+#define __RUN_QUEUE_HPP__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include <process/process.hpp>
+
+#include <stout/synchronized.hpp>
+
+namespace process {
+
+// A multi-producer multi-consumer queue of runnable processes.
+//
+// Processes are kept in a ring of slots, each with a sequence number
+// that tells producers and consumers whether the slot is free or
+// holds a process for the current lap of the ring (see Dmitry Vyukov's
+// bounded MPMC queue). Enqueueing and dequeueing only take a
+// compare-and-swap on the tail or head position, respectively.
+//
+// If the ring is full, processes spill over into an overflow list
+// protected by a mutex, which consumers drain first.
+class RunQueue
+{
+public:
+  // NOTE: The capacity is rounded up to a power of 2.
+  explicit RunQueue(size_t capacity = 4096)
+    : head(0),
+      tail(0),
+      overflowSize(0)
+  {
+    size_t size = 2;
+    while (size < capacity) {
+      size *= 2;
+    }
+
+    mask = size - 1;
+    slots.reset(new Slot[size]);
+
+    for (size_t i = 0; i < size; i++) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+      slots[i].process.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  void enqueue(ProcessBase* process)
+  {
+    if (!push(process)) {
+      synchronized (overflowMutex) {
+        overflow.push_back(process);
+        overflowSize.fetch_add(1);
+      }
+    }
+  }
+
+  // Removes and returns the process at the front of the queue, or
+  // nullptr if the queue is empty.
+  ProcessBase* dequeue()
+  {
+    if (overflowSize.load() > 0) {
+      synchronized (overflowMutex) {
+        if (!overflow.empty()) {
+          ProcessBase* process = overflow.front();
+          overflow.pop_front();
+          overflowSize.fetch_sub(1);
+          return process;
+        }
+      }
+    }
+
+    ProcessBase* process = nullptr;
+
+    // Skip the slots whose process has been extracted.
+    while (pop(&process)) {
+      if (process != nullptr) {
+        return process;
+      }
+    }
+
+    return nullptr;
+  }
+
+  // Removes the process from the queue. Returns false if the process
+  // is not in the queue (or was dequeued concurrently).
+  //
+  // NOTE: This assumes that a process is in the queue at most once.
+  bool extract(ProcessBase* process)
+  {
+    const size_t end = tail.load();
+
+    for (size_t position = head.load(); position != end; position++) {
+      ProcessBase* expected = process;
+      if (slots[position & mask].process.compare_exchange_strong(
+              expected, nullptr)) {
+        return true;
+      }
+    }
+
+    synchronized (overflowMutex) {
+      auto it = std::find(overflow.begin(), overflow.end(), process);
+      if (it != overflow.end()) {
+        overflow.erase(it);
+        overflowSize.fetch_sub(1);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // NOTE: Processes that are being enqueued concurrently are
+  // considered to be in the queue already.
+  bool empty() const
+  {
+    return head.load() == tail.load() && overflowSize.load() == 0;
+  }
+
+private:
+  RunQueue(const RunQueue&) = delete;
+  RunQueue& operator=(const RunQueue&) = delete;
+
+  struct Slot
+  {
+    std::atomic<size_t> sequence;
+
+    // Set to nullptr when the process is dequeued or extracted, so
+    // that exactly one of a consumer and `extract()` gets it.
+    std::atomic<ProcessBase*> process;
+  };
+
+  // Returns false if the ring is full.
+  bool push(ProcessBase* process)
+  {
+    size_t position = tail.load(std::memory_order_relaxed);
+
+    while (true) {
+      Slot& slot = slots[position & mask];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      intptr_t difference =
+        static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+      if (difference == 0) {
+        if (tail.compare_exchange_weak(position, position + 1)) {
+          slot.process.store(process);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns false if the ring is empty. Otherwise `process` is set to
+  // the process at the front of the ring, or to nullptr if that
+  // process has been extracted.
+  bool pop(ProcessBase** process)
+  {
+    size_t position = head.load(std::memory_order_relaxed);
+
+    while (true) {
+      Slot& slot = slots[position & mask];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      intptr_t difference =
+        static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+      if (difference == 0) {
+        if (head.compare_exchange_weak(position, position + 1)) {
+          *process = slot.process.exchange(nullptr);
+          slot.sequence.store(position + mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::atomic<size_t> head;
+  std::atomic<size_t> tail;
+
+  size_t mask;
+  std::unique_ptr<Slot[]> slots;
+
+  std::mutex overflowMutex;
+  std::deque<ProcessBase*> overflow;
+  std::atomic<size_t> overflowSize;
+};
+
+} // namespace process {
+
+#endif // __RUN_QUEUE_HPP__
@@ -212,6 +212,18 @@ Future<string> SocketImpl::recv(const Option<ssize_t>& size)
 }
 
 
+Future<size_t> SocketImpl::send(const Buffer* buffers, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    if (buffers[i].size > 0) {
+      return send(buffers[i].data, buffers[i].size);
+    }
+  }
+
+  return Failure("Nothing to send");
+}
+
+
 static Future<Nothing> _send(
     const std::shared_ptr<SocketImpl>& impl,
     Owned<string> data,
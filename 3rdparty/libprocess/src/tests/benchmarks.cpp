@@ -21,29 +21,43 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <process/collect.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/socket.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashset.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
+
+#include "encoder.hpp"
 
 namespace http = process::http;
 
 using process::Future;
+using process::Message;
+using process::MessageEncoder;
 using process::Owned;
+using process::PID;
 using process::Process;
 using process::ProcessBase;
 using process::Promise;
 using process::UPID;
 
+using process::network::inet::Socket;
+
 using std::cout;
 using std::endl;
 using std::list;
@@ -51,8 +65,14 @@ using std::ostringstream;
 using std::string;
 using std::vector;
 
+// Path of this binary, used to rerun a benchmark with a different
+// number of libprocess worker threads.
+static string binary;
+
 int main(int argc, char** argv)
 {
+  binary = argv[0];
+
   // Initialize Google Mock/Test.
   testing::InitGoogleMock(&argc, argv);
 
@@ -369,3 +389,285 @@ TEST(ProcessTest, Process_BENCHMARK_LargeNumberOfLinks)
     delete process;
   }
 }
+
+
+class CounterProcess : public Process<CounterProcess>
+{
+public:
+  explicit CounterProcess(size_t _expected) : expected(_expected) {}
+
+  void increment()
+  {
+    if (++count == expected) {
+      promise.set(Nothing());
+    }
+  }
+
+  Future<Nothing> done() { return promise.future(); }
+
+private:
+  const size_t expected;
+  size_t count = 0;
+  Promise<Nothing> promise;
+};
+
+
+// Measures the throughput of the event queue of a single process when
+// many threads dispatch to it concurrently, which is what the master
+// sees when many agents and frameworks send messages at once.
+TEST(ProcessTest, Process_BENCHMARK_ManyProducerDispatch)
+{
+  const size_t dispatches = 1000000;
+
+  foreach (size_t producers, vector<size_t>({1, 2, 4, 8, 16})) {
+    CounterProcess counter(dispatches);
+    const PID<CounterProcess> pid = spawn(counter);
+
+    Future<Nothing> done = counter.done();
+
+    Stopwatch watch;
+    watch.start();
+
+    vector<std::thread> threads;
+    for (size_t i = 0; i < producers; i++) {
+      // Spread the remainder over the first producers.
+      size_t count = dispatches / producers +
+        (i < dispatches % producers ? 1 : 0);
+
+      threads.emplace_back([pid, count]() {
+        for (size_t j = 0; j < count; j++) {
+          dispatch(pid, &CounterProcess::increment);
+        }
+      });
+    }
+
+    foreach (std::thread& thread, threads) {
+      thread.join();
+    }
+
+    AWAIT_READY_FOR(done, Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << producers << " producers: "
+         << dispatches / elapsed.secs() << " dispatches / sec" << endl;
+
+    terminate(counter);
+    wait(counter);
+  }
+}
+
+
+class PingPongProcess : public Process<PingPongProcess>
+{
+public:
+  explicit PingPongProcess(const std::shared_ptr<Promise<Nothing>>& _done)
+    : done(_done) {}
+
+  void ping(const PID<PingPongProcess>& from, size_t remaining)
+  {
+    if (remaining == 0) {
+      done->set(Nothing());
+      return;
+    }
+
+    dispatch(from, &PingPongProcess::ping, self(), remaining - 1);
+  }
+
+private:
+  std::shared_ptr<Promise<Nothing>> done;
+};
+
+
+// Measures the dispatch throughput of many pairs of processes that
+// keep dispatching to each other, which keeps all worker threads
+// busy scheduling processes. This is run by the benchmark below with
+// different numbers of worker threads, which can only be set when
+// libprocess gets initialized.
+TEST(ProcessTest, DISABLED_Process_BENCHMARK_DispatchThroughput)
+{
+  const size_t pairs = 128;
+  const size_t dispatches = 20000;
+
+  vector<Owned<PingPongProcess>> processes;
+  list<Future<Nothing>> futures;
+
+  for (size_t i = 0; i < pairs; i++) {
+    std::shared_ptr<Promise<Nothing>> done(new Promise<Nothing>());
+    futures.push_back(done->future());
+
+    processes.push_back(Owned<PingPongProcess>(new PingPongProcess(done)));
+    processes.push_back(Owned<PingPongProcess>(new PingPongProcess(done)));
+
+    spawn(processes[processes.size() - 2].get());
+    spawn(processes[processes.size() - 1].get());
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < processes.size(); i += 2) {
+    dispatch(
+        processes[i]->self(),
+        &PingPongProcess::ping,
+        processes[i + 1]->self(),
+        dispatches);
+  }
+
+  AWAIT_READY_FOR(collect(futures), Minutes(5));
+
+  Duration elapsed = watch.elapsed();
+
+  cout << "Throughput: " << (pairs * dispatches) / elapsed.secs()
+       << " dispatches / sec" << endl;
+
+  foreach (const Owned<PingPongProcess>& process, processes) {
+    terminate(process.get());
+    wait(process.get());
+  }
+}
+
+
+// Runs the benchmark above with an increasing number of worker
+// threads, to see how well the scheduling of processes scales.
+TEST(ProcessTest, Process_BENCHMARK_DispatchThroughputWorkers)
+{
+  foreach (int workers, vector<int>({1, 2, 4, 8, 16, 32})) {
+    Try<string> output = os::shell(
+        "LIBPROCESS_NUM_WORKER_THREADS=%d %s"
+        " --gtest_also_run_disabled_tests"
+        " --gtest_filter=ProcessTest.DISABLED_Process_BENCHMARK_"
+        "DispatchThroughput",
+        workers,
+        binary.c_str());
+
+    ASSERT_SOME(output);
+
+    foreach (const string& line, strings::tokenize(output.get(), "\n")) {
+      if (strings::startsWith(line, "Throughput: ")) {
+        cout << workers << " workers: "
+             << strings::remove(line, "Throughput: ", strings::PREFIX)
+             << endl;
+      }
+    }
+  }
+}
+
+
+// A process which counts the messages it receives.
+class SinkProcess : public Process<SinkProcess>
+{
+public:
+  explicit SinkProcess(size_t _expected)
+    : received(0), expected(_expected) {}
+
+  virtual ~SinkProcess() {}
+
+  Future<Nothing> done()
+  {
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install("message", &SinkProcess::message);
+  }
+
+private:
+  void message(const UPID& from, const string& body)
+  {
+    if (++received == expected) {
+      promise.set(Nothing());
+    }
+  }
+
+  size_t received;
+  const size_t expected;
+  Promise<Nothing> promise;
+};
+
+
+// Sends all of the encoded message, like libprocess does.
+static Future<Nothing> send(
+    Socket socket,
+    const std::shared_ptr<MessageEncoder>& encoder)
+{
+  size_t count;
+  size_t size;
+  const MessageEncoder::Buffer* buffers = encoder->next(&count, &size);
+
+  return socket.send(buffers, count)
+    .then([=](size_t length) -> Future<Nothing> {
+      encoder->backup(size - length);
+
+      if (encoder->remaining() == 0) {
+        return Nothing();
+      }
+
+      return send(socket, encoder);
+    });
+}
+
+
+// Measures the throughput of encoding messages and sending them over
+// a socket, which is how libprocess sends messages to remote processes.
+TEST(ProcessTest, Process_BENCHMARK_MessageEncoderThroughput)
+{
+  foreach (const Bytes& bodySize,
+           vector<Bytes>({Bytes(0), Bytes(100), Kilobytes(4),
+                          Kilobytes(64), Megabytes(1)})) {
+    // Send at most 64MB worth of bodies.
+    const size_t messageCount = bodySize == Bytes(0)
+      ? 100000
+      : std::min<size_t>(100000, Megabytes(64).bytes() / bodySize.bytes());
+
+    SinkProcess sink(messageCount);
+    spawn(sink);
+
+    Try<Socket> socket = Socket::create();
+    ASSERT_SOME(socket);
+
+    AWAIT_READY(socket->connect(sink.self().address));
+
+    // Create the messages upfront, so that we only measure the
+    // encoding and sending.
+    const string body(bodySize.bytes(), '1');
+
+    vector<Message*> messages;
+    for (size_t i = 0; i < messageCount; i++) {
+      Message* message = new Message();
+      message->name = "message";
+      message->from = UPID("benchmark", sink.self().address);
+      message->to = sink.self();
+      message->body = body;
+
+      messages.push_back(message);
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    Future<Nothing> sent = Nothing();
+    foreach (Message* message, messages) {
+      std::shared_ptr<MessageEncoder> encoder(new MessageEncoder(message));
+
+      sent = sent.then([=]() { return send(socket.get(), encoder); });
+    }
+
+    AWAIT_READY_FOR(sent, Minutes(5));
+    AWAIT_READY_FOR(sink.done(), Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Sent " << messageCount << " messages with " << bodySize
+         << " bodies in " << elapsed << " ("
+         << messageCount / elapsed.secs() << " messages / sec, "
+         << static_cast<double>(messageCount * bodySize.bytes()) /
+              Megabytes(1).bytes() / elapsed.secs()
+         << " MB / sec)" << endl;
+
+    terminate(sink);
+    wait(sink);
+  }
+}
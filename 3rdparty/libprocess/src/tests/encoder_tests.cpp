@@ -10,26 +10,41 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#ifndef __WINDOWS__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif // __WINDOWS__
+
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 #include <vector>
 
 #include <process/http.hpp>
+#include <process/message.hpp>
 #include <process/owned.hpp>
+#include <process/pid.hpp>
 #include <process/socket.hpp>
 
 #include <stout/gtest.hpp>
 
+#include <stout/os/close.hpp>
+#include <stout/os/read.hpp>
+
 #include "encoder.hpp"
 #include "decoder.hpp"
 
 namespace http = process::http;
 
+using process::DataDecoder;
 using process::HttpResponseEncoder;
+using process::Message;
+using process::MessageEncoder;
 using process::Owned;
 using process::ResponseDecoder;
+using process::UPID;
 
 using std::deque;
 using std::string;
@@ -115,3 +130,86 @@ TEST(EncoderTest, AcceptableEncodings)
       << gzipRequest.headers.get("Accept-Encoding").get() << "'";
   }
 }
+
+
+#ifndef __WINDOWS__
+// This test verifies that a message arrives intact when the socket
+// accepts only part of it at a time, so that each write ends within
+// one of the buffers of the encoder and the rest is backed up.
+TEST(EncoderTest, MessageShortWrites)
+{
+  string body;
+  for (int i = 0; i < 1000; i++) {
+    body += static_cast<char>('a' + i % 26);
+  }
+
+  const vector<string> bodies = {"", body};
+  const vector<size_t> limits = {1, 2, 5, 17, 64, 4096};
+
+  foreach (const string& data, bodies) {
+    foreach (size_t limit, limits) {
+      Message* message = new Message();
+      message->name = "name";
+      message->from = UPID("sender@127.0.0.1:5050");
+      message->to = UPID("receiver@127.0.0.1:5051");
+      message->body = data;
+
+      const string expected = MessageEncoder::encode(message);
+
+      // The encoder takes ownership of the message.
+      MessageEncoder encoder(message);
+
+      int sockets[2];
+      ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+      while (encoder.remaining() > 0) {
+        size_t count;
+        size_t size;
+        const MessageEncoder::Buffer* buffers = encoder.next(&count, &size);
+
+        ASSERT_LE(count, 4u);
+
+        // Only hand the first 'limit' bytes to 'sendmsg', as if the
+        // socket had no room for more.
+        struct iovec iov[4];
+        size_t iovcnt = 0;
+        size_t total = 0;
+
+        for (size_t i = 0; i < count && total < limit; i++) {
+          iov[i].iov_base = const_cast<char*>(buffers[i].data);
+          iov[i].iov_len = std::min(buffers[i].size, limit - total);
+          total += iov[i].iov_len;
+          iovcnt++;
+        }
+
+        struct msghdr header = {};
+        header.msg_iov = iov;
+        header.msg_iovlen = iovcnt;
+
+        ssize_t length = ::sendmsg(sockets[0], &header, 0);
+        ASSERT_EQ(static_cast<ssize_t>(total), length);
+
+        encoder.backup(size - length);
+      }
+
+      ASSERT_SOME(os::close(sockets[0]));
+
+      Result<string> received = os::read(sockets[1], expected.size());
+      ASSERT_SOME_EQ(expected, received);
+
+      ASSERT_SOME(os::close(sockets[1]));
+
+      DataDecoder decoder;
+      deque<http::Request*> requests =
+        decoder.decode(received->data(), received->size());
+
+      ASSERT_FALSE(decoder.failed());
+      ASSERT_EQ(1u, requests.size());
+
+      Owned<http::Request> request(requests[0]);
+      EXPECT_EQ("/receiver/name", request->url.path);
+      EXPECT_EQ(data, request->body);
+    }
+  }
+}
+#endif // __WINDOWS__
@@ -31,6 +31,7 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
 #include <process/metrics/timer.hpp>
 
 namespace authentication = process::http::authentication;
@@ -47,6 +48,7 @@ using http::Unauthorized;
 
 using metrics::Counter;
 using metrics::Gauge;
+using metrics::PushGauge;
 using metrics::Timer;
 
 using process::Clock;
@@ -168,6 +170,38 @@ TEST_F_TEMP_DISABLED_ON_WINDOWS(MetricsTest, Gauge)
 }
 
 
+TEST_F(MetricsTest, PushGauge)
+{
+  PushGauge gauge("test/push_gauge");
+
+  AWAIT_READY(metrics::add(gauge));
+
+  AWAIT_EXPECT_EQ(0.0, gauge.value());
+
+  ++gauge;
+  AWAIT_EXPECT_EQ(1.0, gauge.value());
+
+  gauge += 41;
+  AWAIT_EXPECT_EQ(42.0, gauge.value());
+
+  --gauge;
+  AWAIT_EXPECT_EQ(41.0, gauge.value());
+
+  gauge -= 0.5;
+  AWAIT_EXPECT_EQ(40.5, gauge.value());
+
+  gauge = 42;
+  AWAIT_EXPECT_EQ(42.0, gauge.value());
+
+  // A copy shares the value with the original.
+  PushGauge copy = gauge;
+  ++copy;
+  AWAIT_EXPECT_EQ(43.0, gauge.value());
+
+  AWAIT_READY(metrics::remove(gauge));
+}
+
+
 TEST_F(MetricsTest, Statistics)
 {
   Counter counter("test/counter", process::TIME_SERIES_WINDOW);
@@ -40,6 +40,7 @@
 #include <process/gc.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/http.hpp>
 #include <process/network.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
@@ -50,11 +51,14 @@
 #include <process/time.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
@@ -1575,6 +1579,67 @@ TEST_TEMP_DISABLED_ON_WINDOWS(ProcessTest, Provide)
 }
 
 
+class BlockedProcess : public Process<BlockedProcess>
+{
+public:
+  BlockedProcess() : blocked(true) {}
+
+  // Stands in for a handler that takes a long time to run.
+  void block()
+  {
+    while (blocked.load()) {
+      os::sleep(Milliseconds(1));
+    }
+  }
+
+  std::atomic_bool blocked;
+};
+
+
+// This test verifies that the /__processes__ endpoint responds even
+// though a process is busy, reporting that process as unresponsive.
+TEST_TEMP_DISABLED_ON_WINDOWS(ProcessTest, ProcessesBlockedProcess)
+{
+  BlockedProcess process;
+  PID<BlockedProcess> pid = spawn(process);
+
+  dispatch(pid, &BlockedProcess::block);
+
+  Future<http::Response> response =
+    http::get(UPID("__processes__", process::address()));
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::Status::OK, response->code);
+
+  Try<JSON::Array> processes = JSON::parse<JSON::Array>(response->body);
+  ASSERT_SOME(processes);
+
+  Option<JSON::Object> blocked;
+  foreach (const JSON::Value& value, processes->values) {
+    ASSERT_TRUE(value.is<JSON::Object>());
+
+    const JSON::Object& object = value.as<JSON::Object>();
+
+    Result<JSON::String> id = object.find<JSON::String>("id");
+    ASSERT_SOME(id);
+
+    if (id->value == pid.id) {
+      blocked = object;
+    }
+  }
+
+  ASSERT_SOME(blocked);
+  EXPECT_SOME_EQ(JSON::Boolean(true),
+                 blocked->find<JSON::Boolean>("unresponsive"));
+  EXPECT_NONE(blocked->find<JSON::Array>("events"));
+
+  process.blocked.store(false);
+
+  terminate(process);
+  wait(process);
+}
+
+
 static int baz(string s) { return 42; }
 
 
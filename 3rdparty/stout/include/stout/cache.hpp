@@ -26,23 +26,25 @@
 #include "option.hpp"
 
 // Forward declaration.
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
 class Cache;
 
 // Outputs the key/value pairs from least to most-recently used.
-template <typename Key, typename Value>
-std::ostream& operator<<(std::ostream& stream, const Cache<Key, Value>& c);
+template <typename Key, typename Value, typename Hash>
+std::ostream& operator<<(
+    std::ostream& stream,
+    const Cache<Key, Value, Hash>& c);
 
 
 // Provides a least-recently used (LRU) cache of some predefined
 // capacity. A "write" and a "read" both count as uses.
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Hash>
 class Cache
 {
 public:
   typedef std::list<Key> list;
   typedef std::unordered_map<
-    Key, std::pair<Value, typename list::iterator>> map;
+    Key, std::pair<Value, typename list::iterator>, Hash> map;
 
   explicit Cache(size_t _capacity) : capacity(_capacity) {}
 
@@ -93,7 +95,7 @@ private:
   // Give the operator access to our internals.
   friend std::ostream& operator<<<>(
       std::ostream& stream,
-      const Cache<Key, Value>& c);
+      const Cache<Key, Value, Hash>& c);
 
   // Insert key/value into the cache.
   void insert(const Key& key, const Value& value)
@@ -139,13 +141,15 @@ private:
 };
 
 
-template <typename Key, typename Value>
-std::ostream& operator<<(std::ostream& stream, const Cache<Key, Value>& c)
+template <typename Key, typename Value, typename Hash>
+std::ostream& operator<<(
+    std::ostream& stream,
+    const Cache<Key, Value, Hash>& c)
 {
-  typename Cache<Key, Value>::list::const_iterator i1;
+  typename Cache<Key, Value, Hash>::list::const_iterator i1;
   for (i1 = c.keys.begin(); i1 != c.keys.end(); i1++) {
     stream << *i1 << ": ";
-    typename Cache<Key, Value>::map::const_iterator i2;
+    typename Cache<Key, Value, Hash>::map::const_iterator i2;
     i2 = c.values.find(*i1);
     CHECK(i2 != c.values.end());
     stream << *i2 << std::endl;
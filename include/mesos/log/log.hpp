@@ -56,6 +56,20 @@ public:
   class Reader;
   class Writer;
 
+  // Parameters for coalescing the writes received by the local
+  // replica into a single synchronous write to disk ("group commit").
+  // A write is acknowledged only once the batch containing it has
+  // been synced, so enabling this trades per-write latency (up to
+  // 'window') for throughput when many writes are in flight.
+  struct GroupCommit
+  {
+    // How long to wait for more writes before syncing the batch.
+    Duration window;
+
+    // The batch is synced immediately once it holds this many writes.
+    size_t maxActions;
+  };
+
   class Position
   {
   public:
@@ -159,8 +173,10 @@ public:
     // one writer (local or remote) can be valid at any point in
     // time. A writer becomes invalid if either Writer::append or
     // Writer::truncate return None, in which case, the writer (or
-    // another writer) must be restarted.
-    explicit Writer(Log* log);
+    // another writer) must be restarted. Up to 'window' appends and
+    // truncates are written to the replicas at once; further ones are
+    // queued. They always complete in the order they were issued.
+    explicit Writer(Log* log, size_t window = 1);
     ~Writer();
 
     // Attempts to get a promise (from the log's replicas) for
@@ -193,7 +209,8 @@ public:
       const std::string& path,
       const std::set<process::UPID>& pids,
       bool autoInitialize = false,
-      const Option<std::string>& metricsPrefix = None());
+      const Option<std::string>& metricsPrefix = None(),
+      const Option<GroupCommit>& groupCommit = None());
 
   // Creates a new replicated log that assumes the specified quorum
   // size, is backed by a file at the specified path, and coordinates
@@ -206,7 +223,8 @@ public:
       const std::string& znode,
       const Option<zookeeper::Authentication>& auth = None(),
       bool autoInitialize = false,
-      const Option<std::string>& metricsPrefix = None());
+      const Option<std::string>& metricsPrefix = None(),
+      const Option<GroupCommit>& groupCommit = None());
 
   ~Log();
 
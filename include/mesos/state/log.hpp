@@ -39,7 +39,12 @@ class LogStorageProcess;
 class LogStorage : public mesos::state::Storage
 {
 public:
-  LogStorage(mesos::log::Log* log, size_t diffsBetweenSnapshots = 0);
+  // Up to 'writeWindow' writes to the log are in flight at once, see
+  // 'mesos::log::Log::Writer'.
+  LogStorage(
+      mesos::log::Log* log,
+      size_t diffsBetweenSnapshots = 0,
+      size_t writeWindow = 1);
 
   virtual ~LogStorage();
 
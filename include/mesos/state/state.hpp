@@ -97,6 +97,12 @@ public:
   // previously did not exist (or an error if one occurs).
   process::Future<Variable> fetch(const std::string& name);
 
+  // Returns a new variable without fetching it from the state. Storing
+  // the variable fails (i.e., returns none) if a variable with the
+  // same name already exists, which makes this a cheaper alternative
+  // to `fetch` for variables that are known not to exist yet.
+  Variable create(const std::string& name);
+
   // Returns the variable specified if it was successfully stored in
   // the state, otherwise returns none if the version of the variable
   // was no longer valid, or an error if one occurs.
@@ -149,6 +155,16 @@ inline process::Future<Variable> State::_fetch(
 }
 
 
+inline Variable State::create(const std::string& name)
+{
+  internal::state::Entry entry;
+  entry.set_name(name);
+  entry.set_uuid(UUID::random().toBytes());
+
+  return Variable(entry);
+}
+
+
 inline process::Future<Option<Variable>> State::store(const Variable& variable)
 {
   // Note that we try and swap an entry even if the value didn't change!
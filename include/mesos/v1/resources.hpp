@@ -571,6 +571,15 @@ private:
   void add(const Resource_& r);
   void subtract(const Resource_& r);
 
+  // Fast paths of `add()` and `subtract()` for unreserved, non-shared
+  // scalars, which make up the bulk of the resources. These compare
+  // only the name and AllocationInfo and update the scalar in place.
+  // `addPlainScalar()` returns false if `r` cannot be combined with
+  // any existing Resource object, in which case nothing is added.
+  // NOTE: These must only be called for valid, non-empty plain scalars.
+  bool addPlainScalar(const Resource& r);
+  void subtractPlainScalar(const Resource& r);
+
   Resources operator+(const Resource_& that) const;
   Resources& operator+=(const Resource_& that);
 
@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include "checks/checker.hpp"
+#include "checks/prober.hpp"
 
 #include <cstdint>
 #include <iterator>
@@ -222,6 +223,9 @@ private:
 
   Option<lambda::function<pid_t(const lambda::function<int()>&)>> clone;
 
+  // Performs HTTP and TCP checks in-process if set.
+  Option<Owned<Prober>> prober;
+
   CheckStatusInfo previousCheckStatus;
   bool paused;
 
@@ -383,6 +387,21 @@ CheckerProcess::CheckerProcess(
     clone = lambda::bind(&cloneWithSetns, lambda::_1, taskPid, namespaces);
   }
 #endif
+
+  // HTTP and TCP checks only need the task's network namespace, so
+  // we probe in-process instead of forking a helper for every check.
+  if ((check.type() == CheckInfo::HTTP || check.type() == CheckInfo::TCP) &&
+      (namespaces.empty() || namespaces == vector<string>{"net"})) {
+    Try<Owned<Prober>> _prober =
+      Prober::create(namespaces.empty() ? Option<pid_t>::none() : taskPid);
+
+    if (_prober.isError()) {
+      LOG(WARNING) << "Failed to create prober for task '" << taskId << "',"
+                   << " falling back to helper binaries: " << _prober.error();
+    } else {
+      prober = _prober.get();
+    }
+  }
 }
 
 
@@ -955,6 +974,17 @@ Future<int> CheckerProcess::httpCheck()
 
   VLOG(1) << "Launching HTTP check '" << url << "' for task '" << taskId << "'";
 
+  if (prober.isSome()) {
+    const Duration timeout = checkTimeout;
+
+    return prober.get()->http(http.port(), path)
+      .after(timeout, [timeout](Future<int> future) -> Future<int> {
+        future.discard();
+
+        return Failure("HTTP probe timed out after " + stringify(timeout));
+      });
+  }
+
   const vector<string> argv = {
     HTTP_CHECK_COMMAND,
     "-s",                 // Don't show progress meter or error messages.
@@ -1096,14 +1126,32 @@ Future<bool> CheckerProcess::tcpCheck()
   CHECK_EQ(CheckInfo::TCP, check.type());
   CHECK(check.has_tcp());
 
-  // TCP_CHECK_COMMAND should be reachable.
-  CHECK(os::exists(launcherDir));
-
   const CheckInfo::Tcp& tcp = check.tcp();
 
   VLOG(1) << "Launching TCP check for task '" << taskId << "' at port "
           << tcp.port();
 
+  if (prober.isSome()) {
+    const Duration timeout = checkTimeout;
+
+    // Like a non-zero exit code of TCP_CHECK_COMMAND, a failed
+    // connection results in an unsuccessful check.
+    return prober.get()->tcp(tcp.port())
+      .then([]() { return true; })
+      .repair([](const Future<bool>& future) {
+        VLOG(1) << "TCP probe failed: " << future.failure();
+        return false;
+      })
+      .after(timeout, [timeout](Future<bool> future) -> Future<bool> {
+        future.discard();
+
+        return Failure("TCP probe timed out after " + stringify(timeout));
+      });
+  }
+
+  // TCP_CHECK_COMMAND should be reachable.
+  CHECK(os::exists(launcherDir));
+
   const string command = path::join(launcherDir, TCP_CHECK_COMMAND);
 
   const vector<string> argv = {
@@ -102,6 +102,20 @@ static const string DEFAULT_HTTP_SCHEME = "http";
 static const string DEFAULT_DOMAIN = "127.0.0.1";
 
 
+// Returns a failure unless the HTTP status code is in [200, 400).
+static Future<Nothing> httpStatusCodeHealthy(int code)
+{
+  if (code < process::http::Status::OK ||
+      code >= process::http::Status::BAD_REQUEST) {
+    return Failure(
+        "Unexpected HTTP response code: " +
+        process::http::Status::string(code));
+  }
+
+  return Nothing();
+}
+
+
 #ifdef __linux__
 // TODO(alexr): Instead of defining this ad-hoc clone function, provide a
 // general solution for entring namespace in child processes, see MESOS-6184.
@@ -268,6 +282,22 @@ HealthCheckerProcess::HealthCheckerProcess(
     clone = lambda::bind(&cloneWithSetns, lambda::_1, taskPid, namespaces);
   }
 #endif
+
+  // HTTP and TCP health checks only need the task's network namespace,
+  // so we probe in-process instead of forking a helper for every check.
+  if ((check.type() == HealthCheck::HTTP ||
+       check.type() == HealthCheck::TCP) &&
+      (namespaces.empty() || namespaces == vector<string>{"net"})) {
+    Try<Owned<Prober>> _prober =
+      Prober::create(namespaces.empty() ? Option<pid_t>::none() : taskPid);
+
+    if (_prober.isError()) {
+      LOG(WARNING) << "Failed to create prober for task '" << taskId << "',"
+                   << " falling back to helper binaries: " << _prober.error();
+    } else {
+      prober = _prober.get();
+    }
+  }
 }
 
 
@@ -835,6 +865,19 @@ Future<Nothing> HealthCheckerProcess::httpHealthCheck()
   VLOG(1) << "Launching HTTP health check '" << url << "'"
           << " for task '" << taskId << "'";
 
+  // We probe plain HTTP in-process, but rely on curl for HTTPS.
+  if (prober.isSome() && scheme == DEFAULT_HTTP_SCHEME) {
+    const Duration timeout = checkTimeout;
+
+    return prober.get()->http(http.port(), path)
+      .after(timeout, [timeout](Future<int> future) -> Future<int> {
+        future.discard();
+
+        return Failure("HTTP probe timed out after " + stringify(timeout));
+      })
+      .then(&httpStatusCodeHealthy);
+  }
+
   const vector<string> argv = {
     HTTP_CHECK_COMMAND,
     "-s",                 // Don't show progress meter or error messages.
@@ -945,14 +988,7 @@ Future<Nothing> HealthCheckerProcess::_httpHealthCheck(
         output.get());
   }
 
-  if (code.get() < process::http::Status::OK ||
-      code.get() >= process::http::Status::BAD_REQUEST) {
-    return Failure(
-        "Unexpected HTTP response code: " +
-        process::http::Status::string(code.get()));
-  }
-
-  return Nothing();
+  return httpStatusCodeHealthy(code.get());
 }
 
 
@@ -961,14 +997,25 @@ Future<Nothing> HealthCheckerProcess::tcpHealthCheck()
   CHECK_EQ(HealthCheck::TCP, check.type());
   CHECK(check.has_tcp());
 
-  // TCP_CHECK_COMMAND should be reachable.
-  CHECK(os::exists(launcherDir));
-
   const HealthCheck::TCPCheckInfo& tcp = check.tcp();
 
   VLOG(1) << "Launching TCP health check for task '" << taskId << "' at port"
           << tcp.port();
 
+  if (prober.isSome()) {
+    const Duration timeout = checkTimeout;
+
+    return prober.get()->tcp(tcp.port())
+      .after(timeout, [timeout](Future<Nothing> future) -> Future<Nothing> {
+        future.discard();
+
+        return Failure("TCP probe timed out after " + stringify(timeout));
+      });
+  }
+
+  // TCP_CHECK_COMMAND should be reachable.
+  CHECK(os::exists(launcherDir));
+
   const string tcpConnectPath = path::join(launcherDir, TCP_CHECK_COMMAND);
 
   const vector<string> tcpConnectArguments = {
@@ -36,6 +36,8 @@
 #include <stout/nothing.hpp>
 #include <stout/stopwatch.hpp>
 
+#include "checks/prober.hpp"
+
 #include "messages/messages.hpp"
 
 namespace mesos {
@@ -236,6 +238,9 @@ private:
 
   Option<lambda::function<pid_t(const lambda::function<int()>&)>> clone;
 
+  // Performs HTTP and TCP health checks in-process if set.
+  Option<process::Owned<Prober>> prober;
+
   uint32_t consecutiveFailures;
   process::Time startTime;
   bool initializing;
@@ -0,0 +1,289 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "checks/prober.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <process/address.hpp>
+#include <process/http.hpp>
+#include <process/socket.hpp>
+
+#include <stout/error.hpp>
+#include <stout/ip.hpp>
+#include <stout/numify.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include <stout/os/close.hpp>
+#include <stout/os/socket.hpp>
+
+#ifdef __linux__
+#include "linux/ns.hpp"
+#endif
+
+using process::Failure;
+using process::Future;
+using process::Owned;
+
+using process::network::inet::Address;
+using process::network::inet::Socket;
+
+using process::network::internal::SocketImpl;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace checks {
+
+// Upper bound for the size of the HTTP status line, to not keep
+// reading from a misbehaving server.
+static const size_t MAX_STATUS_LINE_SIZE = 4096;
+
+
+// A thread which enters the network namespace of a task once and then
+// creates sockets in that namespace on request.
+//
+// NOTE: `setns` re-associates only the calling thread with the network
+// namespace, which is why a dedicated thread is used rather than one of
+// the libprocess worker threads.
+class Prober::Namespace
+{
+public:
+  explicit Namespace(pid_t pid)
+    : requested(false),
+      stopped(false),
+      thread(&Namespace::run, this, pid) {}
+
+  ~Namespace()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopped = true;
+    }
+
+    condition.notify_all();
+    thread.join();
+  }
+
+  Try<int_fd> socket()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    requested = true;
+    condition.notify_all();
+
+    condition.wait(lock, [this]() { return result.isSome(); });
+
+    Try<int_fd> s = result.get();
+    result = None();
+
+    return s;
+  }
+
+private:
+  void run(pid_t pid)
+  {
+    Option<Error> error;
+
+#ifdef __linux__
+    Try<Nothing> setns = ns::setns(
+        path::join("/proc", stringify(pid), "ns", "net"),
+        "net",
+        false);
+
+    if (setns.isError()) {
+      error = Error(
+          "Failed to enter the network namespace of pid " + stringify(pid) +
+          ": " + setns.error());
+    }
+#else
+    error = Error("Entering network namespaces is only supported on Linux");
+#endif // __linux__
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+      condition.wait(lock, [this]() { return requested || stopped; });
+
+      if (stopped) {
+        return;
+      }
+
+      requested = false;
+
+      if (error.isSome()) {
+        result = Try<int_fd>(error.get());
+      } else {
+        result = net::socket(
+            AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      }
+
+      condition.notify_all();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool requested;
+  bool stopped;
+  Option<Try<int_fd>> result;
+
+  // NOTE: Declared last so that the thread starts after the
+  // other members have been initialized.
+  std::thread thread;
+};
+
+
+// Reads from the socket until the HTTP status line has been received
+// and returns the status code it contains.
+static Future<int> readStatusCode(Socket socket, const string& buffer)
+{
+  return socket.recv()
+    .then([socket, buffer](const string& data) -> Future<int> {
+      if (data.empty()) {
+        return Failure("Connection closed before receiving a response");
+      }
+
+      const string received = buffer + data;
+
+      size_t end = received.find("\r\n");
+      if (end == string::npos) {
+        if (received.size() > MAX_STATUS_LINE_SIZE) {
+          return Failure("Received an invalid HTTP response");
+        }
+
+        return readStatusCode(socket, received);
+      }
+
+      // The status line looks like "HTTP/1.1 200 OK".
+      const string line = received.substr(0, end);
+      const vector<string> tokens = strings::tokenize(line, " ");
+
+      if (tokens.size() < 2 || !strings::startsWith(tokens[0], "HTTP/")) {
+        return Failure("Received an invalid HTTP status line '" + line + "'");
+      }
+
+      Try<int> code = numify<int>(tokens[1]);
+      if (code.isError()) {
+        return Failure("Received an invalid HTTP status line '" + line + "'");
+      }
+
+      return code.get();
+    });
+}
+
+
+Try<Owned<Prober>> Prober::create(const Option<pid_t>& taskPid)
+{
+  if (taskPid.isNone()) {
+    return Owned<Prober>(new Prober(Owned<Namespace>()));
+  }
+
+#ifndef __linux__
+  return Error("Probing from a task's network namespace is only supported"
+               " on Linux");
+#else
+  return Owned<Prober>(new Prober(Owned<Namespace>(
+      new Namespace(taskPid.get()))));
+#endif // __linux__
+}
+
+
+Prober::Prober(Owned<Namespace> _ns) : ns(_ns) {}
+
+
+Prober::~Prober() {}
+
+
+Try<Socket> Prober::createSocket()
+{
+  // NOTE: The probes are plain TCP, hence we do not use the default
+  // socket implementation which might be SSL.
+  const SocketImpl::Kind kind = SocketImpl::Kind::POLL;
+
+  if (ns.get() == nullptr) {
+    return Socket::create(kind);
+  }
+
+  Try<int_fd> s = ns->socket();
+  if (s.isError()) {
+    return Error(s.error());
+  }
+
+  Try<Socket> socket = Socket::create(s.get(), kind);
+  if (socket.isError()) {
+    os::close(s.get());
+  }
+
+  return socket;
+}
+
+
+Future<Nothing> Prober::tcp(uint16_t port)
+{
+  Try<Socket> socket = createSocket();
+  if (socket.isError()) {
+    return Failure("Failed to create socket: " + socket.error());
+  }
+
+  const Address address(net::IP(INADDR_LOOPBACK), port);
+
+  // NOTE: We keep a copy of the socket in the continuation so that
+  // the socket is not closed before the connection is established.
+  Socket _socket = socket.get();
+
+  return _socket.connect(address)
+    .then([_socket]() { return Nothing(); })
+    .repair([address](const Future<Nothing>& future) -> Future<Nothing> {
+      return Failure(
+          "Failed to connect to " + stringify(address) + ": " +
+          future.failure());
+    });
+}
+
+
+Future<int> Prober::http(uint16_t port, const string& path)
+{
+  Try<Socket> socket = createSocket();
+  if (socket.isError()) {
+    return Failure("Failed to create socket: " + socket.error());
+  }
+
+  const Address address(net::IP(INADDR_LOOPBACK), port);
+
+  const string request =
+    "GET " + (path.empty() ? "/" : path) + " HTTP/1.1\r\n"
+    "Host: " + stringify(address) + "\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+  Socket _socket = socket.get();
+
+  return _socket.connect(address)
+    .then([_socket, request]() mutable { return _socket.send(request); })
+    .then([_socket]() { return readStatusCode(_socket, ""); });
+}
+
+} // namespace checks {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,90 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __PROBER_HPP__
+#define __PROBER_HPP__
+
+#include <stdint.h>
+
+#include <string>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+#include <process/socket.hpp>
+
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace checks {
+
+/**
+ * Performs TCP and HTTP probes against the loopback interface using
+ * libprocess sockets, rather than forking `mesos-tcp-connect` or `curl`
+ * for every check.
+ *
+ * If the probes have to be performed from the network namespace of a
+ * task, a helper thread enters that namespace once and creates the
+ * sockets for all subsequent probes in it. A socket stays in the
+ * namespace it was created in, so connecting, sending and receiving
+ * happens on the libprocess event loop like for any other socket.
+ */
+class Prober
+{
+public:
+  /**
+   * Creates a `Prober`.
+   *
+   * @param taskPid The pid of a process in the network namespace to
+   *     probe from, or `None` for the caller's network namespace.
+   */
+  static Try<process::Owned<Prober>> create(const Option<pid_t>& taskPid);
+
+  ~Prober();
+
+  // Not copyable, not assignable.
+  Prober(const Prober&) = delete;
+  Prober& operator=(const Prober&) = delete;
+
+  /**
+   * Connects to the given port. The returned future is ready once the
+   * connection has been established.
+   */
+  process::Future<Nothing> tcp(uint16_t port);
+
+  /**
+   * Sends a `GET` request for the path to the given port and returns
+   * the status code of the response. Redirects are not followed.
+   */
+  process::Future<int> http(uint16_t port, const std::string& path);
+
+private:
+  class Namespace;
+
+  explicit Prober(process::Owned<Namespace> ns);
+
+  Try<process::network::inet::Socket> createSocket();
+
+  process::Owned<Namespace> ns;
+};
+
+} // namespace checks {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __PROBER_HPP__
@@ -451,6 +451,41 @@ static bool subtractable(const Resource& left, const Resource& right)
 }
 
 
+// Tests if the Resource object is a "plain" scalar, i.e., an
+// unreserved, non-shared scalar without DiskInfo, RevocableInfo or
+// ResourceProviderID. These make up the bulk of the resources the
+// master and the allocator do arithmetic on.
+static inline bool isPlainScalar(const Resource& resource)
+{
+  return resource.type() == Value::SCALAR &&
+         !resource.has_shared() &&
+         !resource.has_reservation() &&
+         !resource.has_disk() &&
+         !resource.has_revocable() &&
+         !resource.has_provider_id() &&
+         resource.role() == "*";
+}
+
+
+// Tests if two plain scalar Resource objects can be combined. This is
+// equivalent to (but much cheaper than) `addable` and `subtractable`
+// when both objects are plain scalars. Note that a plain scalar is
+// never addable to or subtractable from a non-plain Resource object.
+static inline bool combinable(const Resource& left, const Resource& right)
+{
+  if (left.name() != right.name()) {
+    return false;
+  }
+
+  if (left.has_allocation_info() != right.has_allocation_info()) {
+    return false;
+  }
+
+  return !left.has_allocation_info() ||
+         left.allocation_info() == right.allocation_info();
+}
+
+
 // Tests if "right" is contained in "left".
 static bool contains(const Resource& left, const Resource& right)
 {
@@ -871,8 +906,9 @@ Option<Error> Resources::validate(const RepeatedPtrField<Resource>& resources)
 bool Resources::isEmpty(const Resource& resource)
 {
   if (resource.type() == Value::SCALAR) {
-    Value::Scalar zero;
-    zero.set_value(0);
+    // A default constructed scalar has a value of 0. We construct it
+    // only once as this is called for every arithmetic operation.
+    static const Value::Scalar zero;
     return resource.scalar() == zero;
   } else if (resource.type() == Value::RANGES) {
     return resource.ranges().range_size() == 0;
@@ -1057,18 +1093,27 @@ Resources::Resources(const RepeatedPtrField<Resource>& _resources)
 
 bool Resources::contains(const Resources& that) const
 {
-  Resources remaining = *this;
+  // We only need to track what remains of these resources once a
+  // persistent volume has been matched, so we avoid copying them
+  // until then (which for most resources means never).
+  Option<Resources> remaining;
 
   foreach (const Resource_& resource_, that.resources) {
+    const Resources& current = remaining.isSome() ? remaining.get() : *this;
+
     // NOTE: We use _contains because Resources only contain valid
     // Resource objects, and we don't want the performance hit of the
     // validity check.
-    if (!remaining._contains(resource_)) {
+    if (!current._contains(resource_)) {
       return false;
     }
 
     if (isPersistentVolume(resource_.resource)) {
-      remaining.subtract(resource_);
+      if (remaining.isNone()) {
+        remaining = *this;
+      }
+
+      remaining->subtract(resource_);
     }
   }
 
@@ -1626,6 +1671,17 @@ Option<Value::Ranges> Resources::ephemeral_ports() const
 
 bool Resources::_contains(const Resource_& that) const
 {
+  if (internal::isPlainScalar(that.resource)) {
+    foreach (const Resource_& resource_, resources) {
+      if (internal::isPlainScalar(resource_.resource) &&
+          internal::combinable(resource_.resource, that.resource)) {
+        return that.resource.scalar() <= resource_.resource.scalar();
+      }
+    }
+
+    return false;
+  }
+
   foreach (const Resource_& resource_, resources) {
     if (resource_.contains(that)) {
       return true;
@@ -1739,6 +1795,14 @@ void Resources::add(const Resource_& that)
     return;
   }
 
+  if (internal::isPlainScalar(that.resource)) {
+    if (!addPlainScalar(that.resource)) {
+      resources.push_back(that);
+    }
+
+    return;
+  }
+
   bool found = false;
   foreach (Resource_& resource_, resources) {
     if (internal::addable(resource_.resource, that)) {
@@ -1767,6 +1831,15 @@ Resources& Resources::operator+=(const Resource_& that)
 
 Resources& Resources::operator+=(const Resource& that)
 {
+  // Plain scalars are usually combined with an existing Resource
+  // object, in which case we can avoid copying `that`.
+  if (internal::isPlainScalar(that) &&
+      !isEmpty(that) &&
+      validate(that).isNone() &&
+      addPlainScalar(that)) {
+    return *this;
+  }
+
   *this += Resource_(that);
 
   return *this;
@@ -1813,6 +1886,11 @@ void Resources::subtract(const Resource_& that)
     return;
   }
 
+  if (internal::isPlainScalar(that.resource)) {
+    subtractPlainScalar(that.resource);
+    return;
+  }
+
   for (size_t i = 0; i < resources.size(); i++) {
     Resource_& resource_ = resources[i];
 
@@ -1859,12 +1937,57 @@ Resources& Resources::operator-=(const Resource_& that)
 
 Resources& Resources::operator-=(const Resource& that)
 {
+  // Plain scalars can be subtracted without copying `that`.
+  if (internal::isPlainScalar(that)) {
+    if (!isEmpty(that) && validate(that).isNone()) {
+      subtractPlainScalar(that);
+    }
+
+    return *this;
+  }
+
   *this -= Resource_(that);
 
   return *this;
 }
 
 
+bool Resources::addPlainScalar(const Resource& that)
+{
+  foreach (Resource_& resource_, resources) {
+    if (internal::isPlainScalar(resource_.resource) &&
+        internal::combinable(resource_.resource, that)) {
+      *resource_.resource.mutable_scalar() += that.scalar();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+void Resources::subtractPlainScalar(const Resource& that)
+{
+  for (size_t i = 0; i < resources.size(); i++) {
+    Resource_& resource_ = resources[i];
+
+    if (internal::isPlainScalar(resource_.resource) &&
+        internal::combinable(resource_.resource, that)) {
+      *resource_.resource.mutable_scalar() -= that.scalar();
+
+      // Remove the resource if it has become negative or empty,
+      // see `subtract()` above.
+      if (resource_.resource.scalar().value() <= 0) {
+        resources[i] = resources.back();
+        resources.pop_back();
+      }
+
+      return;
+    }
+  }
+}
+
+
 Resources& Resources::operator-=(const Resources& that)
 {
   foreach (const Resource_& resource_, that) {
@@ -123,6 +123,17 @@ Try<Owned<Docker>> Docker::create(
     return docker;
   }
 
+  Try<Nothing> validation = Docker::validate(*docker);
+  if (validation.isError()) {
+    return Error(validation.error());
+  }
+
+  return docker;
+}
+
+
+Try<Nothing> Docker::validate(const Docker& docker)
+{
 #ifdef __linux__
   // Make sure that cgroups are mounted, and at least the 'cpu'
   // subsystem is attached.
@@ -135,12 +146,7 @@ Try<Owned<Docker>> Docker::create(
   }
 #endif // __linux__
 
-  Try<Nothing> validateVersion = docker->validateVersion(Version(1, 0, 0));
-  if (validateVersion.isError()) {
-    return Error(validateVersion.error());
-  }
-
-  return docker;
+  return docker.validateVersion(Version(1, 0, 0));
 }
 
 
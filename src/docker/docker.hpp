@@ -291,6 +291,10 @@ protected:
          socket(DEFAULT_DOCKER_HOST_PREFIX + _socket),
          config(_config) {}
 
+  // Checks that the cgroups needed by Docker are mounted and that
+  // the Docker version is supported.
+  static Try<Nothing> validate(const Docker& docker);
+
 private:
   static process::Future<Version> _version(
       const std::string& cmd,
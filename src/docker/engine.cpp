@@ -0,0 +1,673 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <process/address.hpp>
+#include <process/collect.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/path.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "docker/engine.hpp"
+
+namespace http = process::http;
+namespace unix = process::network::unix;
+
+using namespace process;
+
+using std::list;
+using std::string;
+using std::vector;
+
+
+template <typename T>
+static Future<T> failure(
+    const string& operation,
+    const http::Response& response)
+{
+  return Failure(
+      "Failed to " + operation + ": " + response.status +
+      "; body='" + strings::trim(response.body) + "'");
+}
+
+
+static http::Request request(
+    const string& method,
+    const string& path,
+    const hashmap<string, string>& query = hashmap<string, string>())
+{
+  http::Request request;
+  request.method = method;
+
+  // NOTE: The daemon ignores the host since we talk to it over its
+  // unix socket, but HTTP/1.1 requires one to be present.
+  request.url = http::URL("http", "docker", 80, path, query);
+  request.keepAlive = true;
+
+  return request;
+}
+
+
+// Returns the value of the 'filters' query parameter of the Engine
+// API, which maps each filter to the list of values to match.
+static string filters(const hashmap<string, string>& values)
+{
+  JSON::Object filters;
+
+  foreachpair (const string& name, const string& value, values) {
+    JSON::Array array;
+    array.values.push_back(JSON::String(value));
+    filters.values[name] = array;
+  }
+
+  // NOTE: Query values are not escaped when encoding the request.
+  return http::encode(stringify(filters));
+}
+
+
+static Future<Docker::Container> container(
+    const string& containerName,
+    const http::Response& response)
+{
+  if (response.code != http::Status::OK) {
+    return failure<Docker::Container>(
+        "inspect container '" + containerName + "'", response);
+  }
+
+  // 'Docker::Container::create' expects the output of 'docker
+  // inspect', which wraps the container in an array.
+  Try<Docker::Container> container =
+    Docker::Container::create("[" + response.body + "]");
+
+  if (container.isError()) {
+    return Failure("Unable to create container: " + container.error());
+  }
+
+  return container.get();
+}
+
+
+class DockerEngineProcess : public Process<DockerEngineProcess>
+{
+public:
+  explicit DockerEngineProcess(const unix::Address& _address)
+    : ProcessBase(process::ID::generate("docker-engine")),
+      address(_address) {}
+
+  virtual ~DockerEngineProcess() {}
+
+  // Sends the request over the shared keep-alive connection,
+  // (re)connecting to the daemon if there is none.
+  Future<http::Response> send(const http::Request& request)
+  {
+    const bool reused = connection.isSome();
+    const Future<http::Connection> used = connect();
+
+    return used
+      .then([request](http::Connection connection) {
+        return connection.send(request);
+      })
+      .repair(defer(self(), [=](const Future<http::Response>& response)
+          -> Future<http::Response> {
+        reset(used);
+
+        // The daemon may have closed an idle connection underneath
+        // us, so retry reads once on a new connection.
+        if (!reused || request.method != "GET") {
+          return response;
+        }
+
+        return connect()
+          .then([request](http::Connection connection) {
+            return connection.send(request);
+          });
+      }));
+  }
+
+  // Sends the request over a connection of its own. This is used for
+  // requests the daemon may take arbitrarily long to respond to, which
+  // would otherwise hold up every request pipelined behind them.
+  Future<http::Response> sendDedicated(const http::Request& request)
+  {
+    http::Request _request = request;
+    _request.keepAlive = false;
+
+    return http::connect(address, http::Scheme::HTTP)
+      .then([_request](http::Connection connection) {
+        // Hold on to the connection until the response is complete.
+        return connection.send(_request)
+          .onAny([connection]() {});
+      });
+  }
+
+  Future<Docker::Container> inspect(
+      const string& containerName,
+      const Option<Duration>& retryInterval)
+  {
+    if (retryInterval.isNone()) {
+      return send(::request("GET", "/containers/" + containerName + "/json"))
+        .then(lambda::bind(&container, containerName, lambda::_1));
+    }
+
+    Owned<Promise<Docker::Container>> promise(
+        new Promise<Docker::Container>());
+
+    // We subscribe before the first inspect so that a start which
+    // happens in between is not missed. Should the daemon not answer
+    // the subscription within a retry interval we stop waiting for it
+    // and poll instead.
+    subscribe(containerName)
+      .after(retryInterval.get(), [](Future<Events> events) {
+        events.discard();
+        return Failure("Timed out");
+      })
+      .onAny(defer(self(), [=](const Future<Events>& subscription) {
+        Option<Events> events;
+
+        if (subscription.isReady()) {
+          events = subscription.get();
+
+          // Closing the reader fails any pending read, which lets the
+          // loop below notice that the future has been discarded.
+          http::Pipe::Reader reader = events->reader;
+          promise->future()
+            .onDiscard([reader]() mutable { reader.close(); });
+        } else {
+          LOG(WARNING) << "Failed to subscribe to the events of container '"
+                       << containerName << "', falling back to polling: "
+                       << (subscription.isFailed() ? subscription.failure()
+                                                   : "discarded");
+        }
+
+        _inspect(containerName, promise, retryInterval.get(), events);
+      }));
+
+    return promise->future();
+  }
+
+private:
+  // An event stream along with the connection it is received on.
+  struct Events
+  {
+    http::Connection connection;
+    http::Pipe::Reader reader;
+  };
+
+  Future<http::Connection> connect()
+  {
+    if (connection.isSome()) {
+      return connection.get();
+    }
+
+    const Future<http::Connection> future =
+      http::connect(address, http::Scheme::HTTP);
+
+    connection = future;
+
+    future.onAny(defer(self(), [=](const Future<http::Connection>& _future) {
+      if (!_future.isReady()) {
+        reset(future);
+        return;
+      }
+
+      http::Connection connection = _future.get();
+      connection.disconnected()
+        .onAny(defer(self(), [=](const Future<Nothing>&) { reset(future); }));
+    }));
+
+    return future;
+  }
+
+  // Forgets the shared connection if it is still the given one, so
+  // that the next request opens a new one.
+  void reset(const Future<http::Connection>& future)
+  {
+    if (connection.isSome() && connection.get() == future) {
+      connection = None();
+    }
+  }
+
+  // Subscribes to the start events of the given container. The stream
+  // never completes, so it gets a connection of its own.
+  Future<Events> subscribe(const string& containerName)
+  {
+    hashmap<string, string> values;
+    values["container"] = containerName;
+    values["event"] = "start";
+
+    hashmap<string, string> query;
+    query["filters"] = filters(values);
+
+    http::Request request = ::request("GET", "/events", query);
+    request.keepAlive = false;
+
+    return http::connect(address, http::Scheme::HTTP)
+      .then([=](http::Connection connection) {
+        return connection.send(request, true)
+          .then([=](const http::Response& response) -> Future<Events> {
+            if (response.code != http::Status::OK) {
+              http::Connection(connection).disconnect();
+
+              return failure<Events>(
+                  "subscribe to events of container '" + containerName + "'",
+                  response);
+            }
+
+            CHECK_EQ(http::Response::PIPE, response.type);
+            CHECK_SOME(response.reader);
+
+            return Events{connection, response.reader.get()};
+          });
+      });
+  }
+
+  void _inspect(
+      const string& containerName,
+      const Owned<Promise<Docker::Container>>& promise,
+      const Duration& retryInterval,
+      const Option<Events>& events)
+  {
+    if (promise->future().hasDiscard()) {
+      close(events);
+      promise->discard();
+      return;
+    }
+
+    inspect(containerName, None())
+      .onAny(defer(self(), [=](const Future<Docker::Container>& container) {
+        if (promise->future().hasDiscard()) {
+          close(events);
+          promise->discard();
+          return;
+        }
+
+        if (container.isReady() && container->started) {
+          close(events);
+          promise->set(container.get());
+          return;
+        }
+
+        VLOG(1) << "Waiting for container '" << containerName << "' to start"
+                << (container.isFailed() ? ": " + container.failure() : "");
+
+        if (events.isNone()) {
+          delay(retryInterval,
+                self(),
+                &Self::_inspect,
+                containerName,
+                promise,
+                retryInterval,
+                events);
+          return;
+        }
+
+        // Inspect again once the daemon reports the container to
+        // have started (or the event stream ends, in which case we
+        // fall back to polling).
+        http::Pipe::Reader reader = events->reader;
+        reader.read()
+          .onAny(defer(self(), [=](const Future<string>& event) {
+            if (event.isReady() && !event->empty()) {
+              _inspect(containerName, promise, retryInterval, events);
+              return;
+            }
+
+            close(events);
+
+            if (promise->future().hasDiscard()) {
+              promise->discard();
+              return;
+            }
+
+            LOG(WARNING) << "Event stream for container '" << containerName
+                         << "' ended, falling back to polling";
+
+            delay(retryInterval,
+                  self(),
+                  &Self::_inspect,
+                  containerName,
+                  promise,
+                  retryInterval,
+                  Option<Events>::none());
+          }));
+      }));
+  }
+
+  static void close(const Option<Events>& events)
+  {
+    if (events.isSome()) {
+      http::Pipe::Reader reader = events->reader;
+      reader.close();
+
+      http::Connection connection = events->connection;
+      connection.disconnect();
+    }
+  }
+
+  const unix::Address address;
+
+  Option<Future<http::Connection>> connection;
+};
+
+
+Try<Owned<Docker>> DockerEngine::create(
+    const string& path,
+    const string& socket,
+    bool validate,
+    const Option<JSON::Object>& config)
+{
+  if (!path::absolute(socket)) {
+    return Error("Invalid Docker socket path: " + socket);
+  }
+
+  Try<unix::Address> address = unix::Address::create(socket);
+  if (address.isError()) {
+    return Error(
+        "Invalid Docker socket path '" + socket + "': " + address.error());
+  }
+
+  Owned<Docker> docker(new DockerEngine(path, socket, config));
+  if (!validate) {
+    return docker;
+  }
+
+  Try<Nothing> validation = Docker::validate(*docker);
+  if (validation.isError()) {
+    return Error(validation.error());
+  }
+
+  return docker;
+}
+
+
+DockerEngine::DockerEngine(
+    const string& path,
+    const string& socket,
+    const Option<JSON::Object>& config)
+  : Docker(path, socket, config)
+{
+  // NOTE: The socket path is validated in 'DockerEngine::create'.
+  process = new DockerEngineProcess(unix::Address::create(socket).get());
+  spawn(process);
+}
+
+
+DockerEngine::~DockerEngine()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+Future<Version> DockerEngine::version() const
+{
+  return dispatch(
+      process,
+      &DockerEngineProcess::send,
+      request("GET", "/version"))
+    .then([](const http::Response& response) -> Future<Version> {
+      if (response.code != http::Status::OK) {
+        return failure<Version>("get docker version", response);
+      }
+
+      Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.body);
+      if (parse.isError()) {
+        return Failure("Failed to parse JSON: " + parse.error());
+      }
+
+      Result<JSON::String> version = parse->at<JSON::String>("Version");
+      if (!version.isSome()) {
+        return Failure("Unable to find Version in '" + response.body + "'");
+      }
+
+      // Drop suffixes such as the '-ce' of '17.03.0-ce' as well as
+      // any components beyond the third (see 'Docker::__version').
+      vector<string> components =
+        strings::split(strings::split(version->value, "-").front(), ".");
+
+      if (components.size() > 3) {
+        components.erase(components.begin() + 3, components.end());
+      }
+
+      Try<Version> parsed = Version::parse(strings::join(".", components));
+      if (parsed.isError()) {
+        return Failure("Failed to parse docker version: " + parsed.error());
+      }
+
+      return parsed.get();
+    });
+}
+
+
+// Removes the container through the given process; this is shared by
+// 'rm' and 'stop' so the latter does not depend on the lifetime of
+// the 'DockerEngine' once its request is in flight.
+static Future<Nothing> remove(
+    const PID<DockerEngineProcess>& pid,
+    const string& containerName,
+    bool force)
+{
+  hashmap<string, string> query;
+  query["v"] = "1";
+
+  if (force) {
+    query["force"] = "1";
+  }
+
+  return dispatch(
+      pid,
+      &DockerEngineProcess::send,
+      request("DELETE", "/containers/" + containerName, query))
+    .then([containerName](const http::Response& response) -> Future<Nothing> {
+      if (response.code != http::Status::NO_CONTENT) {
+        return failure<Nothing>(
+            "remove container '" + containerName + "'", response);
+      }
+
+      return Nothing();
+    });
+}
+
+
+// NOTE: As with 'Docker::stop', removal is best-effort when `remove`
+// is set to true (MESOS-7777).
+Future<Nothing> DockerEngine::stop(
+    const string& containerName,
+    const Duration& timeout,
+    bool remove) const
+{
+  int timeoutSecs = (int) timeout.secs();
+  if (timeoutSecs < 0) {
+    return Failure("A negative timeout cannot be applied to docker stop: " +
+                   stringify(timeoutSecs));
+  }
+
+  hashmap<string, string> query;
+  query["t"] = stringify(timeoutSecs);
+
+  // The daemon only responds once the container has stopped, which
+  // may take up to the timeout, hence the dedicated connection.
+  Future<Nothing> stop = dispatch(
+      process,
+      &DockerEngineProcess::sendDedicated,
+      request("POST", "/containers/" + containerName + "/stop", query))
+    .then([containerName](const http::Response& response) -> Future<Nothing> {
+      // A '304 Not Modified' means the container was already stopped,
+      // which 'docker stop' does not consider an error either.
+      if (response.code != http::Status::NO_CONTENT &&
+          response.code != http::Status::NOT_MODIFIED) {
+        return failure<Nothing>(
+            "stop container '" + containerName + "'", response);
+      }
+
+      return Nothing();
+    });
+
+  if (!remove) {
+    return stop;
+  }
+
+  const PID<DockerEngineProcess> pid = process->self();
+
+  return stop
+    .then([](const Nothing&) { return false; })
+    .repair([](const Future<bool>&) { return true; })
+    .then([pid, containerName](bool force) {
+      return ::remove(pid, containerName, force)
+        .repair([containerName](const Future<Nothing>& future) {
+          LOG(ERROR) << "Unable to remove Docker container '"
+                     << containerName + "': " << future.failure();
+          return Nothing();
+        });
+    });
+}
+
+
+Future<Nothing> DockerEngine::kill(
+    const string& containerName,
+    int signal) const
+{
+  hashmap<string, string> query;
+  query["signal"] = stringify(signal);
+
+  return dispatch(
+      process,
+      &DockerEngineProcess::send,
+      request("POST", "/containers/" + containerName + "/kill", query))
+    .then([containerName](const http::Response& response) -> Future<Nothing> {
+      if (response.code != http::Status::NO_CONTENT) {
+        return failure<Nothing>(
+            "kill container '" + containerName + "'", response);
+      }
+
+      return Nothing();
+    });
+}
+
+
+Future<Nothing> DockerEngine::rm(
+    const string& containerName,
+    bool force) const
+{
+  return remove(process->self(), containerName, force);
+}
+
+
+Future<Docker::Container> DockerEngine::inspect(
+    const string& containerName,
+    const Option<Duration>& retryInterval) const
+{
+  return dispatch(
+      process,
+      &DockerEngineProcess::inspect,
+      containerName,
+      retryInterval);
+}
+
+
+Future<list<Docker::Container>> DockerEngine::ps(
+    bool all,
+    const Option<string>& prefix) const
+{
+  hashmap<string, string> query;
+
+  if (all) {
+    query["all"] = "1";
+  }
+
+  // NOTE: The daemon matches names by substring, so we still need to
+  // check for the prefix below.
+  if (prefix.isSome()) {
+    hashmap<string, string> values;
+    values["name"] = prefix.get();
+
+    query["filters"] = filters(values);
+  }
+
+  const PID<DockerEngineProcess> pid = process->self();
+
+  return dispatch(
+      pid,
+      &DockerEngineProcess::send,
+      request("GET", "/containers/json", query))
+    .then([pid, prefix](const http::Response& response)
+        -> Future<list<Docker::Container>> {
+      if (response.code != http::Status::OK) {
+        return failure<list<Docker::Container>>("list containers", response);
+      }
+
+      Try<JSON::Array> parse = JSON::parse<JSON::Array>(response.body);
+      if (parse.isError()) {
+        return Failure("Failed to parse JSON: " + parse.error());
+      }
+
+      // The listing lacks most of the state (e.g., the pid and the
+      // network settings) that a 'Docker::Container' is created from,
+      // so we still inspect each matching container. All inspects
+      // share the connection, so unlike 'Docker::ps' we need not limit
+      // how many are in flight.
+      list<Future<Docker::Container>> containers;
+
+      foreach (const JSON::Value& entry, parse->values) {
+        if (!entry.is<JSON::Object>()) {
+          return Failure(
+              "Malformed container entry '" + stringify(entry) + "'");
+        }
+
+        Result<JSON::Array> names =
+          entry.as<JSON::Object>().at<JSON::Array>("Names");
+
+        if (!names.isSome()) {
+          return Failure("Unable to find Names in '" + stringify(entry) + "'");
+        }
+
+        foreach (const JSON::Value& value, names->values) {
+          if (!value.is<JSON::String>()) {
+            continue;
+          }
+
+          // Names are reported with a leading '/', unlike 'docker ps'.
+          const string name = strings::remove(
+              value.as<JSON::String>().value, "/", strings::PREFIX);
+
+          if (prefix.isNone() || strings::startsWith(name, prefix.get())) {
+            containers.push_back(dispatch(
+                pid,
+                &DockerEngineProcess::inspect,
+                name,
+                None()));
+            break;
+          }
+        }
+      }
+
+      return collect(containers);
+    });
+}
@@ -0,0 +1,100 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __DOCKER_ENGINE_HPP__
+#define __DOCKER_ENGINE_HPP__
+
+#include <list>
+#include <string>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/json.hpp>
+#include <stout/none.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+#include <stout/version.hpp>
+
+#include "docker/docker.hpp"
+
+// Forward declaration.
+class DockerEngineProcess;
+
+
+// Docker abstraction that talks to the Docker daemon through the
+// Engine API on its unix socket rather than forking the CLI for
+// every operation. Requests share a single keep-alive connection
+// (pipelined when issued concurrently), and an 'inspect' that waits
+// for a container to start is driven by the daemon's event stream
+// instead of polling.
+//
+// NOTE: 'run' and 'pull' are still delegated to the CLI, since they
+// depend on the CLI for attaching the container output and for
+// registry authentication.
+class DockerEngine : public Docker
+{
+public:
+  static Try<process::Owned<Docker>> create(
+      const std::string& path,
+      const std::string& socket,
+      bool validate = true,
+      const Option<JSON::Object>& config = None());
+
+  virtual ~DockerEngine();
+
+  virtual process::Future<Version> version() const;
+
+  virtual process::Future<Nothing> stop(
+      const std::string& containerName,
+      const Duration& timeout = Seconds(0),
+      bool remove = false) const;
+
+  virtual process::Future<Nothing> kill(
+      const std::string& containerName,
+      int signal) const;
+
+  virtual process::Future<Nothing> rm(
+      const std::string& containerName,
+      bool force = false) const;
+
+  // Performs 'GET /containers/<name>/json'. If retryInterval is set,
+  // we subscribe to the start events of the container and inspect
+  // again whenever one arrives, until the container is started or
+  // the future is discarded. If the event stream is unavailable we
+  // fall back to retrying every retryInterval.
+  virtual process::Future<Container> inspect(
+      const std::string& containerName,
+      const Option<Duration>& retryInterval = None()) const;
+
+  virtual process::Future<std::list<Container>> ps(
+      bool all = false,
+      const Option<std::string>& prefix = None()) const;
+
+private:
+  DockerEngine(
+      const std::string& path,
+      const std::string& socket,
+      const Option<JSON::Object>& config);
+
+  DockerEngine(const DockerEngine&) = delete;
+
+  DockerEngineProcess* process;
+};
+
+#endif // __DOCKER_ENGINE_HPP__
@@ -46,6 +46,9 @@
 #include "common/status_utils.hpp"
 
 #include "docker/docker.hpp"
+#ifndef __WINDOWS__
+#include "docker/engine.hpp"
+#endif // __WINDOWS__
 #include "docker/executor.hpp"
 
 #include "logging/flags.hpp"
@@ -875,10 +878,22 @@ int main(int argc, char** argv)
   // The 2nd argument for docker create is set to false so we skip
   // validation when creating a docker abstraction, as the slave
   // should have already validated docker.
+#ifndef __WINDOWS__
+  Try<Owned<Docker>> docker = flags.docker_engine_api
+    ? DockerEngine::create(
+          flags.docker.get(),
+          flags.docker_socket.get(),
+          false)
+    : Docker::create(
+          flags.docker.get(),
+          flags.docker_socket.get(),
+          false);
+#else
   Try<Owned<Docker>> docker = Docker::create(
       flags.docker.get(),
       flags.docker_socket.get(),
       false);
+#endif // __WINDOWS__
 
   if (docker.isError()) {
     cerr << "Unable to create docker abstraction: " << docker.error() << endl;
@@ -50,6 +50,14 @@ struct Flags : public virtual mesos::internal::logging::Flags
         "socket, such as '/var/run/docker.sock'. On Windows this must be a\n"
         "named pipe, such as '//./pipe/docker_engine'.");
 
+#ifndef __WINDOWS__
+    add(&Flags::docker_engine_api,
+        "docker_engine_api",
+        "Whether to talk to the Docker daemon through the Engine API\n"
+        "on the docker socket instead of running the docker CLI.",
+        false);
+#endif // __WINDOWS__
+
     add(&Flags::sandbox_directory,
         "sandbox_directory",
         "The path to the container sandbox holding stdout and stderr files\n"
@@ -86,6 +94,9 @@ struct Flags : public virtual mesos::internal::logging::Flags
   Option<std::string> container;
   Option<std::string> docker;
   Option<std::string> docker_socket;
+#ifndef __WINDOWS__
+  bool docker_engine_api;
+#endif // __WINDOWS__
   Option<std::string> sandbox_directory;
   Option<std::string> mapped_directory;
   Option<std::string> launcher_dir;
@@ -14,7 +14,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <process/owned.hpp>
@@ -38,6 +41,10 @@
 
 #include "hdfs/hdfs.hpp"
 
+#ifdef __linux__
+#include "linux/fs.hpp"
+#endif // __linux__
+
 #include "logging/flags.hpp"
 #include "logging/logging.hpp"
 
@@ -193,6 +200,21 @@ static Try<string> copyFile(
     const string& sourcePath,
     const string& destinationPath)
 {
+#ifdef __linux__
+  // Prefer a copy-on-write clone, which shares the data blocks of the
+  // source (e.g., a cache file) instead of copying them.
+  Try<Nothing> clone = fs::clone(sourcePath, destinationPath);
+  if (clone.isSome()) {
+    LOG(INFO) << "Cloned resource '" << sourcePath
+              << "' to '" << destinationPath << "'";
+
+    return destinationPath;
+  }
+
+  VLOG(1) << "Copying instead of cloning '" << sourcePath << "': "
+          << clone.error();
+#endif // __linux__
+
   int status = os::spawn("cp", {"cp", sourcePath, destinationPath});
 
   if (status == -1) {
@@ -571,16 +593,49 @@ int main(int argc, char* argv[])
       Option<string>::some(fetcherInfo.get().frameworks_home()) :
         Option<string>::none();
 
-  // Fetch each URI to a local file and chmod if necessary.
-  foreach (const FetcherInfo::Item& item, fetcherInfo.get().items()) {
-    Try<string> fetched =
-      fetch(item, cacheDirectory, sandboxDirectory, frameworksHome);
-    if (fetched.isError()) {
+  const int items = fetcherInfo->items_size();
+
+  // Fetch each URI to a local file and chmod if necessary. The URIs
+  // are independent of each other, so we fetch up to 'concurrency' of
+  // them at a time, each thread taking the next unclaimed item.
+  vector<Option<string>> errors(items);
+  std::atomic<int> next(0);
+
+  auto worker = [&]() {
+    for (int i = next++; i < items; i = next++) {
+      const FetcherInfo::Item& item = fetcherInfo->items(i);
+
+      Try<string> fetched =
+        fetch(item, cacheDirectory, sandboxDirectory, frameworksHome);
+
+      if (fetched.isError()) {
+        errors[i] = fetched.error();
+      } else {
+        LOG(INFO) << "Fetched '" << item.uri().value()
+                  << "' to '" << fetched.get() << "'";
+      }
+    }
+  };
+
+  const int concurrency =
+    std::min(items, std::max(1, (int) fetcherInfo->concurrency()));
+
+  vector<std::thread> threads;
+  for (int i = 1; i < concurrency; i++) {
+    threads.emplace_back(worker);
+  }
+
+  worker();
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < items; i++) {
+    if (errors[i].isSome()) {
       EXIT(EXIT_FAILURE)
-        << "Failed to fetch '" << item.uri().value() << "': " + fetched.error();
-    } else {
-      LOG(INFO) << "Fetched '" << item.uri().value()
-                << "' to '" << fetched.get() << "'";
+        << "Failed to fetch '" << fetcherInfo->items(i).uri().value()
+        << "': " + errors[i].get();
     }
   }
 
@@ -502,6 +502,50 @@ Try<Nothing> unmountAll(const string& target, int flags)
 }
 
 
+Try<Nothing> clone(const string& source, const string& target)
+{
+  Try<int> in = os::open(source, O_RDONLY | O_CLOEXEC);
+  if (in.isError()) {
+    return Error("Failed to open '" + source + "': " + in.error());
+  }
+
+  struct stat s;
+  if (::fstat(in.get(), &s) < 0) {
+    ErrnoError error("Failed to stat '" + source + "'");
+    os::close(in.get());
+    return error;
+  }
+
+  if (!S_ISREG(s.st_mode)) {
+    os::close(in.get());
+    return Error("'" + source + "' is not a regular file");
+  }
+
+  Try<int> out = os::open(
+      target,
+      O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+      s.st_mode & 07777);
+
+  if (out.isError()) {
+    os::close(in.get());
+    return Error("Failed to create '" + target + "': " + out.error());
+  }
+
+  if (::ioctl(out.get(), FICLONE, in.get()) < 0) {
+    ErrnoError error("Failed to clone '" + source + "' to '" + target + "'");
+    os::close(in.get());
+    os::close(out.get());
+    os::rm(target);
+    return error;
+  }
+
+  os::close(in.get());
+  os::close(out.get());
+
+  return Nothing();
+}
+
+
 Try<Nothing> pivot_root(
     const string& newRoot,
     const string& putOld)
@@ -19,6 +19,7 @@
 
 #include <mntent.h>
 
+#include <sys/ioctl.h>
 #include <sys/mount.h>
 #include <sys/types.h>
 #include <sys/vfs.h>
@@ -170,6 +171,12 @@
 #define FS_TYPE_ZFS 0x2fc12fc1
 #define FS_TYPE_OVERLAY 0x794C7630
 
+// Define the reflink ioctl for old includes.
+// http://man7.org/linux/man-pages/man2/ioctl_ficlone.2.html
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
 namespace mesos {
 namespace internal {
 namespace fs {
@@ -369,6 +376,16 @@ Try<Nothing> unmount(const std::string& target, int flags = 0);
 Try<Nothing> unmountAll(const std::string& target, int flags = 0);
 
 
+// Create 'target' as a copy-on-write clone (reflink) of the regular
+// file 'source'. The clone shares the data blocks of 'source' until
+// either file is modified, so this takes time proportional to the
+// file's metadata rather than its size. Fails, without leaving
+// 'target' behind, if the file system does not support reflinks
+// (e.g., XFS without `reflink=1`, ext4) or if 'source' and 'target'
+// are on different file systems.
+Try<Nothing> clone(const std::string& source, const std::string& target);
+
+
 // Change the root filesystem.
 Try<Nothing> pivot_root(const std::string& newRoot, const std::string& putOld);
 
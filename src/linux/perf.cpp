@@ -14,14 +14,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fcntl.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <linux/perf_event.h>
+
 #include <sys/prctl.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <algorithm>
 #include <list>
 #include <sstream>
 #include <string>
@@ -36,9 +42,13 @@
 #include <process/process.hpp>
 #include <process/subprocess.hpp>
 
+#include <stout/numify.hpp>
 #include <stout/os.hpp>
 #include <stout/strings.hpp>
 
+#include <stout/os/close.hpp>
+#include <stout/os/open.hpp>
+#include <stout/os/read.hpp>
 #include <stout/os/signals.hpp>
 
 #include "common/status_utils.hpp"
@@ -189,9 +199,420 @@ private:
   Option<Subprocess> perf;
 };
 
+
+// Returns the online CPUs, as listed (e.g., "0-3,6") in the sysfs
+// 'online' file.
+Try<vector<int>> cpus()
+{
+  Try<string> read = os::read("/sys/devices/system/cpu/online");
+  if (read.isError()) {
+    return Error("Failed to read the online CPUs: " + read.error());
+  }
+
+  vector<int> cpus;
+
+  foreach (const string& range, strings::tokenize(read.get(), ",\n")) {
+    vector<string> bounds = strings::split(strings::trim(range), "-");
+
+    if (bounds.empty() || bounds.size() > 2) {
+      return Error("Unexpected CPU range '" + range + "'");
+    }
+
+    Try<int> first = numify<int>(bounds.front());
+    Try<int> last = numify<int>(bounds.back());
+
+    if (first.isError() || last.isError() || first.get() > last.get()) {
+      return Error("Unexpected CPU range '" + range + "'");
+    }
+
+    for (int cpu = first.get(); cpu <= last.get(); cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  if (cpus.empty()) {
+    return Error("No online CPUs");
+  }
+
+  return cpus;
+}
+
+
+inline Try<int, ErrnoError> open(
+    uint32_t type,
+    uint64_t config,
+    pid_t pid,
+    int cpu,
+    unsigned long flags)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+
+  // The time the counter was enabled and running lets us scale the
+  // count when the kernel multiplexes more counters than the PMU has.
+  attr.read_format =
+    PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  int fd = ::syscall(__NR_perf_event_open, &attr, pid, cpu, -1, flags);
+  if (fd < 0) {
+    return ErrnoError();
+  }
+
+  if (os::cloexec(fd).isError()) {
+    ErrnoError error("Failed to set cloexec");
+    os::close(fd);
+    return error;
+  }
+
+  return fd;
+}
+
 } // namespace internal {
 
 
+// The kernel encoding of the events counted by `Counters`, keyed by
+// their normalized names. This covers the generic hardware, software
+// and hardware cache events `perf list` shows.
+static hashmap<string, std::pair<uint32_t, uint64_t>> encodings()
+{
+  hashmap<string, std::pair<uint32_t, uint64_t>> encodings = {
+    {"cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}},
+    {"stalled_cycles_frontend",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND}},
+    {"stalled_cycles_backend",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND}},
+    {"instructions", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}},
+    {"cache_references",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES}},
+    {"cache_misses", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}},
+    {"branches", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS}},
+    {"branch_misses", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}},
+    {"bus_cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES}},
+    {"ref_cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES}},
+    {"cpu_clock", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK}},
+    {"task_clock", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}},
+    {"page_faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}},
+    {"minor_faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN}},
+    {"major_faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ}},
+    {"context_switches",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}},
+    {"cpu_migrations", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS}},
+    {"alignment_faults",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_ALIGNMENT_FAULTS}},
+    {"emulation_faults",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_EMULATION_FAULTS}},
+  };
+
+  // Hardware cache events are named '<cache>_<op>s' and
+  // '<cache>_<op>_misses', e.g., 'l1_dcache_loads'.
+  const vector<std::pair<string, uint64_t>> caches = {
+    {"l1_dcache", PERF_COUNT_HW_CACHE_L1D},
+    {"l1_icache", PERF_COUNT_HW_CACHE_L1I},
+    {"llc", PERF_COUNT_HW_CACHE_LL},
+    {"dtlb", PERF_COUNT_HW_CACHE_DTLB},
+    {"itlb", PERF_COUNT_HW_CACHE_ITLB},
+    {"branch", PERF_COUNT_HW_CACHE_BPU},
+    {"node", PERF_COUNT_HW_CACHE_NODE},
+  };
+
+  const vector<std::pair<string, uint64_t>> ops = {
+    {"load", PERF_COUNT_HW_CACHE_OP_READ},
+    {"store", PERF_COUNT_HW_CACHE_OP_WRITE},
+    {"prefetch", PERF_COUNT_HW_CACHE_OP_PREFETCH},
+  };
+
+  const mesos::PerfStatistics statistics;
+
+  foreach (const auto& cache, caches) {
+    foreach (const auto& op, ops) {
+      const string prefix = cache.first + "_" + op.first;
+      const uint64_t config = cache.second | (op.second << 8);
+
+      // Not every combination has a PerfStatistics field.
+      if (statistics.GetDescriptor()->FindFieldByName(prefix + "s")) {
+        encodings[prefix + "s"] = {
+          PERF_TYPE_HW_CACHE,
+          config | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16)};
+      }
+
+      if (statistics.GetDescriptor()->FindFieldByName(prefix + "_misses")) {
+        encodings[prefix + "_misses"] = {
+          PERF_TYPE_HW_CACHE,
+          config | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+      }
+    }
+  }
+
+  return encodings;
+}
+
+
+Try<Owned<Counters>> Counters::create(
+    const set<string>& events,
+    const string& hierarchy,
+    size_t maxCounters)
+{
+  const hashmap<string, std::pair<uint32_t, uint64_t>> encodings =
+    perf::encodings();
+
+  vector<Event> _events;
+
+  foreach (const string& event, events) {
+    const string name = internal::normalize(event);
+
+    if (!encodings.contains(name)) {
+      return Error("Event '" + event + "' can not be counted directly");
+    }
+
+    const std::pair<uint32_t, uint64_t>& encoding = encodings.at(name);
+
+    _events.push_back({name, encoding.first, encoding.second});
+  }
+
+  Try<vector<int>> cpus = internal::cpus();
+  if (cpus.isError()) {
+    return Error(cpus.error());
+  }
+
+  if (cpus->empty()) {
+    return Error("No online CPUs found");
+  }
+
+  // Make sure we are permitted to count the events of a cgroup (see
+  // '/proc/sys/kernel/perf_event_paranoid'), by counting the task
+  // clock of the root cgroup of the hierarchy on one CPU.
+  Try<int> directory = os::open(hierarchy, O_RDONLY | O_CLOEXEC);
+  if (directory.isError()) {
+    return Error(
+        "Failed to open '" + hierarchy + "': " + directory.error());
+  }
+
+  Try<int, ErrnoError> fd = internal::open(
+      PERF_TYPE_SOFTWARE,
+      PERF_COUNT_SW_TASK_CLOCK,
+      directory.get(),
+      cpus->front(),
+      PERF_FLAG_PID_CGROUP);
+
+  os::close(directory.get());
+
+  if (fd.isError()) {
+    return Error(
+        "Failed to open a perf event for cgroup '" + hierarchy + "': " +
+        fd.error().message);
+  }
+
+  os::close(fd.get());
+
+  return Owned<Counters>(new Counters(_events, cpus.get(), maxCounters));
+}
+
+
+Counters::Counters(
+    const vector<Event>& _events,
+    const vector<int>& _cpus,
+    size_t _maxCounters)
+  : events(_events),
+    cpus(_cpus),
+    maxCounters(_maxCounters),
+    opened(0) {}
+
+
+Counters::~Counters()
+{
+  foreachvalue (const Cgroup& cgroup, cgroups) {
+    close(cgroup);
+  }
+}
+
+
+size_t Counters::close(const Cgroup& cgroup)
+{
+  size_t closed = 0;
+
+  foreach (const vector<int>& fds, cgroup.fds) {
+    foreach (int fd, fds) {
+      os::close(fd);
+      closed++;
+    }
+  }
+
+  return closed;
+}
+
+
+Try<Nothing> Counters::add(const string& cgroup, const string& path)
+{
+  if (cgroups.contains(cgroup)) {
+    return Error("Cgroup '" + cgroup + "' is already being counted");
+  }
+
+  // Check the budget up front, assuming every event is supported.
+  const size_t needed = events.size() * cpus.size();
+
+  if (opened + needed > maxCounters) {
+    return Error(
+        "Counting cgroup '" + cgroup + "' needs " + stringify(needed) +
+        " perf event counters, which would exceed the maximum of " +
+        stringify(maxCounters) + " (" + stringify(opened) + " in use)");
+  }
+
+  // With PERF_FLAG_PID_CGROUP the kernel takes a file descriptor of
+  // the cgroup directory in place of a pid.
+  Try<int> directory = os::open(path, O_RDONLY | O_CLOEXEC);
+  if (directory.isError()) {
+    return Error("Failed to open '" + path + "': " + directory.error());
+  }
+
+  Cgroup counters;
+  counters.time = Clock::now();
+  counters.totals.resize(events.size(), 0);
+
+  foreach (const Event& event, events) {
+    counters.fds.push_back(vector<int>());
+
+    // Cgroup events are per CPU, so we need one counter per CPU.
+    foreach (int cpu, cpus) {
+      Try<int, ErrnoError> fd = internal::open(
+          event.type,
+          event.config,
+          directory.get(),
+          cpu,
+          PERF_FLAG_PID_CGROUP);
+
+      // Like `perf stat`, we ignore events this host can't count
+      // (e.g., hardware events in a virtual machine without a
+      // virtualized PMU), leaving them out of the statistics.
+      if (fd.isError() &&
+          (fd.error().code == ENOENT || fd.error().code == EOPNOTSUPP)) {
+        LOG(WARNING) << "Unsupported perf event '" << event.name << "'"
+                     << ", ignoring: " << fd.error().message;
+
+        foreach (int opened, counters.fds.back()) {
+          os::close(opened);
+        }
+
+        counters.fds.back().clear();
+        break;
+      }
+
+      if (fd.isError()) {
+        os::close(directory.get());
+        close(counters);
+
+        return Error(
+            "Failed to open perf event '" + event.name + "' on CPU " +
+            stringify(cpu) + " for '" + path + "': " + fd.error().message);
+      }
+
+      counters.fds.back().push_back(fd.get());
+    }
+  }
+
+  os::close(directory.get());
+
+  foreach (const vector<int>& fds, counters.fds) {
+    opened += fds.size();
+  }
+
+  cgroups.put(cgroup, counters);
+
+  return Nothing();
+}
+
+
+void Counters::remove(const string& cgroup)
+{
+  if (cgroups.contains(cgroup)) {
+    opened -= close(cgroups.at(cgroup));
+    cgroups.erase(cgroup);
+  }
+}
+
+
+hashmap<string, mesos::PerfStatistics> Counters::read()
+{
+  hashmap<string, mesos::PerfStatistics> result;
+
+  const Time now = Clock::now();
+
+  foreachpair (const string& cgroup, Cgroup& counters, cgroups) {
+    mesos::PerfStatistics statistics;
+    statistics.set_timestamp(counters.time.secs());
+    statistics.set_duration((now - counters.time).secs());
+
+    const google::protobuf::Reflection* reflection =
+      statistics.GetReflection();
+
+    for (size_t i = 0; i < events.size(); i++) {
+      if (counters.fds[i].empty()) {
+        continue; // Unsupported, see 'add'.
+      }
+
+      // Sum the counts of each CPU, scaling each one by the fraction
+      // of the time the counter was actually on the PMU.
+      double total = 0;
+
+      foreach (int fd, counters.fds[i]) {
+        struct {
+          uint64_t value;
+          uint64_t enabled;
+          uint64_t running;
+        } count;
+
+        ssize_t length = ::read(fd, &count, sizeof(count));
+
+        if (length != sizeof(count)) {
+          PLOG(WARNING) << "Failed to read perf event '" << events[i].name
+                        << "' for '" << cgroup << "'";
+          continue;
+        }
+
+        if (count.running > 0) {
+          total += static_cast<double>(count.value) *
+            count.enabled / count.running;
+        }
+      }
+
+      // The counters are never reset so the sample is the change
+      // since the previous read.
+      const double delta = std::max(0.0, total - counters.totals[i]);
+      counters.totals[i] = total;
+
+      const google::protobuf::FieldDescriptor* field =
+        statistics.GetDescriptor()->FindFieldByName(events[i].name);
+
+      CHECK_NOTNULL(field);
+
+      switch (field->type()) {
+        case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+          // The clock events count nanoseconds, whereas `perf stat`
+          // (and hence PerfStatistics) reports milliseconds.
+          reflection->SetDouble(&statistics, field, delta / 1000000);
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_UINT64:
+          reflection->SetUInt64(
+              &statistics, field, static_cast<uint64_t>(delta));
+          break;
+        default:
+          LOG(FATAL) << "Unsupported perf field type for '"
+                     << events[i].name << "'";
+      }
+    }
+
+    counters.time = now;
+
+    result.put(cgroup, statistics);
+  }
+
+  return result;
+}
+
+
 Future<Version> version()
 {
   internal::Perf* perf = new internal::Perf({"--version"});
@@ -21,11 +21,16 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
+#include <process/time.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/nothing.hpp>
+#include <stout/try.hpp>
 #include <stout/version.hpp>
 
 // For PerfStatistics protobuf.
@@ -43,6 +48,88 @@ process::Future<hashmap<std::string, mesos::PerfStatistics>> sample(
     const Duration& duration);
 
 
+// Counts perf events for a set of cgroups using perf_event_open(2)
+// directly. The counters are opened once per cgroup and kept open, so
+// reading them is a batch of read(2) calls rather than a `perf stat`
+// invocation (and text parsing) per sample. Only the events with a
+// generic kernel encoding (hardware, software and hardware cache
+// events, i.e., the fields of the PerfStatistics protobuf) can be
+// counted this way; 'sample' supports every event `perf` supports.
+//
+// Each counter is a file descriptor, and a cgroup needs one counter
+// per event per online CPU. The counters are therefore bounded by a
+// budget, past which cgroups can't be added.
+class Counters
+{
+public:
+  // Returns an error if any of the events can't be counted directly
+  // or if this host doesn't permit counting the cgroups of the
+  // perf_event 'hierarchy'. At most 'maxCounters' counters are opened.
+  static Try<process::Owned<Counters>> create(
+      const std::set<std::string>& events,
+      const std::string& hierarchy,
+      size_t maxCounters);
+
+  ~Counters();
+
+  // Starts counting the events for the cgroup at the specified path
+  // (i.e., including the perf_event subsystem mount). The cgroup is
+  // identified by 'cgroup' in the statistics returned by 'read'.
+  // Returns an error if the counters of the cgroup would exceed the
+  // budget.
+  Try<Nothing> add(const std::string& cgroup, const std::string& path);
+
+  // Stops counting the events for the specified cgroup.
+  void remove(const std::string& cgroup);
+
+  // Returns the counts of each cgroup since the previous read (or
+  // since it was added). The counts are scaled to compensate for
+  // multiplexing, as `perf stat` does.
+  hashmap<std::string, mesos::PerfStatistics> read();
+
+private:
+  struct Event
+  {
+    std::string name; // Normalized, i.e., the PerfStatistics field.
+    uint32_t type;
+    uint64_t config;
+  };
+
+  struct Cgroup
+  {
+    // The counter for each event on each online CPU, indexed by
+    // event first.
+    std::vector<std::vector<int>> fds;
+
+    // The (scaled) totals of each event as of the previous read.
+    std::vector<double> totals;
+
+    process::Time time;
+  };
+
+  Counters(
+      const std::vector<Event>& events,
+      const std::vector<int>& cpus,
+      size_t maxCounters);
+
+  Counters(const Counters&) = delete;
+  Counters& operator=(const Counters&) = delete;
+
+  // Closes the counters of the cgroup, returning how many there were.
+  static size_t close(const Cgroup& cgroup);
+
+  const std::vector<Event> events;
+  const std::vector<int> cpus;
+
+  const size_t maxCounters;
+
+  // Number of counters currently open.
+  size_t opened;
+
+  hashmap<std::string, Cgroup> cgroups;
+};
+
+
 // Validate a set of events are accepted by `perf stat`.
 bool valid(const std::set<std::string>& events);
 
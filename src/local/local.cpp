@@ -226,7 +226,8 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
           set<UPID>(),
           masterFlags.log_auto_initialize,
           "registrar/");
-      storage = new mesos::state::LogStorage(log);
+      storage = new mesos::state::LogStorage(
+          log, 0, masterFlags.registry_log_write_window);
 #endif // __WINDOWS__
     } else {
       EXIT(EXIT_FAILURE)
@@ -17,14 +17,17 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <deque>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 
 #include "log/catchup.hpp"
@@ -35,6 +38,7 @@
 
 using namespace process;
 
+using std::deque;
 using std::string;
 
 namespace mesos {
@@ -47,11 +51,13 @@ public:
   CoordinatorProcess(
       size_t _quorum,
       const Shared<Replica>& _replica,
-      const Shared<Network>& _network)
+      const Shared<Network>& _network,
+      size_t _window)
     : ProcessBase(ID::generate("log-coordinator")),
       quorum(_quorum),
       replica(_replica),
       network(_network),
+      window(_window),
       state(INITIAL),
       proposal(0),
       index(0) {}
@@ -68,7 +74,7 @@ protected:
   virtual void finalize()
   {
     electing.discard();
-    writing.discard();
+    abortWrites(None());
   }
 
 private:
@@ -93,21 +99,27 @@ private:
   /////////////////////////////////
 
   Future<Option<uint64_t>> write(const Action& action);
+  void startWrites();
   Future<WriteResponse> runWritePhase(const Action& action);
   Future<Option<uint64_t>> checkWritePhase(
       const Action& action,
       const WriteResponse& response);
   Future<Nothing> runLearnPhase(const Action& action);
   Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t>> updateIndexAfterWritten(bool missing);
+  Future<Option<uint64_t>> updateIndexAfterWritten(
+      const Action& action,
+      bool missing);
   void writingFinished();
-  void writingFailed();
-  void writingAborted();
+  void writingDiscarded(uint64_t position);
+  void abortWrites(const Option<string>& failure);
 
   const size_t quorum;
   const Shared<Replica> replica;
   const Shared<Network> network;
 
+  // The maximum number of writes in flight at once.
+  const size_t window;
+
   // The current state of the coordinator. A coordinator needs to be
   // elected first to perform append and truncate operations. If one
   // tries to do an append or a truncate while the coordinator is not
@@ -131,7 +143,26 @@ private:
   uint64_t index;
 
   Future<Option<uint64_t>> electing;
-  Future<Option<uint64_t>> writing;
+
+  // A write that has been assigned a position in the log. Writes are
+  // started in order of their positions, at most 'window' at a time,
+  // and are completed in that same order (so a write never completes
+  // before the writes at preceding positions).
+  struct Write
+  {
+    Action action;
+
+    // The result of the write itself; none until it is started.
+    Option<Future<Option<uint64_t>>> future;
+
+    // The result returned to the caller, set in order of positions.
+    Owned<process::Promise<Option<uint64_t>>> promise;
+  };
+
+  // The writes started or waiting to be started, in order of their
+  // positions. The coordinator is in WRITING state iff this is not
+  // empty.
+  deque<Write> writes;
 };
 
 
@@ -307,8 +338,6 @@ Future<Option<uint64_t>> CoordinatorProcess::append(const string& bytes)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
@@ -327,8 +356,6 @@ Future<Option<uint64_t>> CoordinatorProcess::truncate(uint64_t to)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
@@ -348,18 +375,48 @@ Future<Option<uint64_t>> CoordinatorProcess::write(const Action& action)
   LOG(INFO) << "Coordinator attempting to write " << action.type()
             << " action at position " << action.position();
 
-  CHECK_EQ(state, ELECTED);
+  CHECK(state == ELECTED || state == WRITING);
+  CHECK_EQ(action.position(), index);
   CHECK(action.has_performed() && action.has_type());
 
   state = WRITING;
+  index++;
+
+  Write write;
+  write.action = action;
+  write.promise.reset(new process::Promise<Option<uint64_t>>());
+
+  Future<Option<uint64_t>> future = write.promise->future();
+
+  writes.push_back(write);
 
-  writing = runWritePhase(action)
-    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
-    .onFailed(defer(self(), &Self::writingFailed))
-    .onDiscarded(defer(self(), &Self::writingAborted));
+  future.onDiscard(
+      defer(self(), &Self::writingDiscarded, action.position()));
 
-  return writing;
+  startWrites();
+
+  return future;
+}
+
+
+void CoordinatorProcess::startWrites()
+{
+  size_t started = 0;
+
+  foreach (Write& write, writes) {
+    if (started >= window) {
+      break;
+    }
+
+    if (write.future.isNone()) {
+      write.future = runWritePhase(write.action)
+        .then(defer(self(), &Self::checkWritePhase, write.action, lambda::_1));
+
+      write.future->onAny(defer(self(), &Self::writingFinished));
+    }
+
+    started++;
+  }
 }
 
 
@@ -383,7 +440,7 @@ Future<Option<uint64_t>> CoordinatorProcess::checkWritePhase(
 
   return runLearnPhase(action)
     .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
+    .then(defer(self(), &Self::updateIndexAfterWritten, action, lambda::_1));
 }
 
 
@@ -403,38 +460,102 @@ Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
 
 
 Future<Option<uint64_t>> CoordinatorProcess::updateIndexAfterWritten(
+    const Action& action,
     bool missing)
 {
   CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+                  << action.position() << " after the writing is done";
 
-  return index++;
+  // NOTE: The index was already advanced when the write was started.
+  return action.position();
 }
 
 
 void CoordinatorProcess::writingFinished()
 {
-  CHECK_EQ(state, WRITING);
-  state = ELECTED;
+  // Complete the finished writes in order of their positions.
+  while (!writes.empty() &&
+         writes.front().future.isSome() &&
+         !writes.front().future->isPending()) {
+    CHECK_EQ(state, WRITING);
+
+    const Write write = writes.front();
+    const Future<Option<uint64_t>>& future = write.future.get();
+
+    if (future.isReady() && future->isSome()) {
+      writes.pop_front();
+      write.promise->set(future.get());
+      continue;
+    }
+
+    // Demote the coordinator if a write fails or is discarded since
+    // we don't actually know whether it was successful or not and we
+    // really need to "catch-up" that position before we try and do
+    // another write (see MESOS-1038 for more details). The same is
+    // true for all the writes that follow it.
+    if (future.isFailed()) {
+      abortWrites(future.failure());
+    } else {
+      abortWrites(None());
+    }
+    return;
+  }
+
+  if (writes.empty()) {
+    if (state == WRITING) {
+      state = ELECTED;
+    }
+    return;
+  }
+
+  startWrites();
 }
 
 
-void CoordinatorProcess::writingFailed()
+void CoordinatorProcess::writingDiscarded(uint64_t position)
 {
-  CHECK_EQ(state, WRITING);
-  state = INITIAL;
+  foreach (Write& write, writes) {
+    if (write.action.position() == position) {
+      if (write.future.isSome()) {
+        write.future->discard();
+      } else {
+        // The write hasn't been started yet so there is nothing to
+        // discard. We still need to give up on it (and all the writes
+        // after it) since its position has been taken.
+        abortWrites(None());
+      }
+      return;
+    }
+  }
 }
 
 
-void CoordinatorProcess::writingAborted()
+void CoordinatorProcess::abortWrites(const Option<string>& failure)
 {
-  CHECK_EQ(state, WRITING);
+  if (state == WRITING) {
+    state = INITIAL;
+  }
 
-  // Demote the coordinator if a write operation is discarded since we
-  // don't actually know the write was successful or not and we really
-  // need to "catch-up" that position before we try and do another
-  // write (see MESOS-1038 for more details).
-  state = INITIAL;
+  // Callbacks on the promises might start new writes (although the
+  // coordinator must be elected again first), so clear the writes
+  // before completing them.
+  deque<Write> aborted;
+  std::swap(aborted, writes);
+
+  foreach (const Write& write, aborted) {
+    if (write.future.isSome()) {
+      Future<Option<uint64_t>> future = write.future.get();
+      future.discard();
+    }
+
+    if (write.promise->future().hasDiscard()) {
+      write.promise->discard();
+    } else if (failure.isSome()) {
+      write.promise->fail(failure.get());
+    } else {
+      write.promise->set(Option<uint64_t>::none());
+    }
+  }
 }
 
 
@@ -446,9 +567,12 @@ void CoordinatorProcess::writingAborted()
 Coordinator::Coordinator(
     size_t quorum,
     const Shared<Replica>& replica,
-    const Shared<Network>& network)
+    const Shared<Network>& network,
+    size_t window)
 {
-  process = new CoordinatorProcess(quorum, replica, network);
+  CHECK_GT(window, 0u);
+
+  process = new CoordinatorProcess(quorum, replica, network, window);
   spawn(process);
 }
 
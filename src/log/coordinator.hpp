@@ -40,10 +40,14 @@ class CoordinatorProcess;
 class Coordinator
 {
 public:
+  // The coordinator keeps up to 'window' writes (appends or
+  // truncates) in flight at once; any further writes are queued.
+  // Writes always complete in the order they were requested.
   Coordinator(
       size_t quorum,
       const process::Shared<Replica>& replica,
-      const process::Shared<Network>& network);
+      const process::Shared<Network>& network,
+      size_t window = 1);
 
   ~Coordinator();
 
@@ -55,12 +59,14 @@ public:
   // Handles coordinator demotion. Returns the last committed (a.k.a.,
   // learned) log position if the operation succeeds. One should only
   // call this function if the coordinator has been elected, and no
-  // write (append or truncate) is in progress.
+  // write (append or truncate) is in progress or queued.
   process::Future<uint64_t> demote();
 
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
-  // if the coordinator was demoted.
+  // if the coordinator was demoted. If a write fails or the
+  // coordinator is demoted, all the writes after it that are still
+  // in flight or queued fail or return none as well.
   process::Future<Option<uint64_t>> append(const std::string& bytes);
 
   // Removes all log entries preceding the log entry at the given
@@ -25,6 +25,7 @@
 
 #include <stout/check.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
@@ -33,6 +34,7 @@
 #include "log/leveldb.hpp"
 
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -126,10 +128,37 @@ static string encode(uint64_t position, bool adjust = true)
 // }
 
 
+// Number of actions persisted between two checkpoints of the index.
+// This bounds the number of records read during recovery.
+static const size_t CHECKPOINT_INTERVAL = 1024;
+
+
+// Updates the summary of the log to include the specified action.
+static void update(Storage::State* state, const Action& action)
+{
+  if (action.has_learned() && action.learned()) {
+    state->learned.insert(action.position());
+    state->unlearned.erase(action.position());
+    if (action.has_type() && action.type() == Action::TRUNCATE) {
+      state->begin = std::max(state->begin, action.truncate().to());
+    }
+  } else {
+    state->learned.erase(action.position());
+    state->unlearned.insert(action.position());
+  }
+  state->end = std::max(state->end, action.position());
+}
+
+
 LevelDBStorage::LevelDBStorage()
-  : db(nullptr), first(None())
+  : db(nullptr),
+    first(None()),
+    hasMetadata(false),
+    indexed(false),
+    uncheckpointed(0)
 {
-  // Nothing to see here.
+  summary.begin = 0;
+  summary.end = 0;
 }
 
 
@@ -180,6 +209,144 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   VLOG(1) << "Compacted db in " << stopwatch.elapsed();
 
+  Try<bool> recovered = recover();
+
+  if (recovered.isSome() && recovered.get()) {
+    return summary;
+  }
+
+  // Fall back to reading every record, which is always correct
+  // (e.g., the log was written by a version without an index).
+  if (recovered.isError()) {
+    LOG(WARNING) << "Failed to recover the log from its index, "
+                 << "reading all records instead: " << recovered.error();
+  }
+
+  Try<Nothing> scanned = scan();
+
+  if (scanned.isError()) {
+    return Error(scanned.error());
+  }
+
+  // Checkpoint the index right away so that the next recovery does
+  // not need to read every record again. This is an optimization so
+  // failing to do so is not fatal.
+  if (hasMetadata) {
+    Try<Nothing> persisted = persist(summary.metadata);
+
+    if (persisted.isError()) {
+      LOG(WARNING) << "Failed to checkpoint the log index: "
+                   << persisted.error();
+    }
+  }
+
+  return summary;
+}
+
+
+Try<bool> LevelDBStorage::recover()
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  string value;
+
+  leveldb::Status status =
+    db->Get(leveldb::ReadOptions(), encode(0, false), &value);
+
+  if (status.IsNotFound()) {
+    return false;
+  } else if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  Record record;
+
+  if (!record.ParseFromString(value)) {
+    return Error("Failed to deserialize record");
+  }
+
+  if (record.type() != Record::METADATA ||
+      !record.has_metadata() ||
+      !record.has_index()) {
+    return false;
+  }
+
+  const Index& index = record.index();
+
+  State state;
+  state.metadata.CopyFrom(record.metadata());
+  state.begin = index.begin();
+  state.end = index.end();
+
+  foreach (const Index::Interval& interval, index.learned()) {
+    state.learned += (Bound<uint64_t>::closed(interval.begin()),
+                      Bound<uint64_t>::open(interval.end()));
+  }
+
+  foreach (const Index::Interval& interval, index.unlearned()) {
+    state.unlearned += (Bound<uint64_t>::closed(interval.begin()),
+                        Bound<uint64_t>::open(interval.end()));
+  }
+
+  Option<uint64_t> _first = None();
+  if (index.has_first()) {
+    _first = index.first();
+  }
+
+  // The index covers every position up to its ending position (if it
+  // covers any position at all), so only the records written after
+  // it need to be read.
+  leveldb::Iterator* iterator = db->NewIterator(leveldb::ReadOptions());
+
+  iterator->Seek(encode(_first.isSome() ? index.end() + 1 : 0));
+
+  uint64_t keys = 0;
+
+  while (iterator->Valid()) {
+    keys++;
+    const leveldb::Slice& slice = iterator->value();
+
+    google::protobuf::io::ArrayInputStream stream(slice.data(), slice.size());
+
+    Record entry;
+
+    if (!entry.ParseFromZeroCopyStream(&stream) ||
+        entry.type() != Record::ACTION ||
+        !entry.has_action()) {
+      delete iterator;
+      return Error("Unexpected record after the index");
+    }
+
+    update(&state, entry.action());
+    _first = min(_first, entry.action().position());
+
+    iterator->Next();
+  }
+
+  delete iterator;
+
+  VLOG(1) << "Recovered the log from its index and " << keys
+          << " keys in the db in " << stopwatch.elapsed();
+
+  summary = state;
+  first = _first;
+  hasMetadata = true;
+  indexed = true;
+  uncheckpointed = keys;
+
+  if (index.has_first()) {
+    checkpointed = index.end();
+  }
+
+  return true;
+}
+
+
+Try<Nothing> LevelDBStorage::scan()
+{
+  Stopwatch stopwatch;
+
   State state;
   state.begin = 0;
   state.end = 0;
@@ -214,6 +381,7 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
     Record record;
 
     if (!record.ParseFromZeroCopyStream(&stream)) {
+      delete iterator;
       return Error("Failed to deserialize record");
     }
 
@@ -221,6 +389,7 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
       case Record::METADATA: {
         CHECK(record.has_metadata());
         state.metadata.CopyFrom(record.metadata());
+        hasMetadata = true;
         break;
       }
 
@@ -238,17 +407,7 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
       case Record::ACTION: {
         CHECK(record.has_action());
         const Action& action = record.action();
-        if (action.has_learned() && action.learned()) {
-          state.learned.insert(action.position());
-          state.unlearned.erase(action.position());
-          if (action.has_type() && action.type() == Action::TRUNCATE) {
-            state.begin = std::max(state.begin, action.truncate().to());
-          }
-        } else {
-          state.learned.erase(action.position());
-          state.unlearned.insert(action.position());
-        }
-        state.end = std::max(state.end, action.position());
+        update(&state, action);
 
         // Cache the first position in this replica so during a
         // truncation, we can attempt to delete all positions from the
@@ -261,6 +420,7 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
       }
 
       default: {
+        delete iterator;
         return Error("Bad record");
       }
     }
@@ -273,7 +433,35 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   delete iterator;
 
-  return state;
+  summary = state;
+
+  return Nothing();
+}
+
+
+Index LevelDBStorage::index() const
+{
+  Index index;
+  index.set_begin(summary.begin);
+  index.set_end(summary.end);
+
+  if (first.isSome()) {
+    index.set_first(first.get());
+  }
+
+  foreach (const Interval<uint64_t>& interval, summary.learned) {
+    Index::Interval* learned = index.add_learned();
+    learned->set_begin(interval.lower());
+    learned->set_end(interval.upper());
+  }
+
+  foreach (const Interval<uint64_t>& interval, summary.unlearned) {
+    Index::Interval* unlearned = index.add_unlearned();
+    unlearned->set_begin(interval.lower());
+    unlearned->set_end(interval.upper());
+  }
+
+  return index;
 }
 
 
@@ -285,9 +473,12 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
   leveldb::WriteOptions options;
   options.sync = true;
 
+  // The index is checkpointed along with the metadata (see
+  // 'LevelDBStorage::recover').
   Record record;
   record.set_type(Record::METADATA);
   record.mutable_metadata()->CopyFrom(metadata);
+  record.mutable_index()->CopyFrom(index());
 
   string value;
 
@@ -301,6 +492,13 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
     return Error(status.ToString());
   }
 
+  summary.metadata.CopyFrom(metadata);
+  hasMetadata = true;
+
+  indexed = true;
+  checkpointed = first.isSome() ? Option<uint64_t>(summary.end) : None();
+  uncheckpointed = 0;
+
   VLOG(1) << "Persisting metadata (" << value.size()
           << " bytes) to leveldb took " << stopwatch.elapsed();
 
@@ -309,38 +507,115 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
 
 
 Try<Nothing> LevelDBStorage::persist(const Action& action)
+{
+  return persist(vector<Action>{action});
+}
+
+
+Try<Nothing> LevelDBStorage::persist(const vector<Action>& actions)
 {
   Stopwatch stopwatch;
   stopwatch.start();
 
-  Record record;
-  record.set_type(Record::ACTION);
-  record.mutable_action()->MergeFrom(action);
+  // All the actions are written with a single synchronous write so
+  // that a batch of actions pays for only one sync to disk.
+  leveldb::WriteBatch batch;
+
+  size_t bytes = 0;
+
+  // Update the summary of the log up front so that it can be
+  // checkpointed in the same batch, and roll it back if the write
+  // fails. Notice that we use 'min' to update the first position
+  // instead of checking 'isNone()' because it's likely that log
+  // entries are written out of order during catch-up (e.g. if a
+  // random bulk catch-up policy is used).
+  const State previous = summary;
+  const Option<uint64_t> previousFirst = first;
+
+  // The index only covers the positions up to its ending position,
+  // so it must be checkpointed again whenever one of those positions
+  // is overwritten (e.g., when an action is learned). Otherwise, it
+  // is checkpointed periodically to bound the number of records read
+  // during recovery. The index is stored with the metadata, so there
+  // is nothing to checkpoint until the metadata has been persisted.
+  bool checkpointing =
+    hasMetadata &&
+    (!indexed || uncheckpointed + actions.size() >= CHECKPOINT_INTERVAL);
+
+  foreach (const Action& action, actions) {
+    Record record;
+    record.set_type(Record::ACTION);
+    record.mutable_action()->MergeFrom(action);
 
-  string value;
+    string value;
 
-  if (!record.SerializeToString(&value)) {
-    return Error("Failed to serialize record");
+    if (!record.SerializeToString(&value)) {
+      summary = previous;
+      first = previousFirst;
+      return Error("Failed to serialize record");
+    }
+
+    batch.Put(encode(action.position()), value);
+    bytes += value.size();
+
+    update(&summary, action);
+    first = min(first, action.position());
+
+    if (checkpointed.isSome() && action.position() <= checkpointed.get()) {
+      checkpointing = hasMetadata;
+    }
+  }
+
+  if (checkpointing) {
+    Record record;
+    record.set_type(Record::METADATA);
+    record.mutable_metadata()->CopyFrom(summary.metadata);
+    record.mutable_index()->CopyFrom(index());
+
+    string value;
+
+    if (!record.SerializeToString(&value)) {
+      summary = previous;
+      first = previousFirst;
+      return Error("Failed to serialize record");
+    }
+
+    batch.Put(encode(0, false), value);
+    bytes += value.size();
   }
 
   leveldb::WriteOptions options;
   options.sync = true;
 
-  leveldb::Status status = db->Put(options, encode(action.position()), value);
+  leveldb::Status status = db->Write(options, &batch);
 
   if (!status.ok()) {
+    summary = previous;
+    first = previousFirst;
     return Error(status.ToString());
   }
 
-  // Updated the first position. Notice that we use 'min' here instead
-  // of checking 'isNone()' because it's likely that log entries are
-  // written out of order during catch-up (e.g. if a random bulk
-  // catch-up policy is used).
-  first = min(first, action.position());
+  if (checkpointing) {
+    indexed = true;
+    checkpointed = first.isSome() ? Option<uint64_t>(summary.end) : None();
+    uncheckpointed = 0;
+  } else {
+    uncheckpointed += actions.size();
+  }
 
-  VLOG(1) << "Persisting action (" << value.size()
+  VLOG(1) << "Persisting " << actions.size() << " action(s) (" << bytes
           << " bytes) to leveldb took " << stopwatch.elapsed();
 
+  foreach (const Action& action, actions) {
+    truncate(action);
+  }
+
+  return Nothing();
+}
+
+
+void LevelDBStorage::truncate(const Action& action)
+{
   // Delete positions if a truncate action has been *learned*. Note
   // that we do this in a best-effort fashion (i.e., we ignore any
   // failures to the database since we can always try again).
@@ -348,7 +623,8 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
       action.has_learned() && action.learned()) {
     CHECK(action.has_truncate());
 
-    stopwatch.start(); // Restart the stopwatch.
+    Stopwatch stopwatch;
+    stopwatch.start();
 
     // To actually perform the truncation in leveldb we need to remove
     // all the keys that represent positions no longer in the log. We
@@ -401,8 +677,6 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
       }
     }
   }
-
-  return Nothing();
 }
 
 
@@ -21,6 +21,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include <stout/option.hpp>
 
 #include "log/storage.hpp"
@@ -39,13 +41,47 @@ public:
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::vector<Action>& actions);
   virtual Try<Action> read(uint64_t position);
 
 private:
+  // Recovers the summary of the log from the checkpointed index and
+  // the records written after it. Returns false if there is no index.
+  Try<bool> recover();
+
+  // Recovers the summary of the log by reading every record.
+  Try<Nothing> scan();
+
+  // Returns the index to checkpoint for the current summary.
+  Index index() const;
+
+  // Deletes the positions made obsolete by the specified action if it
+  // is a learned truncation. Done in a best-effort fashion.
+  void truncate(const Action& action);
+
   leveldb::DB* db;
 
   // First position still in leveldb, used during truncation.
   Option<uint64_t> first;
+
+  // Summary of the log (i.e., the state returned by 'restore'), kept
+  // up to date as actions are persisted so it can be checkpointed.
+  State summary;
+
+  // Whether the metadata has been persisted. The index is stored in
+  // the metadata record, so it can't be checkpointed before then.
+  bool hasMetadata;
+
+  // Whether the index stored in leveldb is up to date, i.e., it has
+  // been checkpointed since the log was last recovered without one.
+  bool indexed;
+
+  // The ending position covered by the last checkpoint of the index,
+  // if it covered any position.
+  Option<uint64_t> checkpointed;
+
+  // Number of actions persisted since the last checkpoint.
+  size_t uncheckpointed;
 };
 
 } // namespace log {
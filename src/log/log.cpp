@@ -67,10 +67,11 @@ LogProcess::LogProcess(
     const string& path,
     const set<UPID>& pids,
     bool _autoInitialize,
-    const Option<string>& metricsPrefix)
+    const Option<string>& metricsPrefix,
+    const Option<Log::GroupCommit>& groupCommit)
   : ProcessBase(ID::generate("log")),
     quorum(_quorum),
-    replica(new Replica(path)),
+    replica(new Replica(path, groupCommit)),
     network(new Network(pids + (UPID) replica->pid())),
     autoInitialize(_autoInitialize),
     group(nullptr),
@@ -85,10 +86,11 @@ LogProcess::LogProcess(
     const string& znode,
     const Option<zookeeper::Authentication>& auth,
     bool _autoInitialize,
-    const Option<string>& metricsPrefix)
+    const Option<string>& metricsPrefix,
+    const Option<Log::GroupCommit>& groupCommit)
   : ProcessBase(ID::generate("log")),
     quorum(_quorum),
-    replica(new Replica(path)),
+    replica(new Replica(path, groupCommit)),
     network(new ZooKeeperNetwork(
         servers,
         timeout,
@@ -459,10 +461,11 @@ Log::Position LogReaderProcess::position(uint64_t value)
 /////////////////////////////////////////////////
 
 
-LogWriterProcess::LogWriterProcess(Log* log)
+LogWriterProcess::LogWriterProcess(Log* log, size_t _window)
   : ProcessBase(ID::generate("log-writer")),
     quorum(log->process->quorum),
     network(log->process->network),
+    window(_window),
     recovering(dispatch(log->process, &LogProcess::recover)),
     coordinator(nullptr),
     error(None()) {}
@@ -548,7 +551,7 @@ Future<Option<Log::Position>> LogWriterProcess::_start()
 
   CHECK_READY(recovering);
 
-  coordinator = new Coordinator(quorum, recovering.get(), network);
+  coordinator = new Coordinator(quorum, recovering.get(), network, window);
 
   LOG(INFO) << "Attempting to start the writer";
 
@@ -640,7 +643,8 @@ Log::Log(
     const string& path,
     const set<UPID>& pids,
     bool autoInitialize,
-    const Option<string>& metricsPrefix)
+    const Option<string>& metricsPrefix,
+    const Option<Log::GroupCommit>& groupCommit)
 {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
@@ -650,7 +654,8 @@ Log::Log(
         path,
         pids,
         autoInitialize,
-        metricsPrefix);
+        metricsPrefix,
+        groupCommit);
 
   spawn(process);
 }
@@ -664,7 +669,8 @@ Log::Log(
     const string& znode,
     const Option<zookeeper::Authentication>& auth,
     bool autoInitialize,
-    const Option<string>& metricsPrefix)
+    const Option<string>& metricsPrefix,
+    const Option<Log::GroupCommit>& groupCommit)
 {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
@@ -677,7 +683,8 @@ Log::Log(
         znode,
         auth,
         autoInitialize,
-        metricsPrefix);
+        metricsPrefix,
+        groupCommit);
 
   spawn(process);
 }
@@ -736,9 +743,9 @@ Future<Log::Position> Log::Reader::ending()
 /////////////////////////////////////////////////
 
 
-Log::Writer::Writer(Log* log)
+Log::Writer::Writer(Log* log, size_t window)
 {
-  process = new LogWriterProcess(log);
+  process = new LogWriterProcess(log, window);
   spawn(process);
 }
 
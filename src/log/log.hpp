@@ -47,7 +47,8 @@ public:
       const std::string& path,
       const std::set<process::UPID>& pids,
       bool _autoInitialize,
-      const Option<std::string>& metricsPrefix);
+      const Option<std::string>& metricsPrefix,
+      const Option<mesos::log::Log::GroupCommit>& groupCommit);
 
   LogProcess(
       size_t _quorum,
@@ -57,7 +58,8 @@ public:
       const std::string& znode,
       const Option<zookeeper::Authentication>& auth,
       bool _autoInitialize,
-      const Option<std::string>& metricsPrefix);
+      const Option<std::string>& metricsPrefix,
+      const Option<mesos::log::Log::GroupCommit>& groupCommit);
 
   // Recovers the log by catching up if needed. Returns a shared
   // pointer to the local replica if the recovery succeeds.
@@ -160,7 +162,7 @@ private:
 class LogWriterProcess : public process::Process<LogWriterProcess>
 {
 public:
-  explicit LogWriterProcess(mesos::log::Log* log);
+  LogWriterProcess(mesos::log::Log* log, size_t window);
 
   process::Future<Option<mesos::log::Log::Position>> start();
   process::Future<Option<mesos::log::Log::Position>> append(
@@ -192,6 +194,7 @@ private:
 
   const size_t quorum;
   const process::Shared<Network> network;
+  const size_t window;
 
   process::Future<process::Shared<Replica>> recovering;
   std::list<process::Promise<Nothing>*> promises;
@@ -17,11 +17,15 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
+#include <process/clock.hpp>
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/timer.hpp>
 
 #include <stout/check.hpp>
 #include <stout/error.hpp>
@@ -43,6 +47,9 @@ using namespace process;
 
 using std::list;
 using std::string;
+using std::vector;
+
+using mesos::log::Log;
 
 namespace mesos {
 namespace internal {
@@ -63,7 +70,9 @@ class ReplicaProcess : public ProtobufProcess<ReplicaProcess>
 public:
   // Constructs a new replica process using specified path to a
   // directory for storing the underlying log.
-  explicit ReplicaProcess(const string& path);
+  ReplicaProcess(
+      const string& path,
+      const Option<Log::GroupCommit>& groupCommit);
 
   virtual ~ReplicaProcess();
 
@@ -103,6 +112,9 @@ public:
   // to storage. Returns true on success and false otherwise.
   bool update(const Metadata::Status& status);
 
+protected:
+  virtual void finalize();
+
 private:
   // Handles a request from a proposer to promise not to accept writes
   // from any other proposer with lower proposal number.
@@ -121,6 +133,26 @@ private:
   // and false otherwise.
   bool persist(const Action& action);
 
+  // Updates the in-memory state of the log (holes, unlearned
+  // positions, beginning and ending) after the specified action has
+  // been persisted to storage.
+  void _persist(const Action& action);
+
+  // Persists the specified action and then replies to 'from' with
+  // the specified response. With group commit enabled the action is
+  // queued and the reply is sent only once the batch it belongs to
+  // has been persisted (see 'flush').
+  void commit(
+      const UPID& from,
+      const Action& action,
+      const Option<WriteResponse>& response);
+
+  // Persists all the queued actions with a single write to storage
+  // and sends their replies. Any handler that reads the log or the
+  // metadata must flush first so that requests observe the same
+  // state they would have if each write was persisted immediately.
+  void flush();
+
   // Updates the highest promise this replica has given. The update
   // will be persisted to storage. Returns true on success and false
   // otherwise.
@@ -147,13 +179,34 @@ private:
 
   // Unlearned positions in the log.
   IntervalSet<uint64_t> unlearned;
+
+  const Option<Log::GroupCommit> groupCommit;
+
+  // Writes waiting for the next group commit.
+  struct PendingWrite
+  {
+    Action action;
+    UPID from;
+
+    // The response to send once the action is durable; none for
+    // learned notices, which are not acknowledged.
+    Option<WriteResponse> response;
+  };
+
+  vector<PendingWrite> pending;
+
+  // Fires 'flush' once the group commit window elapses.
+  Option<Timer> timer;
 };
 
 
-ReplicaProcess::ReplicaProcess(const string& path)
+ReplicaProcess::ReplicaProcess(
+    const string& path,
+    const Option<Log::GroupCommit>& _groupCommit)
   : ProcessBase(ID::generate("log-replica")),
     begin(0),
-    end(0)
+    end(0),
+    groupCommit(_groupCommit)
 {
   // TODO(benh): Factor out and expose storage.
   storage = new LevelDBStorage();
@@ -182,6 +235,13 @@ ReplicaProcess::~ReplicaProcess()
 }
 
 
+void ReplicaProcess::finalize()
+{
+  // Don't drop writes that have been accepted but not yet persisted.
+  flush();
+}
+
+
 Result<Action> ReplicaProcess::read(uint64_t position)
 {
   if (position < begin) {
@@ -207,6 +267,8 @@ Result<Action> ReplicaProcess::read(uint64_t position)
 // the future semantics to not include failures.
 Future<list<Action>> ReplicaProcess::read(uint64_t from, uint64_t to)
 {
+  flush();
+
   if (to < from) {
     process::Promise<list<Action>> promise;
     promise.fail("Bad read range (to < from)");
@@ -244,6 +306,8 @@ Future<list<Action>> ReplicaProcess::read(uint64_t from, uint64_t to)
 
 bool ReplicaProcess::missing(uint64_t position)
 {
+  flush();
+
   if (position < begin) {
     return false; // Truncated positions are treated as learned.
   } else if (position > end) {
@@ -257,6 +321,8 @@ bool ReplicaProcess::missing(uint64_t position)
 // TODO(jieyu): Allow this method to take an Interval.
 IntervalSet<uint64_t> ReplicaProcess::missing(uint64_t from, uint64_t to)
 {
+  flush();
+
   if (from > to) {
     // Empty interval.
     return IntervalSet<uint64_t>();
@@ -284,12 +350,16 @@ IntervalSet<uint64_t> ReplicaProcess::missing(uint64_t from, uint64_t to)
 
 uint64_t ReplicaProcess::beginning()
 {
+  flush();
+
   return begin;
 }
 
 
 uint64_t ReplicaProcess::ending()
 {
+  flush();
+
   return end;
 }
 
@@ -308,6 +378,8 @@ uint64_t ReplicaProcess::promised()
 
 bool ReplicaProcess::update(const Metadata::Status& status)
 {
+  flush();
+
   Metadata metadata_;
   metadata_.set_status(status);
   metadata_.set_promised(promised());
@@ -372,6 +444,10 @@ bool ReplicaProcess::updatePromised(uint64_t promised)
 
 void ReplicaProcess::promise(const UPID& from, const PromiseRequest& request)
 {
+  // A promise must not be given on top of writes that might still
+  // be persisted afterwards (e.g., with a lower proposal number).
+  flush();
+
   // Ignore promise requests if this replica is not in VOTING status;
   // we also inform the requester, so that they can retry promptly.
   if (status() != Metadata::VOTING) {
@@ -539,6 +615,15 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
   LOG(INFO) << "Replica received write request for position "
             << request.position() << " from " << from;
 
+  // The write is checked against the action currently stored at this
+  // position, so make sure any queued write to it is persisted first.
+  foreach (const PendingWrite& pendingWrite, pending) {
+    if (pendingWrite.action.position() == request.position()) {
+      flush();
+      break;
+    }
+  }
+
   Result<Action> result = read(request.position());
 
   if (result.isError()) {
@@ -577,14 +662,13 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
           LOG(FATAL) << "Unknown Action::Type!";
       }
 
-      if (persist(action)) {
-        WriteResponse response;
-        response.set_type(WriteResponse::ACCEPT);
-        response.set_okay(true);
-        response.set_proposal(request.proposal());
-        response.set_position(request.position());
-        reply(response);
-      }
+      WriteResponse response;
+      response.set_type(WriteResponse::ACCEPT);
+      response.set_okay(true);
+      response.set_proposal(request.proposal());
+      response.set_position(request.position());
+
+      commit(from, action, response);
     }
   } else if (result.isSome()) {
     Action action = result.get();
@@ -656,14 +740,13 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
             LOG(FATAL) << "Unknown Action::Type!";
         }
 
-        if (persist(action)) {
-          WriteResponse response;
-          response.set_type(WriteResponse::ACCEPT);
-          response.set_okay(true);
-          response.set_proposal(request.proposal());
-          response.set_position(request.position());
-          reply(response);
-        }
+        WriteResponse response;
+        response.set_type(WriteResponse::ACCEPT);
+        response.set_okay(true);
+        response.set_proposal(request.proposal());
+        response.set_position(request.position());
+
+        commit(from, action, response);
       }
     }
   }
@@ -676,6 +759,8 @@ void ReplicaProcess::recover(const UPID& from, const RecoverRequest& request)
             << " status received a broadcasted recover request from "
             << from;
 
+  flush();
+
   RecoverResponse response;
   response.set_status(status());
 
@@ -694,7 +779,7 @@ void ReplicaProcess::learned(const UPID& from, const Action& action)
             << action.position() << " from " << from;
 
   CHECK(action.learned());
-  persist(action);
+  commit(from, action, None());
 }
 
 
@@ -710,6 +795,14 @@ bool ReplicaProcess::persist(const Action& action)
   VLOG(1) << "Persisted action " << action.type()
           << " at position " << action.position();
 
+  _persist(action);
+
+  return true;
+}
+
+
+void ReplicaProcess::_persist(const Action& action)
+{
   // No longer a hole here (if there even was one).
   holes -= action.position();
 
@@ -744,8 +837,71 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
+}
 
-  return true;
+
+void ReplicaProcess::commit(
+    const UPID& from,
+    const Action& action,
+    const Option<WriteResponse>& response)
+{
+  if (groupCommit.isNone()) {
+    if (persist(action) && response.isSome()) {
+      send(from, response.get());
+    }
+    return;
+  }
+
+  pending.push_back(PendingWrite{action, from, response});
+
+  if (pending.size() >= groupCommit->maxActions) {
+    flush();
+  } else if (timer.isNone()) {
+    timer = delay(groupCommit->window, self(), &ReplicaProcess::flush);
+  }
+}
+
+
+void ReplicaProcess::flush()
+{
+  if (timer.isSome()) {
+    Clock::cancel(timer.get());
+    timer = None();
+  }
+
+  if (pending.empty()) {
+    return;
+  }
+
+  vector<PendingWrite> writes;
+  std::swap(writes, pending);
+
+  vector<Action> actions;
+  actions.reserve(writes.size());
+
+  foreach (const PendingWrite& pendingWrite, writes) {
+    actions.push_back(pendingWrite.action);
+  }
+
+  Try<Nothing> persisted = storage->persist(actions);
+
+  if (persisted.isError()) {
+    // As with a single write, we don't reply to any of the requests
+    // (see the comment on error handling above).
+    LOG(ERROR) << "Error writing " << actions.size()
+               << " actions to log: " << persisted.error();
+    return;
+  }
+
+  VLOG(1) << "Persisted " << actions.size() << " actions in a single write";
+
+  foreach (const PendingWrite& pendingWrite, writes) {
+    _persist(pendingWrite.action);
+
+    if (pendingWrite.response.isSome()) {
+      send(pendingWrite.from, pendingWrite.response.get());
+    }
+  }
 }
 
 
@@ -782,9 +938,11 @@ void ReplicaProcess::restore(const string& path)
 }
 
 
-Replica::Replica(const string& path)
+Replica::Replica(
+    const string& path,
+    const Option<Log::GroupCommit>& groupCommit)
 {
-  process = new ReplicaProcess(path);
+  process = new ReplicaProcess(path, groupCommit);
   spawn(process);
 }
 
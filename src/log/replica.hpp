@@ -22,11 +22,15 @@
 #include <list>
 #include <string>
 
+#include <mesos/log/log.hpp>
+
 #include <process/future.hpp>
 #include <process/pid.hpp>
 #include <process/protobuf.hpp>
 
 #include <stout/interval.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
 
 #include "messages/log.hpp"
 
@@ -56,8 +60,12 @@ public:
   // with an empty log, it will not be allowed to vote (i.e., cannot
   // reply to any request except the recover request). The recover
   // process will later decide if this replica can be re-allowed to
-  // vote depending on the status of other replicas.
-  explicit Replica(const std::string& path);
+  // vote depending on the status of other replicas. If 'groupCommit'
+  // is set, writes are batched into a single synchronous write to
+  // storage and acknowledged once that batch is durable.
+  explicit Replica(
+      const std::string& path,
+      const Option<mesos::log::Log::GroupCommit>& groupCommit = None());
   virtual ~Replica();
 
   // Returns all the actions between the specified positions, unless
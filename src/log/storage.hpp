@@ -20,7 +20,9 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
+#include <stout/foreach.hpp>
 #include <stout/interval.hpp>
 #include <stout/nothing.hpp>
 #include <stout/try.hpp>
@@ -53,6 +55,22 @@ public:
   virtual Try<State> restore(const std::string& path) = 0;
   virtual Try<Nothing> persist(const Metadata& metadata) = 0;
   virtual Try<Nothing> persist(const Action& action) = 0;
+
+  // Persists the specified actions in order. Implementations should
+  // override this to make all of them durable with a single write;
+  // the default simply persists them one at a time.
+  virtual Try<Nothing> persist(const std::vector<Action>& actions)
+  {
+    foreach (const Action& action, actions) {
+      Try<Nothing> persisted = persist(action);
+      if (persisted.isError()) {
+        return persisted;
+      }
+    }
+
+    return Nothing();
+  }
+
   virtual Try<Action> read(uint64_t position) = 0;
 };
 
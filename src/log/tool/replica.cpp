@@ -55,6 +55,17 @@ Replica::Flags::Flags()
       "znode",
       "ZooKeeper znode");
 
+  add(&Flags::group_commit_window,
+      "group_commit_window",
+      "If set, writes received within this window are coalesced into a\n"
+      "single synchronous write to disk (and acknowledged once durable)");
+
+  add(&Flags::group_commit_max_actions,
+      "group_commit_max_actions",
+      "Maximum number of writes coalesced into a single synchronous\n"
+      "write to disk when --group_commit_window is set",
+      64);
+
   add(&Flags::initialize,
       "initialize",
       "Whether to initialize the log",
@@ -106,6 +117,11 @@ Try<Nothing> Replica::execute(int argc, char** argv)
     return Error(flags.usage("Missing required option --znode"));
   }
 
+  if (flags.group_commit_max_actions == 0) {
+    return Error(
+        flags.usage("Expected --group_commit_max_actions to be positive"));
+  }
+
   // Initialize the log.
   if (flags.initialize) {
     Initialize initialize;
@@ -117,13 +133,24 @@ Try<Nothing> Replica::execute(int argc, char** argv)
     }
   }
 
+  Option<Log::GroupCommit> groupCommit;
+  if (flags.group_commit_window.isSome()) {
+    groupCommit = Log::GroupCommit{
+        flags.group_commit_window.get(),
+        flags.group_commit_max_actions};
+  }
+
   // Create the log.
   Log log(
       flags.quorum.get(),
       flags.path.get(),
       flags.servers.get(),
       Seconds(10),
-      flags.znode.get());
+      flags.znode.get(),
+      None(),
+      false,
+      None(),
+      groupCommit);
 
   // Loop forever.
   Future<Nothing>().get();
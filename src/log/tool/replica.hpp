@@ -19,6 +19,7 @@
 
 #include <stdint.h>
 
+#include <stout/duration.hpp>
 #include <stout/flags.hpp>
 #include <stout/option.hpp>
 
@@ -44,6 +45,8 @@ public:
     Option<std::string> path;
     Option<std::string> servers;
     Option<std::string> znode;
+    Option<Duration> group_commit_window;
+    size_t group_commit_max_actions;
     bool initialize;
     bool help;
   };
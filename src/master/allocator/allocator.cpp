@@ -27,6 +27,8 @@
 using std::string;
 
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+using mesos::internal::master::allocator::HierarchicalIncrementalDRFAllocator;
+using mesos::internal::master::allocator::HierarchicalParallelDRFAllocator;
 
 namespace mesos {
 namespace allocator {
@@ -41,6 +43,14 @@ Try<Allocator*> Allocator::create(const string& name)
     return HierarchicalDRFAllocator::create();
   }
 
+  if (name == mesos::internal::master::INCREMENTAL_DRF_ALLOCATOR) {
+    return HierarchicalIncrementalDRFAllocator::create();
+  }
+
+  if (name == mesos::internal::master::PARALLEL_DRF_ALLOCATOR) {
+    return HierarchicalParallelDRFAllocator::create();
+  }
+
   return modules::ModuleManager::create<Allocator>(name);
 }
 
@@ -17,8 +17,11 @@
 #include "master/allocator/mesos/hierarchical.hpp"
 
 #include <algorithm>
+#include <functional>
+#include <iterator>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -29,6 +32,7 @@
 #include <process/dispatch.hpp>
 #include <process/event.hpp>
 #include <process/id.hpp>
+#include <process/clock.hpp>
 #include <process/timeout.hpp>
 
 #include <stout/check.hpp>
@@ -44,9 +48,11 @@ using std::vector;
 
 using mesos::allocator::InverseOfferStatus;
 
+using process::Clock;
 using process::Failure;
 using process::Future;
 using process::Owned;
+using process::Time;
 using process::Timeout;
 
 using mesos::internal::protobuf::framework::Capabilities;
@@ -64,13 +70,19 @@ public:
   virtual ~OfferFilter() {}
 
   virtual bool filter(const Resources& resources) const = 0;
+
+  // Returns true if this filter filters at least the resources that
+  // `that` filter does, for at least as long. Such a filter makes
+  // `that` redundant.
+  virtual bool subsumes(const OfferFilter& that) const = 0;
 };
 
 
 class RefusedOfferFilter : public OfferFilter
 {
 public:
-  RefusedOfferFilter(const Resources& _resources) : resources(_resources) {}
+  RefusedOfferFilter(const Resources& _resources, const Timeout& _timeout)
+    : resources(_resources), timeout(_timeout) {}
 
   virtual bool filter(const Resources& _resources) const
   {
@@ -82,8 +94,23 @@ public:
     return resources.contains(_resources); // Refused resources are superset.
   }
 
+  virtual bool subsumes(const OfferFilter& that) const
+  {
+    const RefusedOfferFilter* refused =
+      dynamic_cast<const RefusedOfferFilter*>(&that);
+
+    return refused != nullptr &&
+           timeout.time() >= refused->timeout.time() &&
+           resources.contains(refused->resources);
+  }
+
+  // NOTE: The filter does not check the timeout itself, the allocator
+  // removes the filter once it expires.
+  const Timeout& expiry() const { return timeout; }
+
 private:
   const Resources resources;
+  const Timeout timeout;
 };
 
 
@@ -286,6 +313,8 @@ void HierarchicalAllocatorProcess::removeFramework(
   CHECK(initialized);
   CHECK(frameworks.contains(frameworkId));
 
+  clearOfferFilters(frameworkId);
+
   const Framework& framework = frameworks.at(frameworkId);
 
   foreach (const string& role, framework.roles) {
@@ -368,7 +397,7 @@ void HierarchicalAllocatorProcess::deactivateFramework(
   // framework's `offerFilters` hashset yet, see comments in
   // HierarchicalAllocatorProcess::reviveOffers and
   // HierarchicalAllocatorProcess::expire.
-  framework.offerFilters.clear();
+  clearOfferFilters(frameworkId);
   framework.inverseOfferFilters.clear();
 
   LOG(INFO) << "Deactivated framework " << frameworkId;
@@ -405,9 +434,7 @@ void HierarchicalAllocatorProcess::updateFramework(
       untrackFrameworkUnderRole(frameworkId, role);
     }
 
-    if (framework.offerFilters.contains(role)) {
-      framework.offerFilters.erase(role);
-    }
+    clearOfferFilters(frameworkId, role);
   }
 
   const set<string> addedRoles = [&]() {
@@ -1152,15 +1179,6 @@ void HierarchicalAllocatorProcess::recoverResources(
             << " filtered agent " << slaveId
             << " for " << timeout.get();
 
-    // Create a new filter. Note that we unallocate the resources
-    // since filters are applied per-role already.
-    Resources unallocated = resources;
-    unallocated.unallocate();
-
-    OfferFilter* offerFilter = new RefusedOfferFilter(unallocated);
-    frameworks.at(frameworkId)
-      .offerFilters[role][slaveId].insert(offerFilter);
-
     // Expire the filter after both an `allocationInterval` and the
     // `timeout` have elapsed. This ensures that the filter does not
     // expire before we perform the next allocation for this agent,
@@ -1168,27 +1186,55 @@ void HierarchicalAllocatorProcess::recoverResources(
     //
     // Because the next batched allocation goes through a dispatch
     // after `allocationInterval`, we do the same for `expire()`
-    // (with a hepler `_expire()`) to achieve the above.
+    // (with a helper `_expireOfferFilters()`) to achieve the above.
     //
     // TODO(alexr): If we allocated upon resource recovery
     // (MESOS-3078), we would not need to increase the timeout here.
     timeout = std::max(allocationInterval, timeout.get());
 
-    // We need to disambiguate the function call to pick the correct
-    // `expire()` overload.
-    void (Self::*expireOffer)(
-        const FrameworkID&,
-        const string&,
-        const SlaveID&,
-        OfferFilter*) = &Self::expire;
-
-    delay(timeout.get(),
-          self(),
-          expireOffer,
-          frameworkId,
-          role,
-          slaveId,
-          offerFilter);
+    // Create a new filter. Note that we unallocate the resources
+    // since filters are applied per-role already.
+    Resources unallocated = resources;
+    unallocated.unallocate();
+
+    RefusedOfferFilter* offerFilter =
+      new RefusedOfferFilter(unallocated, Timeout::in(timeout.get()));
+
+    hashset<OfferFilter*>& offerFilters =
+      frameworks.at(frameworkId).offerFilters[role][slaveId];
+
+    // Frameworks which keep declining the same resources would
+    // otherwise accumulate filters, all of which we check for every
+    // allocation. Skip the new filter if an existing one makes it
+    // redundant, and remove the existing ones it makes redundant.
+    // The removed filters get deleted once they expire, see
+    // `_expireOfferFilters()`.
+    foreach (OfferFilter* existing, offerFilters) {
+      if (existing->subsumes(*offerFilter)) {
+        delete offerFilter;
+        return;
+      }
+    }
+
+    vector<OfferFilter*> redundant;
+    foreach (OfferFilter* existing, offerFilters) {
+      if (offerFilter->subsumes(*existing)) {
+        redundant.push_back(existing);
+      }
+    }
+
+    foreach (OfferFilter* existing, redundant) {
+      offerFilters.erase(existing);
+    }
+
+    offerFilters.insert(offerFilter);
+
+    metrics.addOfferFilters(role, 1);
+    metrics.removeOfferFilters(role, redundant.size());
+
+    expire(
+        offerFilter->expiry().time(),
+        {frameworkId, role, slaveId, offerFilter});
   }
 }
 
@@ -1225,7 +1271,7 @@ void HierarchicalAllocatorProcess::reviveOffers(
   CHECK(frameworks.contains(frameworkId));
 
   Framework& framework = frameworks.at(frameworkId);
-  framework.offerFilters.clear();
+  clearOfferFilters(frameworkId);
   framework.inverseOfferFilters.clear();
 
   const set<string>& roles = roles_.empty() ? framework.roles : roles_;
@@ -1333,6 +1379,8 @@ void HierarchicalAllocatorProcess::updateWeights(
 
     quotaRoleSorter->updateWeight(weightInfo.role(), weightInfo.weight());
     roleSorter->updateWeight(weightInfo.role(), weightInfo.weight());
+
+    weights[weightInfo.role()] = weightInfo.weight();
   }
 
   // NOTE: Since weight changes do not result in rebalancing of
@@ -1431,6 +1479,10 @@ Nothing HierarchicalAllocatorProcess::_allocate() {
 
   metrics.allocation_run.stop();
 
+  metrics.offer_filter_lookups += offerFilterLookups.exchange(0);
+  metrics.offer_filter_lookup_time =
+    Nanoseconds(offerFilterLookupNanos.exchange(0)).us();
+
   VLOG(1) << "Performed allocation for " << allocationCandidates.size()
           << " agents in " << stopwatch.elapsed();
 
@@ -1505,7 +1557,9 @@ void HierarchicalAllocatorProcess::__allocate()
   // roles for which quota is set (quota'ed roles). Such roles form a
   // special allocation group with a dedicated sorter.
   foreach (const SlaveID& slaveId, slaveIds) {
-    foreach (const string& role, quotaRoleSorter->sort()) {
+    foreach (const string* rolePath, quotaRoleSorter->order()) {
+      const string& role = *rolePath;
+
       CHECK(quotas.contains(role));
 
       const Quota& quota = quotas.at(role);
@@ -1552,7 +1606,9 @@ void HierarchicalAllocatorProcess::__allocate()
       CHECK(frameworkSorters.contains(role));
       const Owned<Sorter>& frameworkSorter = frameworkSorters.at(role);
 
-      foreach (const string& frameworkId_, frameworkSorter->sort()) {
+      foreach (const string* frameworkPath, frameworkSorter->order()) {
+        const string& frameworkId_ = *frameworkPath;
+
         FrameworkID frameworkId;
         frameworkId.set_value(frameworkId_);
 
@@ -1705,26 +1761,143 @@ void HierarchicalAllocatorProcess::__allocate()
 
   // At this point resources for quotas are allocated or accounted for.
   // Proceed with allocating the remaining free pool.
+  //
+  // For large allocation runs, the agents can be partitioned across
+  // multiple threads. Each shard only sees its own allocations, so the
+  // results are reconciled against `remainingClusterResources` below.
+  const size_t shardCount = std::min(
+      allocationThreads,
+      slaveIds.size() / MIN_AGENTS_PER_ALLOCATION_SHARD);
+
+  const bool parallel = shardCount > 1;
+
+  vector<FairShareAllocation> fairShareAllocations;
+
+  if (parallel) {
+    fairShareAllocations = allocateFairShareParallel(
+        slaveIds,
+        shardCount,
+        offeredSharedResources,
+        remainingClusterResources);
+  } else {
+    hashmap<string, Sorter*> frameworkSorters_;
+    foreachpair (const string& role,
+                 const Owned<Sorter>& frameworkSorter,
+                 frameworkSorters) {
+      frameworkSorters_.put(role, frameworkSorter.get());
+    }
+
+    fairShareAllocations = allocateFairShare(
+        slaveIds,
+        roleSorter.get(),
+        frameworkSorters_,
+        quotaRoleSorter.get(),
+        offeredSharedResources,
+        remainingClusterResources);
+  }
+
+  foreach (const FairShareAllocation& allocation, fairShareAllocations) {
+    const FrameworkID& frameworkId = allocation.frameworkId;
+    const string& role = allocation.role;
+    const SlaveID& slaveId = allocation.slaveId;
+    const Resources& resources = allocation.resources;
+
+    const Resources scalarQuantity =
+      resources.nonShared().createStrippedScalarQuantity();
+
+    if (parallel) {
+      // Shards allocate optimistically, so drop the allocations that
+      // would force the second stage to use more than
+      // `remainingClusterResources` once all shards are combined. The
+      // allocations are visited in a deterministic (shard) order.
+      if (!remainingClusterResources.contains(
+              allocatedStage2 + scalarQuantity)) {
+        VLOG(1) << "Dropped allocation of " << resources << " on agent "
+                << slaveId << " to role " << role << " of framework "
+                << frameworkId << " which exceeds the available resources";
+        continue;
+      }
+
+      // The shards only updated their own copies of the sorters.
+      CHECK(frameworkSorters.contains(role));
+      const Owned<Sorter>& frameworkSorter = frameworkSorters.at(role);
+
+      frameworkSorter->add(slaveId, resources);
+      frameworkSorter->allocated(frameworkId.value(), slaveId, resources);
+      roleSorter->allocated(role, slaveId, resources);
+
+      if (quotas.contains(role)) {
+        // See comment at `quotaRoleSorter` declaration regarding
+        // non-revocable.
+        quotaRoleSorter->allocated(role, slaveId, resources.nonRevocable());
+      }
+    }
+
+    // NOTE: We may have already allocated some resources on the current
+    // agent as part of quota.
+    offerable[frameworkId][role][slaveId] += resources;
+    offeredSharedResources[slaveId] += resources.shared();
+    allocatedStage2 += scalarQuantity;
+
+    CHECK(slaves.contains(slaveId));
+    slaves.at(slaveId).allocated += resources;
+  }
+
+  if (offerable.empty()) {
+    VLOG(1) << "No allocations performed";
+  } else {
+    // Now offer the resources to each framework.
+    foreachkey (const FrameworkID& frameworkId, offerable) {
+      offerCallback(frameworkId, offerable.at(frameworkId));
+    }
+  }
+}
+
+
+vector<HierarchicalAllocatorProcess::FairShareAllocation>
+HierarchicalAllocatorProcess::allocateFairShare(
+    const vector<SlaveID>& slaveIds,
+    Sorter* roleSorter,
+    const hashmap<string, Sorter*>& frameworkSorters,
+    Sorter* quotaRoleSorter,
+    hashmap<SlaveID, Resources> offeredSharedResources,
+    const Resources& remainingClusterResources) const
+{
+  vector<FairShareAllocation> result;
+
+  // See `__allocate()` for the stopping criteria of the second stage.
+  Resources allocatedStage2;
+
   foreach (const SlaveID& slaveId, slaveIds) {
     // If there are no resources available for the second stage, stop.
     if (!allocatable(remainingClusterResources - allocatedStage2)) {
       break;
     }
 
-    foreach (const string& role, roleSorter->sort()) {
+    CHECK(slaves.contains(slaveId));
+    const Slave& slave = slaves.at(slaveId);
+
+    // The non-shared resources available on the agent. Since agents are
+    // visited one at a time, we only need to track the allocations made
+    // to this agent in this stage.
+    Resources slaveAvailable = slave.available().nonShared();
+
+    foreach (const string* rolePath, roleSorter->order()) {
+      const string& role = *rolePath;
+
       // NOTE: Suppressed frameworks are not included in the sort.
       CHECK(frameworkSorters.contains(role));
-      const Owned<Sorter>& frameworkSorter = frameworkSorters.at(role);
+      Sorter* frameworkSorter = frameworkSorters.at(role);
+
+      foreach (const string* frameworkPath, frameworkSorter->order()) {
+        const string& frameworkId_ = *frameworkPath;
 
-      foreach (const string& frameworkId_, frameworkSorter->sort()) {
         FrameworkID frameworkId;
         frameworkId.set_value(frameworkId_);
 
-        CHECK(slaves.contains(slaveId));
         CHECK(frameworks.contains(frameworkId));
 
         const Framework& framework = frameworks.at(frameworkId);
-        Slave& slave = slaves.at(slaveId);
 
         // Only offer resources from slaves that have GPUs to
         // frameworks that are capable of receiving GPUs.
@@ -1740,7 +1913,7 @@ void HierarchicalAllocatorProcess::__allocate()
         // Since shared resources are offerable even when they are in use, we
         // make one copy of the shared resources available regardless of the
         // past allocations.
-        Resources available = slave.available().nonShared();
+        Resources available = slaveAvailable;
 
         // Offer a shared resource only if it has not been offered in
         // this offer cycle to a framework.
@@ -1819,24 +1992,21 @@ void HierarchicalAllocatorProcess::__allocate()
         LOG(INFO) << "lele Allocating " << resources << " on agent " << slaveId
                 << " to role " << role << " of framework " << frameworkId;
 
+        slaveAvailable -= resources.nonShared();
+
         resources.allocate(role);
 
         // NOTE: We perform "coarse-grained" allocation, meaning that we always
         // allocate the entire remaining slave resources to a single framework.
-        //
-        // NOTE: We may have already allocated some resources on the current
-        // agent as part of quota.
-        offerable[frameworkId][role][slaveId] += resources;
+        result.push_back({frameworkId, role, slaveId, resources});
         offeredSharedResources[slaveId] += resources.shared();
         allocatedStage2 += scalarQuantity;
 
-        slave.allocated += resources;
-
         frameworkSorter->add(slaveId, resources);
         frameworkSorter->allocated(frameworkId_, slaveId, resources);
         roleSorter->allocated(role, slaveId, resources);
 
-        if (quotas.contains(role)) {
+        if (quotaRoleSorter != nullptr && quotas.contains(role)) {
           // See comment at `quotaRoleSorter` declaration regarding
           // non-revocable.
           quotaRoleSorter->allocated(role, slaveId, resources.nonRevocable());
@@ -1845,14 +2015,125 @@ void HierarchicalAllocatorProcess::__allocate()
     }
   }
 
-  if (offerable.empty()) {
-    VLOG(1) << "No allocations performed";
-  } else {
-    // Now offer the resources to each framework.
-    foreachkey (const FrameworkID& frameworkId, offerable) {
-      offerCallback(frameworkId, offerable.at(frameworkId));
+  return result;
+}
+
+
+vector<HierarchicalAllocatorProcess::FairShareAllocation>
+HierarchicalAllocatorProcess::allocateFairShareParallel(
+    const vector<SlaveID>& slaveIds,
+    size_t shardCount,
+    const hashmap<SlaveID, Resources>& offeredSharedResources,
+    const Resources& remainingClusterResources)
+{
+  CHECK_GT(shardCount, 1u);
+  CHECK_LE(shardCount, slaveIds.size());
+
+  // The shards' sorters are initialized with the current scalar
+  // allocations of each role and framework, recorded against a
+  // placeholder agent. This preserves the fair share order at the start
+  // of the allocation run (modulo allocation counts, which are only
+  // used to break ties) without copying per-agent allocations.
+  SlaveID snapshotId;
+  snapshotId.set_value("__allocation_snapshot__");
+
+  struct Shard
+  {
+    vector<SlaveID> slaveIds;
+    Owned<Sorter> roleSorter;
+    hashmap<string, Owned<Sorter>> frameworkSorters;
+    vector<FairShareAllocation> allocations;
+  };
+
+  vector<Shard> shards(shardCount);
+
+  // NOTE: Sorting mutates the sorters, hence we do all reads of the
+  // allocator's sorters here, before starting any threads.
+  const vector<string> roleOrder = roleSorter->sort();
+
+  for (size_t i = 0; i < shardCount; i++) {
+    Shard& shard = shards[i];
+
+    shard.slaveIds.assign(
+        slaveIds.begin() + (i * slaveIds.size()) / shardCount,
+        slaveIds.begin() + ((i + 1) * slaveIds.size()) / shardCount);
+
+    shard.roleSorter.reset(frameworkSorterFactory());
+    shard.roleSorter->initialize(fairnessExcludeResourceNames);
+    shard.roleSorter->add(snapshotId, roleSorter->totalScalarQuantities());
+
+    foreachpair (const string& role, double weight, weights) {
+      shard.roleSorter->updateWeight(role, weight);
+    }
+
+    foreach (const string& role, roleOrder) {
+      shard.roleSorter->add(role);
+      shard.roleSorter->activate(role);
+      shard.roleSorter->allocated(
+          role, snapshotId, roleSorter->allocationScalarQuantities(role));
+
+      CHECK(frameworkSorters.contains(role));
+      const Owned<Sorter>& frameworkSorter = frameworkSorters.at(role);
+
+      Owned<Sorter> shardFrameworkSorter(frameworkSorterFactory());
+      shardFrameworkSorter->initialize(fairnessExcludeResourceNames);
+      shardFrameworkSorter->add(
+          snapshotId, frameworkSorter->totalScalarQuantities());
+
+      foreach (const string& frameworkId, frameworkSorter->sort()) {
+        shardFrameworkSorter->add(frameworkId);
+        shardFrameworkSorter->activate(frameworkId);
+        shardFrameworkSorter->allocated(
+            frameworkId,
+            snapshotId,
+            frameworkSorter->allocationScalarQuantities(frameworkId));
+      }
+
+      shard.frameworkSorters.put(role, shardFrameworkSorter);
     }
   }
+
+  auto allocateShard = [&](Shard& shard) {
+    hashmap<string, Sorter*> frameworkSorters_;
+    foreachpair (const string& role,
+                 const Owned<Sorter>& frameworkSorter,
+                 shard.frameworkSorters) {
+      frameworkSorters_.put(role, frameworkSorter.get());
+    }
+
+    shard.allocations = allocateFairShare(
+        shard.slaveIds,
+        shard.roleSorter.get(),
+        frameworkSorters_,
+        nullptr,
+        offeredSharedResources,
+        remainingClusterResources);
+  };
+
+  // The first shard is allocated on the allocator's own thread.
+  vector<std::thread> threads;
+  threads.reserve(shardCount - 1);
+
+  for (size_t i = 1; i < shardCount; i++) {
+    threads.emplace_back(allocateShard, std::ref(shards[i]));
+  }
+
+  allocateShard(shards[0]);
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  vector<FairShareAllocation> result;
+
+  foreach (Shard& shard, shards) {
+    result.insert(
+        result.end(),
+        std::make_move_iterator(shard.allocations.begin()),
+        std::make_move_iterator(shard.allocations.end()));
+  }
+
+  return result;
 }
 
 
@@ -1946,56 +2227,100 @@ void HierarchicalAllocatorProcess::deallocate()
 }
 
 
-void HierarchicalAllocatorProcess::_expire(
-    const FrameworkID& frameworkId,
-    const string& role,
-    const SlaveID& slaveId,
-    OfferFilter* offerFilter)
+void HierarchicalAllocatorProcess::expire(
+    const Time& expiry,
+    const OfferFilterExpiry& filter)
 {
-  // The filter might have already been removed (e.g., if the
-  // framework no longer exists or in `reviveOffers()`) but not
-  // yet deleted (to keep the address from getting reused
-  // possibly causing premature expiration).
-  //
-  // Since this is a performance-sensitive piece of code,
-  // we use find to avoid the doing any redundant lookups.
+  offerFilterExpiries[expiry].push_back(filter);
 
-  auto frameworkIterator = frameworks.find(frameworkId);
-  if (frameworkIterator != frameworks.end()) {
-    Framework& framework = frameworkIterator->second;
+  // Reschedule the timer if this filter expires before the ones
+  // we currently wait for.
+  if (offerFilterTimer.isSome() &&
+      offerFilterTimer->timeout().time() <= expiry) {
+    return;
+  }
 
-    auto roleFilters = framework.offerFilters.find(role);
-    if (roleFilters != framework.offerFilters.end()) {
-      auto agentFilters = roleFilters->second.find(slaveId);
+  if (offerFilterTimer.isSome()) {
+    Clock::cancel(offerFilterTimer.get());
+  }
 
-      if (agentFilters != roleFilters->second.end()) {
-        // Erase the filter (may be a no-op per the comment above).
-        agentFilters->second.erase(offerFilter);
+  offerFilterTimer =
+    delay(expiry - Clock::now(), self(), &Self::expireOfferFilters);
+}
 
-        if (agentFilters->second.empty()) {
-          roleFilters->second.erase(slaveId);
-        }
-      }
-    }
+
+void HierarchicalAllocatorProcess::expireOfferFilters()
+{
+  offerFilterTimer = None();
+
+  const Time now = Clock::now();
+
+  vector<OfferFilterExpiry> expired;
+
+  while (!offerFilterExpiries.empty() &&
+         offerFilterExpiries.begin()->first <= now) {
+    vector<OfferFilterExpiry>& filters = offerFilterExpiries.begin()->second;
+
+    expired.insert(
+        expired.end(),
+        std::make_move_iterator(filters.begin()),
+        std::make_move_iterator(filters.end()));
+
+    offerFilterExpiries.erase(offerFilterExpiries.begin());
   }
 
-  delete offerFilter;
+  if (!offerFilterExpiries.empty()) {
+    offerFilterTimer = delay(
+        offerFilterExpiries.begin()->first - now,
+        self(),
+        &Self::expireOfferFilters);
+  }
+
+  if (!expired.empty()) {
+    dispatch(self(), &Self::_expireOfferFilters, expired);
+  }
 }
 
 
-void HierarchicalAllocatorProcess::expire(
-    const FrameworkID& frameworkId,
-    const string& role,
-    const SlaveID& slaveId,
-    OfferFilter* offerFilter)
+void HierarchicalAllocatorProcess::_expireOfferFilters(
+    const vector<OfferFilterExpiry>& filters)
 {
-  dispatch(
-      self(),
-      &Self::_expire,
-      frameworkId,
-      role,
-      slaveId,
-      offerFilter);
+  foreach (const OfferFilterExpiry& filter, filters) {
+    // The filter might have already been removed (e.g., if the
+    // framework no longer exists, in `reviveOffers()` or because a
+    // newer filter made it redundant) but not yet deleted (to keep
+    // the address from getting reused possibly causing premature
+    // expiration).
+    //
+    // Since this is a performance-sensitive piece of code,
+    // we use find to avoid the doing any redundant lookups.
+    auto frameworkIterator = frameworks.find(filter.frameworkId);
+    if (frameworkIterator != frameworks.end()) {
+      Framework& framework = frameworkIterator->second;
+
+      auto roleFilters = framework.offerFilters.find(filter.role);
+      if (roleFilters != framework.offerFilters.end()) {
+        auto agentFilters = roleFilters->second.find(filter.slaveId);
+
+        if (agentFilters != roleFilters->second.end()) {
+          // Erase the filter (may be a no-op per the comment above).
+          if (agentFilters->second.erase(filter.offerFilter) > 0) {
+            metrics.removeOfferFilters(filter.role, 1);
+          }
+
+          if (agentFilters->second.empty()) {
+            roleFilters->second.erase(agentFilters);
+          }
+        }
+
+        if (roleFilters->second.empty()) {
+          framework.offerFilters.erase(roleFilters);
+        }
+      }
+    }
+
+    delete filter.offerFilter;
+  }
 }
 
 
@@ -2066,6 +2391,11 @@ bool HierarchicalAllocatorProcess::isFiltered(
     return true;
   }
 
+  // Most frameworks do not have any filters.
+  if (framework.offerFilters.empty()) {
+    return false;
+  }
+
   // Since this is a performance-sensitive piece of code,
   // we use find to avoid the doing any redundant lookups.
   auto roleFilters = framework.offerFilters.find(role);
@@ -2078,18 +2408,29 @@ bool HierarchicalAllocatorProcess::isFiltered(
     return false;
   }
 
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  bool filtered = false;
+
   foreach (OfferFilter* offerFilter, agentFilters->second) {
     if (offerFilter->filter(resources)) {
-      VLOG(1) << "Filtered offer with " << resources
-              << " on agent " << slaveId
-              << " for role " << role
-              << " of framework " << frameworkId;
-
-      return true;
+      filtered = true;
+      break;
     }
   }
 
-  return false;
+  offerFilterLookups++;
+  offerFilterLookupNanos += stopwatch.elapsed().ns();
+
+  if (filtered) {
+    VLOG(1) << "Filtered offer with " << resources
+            << " on agent " << slaveId
+            << " for role " << role
+            << " of framework " << frameworkId;
+  }
+
+  return filtered;
 }
 
 
@@ -2170,25 +2511,6 @@ double HierarchicalAllocatorProcess::_quota_allocated(
 }
 
 
-double HierarchicalAllocatorProcess::_offer_filters_active(
-    const string& role)
-{
-  double result = 0;
-
-  foreachvalue (const Framework& framework, frameworks) {
-    if (!framework.offerFilters.contains(role)) {
-      continue;
-    }
-
-    foreachkey (const SlaveID& slaveId, framework.offerFilters.at(role)) {
-      result += framework.offerFilters.at(role).at(slaveId).size();
-    }
-  }
-
-  return result;
-}
-
-
 bool HierarchicalAllocatorProcess::isFrameworkTrackedUnderRole(
     const FrameworkID& frameworkId,
     const string& role) const
@@ -2262,6 +2584,33 @@ void HierarchicalAllocatorProcess::untrackFrameworkUnderRole(
 }
 
 
+void HierarchicalAllocatorProcess::clearOfferFilters(
+    const FrameworkID& frameworkId,
+    const Option<string>& role)
+{
+  CHECK(frameworks.contains(frameworkId));
+
+  Framework& framework = frameworks.at(frameworkId);
+
+  auto roleFilters = framework.offerFilters.begin();
+  while (roleFilters != framework.offerFilters.end()) {
+    if (role.isSome() && roleFilters->first != role.get()) {
+      ++roleFilters;
+      continue;
+    }
+
+    size_t count = 0;
+    foreachvalue (const hashset<OfferFilter*>& filters, roleFilters->second) {
+      count += filters.size();
+    }
+
+    metrics.removeOfferFilters(roleFilters->first, count);
+
+    roleFilters = framework.offerFilters.erase(roleFilters);
+  }
+}
+
+
 void HierarchicalAllocatorProcess::updateSlaveTotal(
     const SlaveID& slaveId,
     const Resources& total)
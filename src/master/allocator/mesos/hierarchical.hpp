@@ -17,14 +17,21 @@
 #ifndef __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 #define __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 
+#include <algorithm>
+#include <atomic>
+#include <map>
 #include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
 #include <process/future.hpp>
 #include <process/id.hpp>
 #include <process/owned.hpp>
+#include <process/time.hpp>
+#include <process/timer.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
@@ -60,6 +67,26 @@ HierarchicalDRFAllocatorProcess;
 typedef MesosAllocator<HierarchicalDRFAllocatorProcess>
 HierarchicalDRFAllocator;
 
+// NOTE: The framework sorters keep using the full `DRFSorter`: their
+// total resources change with every allocation made to the role, which
+// invalidates every share in the sorter anyway.
+typedef HierarchicalAllocatorProcess<
+    IncrementalDRFSorter,
+    DRFSorter,
+    IncrementalDRFSorter>
+HierarchicalIncrementalDRFAllocatorProcess;
+
+typedef MesosAllocator<HierarchicalIncrementalDRFAllocatorProcess>
+HierarchicalIncrementalDRFAllocator;
+
+// Forward declaration of a hierarchical DRF allocator process that
+// computes the fair share stage of each allocation run on multiple
+// threads, see below.
+class HierarchicalParallelDRFAllocatorProcess;
+
+typedef MesosAllocator<HierarchicalParallelDRFAllocatorProcess>
+HierarchicalParallelDRFAllocator;
+
 
 namespace internal {
 
@@ -76,13 +103,17 @@ public:
   HierarchicalAllocatorProcess(
       const std::function<Sorter*()>& roleSorterFactory,
       const std::function<Sorter*()>& _frameworkSorterFactory,
-      const std::function<Sorter*()>& quotaRoleSorterFactory)
+      const std::function<Sorter*()>& quotaRoleSorterFactory,
+      size_t _allocationThreads = 1)
     : initialized(false),
       paused(true),
       metrics(*this),
+      offerFilterLookups(0),
+      offerFilterLookupNanos(0),
       roleSorter(roleSorterFactory()),
       quotaRoleSorter(quotaRoleSorterFactory()),
-      frameworkSorterFactory(_frameworkSorterFactory) {}
+      frameworkSorterFactory(_frameworkSorterFactory),
+      allocationThreads(_allocationThreads) {}
 
   virtual ~HierarchicalAllocatorProcess() {}
 
@@ -237,18 +268,23 @@ protected:
   // Helper for `_allocate()` that deallocates resources for inverse offers.
   void deallocate();
 
-  // Remove an offer filter for the specified role of the framework.
-  void expire(
-      const FrameworkID& frameworkId,
-      const std::string& role,
-      const SlaveID& slaveId,
-      OfferFilter* offerFilter);
+  // An offer filter for the specified role of the framework.
+  struct OfferFilterExpiry
+  {
+    FrameworkID frameworkId;
+    std::string role;
+    SlaveID slaveId;
+    OfferFilter* offerFilter;
+  };
 
-  void _expire(
-      const FrameworkID& frameworkId,
-      const std::string& role,
-      const SlaveID& slaveId,
-      OfferFilter* offerFilter);
+  // Schedules the expiry of an offer filter at `expiry`.
+  void expire(const process::Time& expiry, const OfferFilterExpiry& filter);
+
+  // Removes the offer filters which have expired by now, and
+  // reschedules the timer for the next ones to expire.
+  void expireOfferFilters();
+
+  void _expireOfferFilters(const std::vector<OfferFilterExpiry>& filters);
 
   // Remove an inverse offer filter for the specified framework.
   void expire(
@@ -275,6 +311,53 @@ protected:
 
   static bool allocatable(const Resources& resources);
 
+  // Resources allocated to a framework on an agent during the second
+  // (fair share) stage of an allocation run.
+  struct FairShareAllocation
+  {
+    FrameworkID frameworkId;
+    std::string role;
+    SlaveID slaveId;
+    Resources resources;
+  };
+
+  // Runs the second (fair share) stage of an allocation run over the
+  // given agents, visiting roles and frameworks in the order given by
+  // the passed sorters. Allocations are applied to the passed sorters
+  // (so that subsequent agents are allocated in fair share order) and
+  // returned, but they are NOT applied to the agents; that is up to
+  // the caller.
+  //
+  // `quotaRoleSorter` may be null, in which case quota role
+  // allocations are not tracked. `offeredSharedResources` and
+  // `remainingClusterResources` are as in `__allocate()`.
+  //
+  // NOTE: This does not modify any allocator state other than the
+  // passed sorters, hence it is safe to run concurrently over disjoint
+  // sets of agents, each with its own set of sorters.
+  std::vector<FairShareAllocation> allocateFairShare(
+      const std::vector<SlaveID>& slaveIds,
+      Sorter* roleSorter,
+      const hashmap<std::string, Sorter*>& frameworkSorters,
+      Sorter* quotaRoleSorter,
+      hashmap<SlaveID, Resources> offeredSharedResources,
+      const Resources& remainingClusterResources) const;
+
+  // Runs `allocateFairShare()` on `shardCount` disjoint shards of the
+  // given agents concurrently, one thread per shard. Each shard
+  // allocates against its own copy of the role and framework sorters,
+  // initialized from the current (scalar) allocations. The per-shard
+  // results are returned in shard order, i.e., the order of `slaveIds`.
+  //
+  // Since shards do not see each other's allocations, the results are
+  // optimistic: they may exceed `remainingClusterResources` in total
+  // and must be reconciled by the caller.
+  std::vector<FairShareAllocation> allocateFairShareParallel(
+      const std::vector<SlaveID>& slaveIds,
+      size_t shardCount,
+      const hashmap<SlaveID, Resources>& offeredSharedResources,
+      const Resources& remainingClusterResources);
+
   bool initialized;
   bool paused;
 
@@ -306,7 +389,9 @@ protected:
 
     // Active offer and inverse offer filters for the framework.
     // Offer filters are tied to the role the filtered resources
-    // were allocated to.
+    // were allocated to. We never keep empty sets (or maps) of
+    // offer filters, so that the common case of a framework (or
+    // role) without filters is a single lookup.
     hashmap<std::string, hashmap<SlaveID, hashset<OfferFilter*>>> offerFilters;
     hashmap<SlaveID, hashset<InverseOfferFilter*>> inverseOfferFilters;
   };
@@ -326,11 +411,21 @@ protected:
       const std::string& role,
       const std::string& resource);
 
-  double _offer_filters_active(
-      const std::string& role);
-
   hashmap<FrameworkID, Framework> frameworks;
 
+  // All offer filters, including the ones which have already been
+  // removed from their framework but not deleted yet, by the time at
+  // which they expire. We only keep a single timer for the earliest
+  // expiry rather than one per filter.
+  std::map<process::Time, std::vector<OfferFilterExpiry>> offerFilterExpiries;
+  Option<process::Timer> offerFilterTimer;
+
+  // The number of offer filter lookups which had to check filters in
+  // the current allocation run, and the time they took. These are
+  // updated by the concurrent shards of an allocation run.
+  mutable std::atomic<uint64_t> offerFilterLookups;
+  mutable std::atomic<int64_t> offerFilterLookupNanos;
+
   struct Slave
   {
     // Total amount of regular *and* oversubscribed resources.
@@ -503,6 +598,16 @@ protected:
   // Factory function for framework sorters.
   const std::function<Sorter*()> frameworkSorterFactory;
 
+  // Number of threads used for the second (fair share) stage of an
+  // allocation run. If greater than 1, the agents of large allocation
+  // runs are partitioned across that many threads, see
+  // `allocateFairShareParallel()`.
+  const size_t allocationThreads;
+
+  // Weights of roles, as passed to `updateWeights()`. We keep them to
+  // initialize the per-shard role sorters of a parallel allocation.
+  hashmap<std::string, double> weights;
+
 private:
   bool isFrameworkTrackedUnderRole(
       const FrameworkID& frameworkId,
@@ -516,6 +621,13 @@ private:
       const FrameworkID& frameworkId,
       const std::string& role);
 
+  // Removes the offer filters of the framework for the given role, or
+  // for all roles if none is given, and updates the offer filter
+  // metrics. The filters are deleted once they expire.
+  void clearOfferFilters(
+      const FrameworkID& frameworkId,
+      const Option<std::string>& role = None());
+
   // Helper to update the agent's total resources maintained in the allocator
   // and the role and quota sorters (whose total resources match the agent's
   // total resources).
@@ -537,14 +649,29 @@ class HierarchicalAllocatorProcess
   : public internal::HierarchicalAllocatorProcess
 {
 public:
-  HierarchicalAllocatorProcess()
+  explicit HierarchicalAllocatorProcess(size_t allocationThreads = 1)
     : ProcessBase(process::ID::generate("hierarchical-allocator")),
       internal::HierarchicalAllocatorProcess(
           [this]() -> Sorter* {
             return new RoleSorter(this->self(), "allocator/mesos/roles/");
           },
           []() -> Sorter* { return new FrameworkSorter(); },
-          []() -> Sorter* { return new QuotaRoleSorter(); }) {}
+          []() -> Sorter* { return new QuotaRoleSorter(); },
+          allocationThreads) {}
+};
+
+
+// A hierarchical DRF allocator process that partitions the agents of
+// the fair share stage of each allocation run across one thread per
+// available CPU. See `allocateFairShareParallel()` for the trade-offs.
+class HierarchicalParallelDRFAllocatorProcess
+  : public HierarchicalAllocatorProcess<DRFSorter, DRFSorter, DRFSorter>
+{
+public:
+  HierarchicalParallelDRFAllocatorProcess()
+    : ProcessBase(process::ID::generate("hierarchical-allocator")),
+      HierarchicalAllocatorProcess<DRFSorter, DRFSorter, DRFSorter>(
+          std::max(1u, std::thread::hardware_concurrency())) {}
 };
 
 } // namespace allocator {
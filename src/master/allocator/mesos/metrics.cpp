@@ -30,6 +30,7 @@
 using std::string;
 
 using process::metrics::Gauge;
+using process::metrics::PushGauge;
 
 namespace mesos {
 namespace internal {
@@ -48,12 +49,18 @@ Metrics::Metrics(const HierarchicalAllocatorProcess& _allocator)
         process::defer(
             allocator, &HierarchicalAllocatorProcess::_event_queue_dispatches)),
     allocation_runs("allocator/mesos/allocation_runs"),
-    allocation_run("allocator/mesos/allocation_run", Hours(1))
+    allocation_run("allocator/mesos/allocation_run", Hours(1)),
+    offer_filters("allocator/mesos/offer_filters/active"),
+    offer_filter_lookups("allocator/mesos/offer_filters/lookups"),
+    offer_filter_lookup_time("allocator/mesos/offer_filters/lookup_time_us")
 {
   process::metrics::add(event_queue_dispatches);
   process::metrics::add(event_queue_dispatches_);
   process::metrics::add(allocation_runs);
   process::metrics::add(allocation_run);
+  process::metrics::add(offer_filters);
+  process::metrics::add(offer_filter_lookups);
+  process::metrics::add(offer_filter_lookup_time);
 
   // Create and install gauges for the total and allocated
   // amount of standard scalar resources.
@@ -92,6 +99,9 @@ Metrics::~Metrics()
   process::metrics::remove(event_queue_dispatches_);
   process::metrics::remove(allocation_runs);
   process::metrics::remove(allocation_run);
+  process::metrics::remove(offer_filters);
+  process::metrics::remove(offer_filter_lookups);
+  process::metrics::remove(offer_filter_lookup_time);
 
   foreach (const Gauge& gauge, resources_total) {
     process::metrics::remove(gauge);
@@ -108,12 +118,12 @@ Metrics::~Metrics()
   }
 
   foreachkey (const string& role, quota_guarantee) {
-    foreachvalue (const Gauge& gauge, quota_guarantee[role]) {
+    foreachvalue (const PushGauge& gauge, quota_guarantee[role]) {
       process::metrics::remove(gauge);
     }
   }
 
-  foreachvalue (const Gauge& gauge, offer_filters_active) {
+  foreachvalue (const PushGauge& gauge, offer_filters_active) {
     process::metrics::remove(gauge);
   }
 }
@@ -124,18 +134,18 @@ void Metrics::setQuota(const string& role, const Quota& quota)
   CHECK(!quota_allocated.contains(role));
 
   hashmap<string, Gauge> allocated;
-  hashmap<string, Gauge> guarantees;
+  hashmap<string, PushGauge> guarantees;
 
   foreach (const Resource& resource, quota.info.guarantee()) {
     CHECK_EQ(Value::SCALAR, resource.type());
-    double value = resource.scalar().value();
 
-    Gauge guarantee = Gauge(
+    PushGauge guarantee(
         "allocator/mesos/quota"
         "/roles/" + role +
         "/resources/" + resource.name() +
-        "/guarantee",
-        process::defer([value]() { return value; }));
+        "/guarantee");
+
+    guarantee = resource.scalar().value();
 
     Gauge offered_or_allocated(
         "allocator/mesos/quota"
@@ -173,29 +183,89 @@ void Metrics::removeQuota(const string& role)
 
 void Metrics::addRole(const string& role)
 {
-  CHECK(!offer_filters_active.contains(role));
+  CHECK(!roles.contains(role));
+
+  roles.insert(role);
 
-  Gauge gauge(
-      "allocator/mesos/offer_filters/roles/" + role + "/active",
-      defer(allocator,
-            &HierarchicalAllocatorProcess::_offer_filters_active,
-            role));
+  // The gauge might still exist if the role had offer filters when
+  // it was last removed.
+  if (!offer_filters_active.contains(role)) {
+    PushGauge gauge(
+        "allocator/mesos/offer_filters/roles/" + role + "/active");
 
-  offer_filters_active.put(role, gauge);
+    offer_filters_active.put(role, gauge);
 
-  process::metrics::add(gauge);
+    process::metrics::add(gauge);
+  }
 }
 
 
 void Metrics::removeRole(const string& role)
 {
-  Option<Gauge> gauge = offer_filters_active.get(role);
+  CHECK(roles.contains(role));
+
+  roles.erase(role);
+
+  // Offer filters can outlive the role, e.g., when a framework that
+  // is no longer subscribed to the role declines resources allocated
+  // to it. The gauge is then removed along with the last filter.
+  if (!offer_filters_count.contains(role)) {
+    Option<PushGauge> gauge = offer_filters_active.get(role);
+
+    CHECK_SOME(gauge);
+
+    offer_filters_active.erase(role);
+
+    process::metrics::remove(gauge.get());
+  }
+}
+
+
+void Metrics::addOfferFilters(const string& role, size_t count)
+{
+  if (count == 0) {
+    return;
+  }
+
+  offer_filters += count;
+
+  offer_filters_count[role] += count;
+
+  if (!offer_filters_active.contains(role)) {
+    PushGauge gauge(
+        "allocator/mesos/offer_filters/roles/" + role + "/active");
+
+    offer_filters_active.put(role, gauge);
+
+    process::metrics::add(gauge);
+  }
+
+  offer_filters_active.at(role) += count;
+}
+
+
+void Metrics::removeOfferFilters(const string& role, size_t count)
+{
+  if (count == 0) {
+    return;
+  }
+
+  CHECK(offer_filters_count.contains(role));
+  CHECK_GE(offer_filters_count.at(role), count);
 
-  CHECK_SOME(gauge);
+  offer_filters -= count;
 
-  offer_filters_active.erase(role);
+  offer_filters_count.at(role) -= count;
+  offer_filters_active.at(role) -= count;
 
-  process::metrics::remove(gauge.get());
+  if (offer_filters_count.at(role) == 0) {
+    offer_filters_count.erase(role);
+
+    if (!roles.contains(role)) {
+      process::metrics::remove(offer_filters_active.at(role));
+      offer_filters_active.erase(role);
+    }
+  }
 }
 
 } // namespace internal {
@@ -24,11 +24,13 @@
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/push_gauge.hpp>
 #include <process/metrics/timer.hpp>
 
 #include <process/pid.hpp>
 
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 
 namespace mesos {
 namespace internal {
@@ -53,6 +55,11 @@ struct Metrics
   void addRole(const std::string& role);
   void removeRole(const std::string& role);
 
+  // Updates the offer filter gauges when filters for the role are
+  // added or removed.
+  void addOfferFilters(const std::string& role, size_t count);
+  void removeOfferFilters(const std::string& role, size_t count);
+
   const process::PID<HierarchicalAllocatorProcess> allocator;
 
   // Number of dispatch events currently waiting in the allocator process.
@@ -69,6 +76,15 @@ struct Metrics
   // Latency of the allocation algorithm.
   process::metrics::Timer<Milliseconds> allocation_run;
 
+  // Number of active offer filters across all roles.
+  process::metrics::PushGauge offer_filters;
+
+  // Number of times the allocation algorithm had to check the offer
+  // filters of a framework on an agent, and the total time these
+  // checks took during the last allocation run.
+  process::metrics::Counter offer_filter_lookups;
+  process::metrics::PushGauge offer_filter_lookup_time;
+
   // Gauges for the total amount of each resource in the cluster.
   std::vector<process::metrics::Gauge> resources_total;
 
@@ -80,11 +96,17 @@ struct Metrics
     quota_allocated;
 
   // Gauges for the per-role quota guarantee for each resource.
-  hashmap<std::string, hashmap<std::string, process::metrics::Gauge>>
+  hashmap<std::string, hashmap<std::string, process::metrics::PushGauge>>
     quota_guarantee;
 
-  // Gauges for the per-role count of active offer filters.
-  hashmap<std::string, process::metrics::Gauge> offer_filters_active;
+  // Gauges for the per-role count of active offer filters. A gauge
+  // exists while its role is tracked or still has offer filters.
+  hashmap<std::string, process::metrics::PushGauge> offer_filters_active;
+
+  // The roles tracked by the allocator, and the per-role count of
+  // active offer filters, which can outlive the role.
+  hashset<std::string> roles;
+  hashmap<std::string, size_t> offer_filters_count;
 };
 
 } // namespace internal {
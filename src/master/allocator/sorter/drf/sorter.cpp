@@ -16,6 +16,8 @@
 
 #include "master/allocator/sorter/drf/sorter.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <set>
 #include <string>
 #include <vector>
@@ -45,13 +47,26 @@ namespace allocator {
 
 
 DRFSorter::DRFSorter()
-  : root(new Node("", Node::INTERNAL, nullptr)) {}
+  : DRFSorter(false) {}
 
 
 DRFSorter::DRFSorter(
     const UPID& allocator,
     const string& metricsPrefix)
-  : root(new Node("", Node::INTERNAL, nullptr)),
+  : DRFSorter(allocator, metricsPrefix, false) {}
+
+
+DRFSorter::DRFSorter(bool _incremental)
+  : incremental(_incremental),
+    root(new Node("", Node::INTERNAL, nullptr)) {}
+
+
+DRFSorter::DRFSorter(
+    const UPID& allocator,
+    const string& metricsPrefix,
+    bool _incremental)
+  : incremental(_incremental),
+    root(new Node("", Node::INTERNAL, nullptr)),
     metrics(Metrics(allocator, *this, metricsPrefix)) {}
 
 
@@ -64,12 +79,14 @@ DRFSorter::~DRFSorter()
 void DRFSorter::initialize(
     const Option<set<string>>& _fairnessExcludeResourceNames)
 {
-  fairnessExcludeResourceNames = _fairnessExcludeResourceNames;
+  resourceNames.exclude(_fairnessExcludeResourceNames);
 }
 
 
 void DRFSorter::add(const string& clientPath)
 {
+  sortedStale = true;
+
   vector<string> pathElements = strings::tokenize(clientPath, "/");
   CHECK(!pathElements.empty());
 
@@ -109,6 +126,7 @@ void DRFSorter::add(const string& clientPath)
       Node* internal = new Node(current->name, Node::INTERNAL, parent);
       parent->addChild(internal);
       internal->allocation = current->allocation;
+      invalidate(internal);
 
       CHECK_EQ(current->path, internal->path);
 
@@ -119,6 +137,7 @@ void DRFSorter::add(const string& clientPath)
       current->path = strings::join("/", parent->path, current->name);
 
       internal->addChild(current);
+      invalidate(current);
 
       CHECK_EQ(internal->path, current->clientPath());
 
@@ -128,6 +147,7 @@ void DRFSorter::add(const string& clientPath)
     // Now actually add a new child to `current`.
     Node* newChild = new Node(element, Node::INTERNAL, current);
     current->addChild(newChild);
+    invalidate(newChild);
 
     current = newChild;
     lastCreatedNode = newChild;
@@ -169,8 +189,13 @@ void DRFSorter::add(const string& clientPath)
 
   clients[clientPath] = current;
 
-  // TODO(neilc): Avoid dirtying the tree in some circumstances.
-  dirty = true;
+  // In incremental mode, the nodes created above have already been
+  // invalidated individually. The new leaf itself is inactive, so it
+  // does not need to be sorted until it is activated.
+  if (!incremental) {
+    // TODO(neilc): Avoid dirtying the tree in some circumstances.
+    dirty = true;
+  }
 
   if (metrics.isSome()) {
     metrics->add(clientPath);
@@ -180,6 +205,8 @@ void DRFSorter::add(const string& clientPath)
 
 void DRFSorter::remove(const string& clientPath)
 {
+  sortedStale = true;
+
   Node* current = CHECK_NOTNULL(find(clientPath));
 
   // Save a copy of the leaf node's allocated resources, because we
@@ -215,12 +242,15 @@ void DRFSorter::remove(const string& clientPath)
       foreachpair (const SlaveID& slaveId,
                    const Resources& resources,
                    leafAllocation) {
-        parent->allocation.subtract(slaveId, resources);
+        parent->allocation.subtract(slaveId, resources, resourceNames);
       }
+
+      invalidate(parent);
     }
 
     if (current->children.empty()) {
       parent->removeChild(current);
+      dirtyParents.erase(current);
       delete current;
     } else if (current->children.size() == 1) {
       // If `current` has only one child that was created to
@@ -240,7 +270,7 @@ void DRFSorter::remove(const string& clientPath)
         // `current` has changed kind (from `INTERNAL` to a leaf,
         // which might be active or inactive). Hence we might need to
         // change its position in the `children` list.
-        if (current->kind == Node::INTERNAL) {
+        if (current->kind == Node::INACTIVE_LEAF) {
           CHECK_NOTNULL(current->parent);
 
           current->parent->removeChild(current);
@@ -249,6 +279,10 @@ void DRFSorter::remove(const string& clientPath)
 
         clients[current->path] = current;
 
+        // `current` might now be in the wrong position among its
+        // siblings, see above.
+        invalidate(current);
+
         delete child;
       }
     }
@@ -256,8 +290,10 @@ void DRFSorter::remove(const string& clientPath)
     current = parent;
   }
 
-  // TODO(neilc): Avoid dirtying the tree in some circumstances.
-  dirty = true;
+  if (!incremental) {
+    // TODO(neilc): Avoid dirtying the tree in some circumstances.
+    dirty = true;
+  }
 
   if (metrics.isSome()) {
     metrics->remove(clientPath);
@@ -271,20 +307,17 @@ void DRFSorter::activate(const string& clientPath)
 
   if (client->kind == Node::INACTIVE_LEAF) {
     client->kind = Node::ACTIVE_LEAF;
+    sortedStale = true;
 
     // `client` has been activated, so move it to the beginning of its
-    // parent's list of children. We mark the tree dirty, so that the
-    // client's share is updated correctly and it is sorted properly.
-    //
-    // TODO(neilc): We could instead calculate share here and insert
-    // the client into the appropriate place here, which would avoid
-    // dirtying the whole tree.
+    // parent's list of children. We invalidate the client, so that its
+    // share is updated correctly and it is sorted properly.
     CHECK_NOTNULL(client->parent);
 
     client->parent->removeChild(client);
     client->parent->addChild(client);
 
-    dirty = true;
+    invalidate(client);
   }
 }
 
@@ -295,6 +328,7 @@ void DRFSorter::deactivate(const string& clientPath)
 
   if (client->kind == Node::ACTIVE_LEAF) {
     client->kind = Node::INACTIVE_LEAF;
+    sortedStale = true;
 
     // `client` has been deactivated, so move it to the end of its
     // parent's list of children.
@@ -326,12 +360,10 @@ void DRFSorter::allocated(
   // node. This is debatable, but the current implementation doesn't
   // require looking at the allocation of the root node.
   while (current != root) {
-    current->allocation.add(slaveId, resources);
+    current->allocation.add(slaveId, resources, resourceNames);
+    invalidate(current);
     current = CHECK_NOTNULL(current->parent);
   }
-
-  // TODO(neilc): Avoid dirtying the tree in some circumstances.
-  dirty = true;
 }
 
 
@@ -352,12 +384,11 @@ void DRFSorter::update(
   // node. This is debatable, but the current implementation doesn't
   // require looking at the allocation of the root node.
   while (current != root) {
-    current->allocation.update(slaveId, oldAllocation, newAllocation);
+    current->allocation.update(
+        slaveId, oldAllocation, newAllocation, resourceNames);
+    invalidate(current);
     current = CHECK_NOTNULL(current->parent);
   }
-
-  // Just assume the total has changed, per the TODO above.
-  dirty = true;
 }
 
 
@@ -372,12 +403,10 @@ void DRFSorter::unallocated(
   // node. This is debatable, but the current implementation doesn't
   // require looking at the allocation of the root node.
   while (current != root) {
-    current->allocation.subtract(slaveId, resources);
+    current->allocation.subtract(slaveId, resources, resourceNames);
+    invalidate(current);
     current = CHECK_NOTNULL(current->parent);
   }
-
-  // TODO(neilc): Avoid dirtying the tree in some circumstances.
-  dirty = true;
 }
 
 
@@ -459,10 +488,7 @@ void DRFSorter::add(const SlaveID& slaveId, const Resources& resources)
       (resources.nonShared() + newShared).createStrippedScalarQuantity();
 
     total_.scalarQuantities += scalarQuantities;
-
-    foreach (const Resource& resource, scalarQuantities) {
-      total_.totals[resource.name()] += resource.scalar();
-    }
+    total_.totals.add(resourceNames, scalarQuantities);
 
     // We have to recalculate all shares when the total resources
     // change, but we put it off until `sort` is called so that if
@@ -492,9 +518,7 @@ void DRFSorter::remove(const SlaveID& slaveId, const Resources& resources)
     const Resources scalarQuantities =
       (resources.nonShared() + absentShared).createStrippedScalarQuantity();
 
-    foreach (const Resource& resource, scalarQuantities) {
-      total_.totals[resource.name()] -= resource.scalar();
-    }
+    total_.totals.subtract(resourceNames, scalarQuantities);
 
     CHECK(total_.scalarQuantities.contains(scalarQuantities));
     total_.scalarQuantities -= scalarQuantities;
@@ -510,6 +534,22 @@ void DRFSorter::remove(const SlaveID& slaveId, const Resources& resources)
 
 vector<string> DRFSorter::sort()
 {
+  vector<string> result;
+
+  foreach (const string* clientPath, order()) {
+    result.push_back(*clientPath);
+  }
+
+  return result;
+}
+
+
+const vector<const string*>& DRFSorter::order()
+{
+  if (!dirty && dirtyParents.empty() && !sortedStale) {
+    return sorted;
+  }
+
   if (dirty) {
     std::function<void (Node*)> sortTree = [this, &sortTree](Node* node) {
       // Inactive leaves are always stored at the end of the
@@ -526,6 +566,7 @@ vector<string> DRFSorter::sort()
         }
 
         child->share = calculateShare(child);
+        child->stale = false;
         ++childIter;
       }
 
@@ -545,19 +586,33 @@ vector<string> DRFSorter::sort()
     sortTree(root);
 
     dirty = false;
+
+    // All shares have just been recalculated, so there is no need to
+    // resort any part of the tree again.
+    dirtyParents.clear();
+  } else if (!dirtyParents.empty()) {
+    CHECK(incremental);
+
+    // The children of different parents are sorted independently,
+    // so the order in which we visit the parents does not matter.
+    foreach (Node* parent, dirtyParents) {
+      resort(parent);
+    }
+
+    dirtyParents.clear();
   }
 
-  // Return all active leaves in the tree via pre-order traversal.
+  // Collect all active leaves in the tree via pre-order traversal.
   // The children of each node are already sorted in DRF order, with
   // inactive leaves sorted after active leaves and internal nodes.
-  vector<string> result;
+  sorted.clear();
 
   std::function<void (const Node*)> listClients =
-      [&listClients, &result](const Node* node) {
+      [this, &listClients](const Node* node) {
     foreach (const Node* child, node->children) {
       switch (child->kind) {
         case Node::ACTIVE_LEAF:
-          result.push_back(child->clientPath());
+          sorted.push_back(&child->clientPath());
           break;
 
         case Node::INACTIVE_LEAF:
@@ -574,7 +629,10 @@ vector<string> DRFSorter::sort()
 
   listClients(root);
 
-  return result;
+  sortedStale = false;
+  orderRebuilds++;
+
+  return sorted;
 }
 
 
@@ -598,25 +656,85 @@ double DRFSorter::calculateShare(const Node* node) const
   // currently does not take into account resources that are not
   // scalars.
 
-  foreachpair (const string& resourceName,
-               const Value::Scalar& scalar,
-               total_.totals) {
+  const vector<double>& totals = total_.totals.values;
+  const vector<double>& allocations = node->allocation.totals.values;
+  const vector<bool>& excluded = resourceNames.excluded;
+
+  // Both arrays are indexed by resource id; an id beyond the end of
+  // either array means a zero quantity, which does not affect the
+  // share.
+  const size_t size = std::min(totals.size(), allocations.size());
+
+  for (size_t id = 0; id < size; id++) {
     // Filter out the resources excluded from fair sharing.
-    if (fairnessExcludeResourceNames.isSome() &&
-        fairnessExcludeResourceNames->count(resourceName) > 0) {
-      continue;
+    if (!excluded[id] && totals[id] > 0.0) {
+      share = std::max(share, allocations[id] / totals[id]);
     }
+  }
+
+  return share / findWeight(node);
+}
+
+
+void DRFSorter::invalidate(Node* node)
+{
+  if (!incremental) {
+    dirty = true;
+    return;
+  }
+
+  // If the whole tree will be resorted anyway, there is no need to
+  // track individual nodes.
+  if (dirty) {
+    return;
+  }
+
+  node->stale = true;
+  dirtyParents.insert(CHECK_NOTNULL(node->parent));
+}
 
-    if (scalar.value() > 0.0 &&
-        node->allocation.totals.contains(resourceName)) {
-      const double allocation =
-        node->allocation.totals.at(resourceName).value();
 
-      share = std::max(share, allocation / scalar.value());
+void DRFSorter::resort(Node* parent)
+{
+  // Split the children into those that are still in sorted order,
+  // those whose share needs to be recalculated, and inactive leaves.
+  // Removing elements from a sorted sequence keeps it sorted, so the
+  // unchanged children do not need to be compared again.
+  vector<Node*> unchanged;
+  vector<Node*> changed;
+  vector<Node*> inactive;
+
+  unchanged.reserve(parent->children.size());
+
+  foreach (Node* child, parent->children) {
+    if (child->kind == Node::INACTIVE_LEAF) {
+      inactive.push_back(child);
+    } else if (child->stale) {
+      child->share = calculateShare(child);
+      changed.push_back(child);
+    } else {
+      unchanged.push_back(child);
     }
+
+    child->stale = false;
   }
 
-  return share / findWeight(node);
+  std::sort(changed.begin(), changed.end(), DRFSorter::Node::compareDRF);
+
+  // Merge the recalculated children back in, keeping inactive leaves
+  // at the end to maintain ordering invariant (1).
+  parent->children.clear();
+
+  std::merge(
+      unchanged.begin(),
+      unchanged.end(),
+      changed.begin(),
+      changed.end(),
+      std::back_inserter(parent->children),
+      DRFSorter::Node::compareDRF);
+
+  parent->children.insert(
+      parent->children.end(), inactive.begin(), inactive.end());
 }
 
 
@@ -632,6 +750,74 @@ double DRFSorter::findWeight(const Node* node) const
 }
 
 
+size_t DRFSorter::ResourceNames::intern(const string& name)
+{
+  Option<size_t> id = ids.get(name);
+
+  if (id.isSome()) {
+    return id.get();
+  }
+
+  const size_t newId = ids.size();
+  ids.put(name, newId);
+
+  excluded.push_back(
+      excludedNames.isSome() && excludedNames->count(name) > 0);
+
+  return newId;
+}
+
+
+void DRFSorter::ResourceNames::exclude(const Option<set<string>>& names)
+{
+  excludedNames = names;
+
+  foreachpair (const string& name, size_t id, ids) {
+    excluded[id] = excludedNames.isSome() && excludedNames->count(name) > 0;
+  }
+}
+
+
+void DRFSorter::ScalarTotals::add(
+    ResourceNames& names,
+    const Resources& quantities)
+{
+  foreach (const Resource& resource, quantities) {
+    const size_t id = names.intern(resource.name());
+
+    if (id >= values.size()) {
+      values.resize(id + 1, 0.0);
+    }
+
+    Value::Scalar scalar;
+    scalar.set_value(values[id]);
+    scalar += resource.scalar();
+
+    values[id] = scalar.value();
+  }
+}
+
+
+void DRFSorter::ScalarTotals::subtract(
+    ResourceNames& names,
+    const Resources& quantities)
+{
+  foreach (const Resource& resource, quantities) {
+    const size_t id = names.intern(resource.name());
+
+    if (id >= values.size()) {
+      values.resize(id + 1, 0.0);
+    }
+
+    Value::Scalar scalar;
+    scalar.set_value(values[id]);
+    scalar -= resource.scalar();
+
+    values[id] = scalar.value();
+  }
+}
+
+
 DRFSorter::Node* DRFSorter::find(const string& clientPath) const
 {
   Option<Node*> client_ = clients.get(clientPath);
@@ -28,6 +28,7 @@
 
 #include <stout/check.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/option.hpp>
 
 #include "master/allocator/sorter/drf/metrics.hpp"
@@ -101,17 +102,77 @@ public:
 
   virtual std::vector<std::string> sort();
 
+  virtual const std::vector<const std::string*>& order();
+
   virtual bool contains(const std::string& clientPath) const;
 
   virtual int count() const;
 
+  // Returns the number of times `order()` rebuilt the order instead
+  // of returning the one it kept. Used for testing.
+  size_t rebuilds() const { return orderRebuilds; }
+
+protected:
+  // Used by `IncrementalDRFSorter` to enable incremental sorting.
+  explicit DRFSorter(bool incremental);
+
+  explicit DRFSorter(
+      const process::UPID& allocator,
+      const std::string& metricsPrefix,
+      bool incremental);
+
 private:
   // A node in the sorter's tree.
   struct Node;
 
+  // Maps resource names to small, dense integer ids. Names are
+  // interned the first time the sorter sees them; ids are never
+  // reused, which is fine since the number of distinct resource names
+  // in a cluster is small.
+  struct ResourceNames
+  {
+    // Returns the id of the resource name, interning it if needed.
+    size_t intern(const std::string& name);
+
+    // Updates the set of resource names excluded from fair sharing.
+    void exclude(const Option<std::set<std::string>>& names);
+
+    hashmap<std::string, size_t> ids;
+
+    // Resources (by name) that will be excluded from fair sharing.
+    Option<std::set<std::string>> excludedNames;
+
+    // Precomputed mask, indexed by resource id, of the resources that
+    // are excluded from fair sharing. Always has one entry per id.
+    std::vector<bool> excluded;
+  };
+
+  // Aggregated scalar quantities, stored as a dense array indexed by
+  // the interned resource id. This lets `calculateShare()` loop over
+  // contiguous memory instead of doing string-keyed hashmap lookups.
+  struct ScalarTotals
+  {
+    // NOTE: These use `Value::Scalar` arithmetic so that the stored
+    // values are rounded in the same way as `Resources`.
+    void add(ResourceNames& names, const Resources& quantities);
+    void subtract(ResourceNames& names, const Resources& quantities);
+
+    std::vector<double> values;
+  };
+
   // Returns the dominant resource share for the node.
   double calculateShare(const Node* node) const;
 
+  // Records that the share (or sort position) of the node might have
+  // changed. In incremental mode only the node is flagged and its
+  // parent is scheduled for a partial resort, otherwise the whole
+  // tree is marked dirty.
+  void invalidate(Node* node);
+
+  // Recalculates the shares of the flagged children of `parent` and
+  // merges them back into the (still sorted) unflagged children.
+  void resort(Node* parent);
+
   // Returns the weight associated with the node. If no weight has
   // been configured for the node's path, the default weight (1.0) is
   // returned.
@@ -122,12 +183,34 @@ private:
   // internal node in the tree (not a client).
   Node* find(const std::string& clientPath) const;
 
-  // Resources (by name) that will be excluded from fair sharing.
-  Option<std::set<std::string>> fairnessExcludeResourceNames;
+  // Interned names of all resources the sorter has seen, see above.
+  ResourceNames resourceNames;
 
   // If true, sort() will recalculate all shares and resort the tree.
   bool dirty = false;
 
+  // If true, changes to a client's allocation only invalidate the
+  // nodes on the path from that client to the root, rather than the
+  // whole tree. Changes to the total resources or to weights still
+  // invalidate the whole tree, because they affect every share.
+  const bool incremental;
+
+  // Internal nodes with at least one child whose share needs to be
+  // recalculated on the next call to sort(). Only used in incremental
+  // mode and only meaningful while `dirty` is false.
+  hashset<Node*> dirtyParents;
+
+  // The active clients in sort order, as returned by `order()`. The
+  // entries point at the `path` of nodes in the tree.
+  std::vector<const std::string*> sorted;
+
+  // If true, the clients or their activation changed since `sorted`
+  // was built. Share changes are tracked by `dirty` and `dirtyParents`.
+  bool sortedStale = true;
+
+  // Number of times `sorted` was rebuilt, see `rebuilds()`.
+  size_t orderRebuilds = 0;
+
   // The root node in the sorter tree.
   Node* root;
 
@@ -168,14 +251,14 @@ private:
     // identities of resources and not quantities.
     Resources scalarQuantities;
 
-    // We also store a map version of `scalarQuantities`, mapping
-    // the `Resource::name` to aggregated scalar. This improves the
-    // performance of calculating shares. See MESOS-4694.
+    // We also store a dense version of `scalarQuantities`, indexed by
+    // the interned resource name. This improves the performance of
+    // calculating shares. See MESOS-4694.
     //
     // TODO(bmahler): Ideally we do not store `scalarQuantities`
     // redundantly here, investigate performance improvements to
     // `Resources` to make this unnecessary.
-    hashmap<std::string, Value::Scalar> totals;
+    ScalarTotals totals;
   } total_;
 
   // Metrics are optionally exposed by the sorter.
@@ -207,7 +290,7 @@ struct DRFSorter::Node
   };
 
   Node(const std::string& _name, Kind _kind, Node* _parent)
-    : name(_name), share(0), kind(_kind), parent(_parent)
+    : name(_name), share(0), stale(false), kind(_kind), parent(_parent)
   {
     // Compute the node's path. Three cases:
     //
@@ -243,6 +326,11 @@ struct DRFSorter::Node
 
   double share;
 
+  // True if `share` might be out of date and the node might not be in
+  // its sorted position among its siblings. Only used when the sorter
+  // is in incremental mode.
+  bool stale;
+
   Kind kind;
 
   Node* parent;
@@ -258,7 +346,8 @@ struct DRFSorter::Node
   // can stop when the first inactive leaf is observed.
   //
   // (2) If the tree is not dirty, the active leaves and internal
-  // nodes are kept sorted by DRF share.
+  // nodes are kept sorted by DRF share. In incremental mode, this only
+  // holds for children that are not `stale`.
   std::vector<Node*> children;
 
   // If this node represents a sorter client, this returns the path of
@@ -270,7 +359,7 @@ struct DRFSorter::Node
   // (virtual leaf), and "a/b". The `clientPath()` of "a/." is "a",
   // because that is the name of the client associated with that
   // virtual leaf node.
-  std::string clientPath() const
+  const std::string& clientPath() const
   {
     if (name == ".") {
       CHECK(kind == ACTIVE_LEAF || kind == INACTIVE_LEAF);
@@ -321,7 +410,10 @@ struct DRFSorter::Node
   {
     Allocation() : count(0) {}
 
-    void add(const SlaveID& slaveId, const Resources& toAdd)
+    void add(
+        const SlaveID& slaveId,
+        const Resources& toAdd,
+        ResourceNames& names)
     {
       // Add shared resources to the allocated quantities when the same
       // resources don't already exist in the allocation.
@@ -335,15 +427,15 @@ struct DRFSorter::Node
 
       resources[slaveId] += toAdd;
       scalarQuantities += quantitiesToAdd;
-
-      foreach (const Resource& resource, quantitiesToAdd) {
-        totals[resource.name()] += resource.scalar();
-      }
+      totals.add(names, quantitiesToAdd);
 
       count++;
     }
 
-    void subtract(const SlaveID& slaveId, const Resources& toRemove)
+    void subtract(
+        const SlaveID& slaveId,
+        const Resources& toRemove,
+        ResourceNames& names)
     {
       CHECK(resources.contains(slaveId));
       CHECK(resources.at(slaveId).contains(toRemove));
@@ -360,9 +452,7 @@ struct DRFSorter::Node
       const Resources quantitiesToRemove =
         (toRemove.nonShared() + sharedToRemove).createStrippedScalarQuantity();
 
-      foreach (const Resource& resource, quantitiesToRemove) {
-        totals[resource.name()] -= resource.scalar();
-      }
+      totals.subtract(names, quantitiesToRemove);
 
       CHECK(scalarQuantities.contains(quantitiesToRemove));
       scalarQuantities -= quantitiesToRemove;
@@ -375,7 +465,8 @@ struct DRFSorter::Node
     void update(
         const SlaveID& slaveId,
         const Resources& oldAllocation,
-        const Resources& newAllocation)
+        const Resources& newAllocation,
+        ResourceNames& names)
     {
       const Resources oldAllocationQuantity =
         oldAllocation.createStrippedScalarQuantity();
@@ -391,13 +482,8 @@ struct DRFSorter::Node
       scalarQuantities -= oldAllocationQuantity;
       scalarQuantities += newAllocationQuantity;
 
-      foreach (const Resource& resource, oldAllocationQuantity) {
-        totals[resource.name()] -= resource.scalar();
-      }
-
-      foreach (const Resource& resource, newAllocationQuantity) {
-        totals[resource.name()] += resource.scalar();
-      }
+      totals.subtract(names, oldAllocationQuantity);
+      totals.add(names, newAllocationQuantity);
     }
 
     // We store the number of times this client has been chosen for
@@ -420,14 +506,14 @@ struct DRFSorter::Node
     // the corresponding resource. See notes above.
     Resources scalarQuantities;
 
-    // We also store a map version of `scalarQuantities`, mapping
-    // the `Resource::name` to aggregated scalar. This improves the
-    // performance of calculating shares. See MESOS-4694.
+    // We also store a dense version of `scalarQuantities`, indexed by
+    // the interned resource name. This improves the performance of
+    // calculating shares. See MESOS-4694.
     //
     // TODO(bmahler): Ideally we do not store `scalarQuantities`
     // redundantly here, investigate performance improvements to
     // `Resources` to make this unnecessary.
-    hashmap<std::string, Value::Scalar> totals;
+    ScalarTotals totals;
   } allocation;
 
   // Compares two nodes according to DRF share.
@@ -445,6 +531,30 @@ struct DRFSorter::Node
   }
 };
 
+
+// A DRF sorter that avoids recalculating the share of every client
+// whenever an allocation changes. Allocation changes only mark the
+// affected nodes as stale; `sort()` then recalculates the shares of
+// those nodes and merges them back into their parents' (already
+// sorted) lists of children. This makes sorting after a handful of
+// allocation changes roughly linear in the number of siblings rather
+// than O(n log n) share calculations and comparisons.
+//
+// NOTE: Changes to the total resources or to weights affect the share
+// of every client, so they still trigger a full resort of the tree.
+class IncrementalDRFSorter : public DRFSorter
+{
+public:
+  IncrementalDRFSorter() : DRFSorter(true) {}
+
+  explicit IncrementalDRFSorter(
+      const process::UPID& allocator,
+      const std::string& metricsPrefix)
+    : DRFSorter(allocator, metricsPrefix, true) {}
+
+  virtual ~IncrementalDRFSorter() {}
+};
+
 } // namespace allocator {
 } // namespace master {
 } // namespace internal {
@@ -139,6 +139,18 @@ public:
   // be allocated to, according to this Sorter's policy.
   virtual std::vector<std::string> sort() = 0;
 
+  // Returns the same order as `sort()`, but pointing at the sorter's
+  // own copies of the client paths instead of copying them. The order
+  // is kept between calls and only rebuilt after a change that can
+  // affect it, so that walking it for every agent of an allocation run
+  // is cheap.
+  //
+  // NOTE: The returned vector (and the paths it points to) is only
+  // valid until the next call to `sort()` or `order()`, or until a
+  // client is added or removed. Allocation changes made while
+  // iterating over it are reflected by the next call.
+  virtual const std::vector<const std::string*>& order() = 0;
+
   // Returns true if this Sorter contains the specified client,
   // which may be active or inactive.
   virtual bool contains(const std::string& client) const = 0;
@@ -0,0 +1,86 @@
+////
+//* Copyright  ：SIAT 异构智能计算体系结构与系统研究中心
+//* Author     ：Lele Li lilelr@163.com
+//* Date       ：2021-7-16
+//* Description：Linear performance loss model of a best-tuned (BT) workload
+////
+
+#ifndef CHAMELEON_BT_LINEAR_MODEL_HPP
+#define CHAMELEON_BT_LINEAR_MODEL_HPP
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <string>
+
+namespace chameleon {
+
+class BTLinearModel
+{
+public:
+  explicit BTLinearModel(
+    const std::string& name,
+    const double coe_cpu,
+    const double coe_mem,
+    const double c)
+    : m_name(name), m_coe_cpu(coe_cpu), m_coe_mem(coe_mem), m_c(c)
+  {}
+
+  int reduced_cores;
+  int reduced_executors;
+  int reduced_mem;
+  int reduced_per_mem;
+  int cores_max;
+  int per_executor_cores;
+  int per_executor_memory;
+  int overall_executors;
+
+  const std::string m_name;
+  double m_coe_cpu;
+  double m_coe_mem;
+  double m_c;
+
+  int lower_bound_reduced_cores;
+  int lower_bound_reduced_mem;
+
+  ~BTLinearModel() {}
+
+  template <typename... Args>
+  static std::string str_format(const std::string& format, Args... args)
+  {
+    auto size_buf = std::snprintf(nullptr, 0, format.c_str(), args...) + 1;
+    std::unique_ptr<char[]> buf(new (std::nothrow) char[size_buf]);
+
+    if (!buf) return std::string("");
+
+    std::snprintf(buf.get(), size_buf, format.c_str(), args...);
+    return std::string(buf.get(), buf.get() + size_buf - 1);
+  }
+
+  std::string info()
+  {
+    std::string result = str_format(
+      "model name is %s, m_coe_cpu is %lf, m_coe_mem is %lf, m_c is %lf.\n"
+      "overall_executors is %d,  per_executor_cores is %d, per_executor_memory "
+      "is %d. \n"
+      "reduced_cores is %d,  reduced_executors is %d, reduced_mem is %d, "
+      "reduced_per_mem is %d.",
+      m_name.c_str(),
+      m_coe_cpu,
+      m_coe_mem,
+      m_c,
+      overall_executors,
+      per_executor_cores,
+      per_executor_memory,
+      reduced_cores,
+      reduced_executors,
+      reduced_mem,
+      reduced_per_mem);
+    //            LOG(INFO)<<result;
+    return result;
+  }
+};
+
+} // namespace chameleon
+
+
+#endif
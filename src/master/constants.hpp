@@ -104,6 +104,25 @@ constexpr Duration DEFAULT_REGISTRY_MAX_AGENT_AGE = Weeks(2);
 
 constexpr size_t DEFAULT_REGISTRY_MAX_AGENT_COUNT = 100 * 1024;
 
+// Maximum number of registry updates that the registrar stores
+// concurrently. Further operations are batched until one completes.
+// The log storage issues the appends of these stores without waiting
+// for the earlier ones to be learned.
+constexpr size_t MAX_REGISTRY_STORES_IN_FLIGHT = 8;
+
+// Maximum number of registry deltas between two stores of the full
+// registry. The registrar also stores the full registry once the
+// deltas are larger than the registry itself.
+constexpr size_t MAX_REGISTRY_DELTAS = 1000;
+
+// Default maximum number of writes the registry's replicated log
+// coalesces into a single sync when group commit is enabled.
+constexpr size_t DEFAULT_REGISTRY_LOG_GROUP_COMMIT_MAX_ACTIONS = 64;
+
+// Default number of writes the registry's replicated log keeps in
+// flight at once.
+constexpr size_t DEFAULT_REGISTRY_LOG_WRITE_WINDOW = 1;
+
 /**
  * Label used by the Leader Contender and Detector.
  *
@@ -128,9 +147,22 @@ constexpr char DEFAULT_AUTHENTICATOR[] = "crammd5";
 // Name of the default, HierarchicalDRF authenticator.
 constexpr char DEFAULT_ALLOCATOR[] = "HierarchicalDRF";
 
+// Name of the built-in HierarchicalDRF allocator that resorts roles
+// incrementally as their allocations change.
+constexpr char INCREMENTAL_DRF_ALLOCATOR[] = "HierarchicalIncrementalDRF";
+
+// Name of the built-in HierarchicalDRF allocator that computes the
+// fair share stage of an allocation run on multiple threads.
+constexpr char PARALLEL_DRF_ALLOCATOR[] = "HierarchicalParallelDRF";
+
 // The default interval between allocations.
 constexpr Duration DEFAULT_ALLOCATION_INTERVAL = Seconds(1);
 
+// The minimum number of agents per thread in an allocation run of an
+// allocator that computes allocations on multiple threads. Below this,
+// the cost of setting up the threads outweighs the gains.
+constexpr size_t MIN_AGENTS_PER_ALLOCATION_SHARD = 500;
+
 // Name of the default, local authorizer.
 constexpr char DEFAULT_AUTHORIZER[] = "local";
 
@@ -121,6 +121,43 @@ mesos::internal::master::Flags::Flags()
       "initialized when used for the very first time.",
       true);
 
+  add(&Flags::registry_log_group_commit_window,
+      "registry_log_group_commit_window",
+      "If set, the local replica of the replicated log used for the\n"
+      "registry coalesces the writes it receives within this window into\n"
+      "a single synchronous write to disk. Writes are acknowledged only\n"
+      "once they are durable, so this trades write latency for throughput\n"
+      "when many registry operations are in flight.");
+
+  add(&Flags::registry_log_group_commit_max_actions,
+      "registry_log_group_commit_max_actions",
+      "Maximum number of writes coalesced into a single synchronous write\n"
+      "to disk when `--registry_log_group_commit_window` is set. The\n"
+      "writes are synced as soon as this many are pending.",
+      DEFAULT_REGISTRY_LOG_GROUP_COMMIT_MAX_ACTIONS,
+      [](size_t value) -> Option<Error> {
+        if (value == 0) {
+          return Error(
+              "Expected --registry_log_group_commit_max_actions "
+              "to be positive");
+        }
+        return None();
+      });
+
+  add(&Flags::registry_log_write_window,
+      "registry_log_write_window",
+      "Maximum number of writes to the replicated log used for the\n"
+      "registry that are in flight at once. Further writes are queued.\n"
+      "Setting this above 1 lets the concurrent registry updates of the\n"
+      "registrar be replicated together instead of one after another.",
+      DEFAULT_REGISTRY_LOG_WRITE_WINDOW,
+      [](size_t value) -> Option<Error> {
+        if (value == 0) {
+          return Error("Expected --registry_log_write_window to be positive");
+        }
+        return None();
+      });
+
   add(&Flags::agent_reregister_timeout,
       "agent_reregister_timeout",
       flags::DeprecatedName("slave_reregister_timeout"),
@@ -446,8 +483,12 @@ mesos::internal::master::Flags::Flags()
   add(&Flags::allocator,
       "allocator",
       "Allocator to use for resource allocation to frameworks.\n"
-      "Use the default `" + string(DEFAULT_ALLOCATOR) + "` allocator, or\n"
-      "load an alternate allocator module using `--modules`.",
+      "Use the default `" + string(DEFAULT_ALLOCATOR) + "` allocator, the\n"
+      "`" + string(INCREMENTAL_DRF_ALLOCATOR) + "` allocator (which only\n"
+      "resorts roles whose allocations changed), the\n"
+      "`" + string(PARALLEL_DRF_ALLOCATOR) + "` allocator (which computes\n"
+      "offers for large clusters on multiple threads), or load an\n"
+      "alternate allocator module using `--modules`.",
       DEFAULT_ALLOCATOR);
 
   add(&Flags::fair_sharing_excluded_resource_names,
@@ -512,6 +553,23 @@ mesos::internal::master::Flags::Flags()
       "Currently there's no support for multiple authorizers.",
       DEFAULT_AUTHORIZER);
 
+  add(&Flags::bt_repartition_strategy,
+      "bt_repartition_strategy",
+      "How the resources taken from batch (BT) frameworks for a\n"
+      "latency-critical application are split across them. Available\n"
+      "options are `parties`, which splits them evenly, and `milp`, which\n"
+      "solves a mixed integer linear program over the performance models\n"
+      "of the BT frameworks.",
+      "parties",
+      [](const string& value) -> Option<Error> {
+        if (value != "parties" && value != "milp") {
+          return Error(
+              "Expected --bt_repartition_strategy to be one of "
+              "'parties' or 'milp'");
+        }
+        return None();
+      });
+
   add(&Flags::http_authenticators,
       "http_authenticators",
       "HTTP authenticator implementation to use when handling requests to\n"
@@ -55,6 +55,9 @@ public:
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
   bool log_auto_initialize;
+  Option<Duration> registry_log_group_commit_window;
+  size_t registry_log_group_commit_max_actions;
+  size_t registry_log_write_window;
   Duration agent_reregister_timeout;
   std::string recovery_agent_removal_limit;
   Option<std::string> agent_removal_rate_limit;
@@ -85,6 +88,7 @@ public:
   Duration agent_ping_timeout;
   size_t max_agent_ping_timeouts;
   std::string authorizers;
+  std::string bt_repartition_strategy;
   std::string http_authenticators;
   Option<std::string> http_framework_authenticators;
   size_t max_completed_frameworks;
@@ -205,17 +205,63 @@ struct Full : Representation<T>
 static void json(JSON::ObjectWriter* writer, const Summary<Framework>& summary);
 
 
+// Writes a task that is pending authorization the same way as a
+// `Task` in state `TASK_STAGING`.
+static void writePendingTask(
+    JSON::ObjectWriter* writer,
+    const TaskInfo& taskInfo,
+    const FrameworkID& frameworkId)
+{
+  writer->field("id", taskInfo.task_id().value());
+  writer->field("name", taskInfo.name());
+  writer->field("framework_id", frameworkId.value());
+
+  writer->field(
+      "executor_id",
+      taskInfo.executor().executor_id().value());
+
+  writer->field("slave_id", taskInfo.slave_id().value());
+  writer->field("state", TaskState_Name(TASK_STAGING));
+  writer->field("resources", Resources(taskInfo.resources()));
+
+  // Tasks are not allowed to mix resources allocated to
+  // different roles, see MESOS-6636.
+  writer->field(
+      "role",
+      taskInfo.resources().begin()->allocation_info().role());
+
+  writer->field("statuses", std::initializer_list<TaskStatus>{});
+
+  if (taskInfo.has_labels()) {
+    writer->field("labels", taskInfo.labels());
+  }
+
+  if (taskInfo.has_discovery()) {
+    writer->field("discovery", JSON::Protobuf(taskInfo.discovery()));
+  }
+
+  if (taskInfo.has_container()) {
+    writer->field("container", JSON::Protobuf(taskInfo.container()));
+  }
+}
+
+
 // Filtered representation of Full<Framework>.
 // Executors and Tasks are filtered based on whether the
 // user is authorized to view them.
+//
+// The tasks can be left out for the `/state` snapshot, which keeps
+// them separately, see `Master::Http::updateStateCache()`.
 struct FullFrameworkWriter {
   FullFrameworkWriter(
       const Owned<ObjectApprover>& taskApprover,
       const Owned<ObjectApprover>& executorApprover,
-      const Framework* framework)
+      const Framework* framework,
+      bool tasks = true)
     : taskApprover_(taskApprover),
       executorApprover_(executorApprover),
-      framework_(framework) {}
+      framework_(framework),
+      tasks_(tasks) {}
 
   void operator()(JSON::ObjectWriter* writer) const
   {
@@ -255,6 +301,51 @@ struct FullFrameworkWriter {
       writer->field("role", framework_->info.role());
     }
 
+    if (tasks_) {
+      writeTasks(writer);
+      writeFinishedTasks(writer);
+    }
+
+    // Model all of the offers associated with a framework.
+    writer->field("offers", [this](JSON::ArrayWriter* writer) {
+      foreach (Offer* offer, framework_->offers) {
+        writer->element(*offer);
+      }
+    });
+
+    // Model all of the executors of a framework.
+    writer->field("executors", [this](JSON::ArrayWriter* writer) {
+      foreachpair (
+          const SlaveID& slaveId,
+          const auto& executorsMap,
+          framework_->executors) {
+        foreachvalue (const ExecutorInfo& executor, executorsMap) {
+          writer->element([this,
+                           &executor,
+                           &slaveId](JSON::ObjectWriter* writer) {
+            // Skip unauthorized executors.
+            if (!approveViewExecutorInfo(
+                    executorApprover_,
+                    executor,
+                    framework_->info)) {
+              return;
+            }
+
+            json(writer, executor);
+            writer->field("slave_id", slaveId.value());
+          });
+        }
+      }
+    });
+
+    // Model all of the labels associated with a framework.
+    if (framework_->info.has_labels()) {
+      writer->field("labels", framework_->info.labels());
+    }
+  }
+
+  void writeTasks(JSON::ObjectWriter* writer) const
+  {
     // Model all of the tasks associated with a framework.
     writer->field("tasks", [this](JSON::ArrayWriter* writer) {
       foreachvalue (const TaskInfo& taskInfo, framework_->pendingTasks) {
@@ -264,37 +355,7 @@ struct FullFrameworkWriter {
         }
 
         writer->element([this, &taskInfo](JSON::ObjectWriter* writer) {
-          writer->field("id", taskInfo.task_id().value());
-          writer->field("name", taskInfo.name());
-          writer->field("framework_id", framework_->id().value());
-
-          writer->field(
-              "executor_id",
-              taskInfo.executor().executor_id().value());
-
-          writer->field("slave_id", taskInfo.slave_id().value());
-          writer->field("state", TaskState_Name(TASK_STAGING));
-          writer->field("resources", Resources(taskInfo.resources()));
-
-          // Tasks are not allowed to mix resources allocated to
-          // different roles, see MESOS-6636.
-          writer->field(
-              "role",
-              taskInfo.resources().begin()->allocation_info().role());
-
-          writer->field("statuses", std::initializer_list<TaskStatus>{});
-
-          if (taskInfo.has_labels()) {
-            writer->field("labels", taskInfo.labels());
-          }
-
-          if (taskInfo.has_discovery()) {
-            writer->field("discovery", JSON::Protobuf(taskInfo.discovery()));
-          }
-
-          if (taskInfo.has_container()) {
-            writer->field("container", JSON::Protobuf(taskInfo.container()));
-          }
+          writePendingTask(writer, taskInfo, framework_->id());
         });
       }
 
@@ -307,7 +368,10 @@ struct FullFrameworkWriter {
         writer->element(*task);
       }
     });
+  }
 
+  void writeFinishedTasks(JSON::ObjectWriter* writer) const
+  {
     writer->field("unreachable_tasks", [this](JSON::ArrayWriter* writer) {
       foreachvalue (const Owned<Task>& task, framework_->unreachableTasks) {
         // Skip unauthorized tasks.
@@ -329,48 +393,12 @@ struct FullFrameworkWriter {
         writer->element(*task.get());
       }
     });
-
-    // Model all of the offers associated with a framework.
-    writer->field("offers", [this](JSON::ArrayWriter* writer) {
-      foreach (Offer* offer, framework_->offers) {
-        writer->element(*offer);
-      }
-    });
-
-    // Model all of the executors of a framework.
-    writer->field("executors", [this](JSON::ArrayWriter* writer) {
-      foreachpair (
-          const SlaveID& slaveId,
-          const auto& executorsMap,
-          framework_->executors) {
-        foreachvalue (const ExecutorInfo& executor, executorsMap) {
-          writer->element([this,
-                           &executor,
-                           &slaveId](JSON::ObjectWriter* writer) {
-            // Skip unauthorized executors.
-            if (!approveViewExecutorInfo(
-                    executorApprover_,
-                    executor,
-                    framework_->info)) {
-              return;
-            }
-
-            json(writer, executor);
-            writer->field("slave_id", slaveId.value());
-          });
-        }
-      }
-    });
-
-    // Model all of the labels associated with a framework.
-    if (framework_->info.has_labels()) {
-      writer->field("labels", framework_->info.labels());
-    }
   }
 
   const Owned<ObjectApprover>& taskApprover_;
   const Owned<ObjectApprover>& executorApprover_;
   const Framework* framework_;
+  const bool tasks_;
 };
 
 
@@ -2585,11 +2613,19 @@ string Master::Http::STATE_HELP()
         "Returns 503 SERVICE_UNAVAILABLE if the leading master cannot be",
         "found.",
         "",
+        "Returns 304 NOT_MODIFIED if the request has an If-None-Match",
+        "header with the ETag of the current state.",
+        "",
         "This endpoint shows information about the frameworks, tasks,",
         "executors, and agents running in the cluster as a JSON object.",
         "The information shown might be filtered based on the user",
         "accessing the endpoint.",
         "",
+        "If authorization is disabled, the state is served from a snapshot",
+        "that is updated incrementally and tagged with an ETag. A request",
+        "that only accepts 'application/x-protobuf' gets the snapshot as a",
+        "serialized `GET_STATE` response of the v1 operator API.",
+        "",
         "Example (**Note**: this is not exhaustive):",
         "",
         "```",
@@ -2686,32 +2722,33 @@ Future<Response> Master::Http::state(
     return redirect(request);
   }
 
-  // Retrieve `ObjectApprover`s for authorizing frameworks and tasks.
-  Future<Owned<ObjectApprover>> frameworksApprover;
-  Future<Owned<ObjectApprover>> tasksApprover;
-  Future<Owned<ObjectApprover>> executorsApprover;
-  Future<Owned<ObjectApprover>> flagsApprover;
+  // Without an authorizer every request gets to see the same state,
+  // so we bring the cached snapshot up to date and let the cache
+  // serve it. Serializing the full state of a large cluster for every
+  // request would block the master for a long time.
+  if (master->authorizer.isNone()) {
+    updateStateCache();
+    return master->stateSnapshot.cache->state(request);
+  }
 
-  if (master->authorizer.isSome()) {
-    Option<authorization::Subject> subject = createSubject(principal);
+  // Retrieve `ObjectApprover`s for authorizing frameworks and tasks.
+  Option<authorization::Subject> subject = createSubject(principal);
 
-    frameworksApprover = master->authorizer.get()->getObjectApprover(
+  Future<Owned<ObjectApprover>> frameworksApprover =
+    master->authorizer.get()->getObjectApprover(
         subject, authorization::VIEW_FRAMEWORK);
 
-    tasksApprover = master->authorizer.get()->getObjectApprover(
+  Future<Owned<ObjectApprover>> tasksApprover =
+    master->authorizer.get()->getObjectApprover(
         subject, authorization::VIEW_TASK);
 
-    executorsApprover = master->authorizer.get()->getObjectApprover(
+  Future<Owned<ObjectApprover>> executorsApprover =
+    master->authorizer.get()->getObjectApprover(
         subject, authorization::VIEW_EXECUTOR);
 
-    flagsApprover = master->authorizer.get()->getObjectApprover(
+  Future<Owned<ObjectApprover>> flagsApprover =
+    master->authorizer.get()->getObjectApprover(
         subject, authorization::VIEW_FLAGS);
-  } else {
-    frameworksApprover = Owned<ObjectApprover>(new AcceptingObjectApprover());
-    tasksApprover = Owned<ObjectApprover>(new AcceptingObjectApprover());
-    executorsApprover = Owned<ObjectApprover>(new AcceptingObjectApprover());
-    flagsApprover = Owned<ObjectApprover>(new AcceptingObjectApprover());
-  }
 
   return collect(
       frameworksApprover,
@@ -2738,70 +2775,7 @@ Future<Response> Master::Http::state(
             executorsApprover,
             flagsApprover) = approvers;
 
-        writer->field("version", MESOS_VERSION);
-
-        if (build::GIT_SHA.isSome()) {
-          writer->field("git_sha", build::GIT_SHA.get());
-        }
-
-        if (build::GIT_BRANCH.isSome()) {
-          writer->field("git_branch", build::GIT_BRANCH.get());
-        }
-
-        if (build::GIT_TAG.isSome()) {
-          writer->field("git_tag", build::GIT_TAG.get());
-        }
-
-        writer->field("build_date", build::DATE);
-        writer->field("build_time", build::TIME);
-        writer->field("build_user", build::USER);
-        writer->field("start_time", master->startTime.secs());
-
-        if (master->electedTime.isSome()) {
-          writer->field("elected_time", master->electedTime.get().secs());
-        }
-
-        writer->field("id", master->info().id());
-        writer->field("pid", string(master->self()));
-        writer->field("hostname", master->info().hostname());
-        writer->field("activated_slaves", master->_slaves_active());
-        writer->field("deactivated_slaves", master->_slaves_inactive());
-        writer->field("unreachable_slaves", master->_slaves_unreachable());
-
-        // TODO(haosdent): Deprecated this in favor of `leader_info` below.
-        if (master->leader.isSome()) {
-          writer->field("leader", master->leader.get().pid());
-        }
-
-        if (master->leader.isSome()) {
-          writer->field("leader_info", [this](JSON::ObjectWriter* writer) {
-            json(writer, master->leader.get());
-          });
-        }
-
-        if (approveViewFlags(flagsApprover)) {
-          if (master->flags.cluster.isSome()) {
-            writer->field("cluster", master->flags.cluster.get());
-          }
-
-          if (master->flags.log_dir.isSome()) {
-            writer->field("log_dir", master->flags.log_dir.get());
-          }
-
-          if (master->flags.external_log_file.isSome()) {
-            writer->field("external_log_file",
-                          master->flags.external_log_file.get());
-          }
-
-          writer->field("flags", [this](JSON::ObjectWriter* writer) {
-              foreachvalue (const flags::Flag& flag, master->flags) {
-                Option<string> value = flag.stringify(master->flags);
-                if (value.isSome()) {
-                  writer->field(flag.effective_name().value, value.get());
-                }
-              }
-            });
-        }
+        writeStateFields(writer, flagsApprover);
 
         // Model all of the registered slaves.
         writer->field("slaves", [this](JSON::ArrayWriter* writer) {
@@ -2810,15 +2784,6 @@ Future<Response> Master::Http::state(
           }
         });
 
-        // Model all of the recovered slaves.
-        writer->field("recovered_slaves", [this](JSON::ArrayWriter* writer) {
-          foreachvalue (const SlaveInfo& slaveInfo, master->slaves.recovered) {
-            writer->element([&slaveInfo](JSON::ObjectWriter* writer) {
-              json(writer, slaveInfo);
-            });
-          }
-        });
-
         // Model all of the frameworks.
         writer->field(
             "frameworks",
@@ -2859,61 +2824,430 @@ Future<Response> Master::Http::state(
                 writer->element(frameworkWriter);
               }
             });
+      };
 
-        // Model all of the orphan tasks. Such tasks are only possible
-        // if the cluster contains pre-1.0 agents.
-        //
-        // TODO(neilc): Remove this once we break compatibility with
-        // pre-1.0 agents.
-        writer->field("orphan_tasks", [this](
-            JSON::ArrayWriter* writer) {
-          foreachvalue (const Slave* slave, master->slaves.registered) {
-            typedef hashmap<TaskID, Task*> TaskMap;
-            foreachvalue (const TaskMap& tasks, slave->tasks) {
-              foreachvalue (const Task* task, tasks) {
-                const FrameworkID& frameworkId = task->framework_id();
-                if (!master->frameworks.registered.contains(frameworkId)) {
-                  // If authorization is enabled, do not show any
-                  // orphan tasks. We need the task's FrameworkInfo to
-                  // authorize it, but if we had its FrameworkInfo, it
-                  // would not be an orphan.
-                  if (master->authorizer.isSome()) {
-                    continue;
-                  }
-
-                  writer->element(*task);
-                }
-              }
-            }
+      return OK(jsonify(state), request.url.query.get("jsonp"));
+    }));
+}
+
+
+void Master::Http::writeStateFields(
+    JSON::ObjectWriter* writer,
+    const Owned<ObjectApprover>& flagsApprover) const
+{
+  writer->field("version", MESOS_VERSION);
+
+  if (build::GIT_SHA.isSome()) {
+    writer->field("git_sha", build::GIT_SHA.get());
+  }
+
+  if (build::GIT_BRANCH.isSome()) {
+    writer->field("git_branch", build::GIT_BRANCH.get());
+  }
+
+  if (build::GIT_TAG.isSome()) {
+    writer->field("git_tag", build::GIT_TAG.get());
+  }
+
+  writer->field("build_date", build::DATE);
+  writer->field("build_time", build::TIME);
+  writer->field("build_user", build::USER);
+  writer->field("start_time", master->startTime.secs());
+
+  if (master->electedTime.isSome()) {
+    writer->field("elected_time", master->electedTime.get().secs());
+  }
+
+  writer->field("id", master->info().id());
+  writer->field("pid", string(master->self()));
+  writer->field("hostname", master->info().hostname());
+  writer->field("activated_slaves", master->_slaves_active());
+  writer->field("deactivated_slaves", master->_slaves_inactive());
+  writer->field("unreachable_slaves", master->_slaves_unreachable());
+
+  // TODO(haosdent): Deprecated this in favor of `leader_info` below.
+  if (master->leader.isSome()) {
+    writer->field("leader", master->leader.get().pid());
+  }
+
+  if (master->leader.isSome()) {
+    writer->field("leader_info", [this](JSON::ObjectWriter* writer) {
+      json(writer, master->leader.get());
+    });
+  }
+
+  if (approveViewFlags(flagsApprover)) {
+    if (master->flags.cluster.isSome()) {
+      writer->field("cluster", master->flags.cluster.get());
+    }
+
+    if (master->flags.log_dir.isSome()) {
+      writer->field("log_dir", master->flags.log_dir.get());
+    }
+
+    if (master->flags.external_log_file.isSome()) {
+      writer->field("external_log_file",
+                    master->flags.external_log_file.get());
+    }
+
+    writer->field("flags", [this](JSON::ObjectWriter* writer) {
+        foreachvalue (const flags::Flag& flag, master->flags) {
+          Option<string> value = flag.stringify(master->flags);
+          if (value.isSome()) {
+            writer->field(flag.effective_name().value, value.get());
           }
-        });
+        }
+      });
+  }
 
-        // Model all unregistered frameworks. Such frameworks are only
-        // possible if the cluster contains pre-1.0 agents.
-        //
-        // TODO(neilc): Remove this once we break compatibility with
-        // pre-1.0 agents.
-        //
-        // TODO(vinod): Need to filter these frameworks based on authorization!
-        // See the TODO above for "orphan_tasks" for further details.
-        writer->field("unregistered_frameworks", [this](
-            JSON::ArrayWriter* writer) {
-          // Find unregistered frameworks.
-          hashset<FrameworkID> frameworkIds;
-          foreachvalue (const Slave* slave, master->slaves.registered) {
-            foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-              if (!master->frameworks.registered.contains(frameworkId) &&
-                  !frameworkIds.contains(frameworkId)) {
-                writer->element(frameworkId.value());
-                frameworkIds.insert(frameworkId);
-              }
-            }
+  // Model all of the recovered slaves.
+  writer->field("recovered_slaves", [this](JSON::ArrayWriter* writer) {
+    foreachvalue (const SlaveInfo& slaveInfo, master->slaves.recovered) {
+      writer->element([&slaveInfo](JSON::ObjectWriter* writer) {
+        json(writer, slaveInfo);
+      });
+    }
+  });
+
+  // Model all of the orphan tasks. Such tasks are only possible
+  // if the cluster contains pre-1.0 agents.
+  //
+  // TODO(neilc): Remove this once we break compatibility with
+  // pre-1.0 agents.
+  writer->field("orphan_tasks", [this](JSON::ArrayWriter* writer) {
+    // If authorization is enabled, do not show any orphan tasks. We
+    // need the task's FrameworkInfo to authorize it, but if we had
+    // its FrameworkInfo, it would not be an orphan.
+    if (master->authorizer.isSome()) {
+      return;
+    }
+
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      typedef hashmap<TaskID, Task*> TaskMap;
+      foreachpair (const FrameworkID& frameworkId,
+                   const TaskMap& tasks,
+                   slave->tasks) {
+        if (!master->frameworks.registered.contains(frameworkId)) {
+          foreachvalue (const Task* task, tasks) {
+            writer->element(*task);
           }
-        });
-      };
+        }
+      }
+    }
+  });
 
-      return OK(jsonify(state), request.url.query.get("jsonp"));
+  // Model all unregistered frameworks. Such frameworks are only
+  // possible if the cluster contains pre-1.0 agents.
+  //
+  // TODO(neilc): Remove this once we break compatibility with
+  // pre-1.0 agents.
+  //
+  // TODO(vinod): Need to filter these frameworks based on authorization!
+  // See the TODO above for "orphan_tasks" for further details.
+  writer->field("unregistered_frameworks", [this](
+      JSON::ArrayWriter* writer) {
+    // Find unregistered frameworks.
+    hashset<FrameworkID> frameworkIds;
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      foreachkey (const FrameworkID& frameworkId, slave->tasks) {
+        if (!master->frameworks.registered.contains(frameworkId) &&
+            !frameworkIds.contains(frameworkId)) {
+          writer->element(frameworkId.value());
+          frameworkIds.insert(frameworkId);
+        }
+      }
+    }
+  });
+}
+
+
+// Adds the executors of `framework` to the partial `GetState`.
+static void addExecutors(
+    mesos::master::Response::GetState* getState,
+    const Framework& framework)
+{
+  foreachpair (const SlaveID& slaveId,
+               const auto& executorsMap,
+               framework.executors) {
+    foreachvalue (const ExecutorInfo& executorInfo, executorsMap) {
+      mesos::master::Response::GetExecutors::Executor* executor =
+        getState->mutable_get_executors()->add_executors();
+
+      executor->mutable_executor_info()->CopyFrom(executorInfo);
+      executor->mutable_slave_id()->CopyFrom(slaveId);
+    }
+  }
+}
+
+
+// Adds the unreachable and completed tasks of `framework` to the
+// partial `GetState`.
+static void addFinishedTasks(
+    mesos::master::Response::GetState* getState,
+    const Framework& framework)
+{
+  mesos::master::Response::GetTasks* getTasks = getState->mutable_get_tasks();
+
+  foreachvalue (const Owned<Task>& task, framework.unreachableTasks) {
+    getTasks->add_unreachable_tasks()->CopyFrom(*task);
+  }
+
+  foreach (const Owned<Task>& task, framework.completedTasks) {
+    getTasks->add_completed_tasks()->CopyFrom(*task);
+  }
+}
+
+
+void Master::Http::updateStateCache() const
+{
+  CHECK_NONE(master->authorizer);
+
+  const Owned<ObjectApprover> approver(new AcceptingObjectApprover());
+
+  Master::StateSnapshot& snapshot = master->stateSnapshot;
+
+  Owned<StateDelta> delta(new StateDelta());
+
+  // The global fields are cheap to serialize, apart from the orphan
+  // tasks and executors which only exist with pre-1.0 agents, so they
+  // are serialized from scratch whenever anything in them may have
+  // changed.
+  if (snapshot.global) {
+    StateFragment global;
+    global.json = string(jsonify([&](JSON::ObjectWriter* writer) {
+      writeStateFields(writer, approver);
     }));
+
+    mesos::master::Response::GetState getState;
+
+    foreachvalue (const SlaveInfo& slaveInfo, master->slaves.recovered) {
+      getState.mutable_get_agents()->add_recovered_agents()
+        ->CopyFrom(slaveInfo);
+    }
+
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      typedef hashmap<TaskID, Task*> TaskMap;
+      foreachpair (const FrameworkID& frameworkId,
+                   const TaskMap& tasks,
+                   slave->tasks) {
+        if (!master->frameworks.registered.contains(frameworkId)) {
+          foreachvalue (const Task* task, tasks) {
+            getState.mutable_get_tasks()->add_orphan_tasks()->CopyFrom(*task);
+          }
+        }
+      }
+
+      typedef hashmap<ExecutorID, ExecutorInfo> ExecutorMap;
+      foreachpair (const FrameworkID& frameworkId,
+                   const ExecutorMap& executors,
+                   slave->executors) {
+        if (!master->frameworks.registered.contains(frameworkId)) {
+          foreachvalue (const ExecutorInfo& executorInfo, executors) {
+            mesos::master::Response::GetExecutors::Executor* executor =
+              getState.mutable_get_executors()->add_orphan_executors();
+
+            executor->mutable_executor_info()->CopyFrom(executorInfo);
+            executor->mutable_slave_id()->CopyFrom(slave->id);
+          }
+        }
+      }
+    }
+
+    global.protobuf = getState.SerializeAsString();
+
+    delta->global = global;
+  }
+
+  // Agents, only those that were added, changed or removed.
+  foreach (const SlaveID& slaveId, snapshot.changedSlaves) {
+    Slave* slave = master->slaves.registered.get(slaveId);
+
+    if (slave == nullptr) {
+      if (snapshot.slaves.contains(slaveId)) {
+        delta->slaves[slaveId] = None();
+        snapshot.slaves.erase(slaveId);
+      }
+
+      continue;
+    }
+
+    StateFragment fragment;
+    fragment.json = string(jsonify(Full<Slave>(*slave)));
+
+    mesos::master::Response::GetState getState;
+    getState.mutable_get_agents()->add_agents()->CopyFrom(
+        protobuf::master::event::createAgentResponse(*slave));
+
+    fragment.protobuf = getState.SerializeAsString();
+
+    delta->slaves[slaveId] = fragment;
+
+    snapshot.slaves.insert(slaveId);
+  }
+
+  snapshot.changedSlaves.clear();
+
+  // Frameworks, only those that were added, changed or removed.
+  foreach (const FrameworkID& frameworkId, snapshot.changedFrameworks) {
+    Framework* framework =
+      master->frameworks.registered.get(frameworkId).getOrElse(nullptr);
+
+    if (framework == nullptr) {
+      if (snapshot.frameworks.contains(frameworkId)) {
+        delta->frameworks[frameworkId] = None();
+        snapshot.frameworks.erase(frameworkId);
+      }
+
+      continue;
+    }
+
+    const bool added = !snapshot.frameworks.contains(frameworkId);
+
+    if (added || framework->changes.framework) {
+      StateFragment fragment;
+      fragment.json = string(jsonify(
+          FullFrameworkWriter(approver, approver, framework, false)));
+
+      mesos::master::Response::GetState getState;
+      getState.mutable_get_frameworks()->add_frameworks()->CopyFrom(
+          model(*framework));
+
+      addExecutors(&getState, *framework);
+
+      fragment.protobuf = getState.SerializeAsString();
+
+      delta->frameworks[frameworkId] = fragment;
+    }
+
+    if (added || framework->changes.finishedTasks) {
+      StateFragment fragment;
+      fragment.json = string(jsonify(
+          [&approver, framework](JSON::ObjectWriter* writer) {
+            FullFrameworkWriter(approver, approver, framework)
+              .writeFinishedTasks(writer);
+          }));
+
+      mesos::master::Response::GetState getState;
+      addFinishedTasks(&getState, *framework);
+
+      fragment.protobuf = getState.SerializeAsString();
+
+      delta->finishedTasks[frameworkId] = fragment;
+    }
+
+    // A newly added framework gets all of its tasks serialized,
+    // otherwise only the tasks that changed.
+    vector<TaskID> taskIds;
+    if (added) {
+      foreachkey (const TaskID& taskId, framework->pendingTasks) {
+        taskIds.push_back(taskId);
+      }
+
+      foreachkey (const TaskID& taskId, framework->tasks) {
+        taskIds.push_back(taskId);
+      }
+    } else {
+      foreach (const TaskID& taskId, framework->changes.tasks) {
+        taskIds.push_back(taskId);
+      }
+    }
+
+    foreach (const TaskID& taskId, taskIds) {
+      Option<StateFragment> fragment;
+
+      mesos::master::Response::GetState getState;
+
+      if (framework->pendingTasks.contains(taskId)) {
+        const TaskInfo& taskInfo = framework->pendingTasks.at(taskId);
+
+        fragment = StateFragment();
+        fragment->json = string(jsonify(
+            [&taskInfo, &frameworkId](JSON::ObjectWriter* writer) {
+              writePendingTask(writer, taskInfo, frameworkId);
+            }));
+
+        getState.mutable_get_tasks()->add_pending_tasks()->CopyFrom(
+            protobuf::createTask(taskInfo, TASK_STAGING, frameworkId));
+
+        fragment->protobuf = getState.SerializeAsString();
+      } else if (framework->tasks.contains(taskId)) {
+        const Task& task = *framework->tasks.at(taskId);
+
+        fragment = StateFragment();
+        fragment->json = string(jsonify(task));
+
+        getState.mutable_get_tasks()->add_tasks()->CopyFrom(task);
+
+        fragment->protobuf = getState.SerializeAsString();
+      }
+
+      delta->tasks[frameworkId][taskId] = fragment;
+    }
+
+    framework->changes.framework = false;
+    framework->changes.finishedTasks = false;
+    framework->changes.tasks.clear();
+
+    snapshot.frameworks.insert(frameworkId);
+  }
+
+  snapshot.changedFrameworks.clear();
+
+  // Completed frameworks, which do not change anymore. They are only
+  // added when a framework is removed, which also changes the global
+  // fields.
+  if (snapshot.global) {
+    vector<FrameworkID> removedCompletedFrameworks;
+    foreach (const FrameworkID& frameworkId, snapshot.completedFrameworks) {
+      if (!master->frameworks.completed.contains(frameworkId)) {
+        removedCompletedFrameworks.push_back(frameworkId);
+      }
+    }
+
+    foreach (const FrameworkID& frameworkId, removedCompletedFrameworks) {
+      delta->completedFrameworks[frameworkId] = None();
+      snapshot.completedFrameworks.erase(frameworkId);
+    }
+
+    foreachvalue (const Owned<Framework>& framework,
+                  master->frameworks.completed) {
+      const FrameworkID& frameworkId = framework->id();
+
+      if (snapshot.completedFrameworks.contains(frameworkId)) {
+        continue;
+      }
+
+      StateFragment fragment;
+      fragment.json = string(jsonify(
+          FullFrameworkWriter(approver, approver, framework.get())));
+
+      mesos::master::Response::GetState getState;
+      getState.mutable_get_frameworks()->add_completed_frameworks()->CopyFrom(
+          model(*framework));
+
+      addExecutors(&getState, *framework);
+      addFinishedTasks(&getState, *framework);
+
+      foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
+        getState.mutable_get_tasks()->add_pending_tasks()->CopyFrom(
+            protobuf::createTask(taskInfo, TASK_STAGING, frameworkId));
+      }
+
+      foreachvalue (const Task* task, framework->tasks) {
+        getState.mutable_get_tasks()->add_tasks()->CopyFrom(*task);
+      }
+
+      fragment.protobuf = getState.SerializeAsString();
+
+      delta->completedFrameworks[frameworkId] = fragment;
+
+      snapshot.completedFrameworks.insert(frameworkId);
+    }
+  }
+
+  snapshot.global = false;
+
+  snapshot.cache->update(delta);
 }
 
 
@@ -7,16 +7,31 @@
 
 #ifndef CHAMELEON_LEMON_MILP_HPP
 #define CHAMELEON_LEMON_MILP_HPP
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <set>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 // google
 #include <glog/logging.h>
 //#include <gflags/gflags.h>
 // lemon
 #include <lemon/lp.h>
+// libprocess
+#include <process/id.hpp>
+#include <process/process.hpp>
+
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+
+#include "bt_linear_model.hpp"
 
 using std::make_shared;
 using std::set;
@@ -27,72 +42,6 @@ using std::vector;
 
 namespace chameleon {
 
-class BTLinearModel
-{
-public:
-  explicit BTLinearModel(
-    const string& name,
-    const double coe_cpu,
-    const double coe_mem,
-    const double c)
-    : m_name(name), m_coe_cpu(coe_cpu), m_coe_mem(coe_mem), m_c(c)
-  {}
-
-  int reduced_cores;
-  int reduced_executors;
-  int reduced_mem;
-  int reduced_per_mem;
-  int cores_max;
-  int per_executor_cores;
-  int per_executor_memory;
-  int overall_executors;
-
-  const string m_name;
-  double m_coe_cpu;
-  double m_coe_mem;
-  double m_c;
-
-  int lower_bound_reduced_cores;
-  int lower_bound_reduced_mem;
-
-  ~BTLinearModel() {}
-
-  template <typename... Args>
-  static std::string str_format(const std::string& format, Args... args)
-  {
-    auto size_buf = std::snprintf(nullptr, 0, format.c_str(), args...) + 1;
-    std::unique_ptr<char[]> buf(new (std::nothrow) char[size_buf]);
-
-    if (!buf) return std::string("");
-
-    std::snprintf(buf.get(), size_buf, format.c_str(), args...);
-    return std::string(buf.get(), buf.get() + size_buf - 1);
-  }
-
-  string info()
-  {
-    string result = str_format(
-      "model name is %s, m_coe_cpu is %lf, m_coe_mem is %lf, m_c is %lf.\n"
-      "overall_executors is %d,  per_executor_cores is %d, per_executor_memory "
-      "is %d. \n"
-      "reduced_cores is %d,  reduced_executors is %d, reduced_mem is %d, "
-      "reduced_per_mem is %d.",
-      m_name.c_str(),
-      m_coe_cpu,
-      m_coe_mem,
-      m_c,
-      overall_executors,
-      per_executor_cores,
-      per_executor_memory,
-      reduced_cores,
-      reduced_executors,
-      reduced_mem,
-      reduced_per_mem);
-    //            LOG(INFO)<<result;
-    return result;
-  }
-};
-
 class MILP
 {
 public:
@@ -100,40 +49,6 @@ public:
 
   static void insert_new_lp_model(const string& name)
   {
-    using namespace lemon;
-    // Create an instance of the default MIP solver class
-    // (it will represent an "empty" problem at first)
-    Mip mip;
-    // Add two columns (variables) to the problem
-    Mip::Col x1 = mip.addCol();
-    Mip::Col x2 = mip.addCol();
-    // Add rows (constraints) to the problem
-    //    mip.addRow(x1 - 5 <= x2);
-    mip.addRow(x1 + x2 == 14);
-    mip.addRow(0 <= 2 * x1 + x2 <= 25);
-
-    // Set lower and upper bounds for the columns (variables)
-    mip.colLowerBound(x1, 0);
-    mip.colUpperBound(x2, 10);
-
-    // Set the type of the columns
-    mip.colType(x1, Mip::INTEGER);
-    mip.colType(x2, Mip::REAL);
-
-    // Specify the objective function
-    mip.max();
-    mip.obj(5 * x1 + 3 * x2);
-
-    // Solve the problem using the underlying MIP solver
-    mip.solve();
-    // Print the results
-    if (mip.type() == Mip::OPTIMAL) {
-      std::cout << "Objective function value: " << mip.solValue() << std::endl;
-      std::cout << "x1 = " << mip.sol(x1) << std::endl;
-      std::cout << "x2 = " << mip.sol(x2) << std::endl;
-    } else {
-      std::cout << "Optimal solution not found." << std::endl;
-    }
     // large input datasets
     if (name.find("LDA") != std::string::npos) {
       if (m_bt_lps.count(name) == 0) {
@@ -352,8 +267,8 @@ public:
   static bool m_ILP_solution;
 };
 
-unordered_map<string, BTLinearModel> MILP::m_bt_lps = MILP::create_bts();
-bool MILP::m_ILP_solution = false;
+// NOTE: The static members are defined in master.cpp so that this
+// header can be included from more than one translation unit.
 /**
  *
  * @param lc_name latency-critical framework name, like "repartition"
@@ -364,7 +279,7 @@ bool MILP::m_ILP_solution = false;
  * @return The BTLinearModel with reduced cores and Spark executors as the
  * caculated result of ILP
  */
-vector<BTLinearModel> mix_integer_linear_programming_two(
+inline vector<BTLinearModel> mix_integer_linear_programming_two(
   const string& lc_name,
   const int cpus,
   const int mem,
@@ -479,7 +394,7 @@ vector<BTLinearModel> mix_integer_linear_programming_two(
   return result;
 }
 
-vector<BTLinearModel> mix_integer_linear_programming_two_PARTIES(
+inline vector<BTLinearModel> mix_integer_linear_programming_two_PARTIES(
   const string& lc_name,
   const int cpus,
   const int mem,
@@ -570,7 +485,7 @@ vector<BTLinearModel> mix_integer_linear_programming_two_PARTIES(
  * @return The BTLinearModel with reduced cores and Spark executors as the
  * caculated result of ILP
  */
-vector<BTLinearModel> mix_integer_linear_programming_three(
+inline vector<BTLinearModel> mix_integer_linear_programming_three(
   const string& lc_name,
   const int cpus,
   const int mem,
@@ -722,6 +637,248 @@ vector<BTLinearModel> mix_integer_linear_programming_three(
 }
 
 
+/**
+ * Solves the repartitioning of resources from BT workloads to a
+ * latency-critical application on its own actor, so that the master
+ * keeps processing messages while the solver runs.
+ *
+ * For the MILP strategy the lemon `Mip` model is kept between calls:
+ * every BT workload owns two integer columns (its reduced cores and
+ * memory) and two rows require them to add up to the targeted cpus
+ * and memory. Adding a workload only adds its columns and updates the
+ * rows and the objective, and since the solver keeps its basis the LP
+ * relaxation is warm-started from the previous solution.
+ */
+class MILPSolverProcess : public process::Process<MILPSolverProcess>
+{
+public:
+  enum class Strategy
+  {
+    // Solves the mixed integer linear program, see
+    // `mix_integer_linear_programming_two()`.
+    MILP,
+
+    // Splits the resources evenly, see
+    // `mix_integer_linear_programming_two_PARTIES()`.
+    PARTIES
+  };
+
+  /**
+   * @param strategy: how to repartition the resources
+   * @param workloads: the number of BT workloads to repartition across
+   * @param cores_upper_bound: the most cores to take from a BT workload
+   */
+  explicit MILPSolverProcess(
+    Strategy strategy,
+    size_t workloads = 2,
+    int cores_upper_bound = 20)
+    : ProcessBase(process::ID::generate("milp-solver")),
+      m_strategy(strategy),
+      m_workloads(workloads),
+      m_cores_upper_bound(cores_upper_bound)
+  {}
+
+  /**
+   * @param lc_name latency-critical framework name, like "repartition"
+   * @param cpus: the targeted cpus to be reduced
+   * @param mem: the targeted amount of memory to be reduced in MB
+   * @param bt_names: the registered BT framework names
+   * @return The BTLinearModels of the frameworks, in the same order, with
+   * the reduced cores and Spark executors as the caculated result, or an
+   * empty vector if there is no solution (e.g., too few frameworks yet)
+   */
+  vector<BTLinearModel> repartition(
+    const string& lc_name,
+    const int cpus,
+    const int mem,
+    const vector<string>& bt_names)
+  {
+    foreach (const string& name, bt_names) {
+      MILP::insert_new_lp_model(name);
+    }
+
+    if (bt_names.size() != m_workloads) {
+      return vector<BTLinearModel>();
+    }
+
+    metrics.solve.start();
+
+    vector<BTLinearModel> result;
+    switch (m_strategy) {
+      case Strategy::MILP:
+        result = solve(cpus, mem, bt_names);
+        break;
+      case Strategy::PARTIES:
+        result = mix_integer_linear_programming_two_PARTIES(
+          lc_name, cpus, mem, bt_names);
+        break;
+    }
+
+    Duration elapsed = metrics.solve.stop();
+
+    LOG(INFO) << "Repartitioned " << cpus << " cpus and " << mem << " MB of "
+              << "memory across " << bt_names.size() << " BT workloads in "
+              << elapsed;
+
+    return result;
+  }
+
+  /**
+   * @param name: the BT framework name
+   * @return The ids of the reduced cores and memory columns of the
+   * workload in the kept model, or none if it is not part of it.
+   */
+  Option<std::pair<int, int>> columns(const string& name)
+  {
+    if (m_columns.count(name) == 0) {
+      return None();
+    }
+
+    const Columns& columns = m_columns.at(name);
+
+    return std::make_pair(
+      lemon::Mip::id(columns.cores),
+      lemon::Mip::id(columns.mem));
+  }
+
+private:
+  // The columns of a BT workload in the model.
+  struct Columns
+  {
+    lemon::Mip::Col cores;
+    lemon::Mip::Col mem;
+  };
+
+  vector<BTLinearModel> solve(
+    const int cpus,
+    const int mem,
+    const vector<string>& bt_names)
+  {
+    using namespace lemon;
+
+    vector<BTLinearModel> result;
+
+    foreach (const string& name, bt_names) {
+      if (MILP::m_bt_lps.count(name) == 0) {
+        LOG(INFO) << "cannot find the specified model!!! ";
+        return result;
+      }
+    }
+
+    // Remove the workloads that are no longer part of the problem.
+    for (auto it = m_columns.begin(); it != m_columns.end();) {
+      if (std::find(bt_names.begin(), bt_names.end(), it->first) ==
+          bt_names.end()) {
+        m_mip.erase(it->second.cores);
+        m_mip.erase(it->second.mem);
+        it = m_columns.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    // Add the columns of the new workloads.
+    foreach (const string& name, bt_names) {
+      if (m_columns.count(name) == 0) {
+        const BTLinearModel& model = MILP::m_bt_lps.at(name);
+
+        Columns columns;
+        columns.cores = m_mip.addCol();
+        columns.mem = m_mip.addCol();
+
+        m_mip.colLowerBound(columns.cores, model.lower_bound_reduced_cores);
+        m_mip.colLowerBound(columns.mem, model.lower_bound_reduced_mem);
+        m_mip.colUpperBound(columns.cores, m_cores_upper_bound);
+
+        m_mip.colType(columns.cores, Mip::INTEGER);
+        m_mip.colType(columns.mem, Mip::INTEGER);
+
+        m_columns.insert({name, columns});
+      }
+    }
+
+    // Update the rows (constraints) and the objective function.
+    Mip::Expr cores, memory, objective;
+    foreach (const string& name, bt_names) {
+      const BTLinearModel& model = MILP::m_bt_lps.at(name);
+      const Columns& columns = m_columns.at(name);
+
+      cores += columns.cores;
+      memory += columns.mem;
+      objective += model.m_coe_cpu * columns.cores +
+                   model.m_coe_mem * columns.mem + model.m_c;
+    }
+
+    if (m_cores_row.isNone()) {
+      m_cores_row = m_mip.addRow(cores == cpus);
+      m_mem_row = m_mip.addRow(memory == mem);
+    } else {
+      m_mip.row(m_cores_row.get(), cores == cpus);
+      m_mip.row(m_mem_row.get(), memory == mem);
+    }
+
+    m_mip.min();
+    m_mip.obj(objective);
+
+    m_mip.solve();
+
+    if (m_mip.type() != Mip::OPTIMAL) {
+      LOG(INFO) << "Optimal solution not found.";
+      return result;
+    }
+
+    LOG(INFO) << "Objective function value: " << m_mip.solValue();
+
+    foreach (const string& name, bt_names) {
+      BTLinearModel& model = MILP::m_bt_lps.at(name);
+      const Columns& columns = m_columns.at(name);
+
+      model.reduced_cores = m_mip.sol(columns.cores);
+      model.reduced_executors =
+        model.reduced_cores / model.per_executor_cores;
+      model.reduced_mem = m_mip.sol(columns.mem);
+      model.reduced_per_mem =
+        (model.reduced_mem -
+         model.per_executor_memory * model.reduced_executors) /
+        (model.overall_executors - model.reduced_executors);
+
+      LOG(INFO) << model.info();
+
+      result.push_back(model);
+    }
+
+    return result;
+  }
+
+  struct Metrics
+  {
+    Metrics()
+      : solve("master/repartition_solve", Days(1))
+    {
+      process::metrics::add(solve);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(solve);
+    }
+
+    process::metrics::Timer<Milliseconds> solve;
+  };
+
+  const Strategy m_strategy;
+  const size_t m_workloads;
+  const int m_cores_upper_bound;
+
+  lemon::Mip m_mip;
+  unordered_map<string, Columns> m_columns;
+  Option<lemon::Mip::Row> m_cores_row;
+  Option<lemon::Mip::Row> m_mem_row;
+
+  Metrics metrics;
+};
+
+
 } // namespace chameleon
 
 
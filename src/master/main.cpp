@@ -400,6 +400,13 @@ int main(int argc, char** argv)
         << "': " << mkdir.error();
     }
 
+    Option<Log::GroupCommit> groupCommit;
+    if (flags.registry_log_group_commit_window.isSome()) {
+      groupCommit = Log::GroupCommit{
+          flags.registry_log_group_commit_window.get(),
+          flags.registry_log_group_commit_max_actions};
+    }
+
     if (flags.zk.isSome()) {
       // Use replicated log with ZooKeeper.
       if (flags.quorum.isNone()) {
@@ -421,7 +428,8 @@ int main(int argc, char** argv)
           path::join(url.get().path, "log_replicas"),
           url.get().authentication,
           flags.log_auto_initialize,
-          "registrar/");
+          "registrar/",
+          groupCommit);
     } else {
       // Use replicated log without ZooKeeper.
       log = new Log(
@@ -429,9 +437,10 @@ int main(int argc, char** argv)
           path::join(flags.work_dir.get(), "replicated_log"),
           set<UPID>(),
           flags.log_auto_initialize,
-          "registrar/");
+          "registrar/",
+          groupCommit);
     }
-    storage = new LogStorage(log);
+    storage = new LogStorage(log, 0, flags.registry_log_write_window);
 #endif // __WINDOWS__
   } else {
     EXIT(EXIT_FAILURE)
@@ -23,6 +23,7 @@
 #include <fstream>
 #include <iomanip>
 #include <list>
+#include <map>
 #include <memory>
 #include <set>
 #include <sstream>
@@ -82,6 +83,7 @@
 using google::protobuf::RepeatedPtrField;
 
 using std::list;
+using std::map;
 using std::set;
 using std::shared_ptr;
 using std::string;
@@ -110,6 +112,13 @@ using process::http::authentication::Principal;
 
 using process::metrics::Counter;
 
+namespace chameleon {
+
+unordered_map<string, BTLinearModel> MILP::m_bt_lps = MILP::create_bts();
+bool MILP::m_ILP_solution = false;
+
+} // namespace chameleon {
+
 namespace mesos {
 namespace internal {
 namespace master {
@@ -341,6 +350,7 @@ Master::Master(
   this->m_left_cpus = 0;
   this->m_left_memory_GB = 0;
   this->m_marathon_fm = nullptr;
+  this->m_ILP_solution = false;
 }
 
 
@@ -752,6 +762,16 @@ void Master::initialize()
     });
   spawn(whitelistWatcher);
 
+  // The repartitioning of resources from BT frameworks is solved on
+  // its own actor so that it does not block the master.
+  milpSolver = new chameleon::MILPSolverProcess(
+    flags.bt_repartition_strategy == "milp"
+      ? chameleon::MILPSolverProcess::Strategy::MILP
+      : chameleon::MILPSolverProcess::Strategy::PARTIES);
+  spawn(milpSolver);
+
+  stateSnapshot.cache.reset(new StateCache(info_.id()));
+
   nextFrameworkId = 0;
   nextSlaveId = 0;
   nextOfferId = 0;
@@ -1309,6 +1329,12 @@ void Master::finalize()
   wait(whitelistWatcher);
   delete whitelistWatcher;
 
+  terminate(milpSolver);
+  wait(milpSolver);
+  delete milpSolver;
+
+  stateSnapshot.cache.reset();
+
   if (authenticator.isSome()) {
     delete authenticator.get();
   }
@@ -1749,6 +1775,8 @@ Future<Nothing> Master::_recover(const Registry& registry)
     slaves.unreachable[unreachable.id()] = unreachable.timestamp();
   }
 
+  stateSnapshot.global = true;
+
   // Set up a timer for age-based registry GC.
   scheduleRegistryGc();
 
@@ -1936,6 +1964,8 @@ void Master::_doRegistryGc(
     numRemoved++;
   }
 
+  stateSnapshot.global = true;
+
   // TODO(neilc): Add a metric for # of agents discarded from the registry?
   LOG(INFO) << "Garbage collected " << numRemoved
             << " unreachable agents from the registry";
@@ -2085,6 +2115,7 @@ void Master::_markUnreachableAfterFailover(
   ++metrics->recovery_slave_removals;
 
   slaves.unreachable[slaveInfo.id()] = unreachableTime;
+  stateSnapshot.global = true;
 
   sendSlaveLost(slaveInfo);
 }
@@ -2172,6 +2203,9 @@ void Master::detected(const Future<Option<MasterInfo>>& _leader)
 
   bool wasElected = elected();
   leader = _leader.get();
+  stateSnapshot.global = true;
+
+  metrics->elected = elected() ? 1 : 0;
 
   if (elected()) {
     electedTime = Clock::now();
@@ -3038,6 +3072,7 @@ void Master::_subscribe(
       // the allocator has the correct view of the framework's share.
       if (!framework->active()) {
         framework->state = Framework::State::ACTIVE;
+        framework->changed();
         allocator->activateFramework(framework->id());
       }
 
@@ -3136,6 +3171,7 @@ void Master::disconnect(Framework* framework)
   LOG(INFO) << "Disconnecting framework " << *framework;
 
   framework->state = Framework::State::DISCONNECTED;
+  framework->changed();
 
   if (framework->pid.isSome()) {
     // Remove the framework from authenticated. This is safe because
@@ -3159,6 +3195,7 @@ void Master::deactivate(Framework* framework, bool rescind)
   LOG(INFO) << "Deactivating framework " << *framework;
 
   framework->state = Framework::State::INACTIVE;
+  framework->changed();
 
   // Tell the allocator to stop allocating resources to this framework.
   allocator->deactivateFramework(framework->id());
@@ -3211,6 +3248,7 @@ void Master::deactivate(Slave* slave)
   LOG(INFO) << "Deactivating agent " << *slave;
 
   slave->active = false;
+  slave->changed();
 
   allocator->deactivateSlave(slave->id);
 
@@ -3886,6 +3924,7 @@ void Master::accept(Framework* framework, scheduler::Call::Accept accept)
           // a TASK_ERROR after a TASK_KILLED (see _accept())!
           if (!framework->pendingTasks.contains(task.task_id())) {
             framework->pendingTasks[task.task_id()] = task;
+            framework->taskChanged(task.task_id());
           }
 
           // Add to the slave's list of pending tasks.
@@ -4019,6 +4058,7 @@ void Master::_accept(
       foreach (const TaskInfo& task, tasks) {
         // Remove the task from being pending.
         framework->pendingTasks.erase(task.task_id());
+        framework->taskChanged(task.task_id());
         if (slave != nullptr) {
           slave->pendingTasks[framework->id()].erase(task.task_id());
           if (slave->pendingTasks[framework->id()].empty()) {
@@ -4375,6 +4415,7 @@ void Master::_accept(
 
           bool pending = framework->pendingTasks.contains(task.task_id());
           framework->pendingTasks.erase(task.task_id());
+          framework->taskChanged(task.task_id());
           slave->pendingTasks[framework->id()].erase(task.task_id());
           if (slave->pendingTasks[framework->id()].empty()) {
             slave->pendingTasks.erase(framework->id());
@@ -4540,6 +4581,7 @@ void Master::_accept(
         foreach (const TaskInfo& task, taskGroup.tasks()) {
           bool pending = framework->pendingTasks.contains(task.task_id());
           framework->pendingTasks.erase(task.task_id());
+          framework->taskChanged(task.task_id());
           slave->pendingTasks[framework->id()].erase(task.task_id());
           if (slave->pendingTasks[framework->id()].empty()) {
             slave->pendingTasks.erase(framework->id());
@@ -4969,6 +5011,7 @@ void Master::kill(Framework* framework, const scheduler::Call::Kill& kill)
   if (framework->pendingTasks.contains(taskId)) {
     // Remove from pending tasks.
     framework->pendingTasks.erase(taskId);
+    framework->taskChanged(taskId);
 
     if (slaveId.isSome()) {
       Slave* slave = slaves.registered.get(slaveId.get());
@@ -5805,6 +5848,7 @@ void Master::_reregisterSlave(
     slave->version = version;
     slave->reregisteredTime = Clock::now();
     slave->capabilities = agentCapabilities;
+    slave->changed();
 
     allocator->updateSlave(slave->id, None(), agentCapabilities);
 
@@ -5824,6 +5868,7 @@ void Master::_reregisterSlave(
       dispatch(slave->observer, &SlaveObserver::reconnect);
 
       slave->active = true;
+      slave->changed();
       allocator->activateSlave(slave->id);
     }
 
@@ -6027,6 +6072,7 @@ void Master::__reregisterSlave(
 
       if (framework != nullptr) {
         framework->unreachableTasks.erase(task.task_id());
+        framework->finishedTasksChanged();
       }
     } else if (!slaveWasRemoved) {
       // Only re-add non-partition-aware tasks if the master has
@@ -6271,6 +6317,7 @@ void Master::updateSlave(
 
   slave->totalResources =
     slave->totalResources.nonRevocable() + oversubscribedResources.revocable();
+  slave->changed();
 
   // First update the agent's resources in the allocator.
   allocator->updateSlave(slaveId, oversubscribedResources);
@@ -6480,6 +6527,7 @@ void Master::forward(
     if (update.has_uuid()) {
       task->set_status_update_state(update.status().state());
       task->set_status_update_uuid(update.status().uuid());
+      framework->taskChanged(task->task_id());
     }
   }
 
@@ -7179,10 +7227,8 @@ void Master::offer(
       offer->mutable_resources()->MergeFrom(offered);
       using namespace chameleon;
       LOG(INFO) << " framework name is " << framework->info.name();
-      if (
-        MILP::m_ILP_solution == true &&
-        MILP::m_bt_lps.count(framework->info.name())) {
-        BTLinearModel btLinearModel = MILP::m_bt_lps.at(framework->info.name());
+      if (m_ILP_solution && m_bt_models.count(framework->info.name())) {
+        BTLinearModel btLinearModel = m_bt_models.at(framework->info.name());
         LOG(INFO) << "btLinearModel.reduced_executors is "
                   << btLinearModel.reduced_executors;
 
@@ -7234,6 +7280,7 @@ void Master::offer(
       }
 
       offers[offer->id()] = offer;
+      metrics->outstanding_offers = offers.size();
 
       framework->addOffer(offer);
       slave->addOffer(offer);
@@ -7686,6 +7733,9 @@ void Master::addFramework(Framework* framework)
 
   frameworks.registered[framework->id()] = framework;
 
+  framework->changed();
+  stateSnapshot.global = true;
+
   if (framework->connected()) {
     if (framework->pid.isSome()) {
       link(framework->pid.get());
@@ -7704,135 +7754,35 @@ void Master::addFramework(Framework* framework)
   LOG(INFO)<<"framework-name is : "<<temp_framework_name;
   // this->m_lc_cpus ==0 marks that we do not trigger PRSSER.
   using namespace chameleon;
-  MILP::m_ILP_solution=false;
+  m_ILP_solution = false;
   if (  // WordCount // ScalaSort  // NaiveBayes  // SVM // DenseKMeans
     this->m_lc_cpus!=0 && (
     temp_framework_name.find("LDA") != std::string::npos ||
     temp_framework_name.find("TeraSort") != std::string::npos || temp_framework_name.find("Gradient") != std::string::npos || temp_framework_name.find("ALS") != std::string::npos ||temp_framework_name.find("SVD") != std::string::npos || temp_framework_name.find("DenseKMeans") != std::string::npos || temp_framework_name.find("WordCount") != std::string::npos || temp_framework_name.find("ScalaSort") != std::string::npos  || temp_framework_name.find("NaiveBayes") != std::string::npos || temp_framework_name.find("SVM") != std::string::npos)) {
 
     framework->state = Framework::State::INACTIVE;
-    chameleon::MILP::insert_new_lp_model(framework->info.name());
+    framework->changed();
     m_registered_framework_names.push_back(framework->info.name());
     m_registered_fw_ids.insert({framework->info.name(), framework->id()});
     LOG(INFO)<<"lele 2 BT workloads";
-    vector<BTLinearModel> btl_models =
-//      chameleon::mix_integer_linear_programming_two(
-        chameleon::mix_integer_linear_programming_two_PARTIES(
+    dispatch(
+        milpSolver,
+        &MILPSolverProcess::repartition,
         "repartition",
         this->m_lc_cpus,
         this->m_lc_memory * 1024,
-        m_registered_framework_names);
-//    LOG(INFO)<<"lele 3 BT workloads";
-//    vector<BTLinearModel> btl_models =
-//      chameleon::mix_integer_linear_programming_three(
-//        "repartition",
-//        this->m_lc_cpus,
-//        this->m_lc_memory * 1024,
-//        m_registered_framework_names);
-    if (MILP::m_ILP_solution) {
-      this->m_left_cpus = this->m_lc_cpus;
-      this->m_left_memory_GB = this->m_lc_memory;
-      for (auto it = m_registered_fw_ids.begin();
-           it != m_registered_fw_ids.end();
-           it++) {
-        Framework* framework = frameworks.registered[it->second];
-        LOG(INFO) << "lele Framework state to active " << it->first;
-        LOG(INFO) << "lele Framework state to active, framework id is: "
-                  << it->second;
-        framework->state = Framework::State::ACTIVE;
-        allocator->addFramework(
-          framework->id(),
-          framework->info,
-          framework->usedResources,
-          framework->active());
-        Option<string> principal =
-          framework->info.has_principal()
-            ? Option<string>(framework->info.principal())
-            : None();
-
-        if (framework->pid.isSome()) {
-          CHECK(!frameworks.principals.contains(framework->pid.get()));
-          frameworks.principals.put(framework->pid.get(), principal);
-        }
-
-        if (principal.isSome()) {
-          // Create new framework metrics if this framework is the first
-          // one of this principal. Otherwise existing metrics are reused.
-          if (!metrics->frameworks.contains(principal.get())) {
-            metrics->frameworks.put(
-              principal.get(),
-              Owned<Metrics::Frameworks>(
-                new Metrics::Frameworks(principal.get())));
-          }
-        }
-      }
-//      MILP::m_ILP_solution=false;
-      m_registered_fw_ids.clear();
-      m_registered_framework_names.clear();
-
-      // begins to stead resources from BT jobs to latency-critical applications
-      if (m_marathon_fm != nullptr) {
-        foreachvalue (Task* task, m_marathon_fm->tasks) {
-          if (this->m_left_cpus < 3 && this->m_left_memory_GB < 1) continue;
-          LOG(INFO) << "lele task id " << task->task_id();
-          LOG(INFO) << "lele task name, state " << task->name() << ", "
-                    << task->state();
-          LOG(INFO) << "lele the corresponding slaveID of the task "
-                    << task->slave_id();
-          LOG(INFO) << "lele resource of the task" << task->resources();
-          LOG(INFO) << "lele task container info " << task->container();
-          if (task->container().has_docker()) {
-            DockerUpdateMessage* dockerUpdateMessage =
-              new DockerUpdateMessage();
-            dockerUpdateMessage->set_docker_name(
-              task->container().docker().image());
-            dockerUpdateMessage->set_run_docker_slave_id(
-              task->slave_id().value());
-            //          task->resources().Get(0).name();
-            double origin_cpus = 0, origin_mem = 0;
-            for (auto it = task->resources().begin();
-                 it != task->resources().end();
-                 it++) {
-              LOG(INFO) << it->name();
-              if (it->name() == "cpus") {
-                LOG(INFO) << it->scalar().value();
-                origin_cpus = it->scalar().value();
-              } else if (it->name() == "mem") {
-                LOG(INFO) << it->scalar().value();
-                origin_mem = it->scalar().value();
-              }
-            }
-            LOG(INFO) << " increase the resource of task " << task->name()
-                      << "by 3 cores and 1 G ";
-            origin_cpus += 3;
-            origin_mem += 1*1024;
-            this->m_left_cpus -= 3;
-            this->m_left_memory_GB -= 1;
-            LOG(INFO) << "after squeezing resource for the docker "
-                         "application,m_left_cpus is "
-                      << this->m_left_cpus;
-            LOG(INFO) << "after squeezing resource for the docker "
-                         "application,m_left_memory_GB is "
-                      << this->m_left_memory_GB;
-            string increased_cpus, increased_mem;
-            num2string(origin_cpus, increased_cpus);
-            num2string(origin_mem, increased_mem);
-            dockerUpdateMessage->set_docker_mem(increased_mem + "M");
-            dockerUpdateMessage->set_docker_cpus(increased_cpus);
-            UPID temp_slave = slaves.registered.get(task->slave_id())->pid;
-            send(temp_slave, *dockerUpdateMessage);
-            LOG(INFO) << "send docker update message to slave " << temp_slave;
-            delete dockerUpdateMessage;
-          }
-        }
-      }
-    }
-
+        m_registered_framework_names)
+      .onAny(defer(
+          self(),
+          &Self::_repartition,
+          m_registered_framework_names,
+          lambda::_1));
   } else {
     if (temp_framework_name.find("marathon") != std::string::npos) {
       m_marathon_fm = framework;
     }
     framework->state = Framework::State::ACTIVE;
+    framework->changed();
     allocator->addFramework(
       framework->id(),
       framework->info,
@@ -7863,6 +7813,148 @@ void Master::addFramework(Framework* framework)
 }
 
 
+void Master::_repartition(
+    const vector<string>& names,
+    const Future<vector<chameleon::BTLinearModel>>& models)
+{
+  using namespace chameleon;
+
+  if (!models.isReady()) {
+    LOG(WARNING) << "Failed to repartition resources across BT frameworks: "
+                 << (models.isFailed() ? models.failure() : "discarded");
+    return;
+  }
+
+  // There is no solution yet, e.g., not enough BT frameworks have
+  // registered, so the frameworks stay inactive.
+  if (models.get().empty()) {
+    return;
+  }
+
+  CHECK_EQ(names.size(), models.get().size());
+
+  for (size_t i = 0; i < names.size(); i++) {
+    m_bt_models.erase(names[i]);
+    m_bt_models.insert({names[i], models.get()[i]});
+  }
+
+  m_ILP_solution = true;
+
+  this->m_left_cpus = this->m_lc_cpus;
+  this->m_left_memory_GB = this->m_lc_memory;
+
+  foreach (const string& name, names) {
+    if (m_registered_fw_ids.count(name) == 0) {
+      continue;
+    }
+
+    const FrameworkID frameworkId = m_registered_fw_ids.at(name);
+
+    m_registered_fw_ids.erase(name);
+    m_registered_framework_names.erase(
+      std::remove(
+        m_registered_framework_names.begin(),
+        m_registered_framework_names.end(),
+        name),
+      m_registered_framework_names.end());
+
+    // The framework might have been removed while the solver ran.
+    Framework* framework = getFramework(frameworkId);
+    if (framework == nullptr) {
+      continue;
+    }
+
+    LOG(INFO) << "lele Framework state to active " << name;
+    LOG(INFO) << "lele Framework state to active, framework id is: "
+              << frameworkId;
+    framework->state = Framework::State::ACTIVE;
+    framework->changed();
+    allocator->addFramework(
+      framework->id(),
+      framework->info,
+      framework->usedResources,
+      framework->active());
+    Option<string> principal =
+      framework->info.has_principal()
+        ? Option<string>(framework->info.principal())
+        : None();
+
+    if (framework->pid.isSome()) {
+      CHECK(!frameworks.principals.contains(framework->pid.get()));
+      frameworks.principals.put(framework->pid.get(), principal);
+    }
+
+    if (principal.isSome()) {
+      // Create new framework metrics if this framework is the first
+      // one of this principal. Otherwise existing metrics are reused.
+      if (!metrics->frameworks.contains(principal.get())) {
+        metrics->frameworks.put(
+          principal.get(),
+          Owned<Metrics::Frameworks>(
+            new Metrics::Frameworks(principal.get())));
+      }
+    }
+  }
+
+  // begins to stead resources from BT jobs to latency-critical applications
+  if (m_marathon_fm != nullptr) {
+    foreachvalue (Task* task, m_marathon_fm->tasks) {
+      if (this->m_left_cpus < 3 && this->m_left_memory_GB < 1) continue;
+      LOG(INFO) << "lele task id " << task->task_id();
+      LOG(INFO) << "lele task name, state " << task->name() << ", "
+                << task->state();
+      LOG(INFO) << "lele the corresponding slaveID of the task "
+                << task->slave_id();
+      LOG(INFO) << "lele resource of the task" << task->resources();
+      LOG(INFO) << "lele task container info " << task->container();
+      if (task->container().has_docker()) {
+        DockerUpdateMessage* dockerUpdateMessage =
+          new DockerUpdateMessage();
+        dockerUpdateMessage->set_docker_name(
+          task->container().docker().image());
+        dockerUpdateMessage->set_run_docker_slave_id(
+          task->slave_id().value());
+        //          task->resources().Get(0).name();
+        double origin_cpus = 0, origin_mem = 0;
+        for (auto it = task->resources().begin();
+             it != task->resources().end();
+             it++) {
+          LOG(INFO) << it->name();
+          if (it->name() == "cpus") {
+            LOG(INFO) << it->scalar().value();
+            origin_cpus = it->scalar().value();
+          } else if (it->name() == "mem") {
+            LOG(INFO) << it->scalar().value();
+            origin_mem = it->scalar().value();
+          }
+        }
+        LOG(INFO) << " increase the resource of task " << task->name()
+                  << "by 3 cores and 1 G ";
+        origin_cpus += 3;
+        origin_mem += 1*1024;
+        this->m_left_cpus -= 3;
+        this->m_left_memory_GB -= 1;
+        LOG(INFO) << "after squeezing resource for the docker "
+                     "application,m_left_cpus is "
+                  << this->m_left_cpus;
+        LOG(INFO) << "after squeezing resource for the docker "
+                     "application,m_left_memory_GB is "
+                  << this->m_left_memory_GB;
+        string increased_cpus, increased_mem;
+        num2string(origin_cpus, increased_cpus);
+        num2string(origin_mem, increased_mem);
+        dockerUpdateMessage->set_docker_mem(increased_mem + "M");
+        dockerUpdateMessage->set_docker_cpus(increased_cpus);
+        UPID temp_slave = slaves.registered.get(task->slave_id())->pid;
+        send(temp_slave, *dockerUpdateMessage);
+        LOG(INFO) << "send docker update message to slave " << temp_slave;
+        delete dockerUpdateMessage;
+      }
+    }
+  }
+}
+
+
 void Master::recoverFramework(const FrameworkInfo& info)
 {
   CHECK(!frameworks.registered.contains(info.id()));
@@ -7928,6 +8020,7 @@ Try<Nothing> Master::activateRecoveredFramework(
 
   // Activate the framework.
   framework->state = Framework::State::ACTIVE;
+  framework->changed();
   allocator->activateFramework(framework->id());
 
   // Export framework metrics if a principal is specified in `FrameworkInfo`.
@@ -8086,6 +8179,7 @@ void Master::_failoverFramework(Framework* framework)
   // the allocator has the correct view of the framework's share.
   if (!framework->active()) {
     framework->state = Framework::State::ACTIVE;
+    framework->changed();
     allocator->activateFramework(framework->id());
   }
 
@@ -8212,6 +8306,7 @@ void Master::removeFramework(Framework* framework)
     // Move task from unreachable map to completed map.
     framework->addCompletedTask(*task.get());
     framework->unreachableTasks.erase(taskId);
+    framework->finishedTasksChanged();
   }
 
   // Remove the framework's executors for correct resource accounting.
@@ -8267,6 +8362,9 @@ void Master::removeFramework(Framework* framework)
   frameworks.registered.erase(framework->id());
   allocator->removeFramework(framework->id());
 
+  framework->changed();
+  stateSnapshot.global = true;
+
   // The framework pointer is now owned by `frameworks.completed`.
   frameworks.completed.set(framework->id(), Owned<Framework>(framework));
 }
@@ -8670,6 +8768,13 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
   // MESOS-1746.
   task->mutable_statuses(task->statuses_size() - 1)->clear_data();
 
+  // Orphan tasks do not need to be marked as changed since they are
+  // serialized anew for every `/state` snapshot update.
+  Framework* framework = getFramework(task->framework_id());
+  if (framework != nullptr) {
+    framework->taskChanged(task->task_id());
+  }
+
   if (sendSubscribersUpdate && !subscribers.subscribed.empty()) {
     subscribers.send(
       protobuf::master::event::createTaskUpdated(*task, task->state(), status));
@@ -8691,7 +8796,6 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 
     slave->recoverResources(task);
 
-    Framework* framework = getFramework(task->framework_id());
     if (framework != nullptr) {
       framework->recoverResources(task);
     }
@@ -8872,6 +8976,7 @@ void Master::removeOffer(Offer* offer, bool rescind)
 
   // Delete it.
   offers.erase(offer->id());
+  metrics->outstanding_offers = offers.size();
   delete offer;
 }
 
@@ -9288,8 +9393,33 @@ void Master::Subscribers::send(const mesos::master::Event& event)
   VLOG(1) << "Notifying all active subscribers about " << event.type() << " "
           << "event";
 
+  if (subscribed.empty()) {
+    return;
+  }
+
+  // All subscribers receive the same event, so we evolve it once and
+  // encode it once per content type rather than once per subscriber.
+  //
+  // NOTE: Each subscriber's pipe still gets its own copy of the
+  // record. Sharing one buffer across the pipes would not save that
+  // copy: libprocess copies every chunk it reads from a streaming
+  // pipe into a new buffer to add the chunked transfer encoding (see
+  // `HttpProxy::stream`).
+  const v1::master::Event v1Event = evolve(event);
+
+  map<ContentType, string> records;
+
   foreachvalue (const Owned<Subscriber>& subscriber, subscribed) {
-    subscriber->http.send<mesos::master::Event, v1::master::Event>(event);
+    const ContentType contentType = subscriber->http.contentType;
+
+    if (records.count(contentType) == 0) {
+      ::recordio::Encoder<v1::master::Event> encoder(lambda::bind(
+          serialize, contentType, lambda::_1));
+
+      records[contentType] = encoder.encode(v1Event);
+    }
+
+    subscriber->http.write(records.at(contentType));
   }
 }
 
@@ -9398,6 +9528,7 @@ void Slave::addTask(Task* task)
 
   if (!Master::isRemovable(task->state())) {
     usedResources[frameworkId] += task->resources();
+    changed();
   }
 
   if (!master->subscribers.subscribed.empty()) {
@@ -9422,6 +9553,8 @@ void Slave::recoverResources(Task* task)
   if (usedResources[frameworkId].empty()) {
     usedResources.erase(frameworkId);
   }
+
+  changed();
 }
 
 
@@ -9438,6 +9571,8 @@ void Slave::removeTask(Task* task)
     if (usedResources[frameworkId].empty()) {
       usedResources.erase(frameworkId);
     }
+
+    changed();
   }
 
   tasks[frameworkId].erase(taskId);
@@ -9455,6 +9590,7 @@ void Slave::addOffer(Offer* offer)
 
   offers.insert(offer);
   offeredResources += offer->resources();
+  changed();
 }
 
 
@@ -9464,6 +9600,7 @@ void Slave::removeOffer(Offer* offer)
 
   offeredResources -= offer->resources();
   offers.erase(offer);
+  changed();
 }
 
 
@@ -9508,6 +9645,7 @@ void Slave::addExecutor(
 
   executors[frameworkId][executorInfo.executor_id()] = executorInfo;
   usedResources[frameworkId] += executorInfo.resources();
+  changed();
 }
 
 void Slave::removeExecutor(
@@ -9525,6 +9663,8 @@ void Slave::removeExecutor(
   if (executors[frameworkId].empty()) {
     executors.erase(frameworkId);
   }
+
+  changed();
 }
 
 
@@ -9541,6 +9681,16 @@ void Slave::apply(const Offer::Operation& operation)
 
   totalResources = resources.get();
   checkpointedResources = totalResources.filter(needCheckpointing);
+  changed();
+}
+
+
+void Slave::changed()
+{
+  // The agent counts and the orphan tasks and executors in the global
+  // fields of `/state` depend on the agents.
+  master->stateSnapshot.changedSlaves.insert(id);
+  master->stateSnapshot.global = true;
 }
 
 } // namespace master
@@ -58,6 +58,7 @@
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/jsonify.hpp>
 #include <stout/linkedhashmap.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/nothing.hpp>
@@ -75,11 +76,13 @@
 #include "internal/devolve.hpp"
 #include "internal/evolve.hpp"
 
+#include "master/bt_linear_model.hpp"
 #include "master/constants.hpp"
 #include "master/flags.hpp"
 #include "master/machine.hpp"
 #include "master/metrics.hpp"
 #include "master/registrar.hpp"
+#include "master/state_cache.hpp"
 #include "master/validation.hpp"
 
 #include "messages/messages.hpp"
@@ -88,6 +91,10 @@ namespace process {
 class RateLimiter; // Forward declaration.
 }
 
+namespace chameleon {
+class MILPSolverProcess; // Forward declaration.
+}
+
 namespace mesos {
 
 // Forward declarations.
@@ -167,6 +174,10 @@ struct Slave
 
   void apply(const Offer::Operation& operation);
 
+  // Records that this agent changed since the `/state` snapshot was
+  // last updated, see `Master::StateSnapshot`.
+  void changed();
+
   Master* const master;
   const SlaveID id;
   const SlaveInfo info;
@@ -289,6 +300,13 @@ struct HttpConnection
     return writer.write(encoder.encode(evolve(message)));
   }
 
+  // Writes a record that was already encoded for this connection's
+  // content type, e.g., when the same event is sent to many connections.
+  bool write(const std::string& record)
+  {
+    return writer.write(record);
+  }
+
   bool close()
   {
     return writer.close();
@@ -589,6 +607,13 @@ protected:
   // Add a framework.
   void addFramework(Framework* framework);
 
+  // Activates the BT frameworks once the resources of the
+  // latency-critical application have been repartitioned across
+  // them, see `chameleon::MILPSolverProcess`.
+  void _repartition(
+      const std::vector<std::string>& names,
+      const process::Future<std::vector<chameleon::BTLinearModel>>& models);
+
   // Recover a framework from its `FrameworkInfo`. This happens after
   // master failover, when an agent running one of the framework's
   // tasks re-registers or when the framework itself re-registers,
@@ -1560,6 +1585,17 @@ private:
         const process::Owned<ObjectApprover>& taskApprover,
         const process::Owned<ObjectApprover>& executorsApprover) const;
 
+    // Writes the fields of the `/state` endpoint other than the
+    // "slaves", "frameworks" and "completed_frameworks".
+    void writeStateFields(
+        JSON::ObjectWriter* writer,
+        const process::Owned<ObjectApprover>& flagsApprover) const;
+
+    // Applies the changes to the state since the last update to the
+    // `/state` snapshot, which only has to serialize the frameworks,
+    // tasks and agents that changed.
+    void updateStateCache() const;
+
     process::Future<process::http::Response> subscribe(
         const mesos::master::Call& call,
         const Option<process::http::authentication::Principal>& principal,
@@ -1607,6 +1643,7 @@ private:
 
   mesos::allocator::Allocator* allocator;
   WhitelistWatcher* whitelistWatcher;
+  chameleon::MILPSolverProcess* milpSolver;
   Registrar* registrar;
   Files* files;
 
@@ -1694,6 +1731,7 @@ private:
         CHECK_NOTNULL(slave);
         ids[slave->id] = slave;
         pids[slave->pid] = slave;
+        slave->changed();
       }
 
       void remove(Slave* slave)
@@ -1701,6 +1739,7 @@ private:
         CHECK_NOTNULL(slave);
         ids.erase(slave->id);
         pids.erase(slave->pid);
+        slave->changed();
       }
 
       void clear()
@@ -1800,6 +1839,9 @@ private:
    // lele ILP
   std::vector<std::string> m_registered_framework_names;
   std::unordered_map<std::string, FrameworkID> m_registered_fw_ids;
+  // the latest repartitioning result, keyed by framework name
+  std::unordered_map<std::string, chameleon::BTLinearModel> m_bt_models;
+  bool m_ILP_solution;
   // squeezing resource from best-tuned jobs to latency-sensitive applications
   int m_lc_cpus;
   int m_lc_memory;
@@ -1841,6 +1883,31 @@ private:
     hashmap<UUID, process::Owned<Subscriber>> subscribed;
   } subscribers;
 
+  // Snapshot of the `/state` endpoint that is only updated with the
+  // parts of the state that changed, see `Master::Http::updateStateCache()`.
+  struct StateSnapshot
+  {
+    StateSnapshot() : global(true) {}
+
+    process::Owned<StateCache> cache;
+
+    // The frameworks and agents that are in the snapshot.
+    hashset<FrameworkID> frameworks;
+    hashset<FrameworkID> completedFrameworks;
+    hashset<SlaveID> slaves;
+
+    // What changed since the snapshot was last updated. Agents and
+    // frameworks record themselves when they are added, changed or
+    // removed, see `Slave::changed()` and `Framework::changed()`, so
+    // that an update only looks at those. The global fields change
+    // with the agents (the agent counts and the orphan tasks), with
+    // the set of registered frameworks, and where the leader or the
+    // recovered or unreachable agents change.
+    bool global;
+    hashset<SlaveID> changedSlaves;
+    hashset<FrameworkID> changedFrameworks;
+  } stateSnapshot;
+
   hashmap<OfferID, Offer*> offers;
   hashmap<OfferID, process::Timer> offerTimers;
 
@@ -1895,11 +1962,6 @@ private:
     return (process::Clock::now() - startTime).secs();
   }
 
-  double _elected()
-  {
-    return elected() ? 1 : 0;
-  }
-
   double _slaves_connected();
   double _slaves_disconnected();
   double _slaves_active();
@@ -1911,11 +1973,6 @@ private:
   double _frameworks_active();
   double _frameworks_inactive();
 
-  double _outstanding_offers()
-  {
-    return offers.size();
-  }
-
   double _event_queue_messages()
   {
     return static_cast<double>(eventCount<process::MessageEvent>());
@@ -1982,6 +2039,7 @@ protected:
     Registry::Slave* slave = registry->mutable_slaves()->add_slaves();
     slave->mutable_info()->CopyFrom(info);
     slaveIDs->insert(info.id());
+    appended.slaves.insert(info.id());
     return true; // Mutation.
   }
 
@@ -2022,6 +2080,7 @@ protected:
 
         unreachable->mutable_id()->CopyFrom(info.id());
         unreachable->mutable_timestamp()->CopyFrom(unreachableTime);
+        appended.unreachable.insert(info.id());
 
         return true; // Mutation.
       }
@@ -2088,6 +2147,7 @@ protected:
     Registry::Slave* slave = registry->mutable_slaves()->add_slaves();
     slave->mutable_info()->CopyFrom(info);
     slaveIDs->insert(info.id());
+    appended.slaves.insert(info.id());
 
     return true; // Mutation.
   }
@@ -2294,8 +2354,10 @@ struct Framework
     }
 
     tasks[task->task_id()] = task;
+    taskChanged(task->task_id());
 
     if (!Master::isRemovable(task->state())) {
+      changed();
       totalUsedResources += task->resources();
       usedResources[task->slave_id()] += task->resources();
 
@@ -2325,6 +2387,8 @@ struct Framework
       << "Unknown task " << task->task_id()
       << " of framework " << task->framework_id();
 
+    changed();
+
     totalUsedResources -= task->resources();
     usedResources[task->slave_id()] -= task->resources();
     if (usedResources[task->slave_id()].empty()) {
@@ -2377,6 +2441,7 @@ struct Framework
     // same task ID. We should consider rejecting attempts to reuse
     // task IDs (MESOS-6779).
     completedTasks.push_back(process::Owned<Task>(new Task(task)));
+    finishedTasksChanged();
   }
 
   void addUnreachableTask(const Task& task)
@@ -2386,6 +2451,7 @@ struct Framework
 
     // TODO(adam-mesos): Check if unreachable task already exists.
     unreachableTasks.set(task.task_id(), process::Owned<Task>(new Task(task)));
+    finishedTasksChanged();
   }
 
   void removeTask(Task* task)
@@ -2405,6 +2471,7 @@ struct Framework
     }
 
     tasks.erase(task->task_id());
+    taskChanged(task->task_id());
   }
 
   void addOffer(Offer* offer)
@@ -2413,6 +2480,7 @@ struct Framework
     offers.insert(offer);
     totalOfferedResources += offer->resources();
     offeredResources[offer->slave_id()] += offer->resources();
+    changed();
   }
 
   void removeOffer(Offer* offer)
@@ -2427,6 +2495,7 @@ struct Framework
     }
 
     offers.erase(offer);
+    changed();
   }
 
   void addInverseOffer(InverseOffer* inverseOffer)
@@ -2465,6 +2534,7 @@ struct Framework
     }
 
     executors[slaveId][executorInfo.executor_id()] = executorInfo;
+    changed();
     totalUsedResources += executorInfo.resources();
     usedResources[slaveId] += executorInfo.resources();
 
@@ -2520,6 +2590,8 @@ struct Framework
     if (executors[slaveId].empty()) {
       executors.erase(slaveId);
     }
+
+    changed();
   }
 
   const FrameworkID id() const { return info.id(); }
@@ -2532,6 +2604,8 @@ struct Framework
     // We only merge 'info' from the same framework 'id'.
     CHECK_EQ(info.id(), newInfo.id());
 
+    changed();
+
     // Save the old list of roles for later.
     std::set<std::string> oldRoles = roles;
 
@@ -2652,6 +2726,7 @@ struct Framework
 
     // TODO(benh): unlink(oldPid);
     pid = newPid;
+    changed();
   }
 
   void updateConnection(const HttpConnection& newHttp)
@@ -2671,6 +2746,7 @@ struct Framework
     CHECK_NONE(http);
 
     http = newHttp;
+    changed();
   }
 
   // Closes the HTTP connection and stops the heartbeat.
@@ -2806,6 +2882,42 @@ struct Framework
   // This is only set for HTTP frameworks.
   Option<process::Owned<Heartbeater>> heartbeater;
 
+  // Record that a part of this framework changed since the `/state`
+  // snapshot was last updated, see `Master::StateSnapshot`.
+  void changed()
+  {
+    changes.framework = true;
+    master->stateSnapshot.changedFrameworks.insert(id());
+  }
+
+  void finishedTasksChanged()
+  {
+    changes.finishedTasks = true;
+    master->stateSnapshot.changedFrameworks.insert(id());
+  }
+
+  void taskChanged(const TaskID& taskId)
+  {
+    changes.tasks.insert(taskId);
+    master->stateSnapshot.changedFrameworks.insert(id());
+  }
+
+  // The parts of this framework that changed since the `/state`
+  // snapshot was last updated, see `Master::Http::updateStateCache()`.
+  struct Changes
+  {
+    Changes() : framework(true), finishedTasks(true) {}
+
+    // Anything but the tasks, e.g., the offers or the executors.
+    bool framework;
+
+    // The unreachable or the completed tasks.
+    bool finishedTasks;
+
+    // The active and pending tasks.
+    hashset<TaskID> tasks;
+  } changes;
+
 private:
   Framework(Master* const _master,
             const Flags& masterFlags,
@@ -42,8 +42,7 @@ Metrics::Metrics(const Master& master)
         "master/uptime_secs",
         defer(master, &Master::_uptime_secs)),
     elected(
-        "master/elected",
-        defer(master, &Master::_elected)),
+        "master/elected"),
     slaves_connected(
         "master/slaves_connected",
         defer(master, &Master::_slaves_connected)),
@@ -72,8 +71,7 @@ Metrics::Metrics(const Master& master)
         "master/frameworks_inactive",
         defer(master, &Master::_frameworks_inactive)),
     outstanding_offers(
-        "master/outstanding_offers",
-        defer(master, &Master::_outstanding_offers)),
+        "master/outstanding_offers"),
     tasks_staging(
         "master/tasks_staging",
         defer(master, &Master::_tasks_staging)),
@@ -23,6 +23,7 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
 
 #include <stout/hashmap.hpp>
 
@@ -42,7 +43,7 @@ struct Metrics
   ~Metrics();
 
   process::metrics::Gauge uptime_secs;
-  process::metrics::Gauge elected;
+  process::metrics::PushGauge elected;
 
   process::metrics::Gauge slaves_connected;
   process::metrics::Gauge slaves_disconnected;
@@ -55,7 +56,7 @@ struct Metrics
   process::metrics::Gauge frameworks_active;
   process::metrics::Gauge frameworks_inactive;
 
-  process::metrics::Gauge outstanding_offers;
+  process::metrics::PushGauge outstanding_offers;
 
   // Task state metrics.
   process::metrics::Gauge tasks_staging;
@@ -14,13 +14,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <deque>
+#include <list>
+#include <map>
+#include <set>
 #include <string>
 
 #include <mesos/type_utils.hpp>
 
 #include <mesos/state/state.hpp>
 
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -34,13 +39,18 @@
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/timer.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
 
+#include "master/constants.hpp"
 #include "master/registrar.hpp"
 #include "master/registry.hpp"
 
@@ -53,6 +63,7 @@ using process::terminate;
 using process::wait; // Necessary on some OS's to disambiguate.
 
 using process::AUTHENTICATION;
+using process::collect;
 using process::DESCRIPTION;
 using process::Failure;
 using process::Future;
@@ -70,7 +81,12 @@ using process::http::authentication::Principal;
 using process::metrics::Gauge;
 using process::metrics::Timer;
 
+using google::protobuf::RepeatedPtrField;
+
 using std::deque;
+using std::list;
+using std::map;
+using std::set;
 using std::string;
 
 namespace mesos {
@@ -90,7 +106,11 @@ public:
     : ProcessBase(process::ID::generate("registrar")),
       metrics(*this),
       state(_state),
-      updating(false),
+      sequence(0),
+      compact(false),
+      compacting(false),
+      deltasSize(0),
+      registrySize(0),
       flags(_flags),
       authenticationRealm(_authenticationRealm) {}
 
@@ -198,15 +218,21 @@ private:
   void _recover(
       const MasterInfo& info,
       const Future<Variable>& recovery);
+  void recoverDeltas(
+      const MasterInfo& info,
+      const Future<set<string>>& names);
+  void _recoverDeltas(
+      const MasterInfo& info,
+      const Future<list<Variable>>& deltas);
   void __recover(const Future<bool>& recover);
   Future<bool> _apply(Owned<Operation> operation);
 
+  // Performs the Recover operation to persist the new MasterInfo.
+  void persist(const MasterInfo& info);
+
   // Helper for updating state (performing store).
   void update();
-  void _update(
-      const Future<Option<Variable>>& store,
-      const Owned<Registry>& updatedRegistry,
-      deque<Owned<Operation>> operations);
+  void _update();
 
   // Fails all pending operations and transitions the Registrar
   // into an error state in which all subsequent operations will fail.
@@ -225,11 +251,46 @@ private:
   // Per the TODO above, we store both serialized and deserialized versions
   // of the `Registry` protobuf. If we're able to move to `protobuf::State`,
   // we could just store a single `protobuf::state::Variable<Registry>`.
+  //
+  // The `registry` includes the operations whose stores are still in
+  // flight, while the `variable` is the last full registry we stored.
+  // The changes since then are stored as `RegistryDelta`s.
   Option<Variable> variable;
   Option<Registry> registry;
 
+  // The fields of `registry` other than the lists of agents, which
+  // are compared in order to find out whether a delta needs them.
+  string others;
+
+  // The sequence number of the last delta (or full registry) stored.
+  uint64_t sequence;
+
+  // Whether the next update has to store the full registry, and
+  // whether a store of the full registry is in flight.
+  bool compact;
+  bool compacting;
+
+  // The deltas that have been stored since the full registry, indexed
+  // by their sequence number, so that we can expunge them once they
+  // have been compacted. Also used for sizing the next compaction.
+  map<uint64_t, Variable> deltas;
+  size_t deltasSize;
+  size_t registrySize;
+
+  // A store of the registry (or a delta) in flight, along with the
+  // operations it persists. Stores complete in the order in which
+  // they were started.
+  struct Store
+  {
+    uint64_t sequence;
+    bool full;
+    deque<Owned<Operation>> operations;
+    Future<Option<Variable>> future;
+    Stopwatch stopwatch;
+  };
+
   deque<Owned<Operation>> operations;
-  bool updating; // Used to signify fetching (recovering) or storing.
+  deque<Owned<Store>> stores;
 
   const Flags flags;
 
@@ -270,6 +331,165 @@ void fail(deque<Owned<Operation>>* operations, const string& message)
 }
 
 
+// Name of the state variable that holds the full registry.
+static const string REGISTRY = "registry";
+
+// Prefix of the names of the state variables that hold the deltas,
+// which are suffixed with their sequence number.
+static const string REGISTRY_DELTA = "registry_delta_";
+
+
+static const SlaveID& id(const Registry::Slave& slave)
+{
+  return slave.info().id();
+}
+
+
+static const SlaveID& id(const Registry::UnreachableSlave& slave)
+{
+  return slave.id();
+}
+
+
+// Computes the changes that a batch of operations made to a list of
+// agents. Operations only ever remove agents from the lists or append
+// agents to them, and record the agents they append (see `Operation`).
+// Hence the agents in `after` consist of the agents that remained from
+// `before`, unchanged and in their order, followed by the appended
+// ones. Note that an agent which was removed and appended again (e.g.,
+// marked unreachable and reachable) is both removed and added.
+//
+// Should an operation ever change the lists in another way, the delta
+// instead replaces the whole list, which is always correct and gets
+// compacted into the full registry like any other large delta.
+template <typename T>
+static void diff(
+    const RepeatedPtrField<T>& before,
+    const RepeatedPtrField<T>& after,
+    const hashset<SlaveID>& appended,
+    RepeatedPtrField<SlaveID>* removed,
+    RepeatedPtrField<T>* added)
+{
+  int remained = after.size();
+  while (remained > 0 && appended.contains(id(after.Get(remained - 1)))) {
+    remained--;
+  }
+
+  int j = 0;
+  for (int i = 0; i < before.size(); i++) {
+    if (j < remained && id(before.Get(i)) == id(after.Get(j))) {
+      j++;
+    } else {
+      removed->Add()->CopyFrom(id(before.Get(i)));
+    }
+  }
+
+  if (j != remained) {
+    LOG(WARNING) << "Agents other than the " << appended.size()
+                 << " appended ones were added or reordered; storing all of"
+                 << " the " << after.size() << " agents in the delta";
+
+    removed->Clear();
+    foreach (const T& agent, before) {
+      removed->Add()->CopyFrom(id(agent));
+    }
+
+    j = 0;
+  }
+
+  for (; j < after.size(); j++) {
+    added->Add()->CopyFrom(after.Get(j));
+  }
+}
+
+
+// Applies the changes computed by `diff` above.
+template <typename T>
+static void patch(
+    RepeatedPtrField<T>* list,
+    const RepeatedPtrField<SlaveID>& removed,
+    const RepeatedPtrField<T>& added)
+{
+  if (!removed.empty()) {
+    hashset<SlaveID> ids;
+    foreach (const SlaveID& slaveId, removed) {
+      ids.insert(slaveId);
+    }
+
+    // Move the remaining agents to the front, keeping their order.
+    int j = 0;
+    for (int i = 0; i < list->size(); i++) {
+      if (!ids.contains(id(list->Get(i)))) {
+        list->SwapElements(i, j++);
+      }
+    }
+
+    while (list->size() > j) {
+      list->RemoveLast();
+    }
+  }
+
+  list->MergeFrom(added);
+}
+
+
+// Returns the fields of the registry other than the lists of agents.
+static Registry withoutAgents(const Registry& registry)
+{
+  Registry result;
+
+  if (registry.has_master()) {
+    result.mutable_master()->CopyFrom(registry.master());
+  }
+
+  if (registry.has_machines()) {
+    result.mutable_machines()->CopyFrom(registry.machines());
+  }
+
+  result.mutable_schedules()->CopyFrom(registry.schedules());
+  result.mutable_quotas()->CopyFrom(registry.quotas());
+  result.mutable_weights()->CopyFrom(registry.weights());
+
+  return result;
+}
+
+
+static Try<Nothing> patch(Registry* registry, const RegistryDelta& delta)
+{
+  patch(
+      registry->mutable_slaves()->mutable_slaves(),
+      delta.removed_slaves(),
+      delta.added_slaves());
+
+  patch(
+      registry->mutable_unreachable()->mutable_slaves(),
+      delta.removed_unreachable(),
+      delta.added_unreachable());
+
+  if (delta.has_registry()) {
+    const Registry& others = delta.registry();
+
+    if (others.has_slaves() ||
+        others.has_unreachable() ||
+        others.has_delta_sequence()) {
+      return Error("Unexpected fields in delta " + stringify(delta.sequence()));
+    }
+
+    registry->clear_master();
+    registry->clear_machines();
+    registry->clear_schedules();
+    registry->clear_quotas();
+    registry->clear_weights();
+
+    registry->MergeFrom(others);
+  }
+
+  registry->set_delta_sequence(delta.sequence());
+
+  return Nothing();
+}
+
+
 Future<Response> RegistrarProcess::getRegistry(
     const Request& request,
     const Option<Principal>&)
@@ -345,7 +565,7 @@ Future<Registry> RegistrarProcess::recover(const MasterInfo& info)
     VLOG(1) << "Recovering registrar";
 
     metrics.state_fetch.start();
-    state->fetch("registry")
+    state->fetch(REGISTRY)
       .after(flags.registry_fetch_timeout,
              lambda::bind(
                  &timeout<Variable>,
@@ -353,7 +573,6 @@ Future<Registry> RegistrarProcess::recover(const MasterInfo& info)
                  flags.registry_fetch_timeout,
                  lambda::_1))
       .onAny(defer(self(), &Self::_recover, info, lambda::_1));
-    updating = true;
     recovered = Owned<Promise<Registry>>(new Promise<Registry>());
   }
 
@@ -365,8 +584,6 @@ void RegistrarProcess::_recover(
     const MasterInfo& info,
     const Future<Variable>& recovery)
 {
-  updating = false;
-
   CHECK(!recovery.isPending());
 
   if (!recovery.isReady()) {
@@ -384,12 +601,6 @@ void RegistrarProcess::_recover(
     return;
   }
 
-  Duration elapsed = metrics.state_fetch.stop();
-
-  LOG(INFO) << "Successfully fetched the registry"
-            << " (" << Bytes(deserialized->ByteSize()) << ")"
-            << " in " << elapsed;
-
   // Save the registry.
   variable = recovery.get();
 
@@ -397,7 +608,142 @@ void RegistrarProcess::_recover(
   registry = Option<Registry>(Registry());
   registry->Swap(&deserialized.get());
 
-  // Perform the Recover operation to add the new MasterInfo.
+  sequence = registry->delta_sequence();
+
+  // There are no deltas without a registry, since we always store the
+  // full registry upon recovery.
+  if (recovery->value().empty()) {
+    persist(info);
+    return;
+  }
+
+  state->names()
+    .after(flags.registry_fetch_timeout,
+           lambda::bind(
+               &timeout<set<string>>,
+               "fetch",
+               flags.registry_fetch_timeout,
+               lambda::_1))
+    .onAny(defer(self(), &Self::recoverDeltas, info, lambda::_1));
+}
+
+
+void RegistrarProcess::recoverDeltas(
+    const MasterInfo& info,
+    const Future<set<string>>& names)
+{
+  CHECK(!names.isPending());
+
+  if (!names.isReady()) {
+    recovered.get()->fail("Failed to recover registrar: " +
+        (names.isFailed() ? names.failure() : "discarded"));
+    return;
+  }
+
+  // Fetch all of the deltas, including the ones that have already
+  // been compacted, so that we can expunge them. Note that `set`
+  // orders the names lexicographically, hence the `map`.
+  map<uint64_t, string> sorted;
+  foreach (const string& name, names.get()) {
+    if (!strings::startsWith(name, REGISTRY_DELTA)) {
+      continue;
+    }
+
+    Try<uint64_t> sequence =
+      numify<uint64_t>(name.substr(REGISTRY_DELTA.size()));
+
+    if (sequence.isError()) {
+      LOG(WARNING) << "Ignoring unexpected registry delta '" << name << "'";
+      continue;
+    }
+
+    sorted[sequence.get()] = name;
+  }
+
+  list<Future<Variable>> fetches;
+  foreachvalue (const string& name, sorted) {
+    fetches.push_back(state->fetch(name));
+  }
+
+  collect(fetches)
+    .after(flags.registry_fetch_timeout,
+           lambda::bind(
+               &timeout<list<Variable>>,
+               "fetch",
+               flags.registry_fetch_timeout,
+               lambda::_1))
+    .onAny(defer(self(), &Self::_recoverDeltas, info, lambda::_1));
+}
+
+
+void RegistrarProcess::_recoverDeltas(
+    const MasterInfo& info,
+    const Future<list<Variable>>& fetched)
+{
+  CHECK(!fetched.isPending());
+
+  if (!fetched.isReady()) {
+    recovered.get()->fail("Failed to recover registrar: " +
+        (fetched.isFailed() ? fetched.failure() : "discarded"));
+    return;
+  }
+
+  size_t applied = 0;
+
+  foreach (const Variable& fetchedDelta, fetched.get()) {
+    Try<RegistryDelta> delta =
+      ::protobuf::deserialize<RegistryDelta>(fetchedDelta.value());
+
+    if (delta.isError()) {
+      recovered.get()->fail("Failed to recover registrar: " + delta.error());
+      return;
+    }
+
+    // We apply the deltas that follow the registry without a gap. A
+    // gap means that a store failed, in which case the registrar
+    // aborted and did not acknowledge any of the subsequent deltas.
+    if (delta->sequence() == registry->delta_sequence() + 1) {
+      Try<Nothing> patched = patch(&registry.get(), delta.get());
+      if (patched.isError()) {
+        recovered.get()->fail(
+            "Failed to recover registrar: " + patched.error());
+        return;
+      }
+
+      applied++;
+    } else if (delta->sequence() > registry->delta_sequence()) {
+      LOG(WARNING) << "Ignoring registry delta " << delta->sequence()
+                   << " which does not follow delta "
+                   << registry->delta_sequence();
+    }
+
+    // All of the deltas get expunged once we store the full registry,
+    // whose sequence number is larger than the ones of all deltas.
+    deltas.emplace(delta->sequence(), fetchedDelta);
+    sequence = std::max(sequence, delta->sequence());
+  }
+
+  LOG(INFO) << "Applied " << applied << " of " << fetched->size()
+            << " registry deltas";
+
+  persist(info);
+}
+
+
+void RegistrarProcess::persist(const MasterInfo& info)
+{
+  Duration elapsed = metrics.state_fetch.stop();
+
+  LOG(INFO) << "Successfully fetched the registry"
+            << " (" << Bytes(registry->ByteSize()) << ")"
+            << " in " << elapsed;
+
+  others = withoutAgents(registry.get()).SerializeAsString();
+
+  // Perform the Recover operation to add the new MasterInfo. We store
+  // the full registry, which also compacts any deltas we recovered.
+  compact = true;
+
   Owned<Operation> operation(new Recover(info));
   operations.push_back(operation);
   operation->future()
@@ -452,9 +798,7 @@ Future<bool> RegistrarProcess::_apply(Owned<Operation> operation)
 
   operations.push_back(operation);
   Future<bool> future = operation->future();
-  if (!updating) {
-    update();
-  }
+  update();
   return future;
 }
 
@@ -465,16 +809,19 @@ void RegistrarProcess::update()
     return; // No-op.
   }
 
-  CHECK(!updating);
+  // We batch the operations until a store completes, see `_update()`.
+  if (stores.size() >= MAX_REGISTRY_STORES_IN_FLIGHT) {
+    return;
+  }
+
   CHECK_NONE(error);
   CHECK_SOME(variable);
+  CHECK_SOME(registry);
 
   // Time how long it takes to apply the operations.
   Stopwatch stopwatch;
   stopwatch.start();
 
-  updating = true;
-
   // Create a snapshot of the current registry. We use an `Owned` here
   // to avoid copying, since protobuf doesn't suppport move construction.
   auto updatedRegistry = Owned<Registry>(new Registry(registry.get()));
@@ -485,84 +832,188 @@ void RegistrarProcess::update()
     slaveIDs.insert(slave.info().id());
   }
 
+  // The agents appended by the operations, see `diff()`.
+  hashset<SlaveID> appendedSlaves;
+  hashset<SlaveID> appendedUnreachable;
+
   foreach (Owned<Operation>& operation, operations) {
     // No need to process the result of the operation.
     (*operation)(updatedRegistry.get(), &slaveIDs);
+
+    appendedSlaves.insert(
+        operation->appended.slaves.begin(),
+        operation->appended.slaves.end());
+
+    appendedUnreachable.insert(
+        operation->appended.unreachable.begin(),
+        operation->appended.unreachable.end());
   }
 
   LOG(INFO) << "Applied " << operations.size() << " operations in "
             << stopwatch.elapsed() << "; attempting to update the registry";
 
-  // Perform the store, and time the operation.
-  metrics.state_store.start();
-
-  // Serialize updated registry.
-  Try<string> serialized = ::protobuf::serialize(*updatedRegistry);
-  if (serialized.isError()) {
-    string message = "Failed to update registry: " + serialized.error();
-    fail(&operations, message);
-    abort(message);
-    return;
+  Owned<Store> store(new Store());
+  store->sequence = ++sequence;
+  store->operations.swap(operations);
+  store->stopwatch.start();
+
+  // Compute the delta with respect to the registry that includes all
+  // of the previous stores, which complete before this one.
+  RegistryDelta delta;
+  delta.set_sequence(store->sequence);
+
+  diff(registry->slaves().slaves(),
+       updatedRegistry->slaves().slaves(),
+       appendedSlaves,
+       delta.mutable_removed_slaves(),
+       delta.mutable_added_slaves());
+
+  diff(registry->unreachable().slaves(),
+       updatedRegistry->unreachable().slaves(),
+       appendedUnreachable,
+       delta.mutable_removed_unreachable(),
+       delta.mutable_added_unreachable());
+
+  Registry updatedOthers = withoutAgents(*updatedRegistry);
+  string serializedOthers = updatedOthers.SerializeAsString();
+
+  if (serializedOthers != others) {
+    delta.mutable_registry()->Swap(&updatedOthers);
+    others.swap(serializedOthers);
   }
 
-  state->store(variable->mutate(serialized.get()))
-    .after(flags.registry_store_timeout,
-           lambda::bind(
-               &timeout<Option<Variable>>,
-               "store",
-               flags.registry_store_timeout,
-               lambda::_1))
-    .onAny(defer(
-        self(), &Self::_update, lambda::_1, updatedRegistry, operations));
+  // We store the full registry once the deltas add up to more than
+  // the registry itself, so that the deltas only ever make up a
+  // fraction of the data we read upon recovery. There is only one
+  // store of the full registry in flight, since each one depends on
+  // the version of the `variable` stored by the previous one.
+  store->full = !compacting &&
+    (compact ||
+     deltas.size() >= MAX_REGISTRY_DELTAS ||
+     deltasSize + delta.ByteSize() > registrySize);
+
+  Future<Option<Variable>> future;
+
+  if (store->full) {
+    updatedRegistry->set_delta_sequence(store->sequence);
+
+    // Serialize updated registry.
+    Try<string> serialized = ::protobuf::serialize(*updatedRegistry);
+    if (serialized.isError()) {
+      string message = "Failed to update registry: " + serialized.error();
+      fail(&store->operations, message);
+      abort(message);
+      return;
+    }
 
-  // Clear the operations, _update will transition the Promises!
-  operations.clear();
-}
+    compact = false;
+    compacting = true;
+    registrySize = serialized->size();
+    deltasSize = 0;
 
+    future = state->store(variable->mutate(serialized.get()));
+  } else {
+    // Serialize the delta.
+    Try<string> serialized = ::protobuf::serialize(delta);
+    if (serialized.isError()) {
+      string message = "Failed to update registry: " + serialized.error();
+      fail(&store->operations, message);
+      abort(message);
+      return;
+    }
 
-void RegistrarProcess::_update(
-    const Future<Option<Variable>>& store,
-    const Owned<Registry>& updatedRegistry,
-    deque<Owned<Operation>> applied)
-{
-  updating = false;
+    deltasSize += serialized->size();
 
-  // Abort if the storage operation did not succeed.
-  if (!store.isReady() || store.get().isNone()) {
-    string message = "Failed to update registry: ";
+    // The delta does not exist yet, so there is no need to fetch it.
+    future = state->store(
+        state->create(REGISTRY_DELTA + stringify(store->sequence))
+          .mutate(serialized.get()));
+  }
 
-    if (store.isFailed()) {
-      message += store.failure();
-    } else if (store.isDiscarded()) {
-      message += "discarded";
-    } else {
-      message += "version mismatch";
-    }
+  // Perform the store, and time the operation.
+  store->future = metrics.state_store.time(
+      future.after(
+          flags.registry_store_timeout,
+          lambda::bind(
+              &timeout<Option<Variable>>,
+              "store",
+              flags.registry_store_timeout,
+              lambda::_1)));
+
+  store->future
+    .onAny(defer(self(), &Self::_update));
+
+  stores.push_back(store);
+
+  registry->Swap(updatedRegistry.get());
+}
 
-    fail(&applied, message);
-    abort(message);
 
+void RegistrarProcess::_update()
+{
+  // The operations of the stores in flight have been failed already.
+  if (error.isSome()) {
     return;
   }
 
-  Duration elapsed = metrics.state_store.stop();
+  // Complete the stores in order, so that an operation is only
+  // acknowledged once all of the preceding ones are persisted.
+  while (!stores.empty() && !stores.front()->future.isPending()) {
+    Owned<Store> store = stores.front();
+    stores.pop_front();
 
-  LOG(INFO) << "Successfully updated the registry in " << elapsed;
+    const Future<Option<Variable>>& future = store->future;
 
-  variable = store.get().get();
-  registry->Swap(updatedRegistry.get());
+    // Abort if the storage operation did not succeed.
+    if (!future.isReady() || future->isNone()) {
+      string message = "Failed to update registry: ";
 
-  // Remove the operations.
-  while (!applied.empty()) {
-    Owned<Operation> operation = applied.front();
-    applied.pop_front();
+      if (future.isFailed()) {
+        message += future.failure();
+      } else if (future.isDiscarded()) {
+        message += "discarded";
+      } else {
+        message += "version mismatch";
+      }
 
-    operation->set();
-  }
+      fail(&store->operations, message);
+      abort(message);
+
+      return;
+    }
+
+    LOG(INFO) << "Successfully updated the registry"
+              << (store->full ? "" : " (delta " +
+                  stringify(store->sequence) + ")")
+              << " in " << store->stopwatch.elapsed();
+
+    if (store->full) {
+      variable = future->get();
+      compacting = false;
 
-  if (!operations.empty()) {
-    update();
+      // The deltas up to the registry we stored are not needed anymore.
+      while (!deltas.empty() && deltas.begin()->first < store->sequence) {
+        state->expunge(deltas.begin()->second)
+          .onFailed([](const string& failure) {
+            LOG(WARNING) << "Failed to expunge registry delta: " << failure;
+          });
+
+        deltas.erase(deltas.begin());
+      }
+    } else {
+      deltas.emplace(store->sequence, future->get());
+    }
+
+    // Remove the operations.
+    while (!store->operations.empty()) {
+      Owned<Operation> operation = store->operations.front();
+      store->operations.pop_front();
+
+      operation->set();
+    }
   }
+
+  update();
 }
 
 
@@ -573,6 +1024,12 @@ void RegistrarProcess::abort(const string& message)
   LOG(ERROR) << "Registrar aborting: " << message;
 
   fail(&operations, message);
+
+  foreach (const Owned<Store>& store, stores) {
+    fail(&store->operations, message);
+  }
+
+  stores.clear();
 }
 
 
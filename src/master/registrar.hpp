@@ -69,7 +69,19 @@ public:
 protected:
   virtual Try<bool> perform(Registry* registry, hashset<SlaveID>* slaveIDs) = 0;
 
+  // Operations only ever remove agents from the lists of admitted and
+  // unreachable agents or append agents to them, and record the IDs of
+  // the agents they append here. This lets the registrar persist the
+  // changes of a batch of operations without comparing the agents.
+  struct
+  {
+    hashset<SlaveID> slaves;
+    hashset<SlaveID> unreachable;
+  } appended;
+
 private:
+  friend class RegistrarProcess;
+
   bool success;
 };
 
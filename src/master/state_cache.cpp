@@ -0,0 +1,432 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <mesos/http.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <mesos/master/master.hpp>
+
+#include <process/dispatch.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+#include <stout/strings.hpp>
+#include <stout/stringify.hpp>
+
+#include "master/state_cache.hpp"
+
+using google::protobuf::internal::WireFormatLite;
+
+using process::Future;
+using process::Owned;
+using process::Process;
+
+using process::http::OK;
+
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+using process::http::Request;
+using process::http::Response;
+using process::http::Status;
+
+class StateCacheProcess : public Process<StateCacheProcess>
+{
+public:
+  explicit StateCacheProcess(const string& _id)
+    : ProcessBase(process::ID::generate("state-cache")),
+      id(_id),
+      version(0) {}
+
+  virtual ~StateCacheProcess() {}
+
+  void update(const Owned<StateDelta>& delta);
+
+  Future<Response> state(const Request& request);
+
+private:
+  // Puts the snapshot together, if it has not been put together
+  // since the last update.
+  const string& json();
+  const string& protobuf();
+
+  const string id;
+
+  // Incremented whenever an update changes the snapshot.
+  uint64_t version;
+
+  StateFragment global;
+  hashmap<SlaveID, StateFragment> slaves;
+  hashmap<FrameworkID, StateFragment> frameworks;
+  hashmap<FrameworkID, StateFragment> finishedTasks;
+  hashmap<FrameworkID, hashmap<TaskID, StateFragment>> tasks;
+  hashmap<FrameworkID, StateFragment> completedFrameworks;
+
+  Option<string> json_;
+  Option<string> protobuf_;
+};
+
+
+// Applies the changes to the fragments in `fragments`, returns
+// whether there were any.
+template <typename Key>
+static bool apply(
+    hashmap<Key, StateFragment>* fragments,
+    const hashmap<Key, Option<StateFragment>>& changes)
+{
+  foreachpair (const Key& key, const Option<StateFragment>& fragment, changes) {
+    if (fragment.isSome()) {
+      (*fragments)[key] = fragment.get();
+    } else {
+      fragments->erase(key);
+    }
+  }
+
+  return !changes.empty();
+}
+
+
+// Returns the fields of the non-empty JSON object `object`, so that
+// they can be added to another object.
+static string fields(const string& object)
+{
+  CHECK(strings::startsWith(object, "{") &&
+        strings::endsWith(object, "}") &&
+        object != "{}")
+    << "Expected a non-empty JSON object: " << object;
+
+  return object.substr(1, object.size() - 2);
+}
+
+
+void StateCacheProcess::update(const Owned<StateDelta>& delta)
+{
+  bool changed = false;
+
+  // The global fields are re-serialized whenever they may have
+  // changed, which is often not the case.
+  if (delta->global.isSome() &&
+      (delta->global->json != global.json ||
+       delta->global->protobuf != global.protobuf)) {
+    global = delta->global.get();
+    changed = true;
+  }
+
+  changed |= apply(&slaves, delta->slaves);
+  changed |= apply(&frameworks, delta->frameworks);
+  changed |= apply(&completedFrameworks, delta->completedFrameworks);
+
+  foreachpair (const FrameworkID& frameworkId,
+               const Option<StateFragment>& framework,
+               delta->frameworks) {
+    if (framework.isNone()) {
+      finishedTasks.erase(frameworkId);
+      tasks.erase(frameworkId);
+    }
+  }
+
+  foreachpair (const FrameworkID& frameworkId,
+               const StateFragment& fragment,
+               delta->finishedTasks) {
+    CHECK(frameworks.contains(frameworkId))
+      << "Unknown framework " << frameworkId;
+
+    finishedTasks[frameworkId] = fragment;
+    changed = true;
+  }
+
+  foreachpair (const FrameworkID& frameworkId,
+               const auto& changes,
+               delta->tasks) {
+    CHECK(frameworks.contains(frameworkId))
+      << "Unknown framework " << frameworkId;
+
+    changed |= apply(&tasks[frameworkId], changes);
+  }
+
+  if (changed) {
+    ++version;
+    json_ = None();
+    protobuf_ = None();
+  }
+}
+
+
+Future<Response> StateCacheProcess::state(const Request& request)
+{
+  // Prefer JSON, e.g., for "Accept: */*", to stay compatible with
+  // the clients of the endpoint that do not send an "Accept" header.
+  const bool protobuf = !request.acceptsMediaType(APPLICATION_JSON) &&
+    request.acceptsMediaType(APPLICATION_PROTOBUF);
+
+  const Option<string> jsonp = request.url.query.get("jsonp");
+
+  // The entity tag depends on the representation. We do not tag
+  // JSONP responses, which also depend on the callback name.
+  Option<string> etag;
+  if (jsonp.isNone()) {
+    etag = "\"" + id + "-" + stringify(version) +
+      (protobuf ? "-protobuf" : "-json") + "\"";
+  }
+
+  Option<string> match = request.headers.get("If-None-Match");
+  if (etag.isSome() && match.isSome()) {
+    foreach (const string& token, strings::tokenize(match.get(), ",")) {
+      const string tag = strings::trim(token);
+
+      if (tag == "*" || tag == etag.get()) {
+        Response response(Status::NOT_MODIFIED);
+        response.headers["ETag"] = etag.get();
+        return response;
+      }
+    }
+  }
+
+  Response response;
+
+  if (protobuf) {
+    response = OK(this->protobuf(), APPLICATION_PROTOBUF);
+  } else if (jsonp.isSome()) {
+    response = OK(jsonp.get() + "(" + json() + ");", "text/javascript");
+  } else {
+    response = OK(json(), APPLICATION_JSON);
+  }
+
+  if (etag.isSome()) {
+    response.headers["ETag"] = etag.get();
+  }
+
+  return response;
+}
+
+
+const string& StateCacheProcess::json()
+{
+  if (json_.isSome()) {
+    return json_.get();
+  }
+
+  // Reserve enough space up front, the tasks make up most of the
+  // snapshot of a large cluster.
+  size_t size = global.json.size() + 64;
+
+  foreachvalue (const StateFragment& slave, slaves) {
+    size += slave.json.size() + 1;
+  }
+
+  foreachvalue (const StateFragment& framework, frameworks) {
+    size += framework.json.size() + 16;
+  }
+
+  foreachvalue (const StateFragment& fragment, finishedTasks) {
+    size += fragment.json.size() + 1;
+  }
+
+  foreachvalue (const auto& fragments, tasks) {
+    foreachvalue (const StateFragment& task, fragments) {
+      size += task.json.size() + 1;
+    }
+  }
+
+  foreachvalue (const StateFragment& framework, completedFrameworks) {
+    size += framework.json.size() + 1;
+  }
+
+  string json;
+  json.reserve(size);
+
+  json += "{" + fields(global.json);
+
+  json += ",\"slaves\":[";
+
+  bool first = true;
+  foreachvalue (const StateFragment& slave, slaves) {
+    json += first ? "" : ",";
+    json += slave.json;
+    first = false;
+  }
+
+  json += "],\"frameworks\":[";
+
+  first = true;
+  foreachpair (const FrameworkID& frameworkId,
+               const StateFragment& framework,
+               frameworks) {
+    json += first ? "{" : ",{";
+    json += fields(framework.json);
+
+    if (finishedTasks.contains(frameworkId)) {
+      json += ",";
+      json += fields(finishedTasks.at(frameworkId).json);
+    }
+
+    json += ",\"tasks\":[";
+
+    if (tasks.contains(frameworkId)) {
+      bool firstTask = true;
+      foreachvalue (const StateFragment& task, tasks.at(frameworkId)) {
+        json += firstTask ? "" : ",";
+        json += task.json;
+        firstTask = false;
+      }
+    }
+
+    json += "]}";
+    first = false;
+  }
+
+  json += "],\"completed_frameworks\":[";
+
+  first = true;
+  foreachvalue (const StateFragment& framework, completedFrameworks) {
+    json += first ? "" : ",";
+    json += framework.json;
+    first = false;
+  }
+
+  json += "]}";
+
+  json_ = std::move(json);
+
+  return json_.get();
+}
+
+
+const string& StateCacheProcess::protobuf()
+{
+  if (protobuf_.isSome()) {
+    return protobuf_.get();
+  }
+
+  size_t size = global.protobuf.size();
+
+  foreachvalue (const StateFragment& slave, slaves) {
+    size += slave.protobuf.size();
+  }
+
+  foreachvalue (const StateFragment& framework, frameworks) {
+    size += framework.protobuf.size();
+  }
+
+  foreachvalue (const StateFragment& fragment, finishedTasks) {
+    size += fragment.protobuf.size();
+  }
+
+  foreachvalue (const auto& fragments, tasks) {
+    foreachvalue (const StateFragment& task, fragments) {
+      size += task.protobuf.size();
+    }
+  }
+
+  foreachvalue (const StateFragment& framework, completedFrameworks) {
+    size += framework.protobuf.size();
+  }
+
+  // The fragments are partial `GetState` messages, so we write the
+  // `Response` by hand: its `type` followed by the `get_state` field
+  // with the concatenated fragments as its value.
+  mesos::master::Response response;
+  response.set_type(mesos::master::Response::GET_STATE);
+
+  string protobuf;
+  protobuf.reserve(response.ByteSize() + 16 + size);
+
+  response.AppendToString(&protobuf);
+
+  {
+    google::protobuf::io::StringOutputStream stream(&protobuf);
+    google::protobuf::io::CodedOutputStream output(&stream);
+
+    output.WriteTag(WireFormatLite::MakeTag(
+        mesos::master::Response::kGetStateFieldNumber,
+        WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+
+    output.WriteVarint32(size);
+  }
+
+  protobuf += global.protobuf;
+
+  foreachvalue (const StateFragment& slave, slaves) {
+    protobuf += slave.protobuf;
+  }
+
+  foreachvalue (const StateFragment& framework, frameworks) {
+    protobuf += framework.protobuf;
+  }
+
+  foreachvalue (const StateFragment& fragment, finishedTasks) {
+    protobuf += fragment.protobuf;
+  }
+
+  foreachvalue (const auto& fragments, tasks) {
+    foreachvalue (const StateFragment& task, fragments) {
+      protobuf += task.protobuf;
+    }
+  }
+
+  foreachvalue (const StateFragment& framework, completedFrameworks) {
+    protobuf += framework.protobuf;
+  }
+
+  protobuf_ = std::move(protobuf);
+
+  return protobuf_.get();
+}
+
+
+StateCache::StateCache(const string& id)
+{
+  process = new StateCacheProcess(id);
+  spawn(process);
+}
+
+
+StateCache::~StateCache()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+void StateCache::update(const Owned<StateDelta>& delta)
+{
+  dispatch(process, &StateCacheProcess::update, delta);
+}
+
+
+Future<Response> StateCache::state(const Request& request)
+{
+  return dispatch(process, &StateCacheProcess::state, request);
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,118 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_STATE_CACHE_HPP__
+#define __MASTER_STATE_CACHE_HPP__
+
+#include <string>
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/owned.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Forward declaration.
+class StateCacheProcess;
+
+
+// A part of the state served by the `/state` endpoint, serialized
+// both as JSON and as a partial `mesos::master::Response::GetState`.
+// Partial protobuf messages can simply be concatenated, which merges
+// them (and appends their repeated fields) when parsed.
+struct StateFragment
+{
+  std::string json;
+  std::string protobuf;
+};
+
+
+// The changes to the state since the previous `StateDelta`. A `None`
+// fragment means that the agent, framework or task has been removed.
+struct StateDelta
+{
+  // Everything except for the agents and the frameworks, which is
+  // small enough to be serialized from scratch when any of it might
+  // have changed, otherwise `None`. The JSON object gets the "slaves",
+  // "frameworks" and "completed_frameworks" fields added by the
+  // `StateCache`.
+  Option<StateFragment> global;
+
+  hashmap<SlaveID, Option<StateFragment>> slaves;
+
+  // Frameworks without their tasks, which change independently of
+  // the rest of the framework. The JSON object gets the task fields
+  // added by the `StateCache`. Removing a framework also removes its
+  // tasks.
+  hashmap<FrameworkID, Option<StateFragment>> frameworks;
+
+  // The unreachable and completed tasks of the frameworks above, as
+  // a JSON object with the "unreachable_tasks" and "completed_tasks"
+  // fields, which get added to the framework.
+  hashmap<FrameworkID, StateFragment> finishedTasks;
+
+  // Active and pending tasks of the frameworks above.
+  hashmap<FrameworkID, hashmap<TaskID, Option<StateFragment>>> tasks;
+
+  // Completed frameworks do not change, they are only added and
+  // eventually removed.
+  hashmap<FrameworkID, Option<StateFragment>> completedFrameworks;
+};
+
+
+// Versioned snapshot of the state served by the `/state` endpoint,
+// which the master keeps up to date by applying a `StateDelta` with
+// only the parts of the state that changed. The snapshot is served
+// by its own process, so that putting the full response together
+// does not block the master, and it is only put together once per
+// version and representation.
+class StateCache
+{
+public:
+  // The `id` is the ID of the master, used to make sure that the
+  // entity tags of different masters do not match.
+  explicit StateCache(const std::string& id);
+  ~StateCache();
+
+  void update(const process::Owned<StateDelta>& delta);
+
+  // Returns the snapshot as JSON or, if the request does not accept
+  // JSON but accepts protobuf, as a serialized `GET_STATE` response
+  // of the v1 operator API. Returns `304 Not Modified` if the
+  // request has an `If-None-Match` header with the entity tag of the
+  // current version of the snapshot.
+  process::Future<process::http::Response> state(
+      const process::http::Request& request);
+
+private:
+  StateCache(const StateCache&);            // No copying.
+  StateCache& operator=(const StateCache&); // No assigning.
+
+  StateCacheProcess* process;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_STATE_CACHE_HPP__
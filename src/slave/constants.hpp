@@ -157,6 +157,13 @@ constexpr char EXECUTOR_HTTP_AUTHENTICATION_REALM[] = "mesos-agent-executor";
 // Default maximum storage space to be used by the fetcher cache.
 constexpr Bytes DEFAULT_FETCHER_CACHE_SIZE = Gigabytes(2);
 
+// Default number of URIs fetched in parallel for a container.
+constexpr size_t DEFAULT_FETCHER_CONCURRENCY = 4;
+
+// Default number of image layers pulled in parallel from a Docker
+// registry, which matches the default of the Docker daemon.
+constexpr size_t DEFAULT_DOCKER_PULL_CONCURRENCY = 3;
+
 // If no pings received within this timeout, then the slave will
 // trigger a re-detection of the master to cause a re-registration.
 Duration DEFAULT_MASTER_PING_TIMEOUT();
@@ -45,6 +45,10 @@
 
 #include "common/status_utils.hpp"
 
+#ifndef __WINDOWS__
+#include "docker/engine.hpp"
+#endif // __WINDOWS__
+
 #include "hook/manager.hpp"
 
 #ifdef __linux__
@@ -167,11 +171,25 @@ Try<DockerContainerizer*> DockerContainerizer::create(
     return Error("Failed to create container logger: " + logger.error());
   }
 
+#ifndef __WINDOWS__
+  Try<Owned<Docker>> create = flags.docker_engine_api
+    ? DockerEngine::create(
+          flags.docker,
+          flags.docker_socket,
+          true,
+          flags.docker_config)
+    : Docker::create(
+          flags.docker,
+          flags.docker_socket,
+          true,
+          flags.docker_config);
+#else
   Try<Owned<Docker>> create = Docker::create(
       flags.docker,
       flags.docker_socket,
       true,
       flags.docker_config);
+#endif // __WINDOWS__
 
   if (create.isError()) {
     return Error("Failed to create docker: " + create.error());
@@ -249,6 +267,9 @@ DockerContainerizer::~DockerContainerizer()
   dockerFlags.sandbox_directory = directory;
   dockerFlags.mapped_directory = flags.sandbox_directory;
   dockerFlags.docker_socket = flags.docker_socket;
+#ifndef __WINDOWS__
+  dockerFlags.docker_engine_api = flags.docker_engine_api;
+#endif // __WINDOWS__
   dockerFlags.launcher_dir = flags.launcher_dir;
 
   if (taskEnvironment.isSome()) {
@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <unordered_map>
 
 #include <process/async.hpp>
@@ -33,6 +34,9 @@
 #include <stout/os/find.hpp>
 #include <stout/os/killtree.hpp>
 #include <stout/os/read.hpp>
+#include <stout/os/rename.hpp>
+
+#include "common/command_utils.hpp"
 
 #include "hdfs/hdfs.hpp"
 
@@ -553,6 +557,8 @@ Future<Nothing> FetcherProcess::__fetch(
     info.set_frameworks_home(flags.frameworks_home);
   }
 
+  info.set_concurrency(flags.fetcher_concurrency);
+
   return run(containerId, sandboxDirectory, user, info, flags)
     .repair(defer(self(), [=](const Future<Nothing>& future) {
       LOG(ERROR) << "Failed to run mesos-fetcher: " << future.failure();
@@ -586,6 +592,10 @@ Future<Nothing> FetcherProcess::__fetch(
             Try<Nothing> adjust = cache.adjust(entry.get());
             if (adjust.isSome()) {
               entry.get()->complete();
+
+#ifndef __WINDOWS__
+              deduplicate(entry.get());
+#endif // __WINDOWS__
             } else {
               LOG(WARNING) << "Failed to adjust the cache size for entry '"
                            << entry.get()->key << "' with error: "
@@ -677,6 +687,35 @@ Bytes FetcherProcess::availableCacheSpace()
 }
 
 
+void FetcherProcess::deduplicate(const shared_ptr<Cache::Entry>& entry)
+{
+  // NOTE: The entry is already complete, so concurrent fetch attempts
+  // do not wait for the digest. Those retrieving the entry's file in
+  // the meantime still find a complete file at its path, because the
+  // file only ever gets replaced by a hard link with the same content.
+  command::sha512(entry->path())
+    .onAny(defer(self(), [=](const Future<string>& digest) {
+      if (!digest.isReady()) {
+        LOG(WARNING) << "Failed to compute the digest of fetcher cache file '"
+                     << entry->path() << "': "
+                     << (digest.isFailed() ? digest.failure() : "discarded");
+        return;
+      }
+
+      // The entry may have been evicted in the meantime.
+      if (!cache.contains(entry)) {
+        return;
+      }
+
+      Try<Nothing> deduplicate = cache.deduplicate(entry, digest.get());
+      if (deduplicate.isError()) {
+        LOG(WARNING) << "Failed to deduplicate fetcher cache entry '"
+                     << entry->key << "': " << deduplicate.error();
+      }
+    }));
+}
+
+
 Future<shared_ptr<FetcherProcess::Cache::Entry>>
 FetcherProcess::reserveCacheSpace(
     const Try<Bytes>& requestedSpace,
@@ -974,6 +1013,14 @@ static string cacheKey(const Option<string>& user, const string& uri)
 }
 
 
+// Content is only shared within a cache directory, since the cache
+// directories of different users hold files owned by those users.
+static string digestKey(const string& cacheDirectory, const string& digest)
+{
+  return path::join(cacheDirectory, digest);
+}
+
+
 shared_ptr<FetcherProcess::Cache::Entry> FetcherProcess::Cache::create(
     const string& cacheDirectory,
     const Option<string>& user,
@@ -1075,6 +1122,25 @@ Try<Nothing> FetcherProcess::Cache::remove(
   table.erase(entry->key);
   lruSortedEntries.remove(entry);
 
+  if (entry->digest.isSome()) {
+    const string key = digestKey(entry->directory, entry->digest.get());
+
+    CHECK(digests.contains(key));
+
+    list<shared_ptr<Entry>>& entries = digests.at(key);
+    entries.remove(entry);
+
+    if (entries.empty()) {
+      digests.erase(key);
+    } else if (entry->size > 0) {
+      // Deleting this entry's file does not free the content's space
+      // while other links to it remain, so one of them takes over the
+      // accounting for it.
+      entries.front()->size = entry->size;
+      entry->size = 0;
+    }
+  }
+
   // We may or may not have started downloading. The download may or may
   // not have been partial. In any case, clean up whatever is there.
   if (os::exists(entry->path().string())) {
@@ -1109,14 +1175,35 @@ FetcherProcess::Cache::selectVictims(const Bytes& requiredSpace)
   Bytes space = 0;
 
   foreach (const shared_ptr<Cache::Entry>& entry, lruSortedEntries) {
-    if (!entry->isReferenced()) {
-      victims.push_back(entry);
+    if (std::find(victims.begin(), victims.end(), entry) != victims.end()) {
+      continue;
+    }
 
-      space += entry->size;
-      if (space >= requiredSpace) {
-        return victims;
+    // Shared content only gets freed once all of its entries are
+    // removed, so we either select all of them or none.
+    const list<shared_ptr<Cache::Entry>> group = duplicates(entry);
+
+    bool referenced = false;
+    foreach (const shared_ptr<Cache::Entry>& duplicate, group) {
+      if (duplicate->isReferenced()) {
+        referenced = true;
+        break;
       }
     }
+
+    if (referenced) {
+      continue;
+    }
+
+    foreach (const shared_ptr<Cache::Entry>& duplicate, group) {
+      victims.push_back(duplicate);
+
+      space += duplicate->size;
+    }
+
+    if (space >= requiredSpace) {
+      return victims;
+    }
   }
 
   return Error("Could not find enough cache files to evict");
@@ -1179,6 +1266,69 @@ Try<Nothing> FetcherProcess::Cache::adjust(
 }
 
 
+Try<Nothing> FetcherProcess::Cache::deduplicate(
+    const shared_ptr<FetcherProcess::Cache::Entry>& entry,
+    const string& digest)
+{
+  CHECK(contains(entry));
+  CHECK_NONE(entry->digest);
+
+  const string key = digestKey(entry->directory, digest);
+
+  if (digests.contains(key)) {
+#ifdef __WINDOWS__
+    return Error("Hard links are not supported on Windows");
+#else
+    const shared_ptr<Entry>& original = digests.at(key).front();
+
+    // Link under a temporary name first, so that the entry's path
+    // refers to a complete file at all times.
+    const string temporary = entry->path().string() + ".link";
+
+    if (::link(original->path().string().c_str(), temporary.c_str()) < 0) {
+      return ErrnoError(
+          "Failed to link '" + temporary + "' to '" +
+          original->path().string() + "'");
+    }
+
+    Try<Nothing> rename = os::rename(temporary, entry->path().string());
+    if (rename.isError()) {
+      os::rm(temporary);
+      return Error(
+          "Failed to replace '" + entry->path().string() + "': " +
+          rename.error());
+    }
+
+    VLOG(1) << "Cache entry '" << entry->key << "' shares its content with '"
+            << original->key << "'";
+
+    if (entry->size > 0) {
+      releaseSpace(entry->size);
+
+      entry->size = 0;
+    }
+#endif // __WINDOWS__
+  }
+
+  entry->digest = digest;
+  digests[key].push_back(entry);
+
+  return Nothing();
+}
+
+
+list<shared_ptr<FetcherProcess::Cache::Entry>>
+FetcherProcess::Cache::duplicates(
+    const shared_ptr<FetcherProcess::Cache::Entry>& entry)
+{
+  if (entry->digest.isNone()) {
+    return {entry};
+  }
+
+  return digests.at(digestKey(entry->directory, entry->digest.get()));
+}
+
+
 size_t FetcherProcess::Cache::size()
 {
   return table.size();
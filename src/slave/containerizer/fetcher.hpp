@@ -202,8 +202,15 @@ public:
       // The expected size of the cache file. This field is set before
       // downloading. If the actual size of the downloaded file is
       // different a warning is logged and the field's value adjusted.
+      // An entry whose file is a hard link to the file of another
+      // entry with the same content has a size of zero, so that the
+      // shared bytes are only accounted for once.
       Bytes size;
 
+      // The SHA-512 digest of the cache file's content, once it has
+      // been computed after downloading.
+      Option<std::string> digest;
+
     private:
       // Concurrent fetch attempts can reference the same entry multiple
       // times.
@@ -252,9 +259,22 @@ public:
     // Virtual for mock testing.
     virtual Try<Nothing> remove(const std::shared_ptr<Entry>& entry);
 
+    // Records the content digest of a downloaded entry. If another
+    // entry in the same cache directory already holds identical
+    // content, the entry's file is replaced by a hard link to that
+    // entry's file and the entry's claimed space is released.
+    Try<Nothing> deduplicate(
+        const std::shared_ptr<Entry>& entry,
+        const std::string& digest);
+
+    // Returns the entries whose files share the content of the given
+    // entry, including the entry itself.
+    std::list<std::shared_ptr<Entry>> duplicates(
+        const std::shared_ptr<Entry>& entry);
+
     // Determines a list of cache entries to remove, respectively cache files
     // to delete, so that at least the required amount of space would become
-    // available.
+    // available. Entries that share content are only selected together.
     Try<std::list<std::shared_ptr<Cache::Entry>>>
         selectVictims(const Bytes& requiredSpace);
 
@@ -286,6 +306,12 @@ public:
 
     // Stores cache file entries sorted from LRU to MRU.
     std::list<std::shared_ptr<Entry>> lruSortedEntries;
+
+    // Maps content digests (per cache directory) to the entries whose
+    // files hold that content. All but the first of these entries are
+    // hard links to the first one's file. Only the entry accounting
+    // for the content's space has a non-zero size.
+    hashmap<std::string, std::list<std::shared_ptr<Entry>>> digests;
   };
 
   // Public and virtual for mock testing.
@@ -324,6 +350,11 @@ private:
       const Option<std::string>& user,
       const Flags& flags);
 
+  // Computes the digest of a newly downloaded cache file and shares its
+  // content with other entries for the same content. Best effort: on
+  // failure the entry simply keeps its own copy.
+  void deduplicate(const std::shared_ptr<Cache::Entry>& entry);
+
   // Calls Cache::reserve() and returns a ready entry future if successful,
   // else Failure. Claims the space and assigns the entry's size to this
   // amount if and only if successful.
@@ -14,6 +14,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <sys/resource.h>
+
+#include <limits>
+
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/id.hpp>
@@ -21,6 +25,7 @@
 
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
+#include <stout/path.hpp>
 
 #include "linux/perf.hpp"
 
@@ -44,10 +49,6 @@ Try<Owned<Subsystem>> PerfEventSubsystem::create(
     const Flags& flags,
     const string& hierarchy)
 {
-  if (!perf::supported()) {
-    return Error("Perf is not supported");
-  }
-
   if (flags.perf_duration > flags.perf_interval) {
     return Error(
         "Sampling perf for duration (" + stringify(flags.perf_duration) + ") > "
@@ -64,7 +65,54 @@ Try<Owned<Subsystem>> PerfEventSubsystem::create(
     events.insert(event);
   }
 
-  if (!perf::valid(events)) {
+  // Each counter takes a file descriptor, so by default we leave
+  // most of the agent's file descriptors for everything else.
+  size_t maxCounters = 0;
+
+  if (flags.perf_max_counters.isSome()) {
+    maxCounters = flags.perf_max_counters.get();
+  } else {
+    struct rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == -1) {
+      return ErrnoError("Failed to get the open file limit");
+    }
+
+    maxCounters = limit.rlim_cur == RLIM_INFINITY
+      ? std::numeric_limits<size_t>::max()
+      : static_cast<size_t>(limit.rlim_cur / 4);
+  }
+
+  // Prefer counting the events directly, which doesn't need the
+  // 'perf' binary and covers the whole interval at the cost of a few
+  // read(2) calls per container, rather than a `perf stat` process.
+  Try<Owned<perf::Counters>> counters =
+    perf::Counters::create(events, hierarchy, maxCounters);
+
+  // The containers that don't fit into the counters are sampled with
+  // `perf stat`, if possible.
+  const bool sampling = perf::supported() && perf::valid(events);
+
+  if (counters.isSome()) {
+    LOG(INFO) << "perf_event subsystem will count events every "
+              << "'" << flags.perf_interval << "' "
+              << "for events: " << stringify(events)
+              << " using at most " << maxCounters << " counters"
+              << (sampling ? ", profiling the other containers for '" +
+                             stringify(flags.perf_duration) + "'"
+                           : "");
+
+    return Owned<Subsystem>(new PerfEventSubsystem(
+        flags, hierarchy, events, counters.get(), sampling));
+  }
+
+  LOG(INFO) << "perf_event subsystem can not count events directly, "
+            << "falling back to `perf stat`: " << counters.error();
+
+  if (!perf::supported()) {
+    return Error("Perf is not supported");
+  }
+
+  if (!sampling) {
     return Error("Invalid perf events: " + stringify(events));
   }
 
@@ -73,17 +121,22 @@ Try<Owned<Subsystem>> PerfEventSubsystem::create(
             << "every '" << flags.perf_interval << "' "
             << "for events: " << stringify(events);
 
-  return Owned<Subsystem>(new PerfEventSubsystem(flags, hierarchy, events));
+  return Owned<Subsystem>(
+      new PerfEventSubsystem(flags, hierarchy, events, None(), true));
 }
 
 
 PerfEventSubsystem::PerfEventSubsystem(
     const Flags& _flags,
     const string& _hierarchy,
-    const set<string>& _events)
+    const set<string>& _events,
+    const Option<Owned<perf::Counters>>& _counters,
+    bool _sampling)
   : ProcessBase(process::ID::generate("cgroups-perf-event-subsystem")),
     Subsystem(_flags, _hierarchy),
-    events(_events) {}
+    events(_events),
+    counters(_counters),
+    sampling(_sampling) {}
 
 
 void PerfEventSubsystem::initialize()
@@ -103,6 +156,8 @@ Future<Nothing> PerfEventSubsystem::recover(
 
   infos.put(containerId, Owned<Info>(new Info(cgroup)));
 
+  count(infos[containerId].get());
+
   return Nothing();
 }
 
@@ -117,6 +172,8 @@ Future<Nothing> PerfEventSubsystem::prepare(
 
   infos.put(containerId, Owned<Info>(new Info(cgroup)));
 
+  count(infos[containerId].get());
+
   return Nothing();
 }
 
@@ -149,21 +206,66 @@ Future<Nothing> PerfEventSubsystem::cleanup(
     return Nothing();
   }
 
+  if (infos[containerId]->counted) {
+    CHECK_SOME(counters);
+    counters.get()->remove(cgroup);
+  }
+
   infos.erase(containerId);
 
   return Nothing();
 }
 
 
+void PerfEventSubsystem::count(Info* info)
+{
+  if (counters.isNone()) {
+    return;
+  }
+
+  // Perf statistics are best effort, so we don't fail the container
+  // if its cgroup can't be counted (e.g., because the counters are
+  // exhausted). Its events are then sampled with `perf stat` if
+  // possible, otherwise usage() keeps returning the empty sample.
+  Try<Nothing> add =
+    counters.get()->add(info->cgroup, path::join(hierarchy, info->cgroup));
+
+  if (add.isError()) {
+    LOG(WARNING) << "Failed to count perf events for cgroup '"
+                 << info->cgroup << "'"
+                 << (sampling ? ", sampling them with `perf stat`" : "")
+                 << ": " << add.error();
+    return;
+  }
+
+  info->counted = true;
+}
+
+
 void PerfEventSubsystem::sample()
 {
+  if (counters.isSome()) {
+    // Reading the counters is cheap and synchronous, and each read
+    // covers the time since the previous one.
+    update(counters.get()->read());
+  }
+
   // Collect a perf sample for all cgroups that are not being
-  // destroyed. Since destroyal is asynchronous, 'perf stat' may
-  // fail if the cgroup is destroyed before running perf.
+  // destroyed and not counted directly. Since destroyal is
+  // asynchronous, 'perf stat' may fail if the cgroup is destroyed
+  // before running perf.
   set<string> cgroups;
 
   foreachvalue (const Owned<Info>& info, infos) {
-    cgroups.insert(info->cgroup);
+    if (!info->counted) {
+      cgroups.insert(info->cgroup);
+    }
+  }
+
+  if (counters.isSome() && (cgroups.empty() || !sampling)) {
+    _sample(Clock::now() + flags.perf_interval,
+            hashmap<string, PerfStatistics>());
+    return;
   }
 
   // The discard timeout includes an allowance of twice the
@@ -199,13 +301,7 @@ void PerfEventSubsystem::_sample(
     LOG(ERROR) << "Failed to get the perf sample: "
                << (statistics.isFailed() ? statistics.failure() : "timeout");
   } else {
-    // Store the latest statistics, note that cgroups added in the
-    // interim will be picked up by the next sample.
-    foreachvalue (const Owned<Info>& info, infos) {
-      if (statistics->contains(info->cgroup)) {
-        info->statistics = statistics->get(info->cgroup).get();
-      }
-    }
+    update(statistics.get());
   }
 
   // Schedule sample for the next time.
@@ -214,6 +310,19 @@ void PerfEventSubsystem::_sample(
         &PerfEventSubsystem::sample);
 }
 
+
+void PerfEventSubsystem::update(
+    const hashmap<string, PerfStatistics>& statistics)
+{
+  // Store the latest statistics, note that cgroups added in the
+  // interim will be picked up by the next sample.
+  foreachvalue (const Owned<Info>& info, infos) {
+    if (statistics.contains(info->cgroup)) {
+      info->statistics = statistics.at(info->cgroup);
+    }
+  }
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
@@ -28,6 +28,9 @@
 #include <process/time.hpp>
 
 #include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+
+#include "linux/perf.hpp"
 
 #include "slave/flags.hpp"
 
@@ -78,12 +81,15 @@ private:
   PerfEventSubsystem(
       const Flags& flags,
       const std::string& hierarchy,
-      const std::set<std::string>& events);
+      const std::set<std::string>& events,
+      const Option<process::Owned<perf::Counters>>& counters,
+      bool sampling);
 
   struct Info
   {
     Info(const std::string& _cgroup)
-      : cgroup(_cgroup)
+      : cgroup(_cgroup),
+        counted(false)
     {
       // Ensure the initial statistics include the required fields.
       // Note the duration is set to zero to indicate no sampling has
@@ -95,10 +101,20 @@ private:
 
     const std::string cgroup;
     PerfStatistics statistics;
+
+    // Whether the events of the cgroup are counted directly rather
+    // than sampled with `perf stat`.
+    bool counted;
   };
 
+  // Starts counting the events of the cgroup, if counting directly.
+  void count(Info* info);
+
   void sample();
 
+  // Stores the latest statistics of each cgroup.
+  void update(const hashmap<std::string, PerfStatistics>& statistics);
+
   void _sample(
       const process::Time& next,
       const process::Future<hashmap<std::string, PerfStatistics>>& statistics);
@@ -106,6 +122,15 @@ private:
   // Set of events to sample.
   std::set<std::string> events;
 
+  // If all the events can be counted directly, the counters of each
+  // cgroup are kept open and read every interval instead of running
+  // `perf stat` for each sample.
+  Option<process::Owned<perf::Counters>> counters;
+
+  // Whether `perf stat` can be used, i.e., to sample the cgroups that
+  // can't be counted directly because the counters are exhausted.
+  const bool sampling;
+
   // Stores cgroups associated information for container.
   hashmap<ContainerID, process::Owned<Info>> infos;
 };
@@ -17,33 +17,44 @@
 #include <signal.h>
 
 #ifdef __linux__
+#include <sys/inotify.h>
 #include <sys/prctl.h>
 #endif
+#include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <deque>
 #include <tuple>
+#include <utility>
+
+#include <boost/functional/hash.hpp>
 
 #include <glog/logging.h>
 
 #include <process/check.hpp>
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/id.hpp>
 #include <process/io.hpp>
 #include <process/subprocess.hpp>
+#include <process/time.hpp>
 
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
 #include <stout/numify.hpp>
 #include <stout/strings.hpp>
 #include <stout/path.hpp>
 
+#include <stout/os/close.hpp>
 #include <stout/os/constants.hpp>
 #include <stout/os/exists.hpp>
 #include <stout/os/killtree.hpp>
+#include <stout/os/ls.hpp>
 #include <stout/os/stat.hpp>
 
 #include "common/protobuf_utils.hpp"
@@ -57,6 +68,7 @@ using std::list;
 using std::string;
 using std::vector;
 
+using process::Clock;
 using process::Failure;
 using process::Future;
 using process::Owned;
@@ -64,6 +76,7 @@ using process::PID;
 using process::Process;
 using process::Promise;
 using process::Subprocess;
+using process::Time;
 
 using process::await;
 using process::defer;
@@ -455,12 +468,570 @@ Future<Nothing> PosixDiskIsolatorProcess::cleanup(
 }
 
 
+#ifdef __linux__
+// The number of directories listed at a time when walking a tree.
+constexpr size_t DISK_USAGE_SCAN_DIRECTORIES = 64;
+
+
+// Maintains the disk usage of directory trees incrementally. Every
+// directory of a tree is watched with inotify(7) so that only the
+// entries that changed since the usage was last asked for need to be
+// stat'ed again, rather than walking the whole tree like 'du' does.
+// Like 'du -s', the usage is the blocks allocated to each file and
+// directory, counting hard links once and not following symbolic
+// links.
+//
+// Walking a tree is done in steps (see 'scan') so that the caller can
+// interleave other work, and each tree uses at most 'maxWatches'
+// watches so that a single huge tree can't exhaust the watches of the
+// user (see '/proc/sys/fs/inotify/max_user_watches').
+//
+// NOTE: The tracker is owned and used by the DiskUsageCollectorProcess
+// only, and hence does not need any synchronization.
+class DiskUsageTracker
+{
+public:
+  static Try<Owned<DiskUsageTracker>> create(size_t maxWatches)
+  {
+    int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+      return ErrnoError("Failed to initialize inotify");
+    }
+
+    return Owned<DiskUsageTracker>(new DiskUsageTracker(fd, maxWatches));
+  }
+
+  ~DiskUsageTracker()
+  {
+    // Closing the inotify instance removes all of its watches.
+    os::close(fd);
+  }
+
+  // The inotify file descriptor, which is readable when there are
+  // events to be drained.
+  int descriptor() const
+  {
+    return fd;
+  }
+
+  bool tracking(const string& path, const vector<string>& excludes) const
+  {
+    return trees.contains(path) &&
+      trees.at(path)->excludes == normalize(excludes);
+  }
+
+  // Starts tracking the directory tree rooted at 'path', excluding the
+  // directories (or files) at the absolute paths in 'excludes'. Only
+  // the root is watched here, the rest of the tree is walked by 'scan',
+  // which in total costs about as much as running 'du'.
+  Try<Nothing> track(const string& path, const vector<string>& excludes)
+  {
+    untrack(path);
+
+    Owned<Tree> tree(new Tree());
+    tree->root = path;
+    tree->excludes = normalize(excludes);
+
+    trees.put(path, tree);
+
+    Try<Nothing> watch = DiskUsageTracker::watch(tree.get(), None(), path);
+    if (watch.isError()) {
+      untrack(path);
+      return Error(watch.error());
+    }
+
+    return Nothing();
+  }
+
+  // Lists at most 'limit' of the directories of the tree rooted at
+  // 'path' that are watched but not listed yet, which watches their
+  // subdirectories in turn. Returns whether the walk is complete, i.e.,
+  // whether 'usage' accounts for the whole tree.
+  Try<bool> scan(const string& path, size_t limit)
+  {
+    CHECK(trees.contains(path));
+
+    Tree* tree = trees.at(path).get();
+
+    for (size_t i = 0; i < limit && !tree->pending.empty(); i++) {
+      const int wd = tree->pending.front();
+      tree->pending.pop_front();
+
+      // The directory might have been removed in the meantime.
+      if (!watches.contains(wd) || watches.at(wd).first != tree) {
+        continue;
+      }
+
+      Try<Nothing> list =
+        DiskUsageTracker::list(tree, watches.at(wd).second);
+
+      if (list.isError()) {
+        return Error(list.error());
+      }
+    }
+
+    return tree->pending.empty();
+  }
+
+  hashset<string> paths() const
+  {
+    return trees.keys();
+  }
+
+  void untrack(const string& path)
+  {
+    if (!trees.contains(path)) {
+      return;
+    }
+
+    Owned<Tree> tree = trees.at(path);
+
+    if (tree->directory.get() != nullptr) {
+      remove(tree.get(), tree->directory.get());
+    }
+
+    trees.erase(path);
+  }
+
+  // Reads the pending inotify events and records which entries need
+  // to be stat'ed again. Called whenever the inotify file descriptor
+  // is readable so that the kernel's event queue does not overflow.
+  void drain()
+  {
+    // Large enough for a few hundred events with names.
+    char buffer[64 * 1024]
+      __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+    while (true) {
+      ssize_t length = ::read(fd, buffer, sizeof(buffer));
+
+      if (length < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+          PLOG(ERROR) << "Failed to read inotify events";
+        }
+
+        if (errno == EINTR) {
+          continue;
+        }
+
+        return;
+      }
+
+      for (char* position = buffer; position < buffer + length;) {
+        const struct inotify_event* event =
+          reinterpret_cast<const struct inotify_event*>(position);
+
+        position += sizeof(struct inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW) {
+          // Some events were lost, so we can't trust any of the
+          // usages anymore and have to walk the trees again.
+          foreachvalue (const Owned<Tree>& tree, trees) {
+            tree->rescan = true;
+          }
+
+          continue;
+        }
+
+        if (!watches.contains(event->wd)) {
+          continue;
+        }
+
+        Tree* tree = watches.at(event->wd).first;
+        Directory* directory = watches.at(event->wd).second;
+
+        if (event->mask & IN_IGNORED) {
+          // The watched directory was removed, the event for its
+          // entry in the parent directory takes care of the usage.
+          directory->wd = -1;
+          watches.erase(event->wd);
+          tree->watched--;
+          continue;
+        }
+
+        if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+          if (directory == tree->directory.get()) {
+            tree->rescan = true;
+          }
+
+          continue;
+        }
+
+        // Events without a name are about the directory itself.
+        tree->dirty[event->wd].insert(
+            event->len > 0 ? string(event->name) : string());
+      }
+    }
+  }
+
+  // Stats the entries of the tree rooted at 'path' that changed since
+  // the previous call. New directories are left for 'scan' to list, as
+  // is the whole tree if it needs to be walked again because events
+  // were lost.
+  Try<Nothing> update(const string& path)
+  {
+    CHECK(trees.contains(path));
+
+    drain();
+
+    Owned<Tree> tree = trees.at(path);
+
+    if (tree->rescan) {
+      const vector<string> excludes(
+          tree->excludes.begin(), tree->excludes.end());
+
+      return track(path, excludes);
+    }
+
+    hashmap<int, hashset<string>> dirty;
+    std::swap(dirty, tree->dirty);
+
+    foreachpair (int wd, const hashset<string>& names, dirty) {
+      // The directory might have been removed while refreshing the
+      // entries of another one.
+      if (!watches.contains(wd)) {
+        continue;
+      }
+
+      Directory* directory = watches.at(wd).second;
+
+      foreach (const string& name, names) {
+        Try<Nothing> refresh =
+          DiskUsageTracker::refresh(tree.get(), directory, name);
+
+        if (refresh.isError()) {
+          return Error(refresh.error());
+        }
+      }
+    }
+
+    return Nothing();
+  }
+
+  Bytes usage(const string& path) const
+  {
+    CHECK(trees.contains(path));
+
+    return Bytes(trees.at(path)->usage);
+  }
+
+private:
+  typedef std::pair<dev_t, ino_t> Inode;
+
+  struct Directory
+  {
+    string path;
+    Inode inode;
+    int wd;
+
+    // The inodes of the files (i.e., everything but directories) and
+    // the subdirectories, by name.
+    hashmap<string, Inode> files;
+    hashmap<string, Owned<Directory>> directories;
+  };
+
+  struct Usage
+  {
+    uint64_t bytes;
+
+    // The number of names in the tree for this inode.
+    size_t links;
+  };
+
+  struct Tree
+  {
+    Tree() : usage(0), watched(0), rescan(false) {}
+
+    string root;
+    hashset<string> excludes;
+
+    Owned<Directory> directory;
+
+    hashmap<Inode, Usage, boost::hash<Inode>> inodes;
+    uint64_t usage;
+
+    // The names of the entries to stat again, by watch descriptor of
+    // the containing directory. The empty name is the directory
+    // itself.
+    hashmap<int, hashset<string>> dirty;
+
+    // The watch descriptors of the directories that still need to be
+    // listed, and the number of directories watched.
+    deque<int> pending;
+    size_t watched;
+
+    bool rescan;
+  };
+
+  DiskUsageTracker(int _fd, size_t _maxWatches)
+    : fd(_fd), maxWatches(_maxWatches) {}
+
+  DiskUsageTracker(const DiskUsageTracker&) = delete;
+  DiskUsageTracker& operator=(const DiskUsageTracker&) = delete;
+
+  static hashset<string> normalize(const vector<string>& excludes)
+  {
+    hashset<string> result;
+    foreach (const string& exclude, excludes) {
+      result.insert(strings::remove(exclude, "/", strings::SUFFIX));
+    }
+
+    return result;
+  }
+
+  // Counts the inode in the tree, unless it has already been counted
+  // for another name.
+  void reference(Tree* tree, const Inode& inode, uint64_t bytes)
+  {
+    if (tree->inodes.contains(inode)) {
+      tree->inodes.at(inode).links++;
+      return;
+    }
+
+    tree->inodes.put(inode, {bytes, 1});
+    tree->usage += bytes;
+  }
+
+  void dereference(Tree* tree, const Inode& inode)
+  {
+    CHECK(tree->inodes.contains(inode));
+
+    Usage& usage = tree->inodes.at(inode);
+
+    if (--usage.links == 0) {
+      tree->usage -= usage.bytes;
+      tree->inodes.erase(inode);
+    }
+  }
+
+  void resize(Tree* tree, const Inode& inode, uint64_t bytes)
+  {
+    CHECK(tree->inodes.contains(inode));
+
+    Usage& usage = tree->inodes.at(inode);
+
+    tree->usage = tree->usage - usage.bytes + bytes;
+    usage.bytes = bytes;
+  }
+
+  // Starts watching and counting the directory at 'path', which is
+  // an entry of 'parent' (or the root of the tree). Its entries are
+  // counted once 'scan' lists it.
+  Try<Nothing> watch(
+      Tree* tree,
+      const Option<Directory*>& parent,
+      const string& path)
+  {
+    if (tree->watched >= maxWatches) {
+      return Error(
+          "Exceeded the limit of " + stringify(maxWatches) +
+          " watched directories for '" + tree->root + "'");
+    }
+
+    // We watch the directory before listing it so that we don't
+    // miss the entries that are created in the meantime.
+    uint32_t mask =
+      IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+      IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE |
+      IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+    // Like 'du', we only follow a symbolic link at the root if the
+    // path ends with a "/".
+    if (!strings::endsWith(path, "/")) {
+      mask |= IN_DONT_FOLLOW;
+    }
+
+    int wd = ::inotify_add_watch(fd, path.c_str(), mask);
+    if (wd < 0) {
+      // NOTE: This fails with ENOSPC when the number of watches
+      // exceeds '/proc/sys/fs/inotify/max_user_watches'.
+      return ErrnoError("Failed to watch '" + path + "'");
+    }
+
+    // A directory reachable from two places (e.g., a bind mount) has
+    // a single watch, which we can't attribute to both.
+    if (watches.contains(wd)) {
+      return Error("Directory '" + path + "' is already being watched");
+    }
+
+    struct stat s;
+    if (::lstat(path.c_str(), &s) < 0) {
+      ::inotify_rm_watch(fd, wd);
+      return ErrnoError("Failed to stat '" + path + "'");
+    }
+
+    Owned<Directory> directory(new Directory());
+    directory->path = path;
+    directory->inode = {s.st_dev, s.st_ino};
+    directory->wd = wd;
+
+    // Add the directory to the tree before walking it, so that
+    // 'untrack' cleans up after a failed walk.
+    if (parent.isSome()) {
+      parent.get()->directories.put(Path(path).basename(), directory);
+    } else {
+      tree->directory = directory;
+    }
+
+    watches.put(wd, std::make_pair(tree, directory.get()));
+    reference(tree, directory->inode, s.st_blocks * 512);
+
+    tree->pending.push_back(wd);
+    tree->watched++;
+
+    return Nothing();
+  }
+
+  // Counts the entries of 'directory', watching its subdirectories.
+  Try<Nothing> list(Tree* tree, Directory* directory)
+  {
+    Try<std::list<string>> names = os::ls(directory->path);
+    if (names.isError()) {
+      return Error(names.error());
+    }
+
+    foreach (const string& name, names.get()) {
+      Try<Nothing> refresh =
+        DiskUsageTracker::refresh(tree, directory, name);
+
+      if (refresh.isError()) {
+        return refresh;
+      }
+    }
+
+    return Nothing();
+  }
+
+  // Stats the entry 'name' of 'directory' (or the directory itself
+  // for the empty name) and updates the usage of the tree.
+  Try<Nothing> refresh(
+      Tree* tree,
+      Directory* directory,
+      const string& name)
+  {
+    const string path = name.empty()
+      ? directory->path
+      : path::join(directory->path, name);
+
+    if (!name.empty() && tree->excludes.contains(path)) {
+      return Nothing();
+    }
+
+    struct stat s;
+    if (::lstat(path.c_str(), &s) < 0) {
+      if (errno != ENOENT && errno != ENOTDIR) {
+        return ErrnoError("Failed to stat '" + path + "'");
+      }
+
+      // The entry is gone, and will be counted again (if need be)
+      // when the event for whatever replaced it is drained. For the
+      // directory itself, the event in its parent takes care of it.
+      if (!name.empty()) {
+        remove(tree, directory, name);
+      }
+
+      return Nothing();
+    }
+
+    const Inode inode = {s.st_dev, s.st_ino};
+    const uint64_t bytes = s.st_blocks * 512;
+
+    if (name.empty()) {
+      if (inode == directory->inode) {
+        resize(tree, inode, bytes);
+      }
+
+      return Nothing();
+    }
+
+    if (S_ISDIR(s.st_mode)) {
+      if (directory->directories.contains(name)) {
+        const Owned<Directory>& subdirectory =
+          directory->directories.at(name);
+
+        if (subdirectory->inode == inode) {
+          resize(tree, inode, bytes);
+          return Nothing();
+        }
+      }
+
+      remove(tree, directory, name);
+
+      return watch(tree, directory, path);
+    }
+
+    if (directory->files.contains(name) &&
+        directory->files.at(name) == inode) {
+      resize(tree, inode, bytes);
+      return Nothing();
+    }
+
+    remove(tree, directory, name);
+
+    directory->files.put(name, inode);
+    reference(tree, inode, bytes);
+
+    return Nothing();
+  }
+
+  // Stops counting the entry 'name' of 'directory', if any.
+  void remove(Tree* tree, Directory* directory, const string& name)
+  {
+    if (directory->files.contains(name)) {
+      dereference(tree, directory->files.at(name));
+      directory->files.erase(name);
+    }
+
+    if (directory->directories.contains(name)) {
+      remove(tree, directory->directories.at(name).get());
+      directory->directories.erase(name);
+    }
+  }
+
+  // Stops watching and counting the directory and all of its entries.
+  void remove(Tree* tree, Directory* directory)
+  {
+    foreachvalue (const Inode& inode, directory->files) {
+      dereference(tree, inode);
+    }
+
+    foreachvalue (const Owned<Directory>& subdirectory,
+                  directory->directories) {
+      remove(tree, subdirectory.get());
+    }
+
+    dereference(tree, directory->inode);
+
+    if (directory->wd >= 0) {
+      // The kernel queues an IN_IGNORED event for the watch, which
+      // 'drain' skips since the watch descriptor is unknown by then.
+      ::inotify_rm_watch(fd, directory->wd);
+      watches.erase(directory->wd);
+      tree->dirty.erase(directory->wd);
+      tree->watched--;
+    }
+  }
+
+  const int fd;
+
+  // The maximum number of watches per tree.
+  const size_t maxWatches;
+
+  hashmap<string, Owned<Tree>> trees;
+
+  // The directory of each watch descriptor.
+  hashmap<int, std::pair<Tree*, Directory*>> watches;
+};
+#endif // __linux__
+
+
 class DiskUsageCollectorProcess : public Process<DiskUsageCollectorProcess>
 {
 public:
-  DiskUsageCollectorProcess(const Duration& _interval)
+  DiskUsageCollectorProcess(const Duration& _interval, size_t _maxWatches)
     : ProcessBase(process::ID::generate("posix-disk-usage-collector")),
-      interval(_interval) {}
+      interval(_interval),
+      maxWatches(_maxWatches) {}
   virtual ~DiskUsageCollectorProcess() {}
 
   Future<Bytes> usage(
@@ -471,6 +1042,12 @@ public:
     // either return a Failure here, or does not allow 'excludes' to
     // be specified on OSX.
 
+#ifdef __linux__
+    if (trackable(path, excludes)) {
+      return track(path, excludes);
+    }
+#endif // __linux__
+
     foreach (const Owned<Entry>& entry, entries) {
       if (entry->path == path) {
         return entry->promise.future();
@@ -489,6 +1066,21 @@ public:
 protected:
   void initialize()
   {
+#ifdef __linux__
+    Try<Owned<DiskUsageTracker>> create =
+      DiskUsageTracker::create(maxWatches);
+
+    if (create.isError()) {
+      LOG(WARNING) << "Failed to create the disk usage tracker, "
+                   << "falling back to 'du': " << create.error();
+    } else {
+      tracker = create.get();
+
+      poll();
+      sweep();
+    }
+#endif // __linux__
+
     schedule();
   }
 
@@ -501,6 +1093,14 @@ protected:
 
       entry->promise.fail("DiskUsageCollector is destroyed");
     }
+
+#ifdef __linux__
+    polling.discard();
+
+    foreachvalue (const Owned<Tracked>& tracked, this->tracked) {
+      tracked->promise.fail("DiskUsageCollector is destroyed");
+    }
+#endif // __linux__
   }
 
 private:
@@ -519,6 +1119,17 @@ private:
 
   void discard(const string& path)
   {
+#ifdef __linux__
+    if (tracked.contains(path)) {
+      tracked.at(path)->promise.discard();
+      tracked.erase(path);
+      requested.erase(path);
+
+      tracker.get()->untrack(path);
+      return;
+    }
+#endif // __linux__
+
     for (auto it = entries.begin(); it != entries.end(); ++it) {
       // We only cancel those checks whose 'du' haven't been launched.
       if ((*it)->path == path && (*it)->du.isNone()) {
@@ -658,16 +1269,234 @@ private:
     delay(interval, self(), &Self::schedule);
   }
 
+#ifdef __linux__
+  // A pending check of a tracked path.
+  struct Tracked
+  {
+    explicit Tracked(const vector<string>& _excludes)
+      : excludes(_excludes) {}
+
+    vector<string> excludes;
+    Promise<Bytes> promise;
+  };
+
+  // We track paths with inotify unless we failed to before, e.g.,
+  // because we ran out of inotify watches. Relative excludes are
+  // patterns for 'du' so we leave those to 'du' as well.
+  bool trackable(const string& path, const vector<string>& excludes) const
+  {
+    if (tracker.isNone() || untrackable.contains(path)) {
+      return false;
+    }
+
+    if (!path::absolute(path)) {
+      return false;
+    }
+
+    foreach (const string& exclude, excludes) {
+      if (!path::absolute(exclude)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  Future<Bytes> track(const string& path, const vector<string>& excludes)
+  {
+    const Time now = Clock::now();
+
+    // We keep the time between the last two checks of each path, so
+    // that 'sweep' can tell when a path is not checked anymore.
+    requested[path] = Request{
+      now,
+      requested.contains(path) ? now - requested.at(path).time : interval};
+
+    if (tracked.contains(path)) {
+      return tracked.at(path)->promise.future();
+    }
+
+    tracked.put(path, Owned<Tracked>(new Tracked(excludes)));
+
+    Future<Bytes> future = tracked.at(path)->promise.future();
+    future.onDiscard(defer(self(), &Self::discard, path));
+
+    // The first check walks the tree, so we can report the usage as
+    // soon as the walk completes rather than after an interval.
+    if (!tracker.get()->tracking(path, excludes)) {
+      Try<Nothing> track = tracker.get()->track(path, excludes);
+
+      if (track.isError()) {
+        fallback(path, track.error());
+      } else {
+        dispatch(self(), &Self::scan, path);
+      }
+
+      return future;
+    }
+
+    // Unlike 'du', checking a tracked path is cheap, so each path is
+    // throttled on its own rather than in a queue with all others.
+    delay(interval, self(), &Self::report, path);
+
+    return future;
+  }
+
+  void report(const string& path)
+  {
+    if (!tracked.contains(path)) {
+      return; // Discarded.
+    }
+
+    Try<Nothing> update = tracker.get()->update(path);
+
+    if (update.isError()) {
+      fallback(path, update.error());
+      return;
+    }
+
+    scan(path);
+  }
+
+  // Walks the directories of the tree that have not been listed yet,
+  // 'DISK_USAGE_SCAN_DIRECTORIES' at a time. Each batch is dispatched
+  // separately so that walking a large tree does not hold up the other
+  // checks, nor draining the inotify events, for the whole walk.
+  void scan(const string& path)
+  {
+    if (!tracked.contains(path)) {
+      return; // Discarded.
+    }
+
+    Try<bool> scan =
+      tracker.get()->scan(path, DISK_USAGE_SCAN_DIRECTORIES);
+
+    if (scan.isError()) {
+      fallback(path, scan.error());
+      return;
+    }
+
+    if (!scan.get()) {
+      dispatch(self(), &Self::scan, path);
+      return;
+    }
+
+    Owned<Tracked> entry = tracked.at(path);
+    tracked.erase(path);
+
+    entry->promise.set(tracker.get()->usage(path));
+  }
+
+  // Checks the pending path with 'du' from now on, e.g., because the
+  // tree has more directories than we are willing to watch.
+  void fallback(const string& path, const string& error)
+  {
+    CHECK(tracked.contains(path));
+
+    LOG(WARNING) << "Failed to track the disk usage of '" << path
+                 << "', falling back to 'du': " << error;
+
+    Owned<Tracked> entry = tracked.at(path);
+    tracked.erase(path);
+    requested.erase(path);
+
+    tracker.get()->untrack(path);
+    untrackable.insert(path);
+
+    entry->promise.associate(this->usage(path, entry->excludes));
+  }
+
+  // Keeps draining the inotify events so that the kernel's queue
+  // does not overflow between checks.
+  void poll()
+  {
+    polling = io::poll(tracker.get()->descriptor(), io::READ)
+      .onAny(defer(self(), &Self::_poll, lambda::_1));
+  }
+
+  void _poll(const Future<short>& future)
+  {
+    if (future.isDiscarded()) {
+      return;
+    }
+
+    if (future.isFailed()) {
+      LOG(ERROR) << "Failed to poll for inotify events: " << future.failure();
+
+      delay(interval, self(), &Self::poll);
+      return;
+    }
+
+    tracker.get()->drain();
+
+    poll();
+  }
+
+  // Stops tracking the paths that are not checked anymore, e.g.,
+  // because the container was destroyed right after its previous
+  // check completed (hence there was nothing to discard). A path is
+  // considered abandoned once it has not been checked for twice the
+  // time between its last two checks.
+  void sweep()
+  {
+    const Time now = Clock::now();
+
+    foreach (const string& path, tracker.get()->paths()) {
+      if (tracked.contains(path)) {
+        continue;
+      }
+
+      if (requested.contains(path)) {
+        const Request& request = requested.at(path);
+
+        if (now - request.time <= std::max(request.period, interval) * 2) {
+          continue;
+        }
+      }
+
+      VLOG(1) << "Stopped tracking the disk usage of '" << path << "'";
+
+      tracker.get()->untrack(path);
+      requested.erase(path);
+    }
+
+    delay(interval, self(), &Self::sweep);
+  }
+
+  Option<Owned<DiskUsageTracker>> tracker;
+
+  // The pending checks of tracked paths.
+  hashmap<string, Owned<Tracked>> tracked;
+
+  // The last check of each tracked path.
+  struct Request
+  {
+    Time time;
+
+    // The time since the check before.
+    Duration period;
+  };
+
+  hashmap<string, Request> requested;
+
+  hashset<string> untrackable;
+
+  Future<short> polling;
+#endif // __linux__
+
   const Duration interval;
+  const size_t maxWatches;
 
   // A queue of pending checks.
   deque<Owned<Entry>> entries;
 };
 
 
-DiskUsageCollector::DiskUsageCollector(const Duration& interval)
+DiskUsageCollector::DiskUsageCollector(
+    const Duration& interval,
+    size_t maxWatches)
 {
-  process = new DiskUsageCollectorProcess(interval);
+  process = new DiskUsageCollectorProcess(interval, maxWatches);
   spawn(process);
 }
 
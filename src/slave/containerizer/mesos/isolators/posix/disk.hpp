@@ -38,12 +38,22 @@ namespace slave {
 class DiskUsageCollectorProcess;
 
 
+// The maximum number of directories watched (on Linux) to track the
+// disk usage of a single path, beyond which the collector falls back
+// to 'du' for that path.
+constexpr size_t DISK_USAGE_MAX_WATCHES = 8192;
+
+
 // Responsible for collecting disk usage for paths, while ensuring
-// that an interval elapses between each collection.
+// that an interval elapses between each collection. On Linux, the
+// usage of a directory is tracked incrementally with inotify after
+// the first collection (see DiskUsageTracker), falling back to 'du'.
 class DiskUsageCollector
 {
 public:
-  DiskUsageCollector(const Duration& interval);
+  DiskUsageCollector(
+      const Duration& interval,
+      size_t maxWatches = DISK_USAGE_MAX_WATCHES);
   ~DiskUsageCollector();
 
   // Returns the disk usage rooted at 'path'. The user can discard the
@@ -63,10 +73,10 @@ private:
 // much CPU usage and disk caching effects from running 'du' too
 // often.
 //
-// NOTE: Currently all containers are processed in the same queue,
-// which means that when a container starts, it could take many disk
-// collection intervals until any data is available in the resource
-// usage statistics!
+// NOTE: Currently all containers that fall back to 'du' are processed
+// in the same queue, which means that when a container starts, it
+// could take many disk collection intervals until any data is
+// available in the resource usage statistics!
 //
 // TODO(jieyu): Consider handling each container independently, or
 // triggering an initial collection when the container starts, to
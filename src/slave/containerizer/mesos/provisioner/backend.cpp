@@ -32,6 +32,7 @@
 #include "slave/containerizer/mesos/provisioner/backends/copy.hpp"
 #ifdef __linux__
 #include "slave/containerizer/mesos/provisioner/backends/overlay.hpp"
+#include "slave/containerizer/mesos/provisioner/backends/reflink.hpp"
 #endif
 
 using namespace process;
@@ -64,6 +65,10 @@ hashmap<string, Owned<Backend>> Backend::create(const Flags& flags)
   } else if (overlayfsSupported.get()) {
     creators.put(OVERLAY_BACKEND, &OverlayBackend::create);
   }
+
+  // Whether reflinks work depends on the file system of the store and
+  // provisioner directories, which is validated by the provisioner.
+  creators.put(REFLINK_BACKEND, &ReflinkBackend::create);
 #endif // __linux__
 
   creators.put(COPY_BACKEND, &CopyBackend::create);
@@ -48,8 +48,9 @@ namespace slave {
 class CopyBackendProcess : public Process<CopyBackendProcess>
 {
 public:
-  CopyBackendProcess()
-    : ProcessBase(process::ID::generate("copy-provisioner-backend")) {}
+  explicit CopyBackendProcess(const vector<string>& _options = {})
+    : ProcessBase(process::ID::generate("copy-provisioner-backend")),
+      options(_options) {}
 
   Future<Nothing> provision(const vector<string>& layers, const string& rootfs);
 
@@ -57,6 +58,9 @@ public:
 
 private:
   Future<Nothing> _provision(string layer, const string& rootfs);
+
+  // Additional options for `cp`.
+  const vector<string> options;
 };
 
 
@@ -81,6 +85,10 @@ CopyBackend::CopyBackend(Owned<CopyBackendProcess> _process)
 }
 
 
+CopyBackend::CopyBackend(const vector<string>& options)
+  : CopyBackend(Owned<CopyBackendProcess>(new CopyBackendProcess(options))) {}
+
+
 Future<Nothing> CopyBackend::provision(
     const vector<string>& layers,
     const string& rootfs,
@@ -265,6 +273,8 @@ Future<Nothing> CopyBackendProcess::_provision(
   vector<string> args{"cp", "-aT", layer, rootfs};
 #endif // __APPLE__ || __FreeBSD__
 
+  args.insert(args.begin() + 1, options.begin(), options.end());
+
   Try<Subprocess> s = subprocess(
       "cp",
       args,
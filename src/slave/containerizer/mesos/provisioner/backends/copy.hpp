@@ -17,6 +17,9 @@
 #ifndef __PROVISIONER_BACKENDS_COPY_HPP__
 #define __PROVISIONER_BACKENDS_COPY_HPP__
 
+#include <string>
+#include <vector>
+
 #include "slave/containerizer/mesos/provisioner/backend.hpp"
 
 namespace mesos {
@@ -54,6 +57,10 @@ public:
       const std::string& rootfs,
       const std::string& backendDir);
 
+protected:
+  // Creates a backend that passes 'options' to the `cp` of each layer.
+  explicit CopyBackend(const std::vector<std::string>& options);
+
 private:
   explicit CopyBackend(process::Owned<CopyBackendProcess> process);
 
@@ -0,0 +1,52 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __PROVISIONER_BACKENDS_REFLINK_HPP__
+#define __PROVISIONER_BACKENDS_REFLINK_HPP__
+
+#include "slave/containerizer/mesos/provisioner/backends/copy.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// The backend implementation that copies the layers to the target
+// like the copy backend, but clones every file with a copy-on-write
+// reflink instead of copying its data. Provisioning a rootfs thus only
+// writes metadata, and the files share their data blocks with the
+// layers in the store until the container modifies them.
+// NOTE: This backend requires the layers and the rootfs to be on the
+// same file system, and that file system to support reflinks (e.g.,
+// btrfs, or XFS created with `reflink=1`). Otherwise, provisioning
+// fails rather than falling back to copying.
+class ReflinkBackend : public CopyBackend
+{
+public:
+  // ReflinkBackend doesn't use any flag.
+  static Try<process::Owned<Backend>> create(const Flags&);
+
+private:
+  ReflinkBackend();
+
+  ReflinkBackend(const ReflinkBackend&); // Not copyable.
+  ReflinkBackend& operator=(const ReflinkBackend&); // Not assignable.
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __PROVISIONER_BACKENDS_REFLINK_HPP__
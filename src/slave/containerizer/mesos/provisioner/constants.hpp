@@ -26,6 +26,7 @@ constexpr char AUFS_BACKEND[] = "aufs";
 constexpr char BIND_BACKEND[] = "bind";
 constexpr char COPY_BACKEND[] = "copy";
 constexpr char OVERLAY_BACKEND[] = "overlay";
+constexpr char REFLINK_BACKEND[] = "reflink";
 
 } // namespace slave {
 } // namespace internal {
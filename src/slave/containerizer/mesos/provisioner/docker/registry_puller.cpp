@@ -14,6 +14,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <memory>
+
 #include <glog/logging.h>
 
 #include <process/collect.hpp>
@@ -21,6 +24,11 @@
 #include <process/dispatch.hpp>
 #include <process/http.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
 #include <stout/os/exists.hpp>
 #include <stout/os/mkdir.hpp>
 #include <stout/os/rm.hpp>
@@ -46,6 +54,10 @@ using process::Owned;
 using process::Process;
 using process::Shared;
 
+using process::metrics::Counter;
+using process::metrics::Gauge;
+using process::metrics::Timer;
+
 using process::defer;
 using process::dispatch;
 using process::spawn;
@@ -56,13 +68,24 @@ namespace internal {
 namespace slave {
 namespace docker {
 
+// A blob to be downloaded and the layers that are extracted from it.
+// Several layers can share one blob, e.g., the empty layers that only
+// change the image configuration.
+struct Blob
+{
+  string blobSum;
+  vector<spec::v1::ImageManifest> layers;
+};
+
+
 class RegistryPullerProcess : public Process<RegistryPullerProcess>
 {
 public:
   RegistryPullerProcess(
       const string& _storeDir,
       const http::URL& _defaultRegistryUrl,
-      const Shared<uri::Fetcher>& _fetcher);
+      const Shared<uri::Fetcher>& _fetcher,
+      size_t _concurrency);
 
   Future<vector<string>> pull(
       const spec::ImageReference& reference,
@@ -79,14 +102,33 @@ private:
     const spec::ImageReference& reference,
     const string& directory,
     const spec::v2::ImageManifest& manifest,
-    const hashset<string>& blobSums,
     const string& backend);
 
-  Future<hashset<string>> fetchBlobs(
+  // Pulls the blobs in the queue one after another. Each pull runs
+  // '--docker_pull_concurrency' of these on a shared queue.
+  Future<Nothing> fetchBlobs(
     const spec::ImageReference& reference,
     const string& directory,
-    const spec::v2::ImageManifest& manifest,
-    const string& backend);
+    const string& backend,
+    const std::shared_ptr<list<Blob>>& blobs);
+
+  // Downloads the blob, verifies its digest and extracts its layers.
+  Future<Nothing> fetchBlob(
+    const spec::ImageReference& reference,
+    const string& directory,
+    const string& backend,
+    const Blob& blob);
+
+  Future<Nothing> extractBlob(
+    const string& directory,
+    const string& backend,
+    const Blob& blob);
+
+  Try<URI> getBlobUri(
+    const spec::ImageReference& reference,
+    const string& blobSum);
+
+  double _layers_pending() { return pending; }
 
   RegistryPullerProcess(const RegistryPullerProcess&) = delete;
   RegistryPullerProcess& operator=(const RegistryPullerProcess&) = delete;
@@ -98,6 +140,25 @@ private:
   const http::URL defaultRegistryUrl;
 
   Shared<uri::Fetcher> fetcher;
+
+  // Maximum number of blobs that a pull downloads or extracts at once.
+  const size_t concurrency;
+
+  // Number of blobs queued or being pulled, across all pulls.
+  size_t pending;
+
+  struct Metrics
+  {
+    explicit Metrics(const RegistryPullerProcess& process);
+    ~Metrics();
+
+    Gauge layers_pending;
+    Counter layers_pulled;
+    Counter layers_skipped;
+
+    Timer<Milliseconds> layer_download;
+    Timer<Milliseconds> layer_extraction;
+  } metrics;
 };
 
 
@@ -119,7 +180,8 @@ Try<Owned<Puller>> RegistryPuller::create(
       new RegistryPullerProcess(
           flags.docker_store_dir,
           defaultRegistryUrl.get(),
-          fetcher));
+          fetcher,
+          flags.docker_pull_concurrency));
 
   return Owned<Puller>(new RegistryPuller(process));
 }
@@ -156,11 +218,48 @@ Future<vector<string>> RegistryPuller::pull(
 RegistryPullerProcess::RegistryPullerProcess(
     const string& _storeDir,
     const http::URL& _defaultRegistryUrl,
-    const Shared<uri::Fetcher>& _fetcher)
+    const Shared<uri::Fetcher>& _fetcher,
+    size_t _concurrency)
   : ProcessBase(process::ID::generate("docker-provisioner-registry-puller")),
     storeDir(_storeDir),
     defaultRegistryUrl(_defaultRegistryUrl),
-    fetcher(_fetcher) {}
+    fetcher(_fetcher),
+    concurrency(std::max<size_t>(1, _concurrency)),
+    pending(0),
+    metrics(*this) {}
+
+
+RegistryPullerProcess::Metrics::Metrics(const RegistryPullerProcess& process)
+  : layers_pending(
+        "containerizer/mesos/provisioner/docker_store/layers_pending",
+        defer(process, &RegistryPullerProcess::_layers_pending)),
+    layers_pulled(
+        "containerizer/mesos/provisioner/docker_store/layers_pulled"),
+    layers_skipped(
+        "containerizer/mesos/provisioner/docker_store/layers_skipped"),
+    layer_download(
+        "containerizer/mesos/provisioner/docker_store/layer_download",
+        Hours(1)),
+    layer_extraction(
+        "containerizer/mesos/provisioner/docker_store/layer_extraction",
+        Hours(1))
+{
+  process::metrics::add(layers_pending);
+  process::metrics::add(layers_pulled);
+  process::metrics::add(layers_skipped);
+  process::metrics::add(layer_download);
+  process::metrics::add(layer_extraction);
+}
+
+
+RegistryPullerProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(layers_pending);
+  process::metrics::remove(layers_pulled);
+  process::metrics::remove(layers_skipped);
+  process::metrics::remove(layer_download);
+  process::metrics::remove(layer_extraction);
+}
 
 
 static spec::ImageReference normalize(
@@ -277,14 +376,7 @@ Future<vector<string>> RegistryPullerProcess::_pull(
     return Failure("'fsLayers' and 'history' have different size in manifest");
   }
 
-  return fetchBlobs(reference, directory, manifest.get(), backend)
-    .then(defer(self(),
-                &Self::__pull,
-                reference,
-                directory,
-                manifest.get(),
-                lambda::_1,
-                backend));
+  return __pull(reference, directory, manifest.get(), backend);
 }
 
 
@@ -292,7 +384,6 @@ Future<vector<string>> RegistryPullerProcess::__pull(
     const spec::ImageReference& reference,
     const string& directory,
     const spec::v2::ImageManifest& manifest,
-    const hashset<string>& blobSums,
     const string& backend)
 {
   // Docker reads the layer ids from the disk:
@@ -315,7 +406,12 @@ Future<vector<string>> RegistryPullerProcess::__pull(
   // sure ids are unique.
   hashset<string> uniqueIds;
   vector<string> layerIds;
-  list<Future<Nothing>> futures;
+
+  // The blobs to fetch, in manifest order, i.e., starting with the
+  // leaf layer. There might exist duplicated blob sums in 'fsLayers'.
+  // We just need to fetch one of them.
+  std::shared_ptr<list<Blob>> blobs(new list<Blob>());
+  hashmap<string, Blob*> blobsBySum;
 
   // The order of `fslayers` should be [child, parent, ...].
   //
@@ -340,11 +436,115 @@ Future<vector<string>> RegistryPullerProcess::__pull(
     // Skip if the layer is already in the store.
     if (os::exists(
         paths::getImageLayerRootfsPath(storeDir, v1.id(), backend))) {
+      ++metrics.layers_skipped;
       continue;
     }
 
+    if (!blobsBySum.contains(blobSum)) {
+      VLOG(1) << "Fetching blob '" << blobSum << "' for layer '"
+              << v1.id() << "' of image '" << reference << "'";
+
+      blobs->push_back(Blob{blobSum, {}});
+      blobsBySum[blobSum] = &blobs->back();
+    }
+
+    blobsBySum[blobSum]->layers.push_back(v1);
+  }
+
+  pending += blobs->size();
+
+  // Each layer is extracted as soon as its blob is downloaded, while
+  // the other blobs continue to download. At most 'concurrency' blobs
+  // are being downloaded or extracted at any time.
+  list<Future<Nothing>> futures;
+  for (size_t i = 0; i < std::min(concurrency, blobs->size()); i++) {
+    futures.push_back(fetchBlobs(reference, directory, backend, blobs));
+  }
+
+  return collect(futures)
+    .onFailed(defer(self(), [=](const string&) {
+      // Don't start pulling any more blobs for a failed pull.
+      pending -= blobs->size();
+      blobs->clear();
+    }))
+    .then([=]() { return layerIds; });
+}
+
+
+Future<Nothing> RegistryPullerProcess::fetchBlobs(
+    const spec::ImageReference& reference,
+    const string& directory,
+    const string& backend,
+    const std::shared_ptr<list<Blob>>& blobs)
+{
+  if (blobs->empty()) {
+    return Nothing();
+  }
+
+  const Blob blob = blobs->front();
+  blobs->pop_front();
+
+  return fetchBlob(reference, directory, backend, blob)
+    .onAny(defer(self(), [=](const Future<Nothing>& future) {
+      --pending;
+
+      if (future.isReady()) {
+        metrics.layers_pulled += blob.layers.size();
+      }
+    }))
+    .then(defer(
+        self(), &Self::fetchBlobs, reference, directory, backend, blobs));
+}
+
+
+Future<Nothing> RegistryPullerProcess::fetchBlob(
+    const spec::ImageReference& reference,
+    const string& directory,
+    const string& backend,
+    const Blob& blob)
+{
+  Try<URI> blobUri = getBlobUri(reference, blob.blobSum);
+  if (blobUri.isError()) {
+    return Failure(blobUri.error());
+  }
+
+  const string tar = path::join(directory, blob.blobSum);
+
+  return metrics.layer_download.time(fetcher->fetch(blobUri.get(), directory))
+    .then([=]() -> Future<Nothing> {
+      // Docker registries name blobs by the digest of their content,
+      // so we can verify the download before extracting it.
+      vector<string> digest = strings::split(blob.blobSum, ":", 2);
+      if (digest.size() != 2 || digest[0] != "sha256") {
+        return Nothing();
+      }
+
+      return command::sha256(Path(tar))
+        .then([=](const string& checksum) -> Future<Nothing> {
+          if (checksum != digest[1]) {
+            return Failure(
+                "Digest of blob '" + blob.blobSum + "' does not match "
+                "its content: sha256:" + checksum);
+          }
+
+          return Nothing();
+        });
+    })
+    .then(defer(self(), &Self::extractBlob, directory, backend, blob));
+}
+
+
+Future<Nothing> RegistryPullerProcess::extractBlob(
+    const string& directory,
+    const string& backend,
+    const Blob& blob)
+{
+  const string tar = path::join(directory, blob.blobSum);
+
+  list<Future<Nothing>> futures;
+
+  foreach (const spec::v1::ImageManifest& v1, blob.layers) {
     const string layerPath = path::join(directory, v1.id());
-    const string tar = path::join(directory, blobSum);
     const string rootfs = paths::getImageLayerRootfsPath(layerPath, backend);
     const string json = paths::getImageLayerManifestPath(layerPath);
 
@@ -369,104 +569,60 @@ Future<vector<string>> RegistryPullerProcess::__pull(
     futures.push_back(command::untar(Path(tar), Path(rootfs)));
   }
 
-  return collect(futures)
-    .then([=]() -> Future<vector<string>> {
-      // Remove the tarballs after the extraction.
-      foreach (const string& blobSum, blobSums) {
-        const string tar = path::join(directory, blobSum);
-
-        Try<Nothing> rm = os::rm(tar);
-        if (rm.isError()) {
-          return Failure(
-              "Failed to remove '" + tar + "' "
-              "after extraction: " + rm.error());
-        }
+  return metrics.layer_extraction.time(collect(futures))
+    .then([tar]() -> Future<Nothing> {
+      // Remove the tarball after the extraction.
+      Try<Nothing> rm = os::rm(tar);
+      if (rm.isError()) {
+        return Failure(
+            "Failed to remove '" + tar + "' after extraction: " + rm.error());
       }
 
-      return layerIds;
+      return Nothing();
     });
 }
 
 
-Future<hashset<string>> RegistryPullerProcess::fetchBlobs(
+Try<URI> RegistryPullerProcess::getBlobUri(
     const spec::ImageReference& reference,
-    const string& directory,
-    const spec::v2::ImageManifest& manifest,
-    const string& backend)
+    const string& blobSum)
 {
-  // First, find all the blobs that need to be fetched.
-  //
-  // NOTE: There might exist duplicated blob sums in 'fsLayers'. We
-  // just need to fetch one of them.
-  hashset<string> blobSums;
-
-  for (int i = 0; i < manifest.fslayers_size(); i++) {
-    CHECK(manifest.history(i).has_v1());
-    const spec::v1::ImageManifest& v1 = manifest.history(i).v1();
-
-    // Check if the layer is in the store or not. If yes, skip the
-    // unnecessary fetching.
-    if (os::exists(
-        paths::getImageLayerRootfsPath(storeDir, v1.id(), backend))) {
-      continue;
+  if (reference.has_registry()) {
+    Result<int> port = spec::getRegistryPort(reference.registry());
+    if (port.isError()) {
+      return Error("Failed to get registry port: " + port.error());
     }
 
-    const string& blobSum = manifest.fslayers(i).blobsum();
-
-    VLOG(1) << "Fetching blob '" << blobSum << "' for layer '"
-            << v1.id() << "' of image '" << reference << "'";
+    Try<string> scheme = spec::getRegistryScheme(reference.registry());
+    if (scheme.isError()) {
+      return Error("Failed to get registry scheme: " + scheme.error());
+    }
 
-    blobSums.insert(blobSum);
+    // If users want to use the registry specified in '--docker_image',
+    // an URL scheme must be specified in '--docker_registry', because
+    // there is no scheme allowed in docker image name.
+    return uri::docker::blob(
+        reference.repository(),
+        blobSum,
+        spec::getRegistryHost(reference.registry()),
+        scheme.get(),
+        port.isSome() ? port.get() : Option<int>());
   }
 
-  // Now, actually fetch the blobs.
-  list<Future<Nothing>> futures;
+  const string registry = defaultRegistryUrl.domain.isSome()
+    ? defaultRegistryUrl.domain.get()
+    : stringify(defaultRegistryUrl.ip.get());
 
-  foreach (const string& blobSum, blobSums) {
-    URI blobUri;
+  const Option<int> port = defaultRegistryUrl.port.isSome()
+    ? static_cast<int>(defaultRegistryUrl.port.get())
+    : Option<int>();
 
-    if (reference.has_registry()) {
-      Result<int> port = spec::getRegistryPort(reference.registry());
-      if (port.isError()) {
-        return Failure("Failed to get registry port: " + port.error());
-      }
-
-      Try<string> scheme = spec::getRegistryScheme(reference.registry());
-      if (scheme.isError()) {
-        return Failure("Failed to get registry scheme: " + scheme.error());
-      }
-
-      // If users want to use the registry specified in '--docker_image',
-      // an URL scheme must be specified in '--docker_registry', because
-      // there is no scheme allowed in docker image name.
-      blobUri = uri::docker::blob(
-          reference.repository(),
-          blobSum,
-          spec::getRegistryHost(reference.registry()),
-          scheme.get(),
-          port.isSome() ? port.get() : Option<int>());
-    } else {
-      const string registry = defaultRegistryUrl.domain.isSome()
-        ? defaultRegistryUrl.domain.get()
-        : stringify(defaultRegistryUrl.ip.get());
-
-      const Option<int> port = defaultRegistryUrl.port.isSome()
-        ? static_cast<int>(defaultRegistryUrl.port.get())
-        : Option<int>();
-
-      blobUri = uri::docker::blob(
-          reference.repository(),
-          blobSum,
-          registry,
-          defaultRegistryUrl.scheme,
-          port);
-    }
-
-    futures.push_back(fetcher->fetch(blobUri, directory));
-  }
-
-  return collect(futures)
-    .then([blobSums]() -> hashset<string> { return blobSums; });
+  return uri::docker::blob(
+      reference.repository(),
+      blobSum,
+      registry,
+      defaultRegistryUrl.scheme,
+      port);
 }
 
 } // namespace docker {
@@ -58,6 +58,7 @@ using mesos::internal::slave::AUFS_BACKEND;
 using mesos::internal::slave::BIND_BACKEND;
 using mesos::internal::slave::COPY_BACKEND;
 using mesos::internal::slave::OVERLAY_BACKEND;
+using mesos::internal::slave::REFLINK_BACKEND;
 
 using mesos::slave::ContainerState;
 
@@ -65,6 +66,41 @@ namespace mesos {
 namespace internal {
 namespace slave {
 
+#ifdef __linux__
+// Checks that a file in the 'source' directory can be cloned into the
+// 'target' directory. Reflinks cannot cross filesystems, so this also
+// fails (with EXDEV) if the directories are on different filesystems.
+static Try<Nothing> validateReflink(
+    const string& source,
+    const string& target)
+{
+  Try<string> file = os::mktemp(path::join(source, "XXXXXX"));
+  if (file.isError()) {
+    return Error(
+        "Failed to create a file in '" + source + "': " + file.error());
+  }
+
+  const string clone =
+    path::join(target, Path(file.get()).basename() + ".reflink");
+
+  Try<Nothing> result = os::write(file.get(), "reflink");
+  if (result.isSome()) {
+    result = fs::clone(file.get(), clone);
+  }
+
+  os::rm(file.get());
+
+  if (result.isError()) {
+    return Error(result.error());
+  }
+
+  os::rm(clone);
+
+  return Nothing();
+}
+#endif // __linux__
+
+
 // Validate whether the backend is supported on the underlying
 // filesystem. Please see the following logic table for detail:
 // +---------+--------------+------------------------------------------+
@@ -73,6 +109,7 @@ namespace slave {
 // | aufs    | ext4 xfs     | btrfs aufs eCryptfs                      |
 // | overlay | ext4 xfs     | btrfs aufs overlay overlay2 zfs eCryptfs |
 // | bind    |              | N/A(`--sandbox_directory' must exist)    |
+// | reflink | btrfs xfs    | Any without reflink support              |
 // | copy    |              | N/A                                      |
 // +---------+--------------+------------------------------------------+
 static Try<Nothing> validateBackend(
@@ -123,6 +160,20 @@ static Try<Nothing> validateBackend(
     return Nothing();
   }
 
+  if (backend == REFLINK_BACKEND) {
+    // Not all file systems of a given type support reflinks (e.g., XFS
+    // needs `reflink=1`), so we probe by cloning a file.
+    Try<Nothing> clone = validateReflink(directory, directory);
+    if (clone.isError()) {
+      return Error(
+          "Backend '" + stringify(REFLINK_BACKEND) + "' is not supported "
+          "on the underlying filesystem '" + fsTypeName + "': " +
+          clone.error());
+    }
+
+    return Nothing();
+  }
+
   if (backend == AUFS_BACKEND) {
     vector<uint32_t> exclusives = {
       FS_TYPE_AUFS,
@@ -207,6 +258,33 @@ Try<Owned<Provisioner>> Provisioner::create(const Flags& flags)
           "' is not supported: " + supported.error());
     }
 
+#ifdef __linux__
+    // The reflink backend clones the layers in the image stores into
+    // the provisioner directory, so they must be on one filesystem.
+    if (flags.image_provisioner_backend.get() == REFLINK_BACKEND) {
+      vector<string> storeDirs;
+
+      if (stores->contains(Image::APPC)) {
+        storeDirs.push_back(flags.appc_store_dir);
+      }
+
+      if (stores->contains(Image::DOCKER)) {
+        storeDirs.push_back(flags.docker_store_dir);
+      }
+
+      foreach (const string& storeDir, storeDirs) {
+        Try<Nothing> clone = validateReflink(storeDir, rootDir.get());
+        if (clone.isError()) {
+          return Error(
+              "The specified provisioner backend '" +
+              flags.image_provisioner_backend.get() +
+              "' is not supported: Failed to clone from the image store "
+              "'" + storeDir + "': " + clone.error());
+        }
+      }
+    }
+#endif // __linux__
+
     defaultBackend = flags.image_provisioner_backend.get();
   } else {
     // TODO(gilbert): Consider select the bind backend if it is a
@@ -217,6 +295,11 @@ Try<Owned<Provisioner>> Provisioner::create(const Flags& flags)
     // Choose a backend smartly if no backend is specified. The follow
     // list is a priority list, meaning that we favor backends in the
     // front of the list.
+    //
+    // NOTE: The reflink backend is never chosen here since it requires
+    // the image stores and the provisioner directory to be on the same
+    // filesystem, which is not the case for the default store
+    // directories (e.g., `/tmp/mesos/store`).
     vector<string> backendNames = {
 #ifdef __linux__
       OVERLAY_BACKEND,
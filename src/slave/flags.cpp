@@ -135,7 +135,7 @@ mesos::internal::slave::Flags::Flags()
   add(&Flags::image_provisioner_backend,
       "image_provisioner_backend",
       "Strategy for provisioning container rootfs from images,\n"
-      "e.g., `aufs`, `bind`, `copy`, `overlay`.");
+      "e.g., `aufs`, `bind`, `copy`, `overlay`, `reflink`.");
 
   add(&Flags::appc_simple_discovery_uri_prefix,
       "appc_simple_discovery_uri_prefix",
@@ -161,6 +161,13 @@ mesos::internal::slave::Flags::Flags()
       "Directory the Docker provisioner will store images in",
       path::join(os::temp(), "mesos", "store", "docker"));
 
+  add(&Flags::docker_pull_concurrency,
+      "docker_pull_concurrency",
+      "Maximum number of image layers that the Docker provisioner downloads\n"
+      "or extracts at the same time when pulling an image from a registry.\n"
+      "Each layer is extracted as soon as its download completes.",
+      DEFAULT_DOCKER_PULL_CONCURRENCY);
+
   add(&Flags::docker_volume_checkpoint_dir,
       "docker_volume_checkpoint_dir",
       "The root directory where we checkpoint the information about docker\n"
@@ -200,6 +207,12 @@ mesos::internal::slave::Flags::Flags()
       "(one subdirectory per agent).",
       path::join(os::temp(), "mesos", "fetch"));
 
+  add(&Flags::fetcher_concurrency,
+      "fetcher_concurrency",
+      "Maximum number of URIs that are downloaded and extracted in\n"
+      "parallel when fetching for a single container.",
+      DEFAULT_FETCHER_CONCURRENCY);
+
   add(&Flags::work_dir,
       "work_dir",
       "Path of the agent work directory. This is where executor sandboxes\n"
@@ -561,15 +574,29 @@ mesos::internal::slave::Flags::Flags()
       "obtained periodically according to `perf_interval` and the most\n"
       "recently obtained sample is returned rather than sampling on\n"
       "demand. For this reason, `perf_interval` is independent of the\n"
-      "resource monitoring interval",
+      "resource monitoring interval. When all of the `perf_events` can be\n"
+      "counted directly (i.e., they are fields of the PerfStatistics\n"
+      "protobuf), the agent keeps the counters of each container open and\n"
+      "each sample covers the whole interval",
       Seconds(60));
 
   add(&Flags::perf_duration,
       "perf_duration",
       "Duration of a perf stat sample. The duration must be less\n"
-      "than the `perf_interval`.",
+      "than the `perf_interval`. Not used when the events are counted\n"
+      "directly, see `perf_interval`.",
       Seconds(10));
 
+  add(&Flags::perf_max_counters,
+      "perf_max_counters",
+      "Maximum number of perf event counters the agent keeps open when\n"
+      "counting the `perf_events` directly. Each counter takes a file\n"
+      "descriptor, and a container needs one for each event on each\n"
+      "online CPU. The events of the containers past this maximum are\n"
+      "sampled with `perf stat` instead (or not at all if `perf` is not\n"
+      "available). Defaults to a quarter of the agent's open file limit\n"
+      "(RLIMIT_NOFILE).");
+
   add(&Flags::revocable_cpu_low_priority,
       "revocable_cpu_low_priority",
       "Run containers with revocable CPU at a lower priority than\n"
@@ -737,6 +764,17 @@ mesos::internal::slave::Flags::Flags()
       "  }\n"
       "}");
 
+#ifndef __WINDOWS__
+  add(&Flags::docker_engine_api,
+      "docker_engine_api",
+      "If set to `true`, the agent and the docker executor talk to the\n"
+      "Docker daemon through the Engine API on `--docker_socket` instead\n"
+      "of running the docker CLI to inspect, list, stop, kill and remove\n"
+      "containers. Waiting for a container to start is then driven by the\n"
+      "daemon's event stream rather than by polling.\n",
+      false);
+#endif // __WINDOWS__
+
   add(&Flags::sandbox_directory,
       "sandbox_directory",
       "The absolute path for the directory in the container where the\n"
@@ -862,6 +900,17 @@ mesos::internal::slave::Flags::Flags()
       "used for the `disk/du` isolator.",
       Seconds(15));
 
+  add(&Flags::container_usage_interval,
+      "container_usage_interval",
+      "The amount of time the resource statistics of a container are\n"
+      "reused for. The agent's consumers of container statistics (e.g.,\n"
+      "the QoS controller, the resource estimator and the\n"
+      "`/monitor/statistics` endpoint) then get statistics that are at\n"
+      "most this old, instead of each collecting them from the\n"
+      "containerizer (e.g., reading cgroups). Requests made while the\n"
+      "statistics are being collected always share the collection.",
+      Duration::zero());
+
   // TODO(jieyu): Consider enabling this flag by default. Remember
   // to update the user doc if we decide to do so.
   add(&Flags::enforce_container_disk_quota,
@@ -56,12 +56,14 @@ public:
 
   std::string docker_registry;
   std::string docker_store_dir;
+  size_t docker_pull_concurrency;
   std::string docker_volume_checkpoint_dir;
 
   std::string default_role;
   Option<std::string> attributes;
   Bytes fetcher_cache_size;
   std::string fetcher_cache_dir;
+  size_t fetcher_concurrency;
   std::string work_dir;
   std::string runtime_dir;
   std::string launcher_dir;
@@ -107,6 +109,7 @@ public:
   Option<std::string> perf_events;
   Duration perf_interval;
   Duration perf_duration;
+  Option<size_t> perf_max_counters;
   bool revocable_cpu_low_priority;
   bool systemd_enable_support;
   std::string systemd_runtime_directory;
@@ -128,6 +131,9 @@ public:
   bool docker_kill_orphans;
   std::string docker_socket;
   Option<JSON::Object> docker_config;
+#ifndef __WINDOWS__
+  bool docker_engine_api;
+#endif // __WINDOWS__
 
 #ifdef WITH_NETWORK_ISOLATOR
   uint16_t ephemeral_ports_per_container;
@@ -143,6 +149,7 @@ public:
   Option<std::string> network_cni_plugins_dir;
   Option<std::string> network_cni_config_dir;
   Duration container_disk_watch_interval;
+  Duration container_usage_interval;
   bool enforce_container_disk_quota;
   Option<Modules> modules;
   Option<std::string> modulesDir;
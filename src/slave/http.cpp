@@ -2116,7 +2116,7 @@ Future<JSON::Array> Slave::Http::__containers(
 
         metadata->push_back(entry);
         statusFutures.push_back(slave->containerizer->status(containerId));
-        statsFutures.push_back(slave->containerizer->usage(containerId));
+        statsFutures.push_back(slave->containerUsage(containerId));
       }
     }
   }
@@ -5397,6 +5397,8 @@ void Slave::removeExecutor(Framework* framework, Executor* executor)
 
   LOG(INFO) << "Cleaning up executor " << *executor;
 
+  usages.erase(executor->containerId);
+
   CHECK(framework->state == Framework::RUNNING ||
         framework->state == Framework::TERMINATING)
     << framework->state;
@@ -6586,7 +6588,7 @@ Future<ResourceUsage> Slave::usage()
         }
       }
 
-      futures.push_back(containerizer->usage(executor->containerId));
+      futures.push_back(containerUsage(executor->containerId));
     }
   }
 
@@ -6620,6 +6622,31 @@ Future<ResourceUsage> Slave::usage()
 }
 
 
+Future<ResourceStatistics> Slave::containerUsage(const ContainerID& containerId)
+{
+  const Time now = Clock::now();
+
+  if (usages.contains(containerId)) {
+    const Usage& usage = usages.at(containerId);
+
+    // We don't reuse failures, the next request might succeed.
+    if (usage.statistics.isPending() ||
+        (usage.statistics.isReady() &&
+         now - usage.time < flags.container_usage_interval)) {
+      // A consumer giving up on the statistics must not discard them
+      // for everybody else.
+      return undiscardable(usage.statistics);
+    }
+  }
+
+  Future<ResourceStatistics> statistics = containerizer->usage(containerId);
+
+  usages[containerId] = {now, statistics};
+
+  return undiscardable(statistics);
+}
+
+
 // TODO(dhamon): Move these to their own metrics.hpp|cpp.
 double Slave::_tasks_staging()
 {
@@ -464,6 +464,14 @@ public:
   // Returns the resource usage information for all executors.
   virtual process::Future<ResourceUsage> usage();
 
+  // Returns the resource statistics of the container. Statistics that
+  // are still being collected, or that were collected less than
+  // `--container_usage_interval` ago, are shared rather than asking
+  // the containerizer again, since the QoS controller, the resource
+  // estimator and the HTTP endpoints all poll for them independently.
+  process::Future<ResourceStatistics> containerUsage(
+      const ContainerID& containerId);
+
   // Handle the second phase of shutting down an executor for those
   // executors that have not properly shutdown within a timeout.
   void shutdownExecutorTimeout(
@@ -894,6 +902,16 @@ private:
 
   mesos::slave::QoSController* qosController;
 
+  // The most recently requested statistics of each container, see
+  // `containerUsage()`.
+  struct Usage
+  {
+    process::Time time;
+    process::Future<ResourceStatistics> statistics;
+  };
+
+  hashmap<ContainerID, Usage> usages;
+
   const Option<Authorizer*> authorizer;
 
   // The most recent estimate of the total amount of oversubscribed
@@ -26,11 +26,13 @@
 
 #include <mesos/state/log.hpp>
 
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
 #include <process/mutex.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
 #include <process/metrics/metrics.hpp>
@@ -84,7 +86,10 @@ namespace state {
 class LogStorageProcess : public Process<LogStorageProcess>
 {
 public:
-  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots);
+  LogStorageProcess(
+      Log* log,
+      size_t diffsBetweenSnapshots,
+      size_t writeWindow);
 
   virtual ~LogStorageProcess();
 
@@ -117,12 +122,19 @@ private:
   // Continuations.
   Future<Option<Entry>> _get(const string& name);
 
-  Future<bool> _set(const Entry& entry, const UUID& uuid);
-  Future<bool> __set(const Entry& entry, const UUID& uuid);
+  Future<Nothing> _set(
+      const Entry& entry,
+      const UUID& uuid,
+      Owned<Promise<bool>> promise);
+  Future<Nothing> __set(
+      const Entry& entry,
+      const UUID& uuid,
+      Owned<Promise<bool>> promise);
   Future<bool> ___set(
       const Entry& entry,
       size_t diff,
       Option<Log::Position> position);
+  void ____set(const string& name, const Future<bool>& future);
 
   Future<bool> _expunge(const Entry& entry);
   Future<bool> __expunge(const Entry& entry);
@@ -137,9 +149,17 @@ private:
 
   const size_t diffsBetweenSnapshots;
 
-  // Used to serialize Log::Writer::append/truncate operations.
+  // Used to serialize Log::Writer::append/truncate operations. Note
+  // that 'set' only holds the mutex until it has issued its append,
+  // so that the appends of consecutive sets are in flight together.
   Mutex mutex;
 
+  // The appends issued by 'set' which are still in flight, indexed
+  // by the name of the entry. A subsequent 'set' or 'expunge' of the
+  // same entry waits for the append to complete before it compares
+  // the version of the entry.
+  hashmap<string, Future<bool>> appending;
+
   // Whether or not we've started the ability to append to log.
   Option<Future<Nothing>> starting;
 
@@ -222,10 +242,13 @@ private:
 };
 
 
-LogStorageProcess::LogStorageProcess(Log* log, size_t diffsBetweenSnapshots)
+LogStorageProcess::LogStorageProcess(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    size_t writeWindow)
   : ProcessBase(process::ID::generate("log-storage")),
     reader(log),
-    writer(log),
+    writer(log, writeWindow),
     diffsBetweenSnapshots(diffsBetweenSnapshots) {}
 
 
@@ -463,33 +486,56 @@ Future<bool> LogStorageProcess::set(
     const Entry& entry,
     const UUID& uuid)
 {
-  return mutex.lock()
-    .then(defer(self(), &Self::_set, entry, uuid))
+  Owned<Promise<bool>> promise(new Promise<bool>());
+
+  // NOTE: We release the mutex once the append has been issued rather
+  // than once it completes. The log completes the appends in the order
+  // they were issued, and up to the window of the writer are in flight
+  // at once (see 'Log::Writer').
+  mutex.lock()
+    .then(defer(self(), &Self::_set, entry, uuid, promise))
     .onAny(lambda::bind(&Mutex::unlock, mutex));
+
+  return promise->future();
 }
 
 
-Future<bool> LogStorageProcess::_set(
+Future<Nothing> LogStorageProcess::_set(
     const Entry& entry,
-    const UUID& uuid)
+    const UUID& uuid,
+    Owned<Promise<bool>> promise)
 {
+  if (appending.contains(entry.name())) {
+    return await(appending.at(entry.name()))
+      .then(defer(self(), &Self::_set, entry, uuid, promise));
+  }
+
   return start()
-    .then(defer(self(), &Self::__set, entry, uuid));
+    .then(defer(self(), &Self::__set, entry, uuid, promise))
+    .onFailed([=](const string& message) { promise->fail(message); })
+    .onDiscarded([=]() { promise->discard(); });
 }
 
 
-Future<bool> LogStorageProcess::__set(
+Future<Nothing> LogStorageProcess::__set(
     const Entry& entry,
-    const UUID& uuid)
+    const UUID& uuid,
+    Owned<Promise<bool>> promise)
 {
   Option<Snapshot> snapshot = snapshots.get(entry.name());
 
   // Check the version first (if we've already got a snapshot).
   if (snapshot.isSome() &&
       UUID::fromBytes(snapshot.get().entry.uuid()).get() != uuid) {
-    return false;
+    promise->set(false);
+    return Nothing();
   }
 
+  // The operation to append, and the number of diffs that make up
+  // the snapshot of the entry once it has been appended.
+  Option<string> value;
+  size_t diffs = 0;
+
   // Check if we should try to compute a diff.
   if (snapshot.isSome() && snapshot.get().diffs < diffsBetweenSnapshots) {
     // Keep metrics for the time to calculate diffs.
@@ -520,32 +566,38 @@ Future<bool> LogStorageProcess::__set(
       operation.mutable_diff()->mutable_entry()->CopyFrom(entry);
       operation.mutable_diff()->mutable_entry()->set_value(diff.get().data);
 
-      string value;
-      if (!operation.SerializeToString(&value)) {
+      value = string();
+      if (!operation.SerializeToString(&value.get())) {
         return Failure("Failed to serialize DIFF Operation");
       }
 
-      return writer.append(value)
-        .then(defer(self(),
-                    &Self::___set,
-                    entry,
-                    snapshot.get().diffs + 1,
-                    lambda::_1));
+      diffs = snapshot.get().diffs + 1;
     }
   }
 
-  // Write the full snapshot.
-  Operation operation;
-  operation.set_type(Operation::SNAPSHOT);
-  operation.mutable_snapshot()->mutable_entry()->CopyFrom(entry);
+  if (value.isNone()) {
+    // Write the full snapshot.
+    Operation operation;
+    operation.set_type(Operation::SNAPSHOT);
+    operation.mutable_snapshot()->mutable_entry()->CopyFrom(entry);
 
-  string value;
-  if (!operation.SerializeToString(&value)) {
-    return Failure("Failed to serialize SNAPSHOT Operation");
+    value = string();
+    if (!operation.SerializeToString(&value.get())) {
+      return Failure("Failed to serialize SNAPSHOT Operation");
+    }
   }
 
-  return writer.append(value)
-    .then(defer(self(), &Self::___set, entry, 0, lambda::_1));
+  Future<bool> future = writer.append(value.get())
+    .then(defer(self(), &Self::___set, entry, diffs, lambda::_1));
+
+  promise->associate(future);
+
+  appending[entry.name()] = future;
+
+  future
+    .onAny(defer(self(), &Self::____set, entry.name(), lambda::_1));
+
+  return Nothing();
 }
 
 
@@ -582,6 +634,17 @@ Future<bool> LogStorageProcess::___set(
 }
 
 
+void LogStorageProcess::____set(
+    const string& name,
+    const Future<bool>& future)
+{
+  // A subsequent set of the entry might have issued another append.
+  if (appending.contains(name) && appending.at(name) == future) {
+    appending.erase(name);
+  }
+}
+
+
 Future<bool> LogStorageProcess::expunge(const Entry& entry)
 {
   return mutex.lock()
@@ -592,6 +655,11 @@ Future<bool> LogStorageProcess::expunge(const Entry& entry)
 
 Future<bool> LogStorageProcess::_expunge(const Entry& entry)
 {
+  if (appending.contains(entry.name())) {
+    return await(appending.at(entry.name()))
+      .then(defer(self(), &Self::_expunge, entry));
+  }
+
   return start()
     .then(defer(self(), &Self::__expunge, entry));
 }
@@ -658,9 +726,12 @@ Future<std::set<string>> LogStorageProcess::_names()
 }
 
 
-LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots)
+LogStorage::LogStorage(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    size_t writeWindow)
 {
-  process = new LogStorageProcess(log, diffsBetweenSnapshots);
+  process = new LogStorageProcess(log, diffsBetweenSnapshots, writeWindow);
   spawn(process);
 }
 
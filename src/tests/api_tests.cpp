@@ -1472,6 +1472,80 @@ TEST_P(MasterAPITest, SubscribeAgentEvents)
 }
 
 
+// This test verifies that subscribers using different content types
+// each receive the events encoded in their own content type.
+TEST_P(MasterAPITest, SubscribeMixedContentTypes)
+{
+  Try<Owned<cluster::Master>> master = this->StartMaster();
+  ASSERT_SOME(master);
+
+  auto subscribe = [&master](ContentType contentType) {
+    v1::master::Call v1Call;
+    v1Call.set_type(v1::master::Call::SUBSCRIBE);
+
+    http::Headers headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+
+    headers["Accept"] = stringify(contentType);
+
+    return http::streaming::post(
+        master.get()->pid,
+        "api/v1",
+        headers,
+        serialize(contentType, v1Call),
+        stringify(contentType));
+  };
+
+  ContentType contentType = GetParam();
+  ContentType otherContentType = contentType == ContentType::PROTOBUF
+    ? ContentType::JSON
+    : ContentType::PROTOBUF;
+
+  vector<ContentType> contentTypes = {contentType, otherContentType};
+  vector<Owned<Reader<v1::master::Event>>> decoders;
+
+  foreach (ContentType type, contentTypes) {
+    Future<http::Response> response = subscribe(type);
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+    ASSERT_EQ(http::Response::PIPE, response->type);
+    ASSERT_SOME(response->reader);
+
+    auto deserializer =
+      lambda::bind(deserialize<v1::master::Event>, type, lambda::_1);
+
+    decoders.push_back(Owned<Reader<v1::master::Event>>(
+        new Reader<v1::master::Event>(
+            Decoder<v1::master::Event>(deserializer),
+            response->reader.get())));
+
+    Future<Result<v1::master::Event>> event = decoders.back()->read();
+    AWAIT_READY(event);
+
+    EXPECT_EQ(v1::master::Event::SUBSCRIBED, event->get().type());
+  }
+
+  // Start one agent, which results in an event for both subscribers.
+  Future<SlaveRegisteredMessage> agentRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get()->pid, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(agentRegisteredMessage);
+
+  foreach (const Owned<Reader<v1::master::Event>>& decoder, decoders) {
+    Future<Result<v1::master::Event>> event = decoder->read();
+    AWAIT_READY(event);
+
+    ASSERT_EQ(v1::master::Event::AGENT_ADDED, event->get().type());
+    EXPECT_EQ(
+        evolve(agentRegisteredMessage->slave_id()),
+        event->get().agent_added().agent().agent_info().id());
+  }
+}
+
+
 // This test verifies that recovered but yet to reregister agents are returned
 // in `recovered_agents` field of `GetAgents` response.
 TEST_P_TEMP_DISABLED_ON_WINDOWS(MasterAPITest, GetRecoveredAgents)
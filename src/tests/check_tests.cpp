@@ -21,8 +21,11 @@
 
 #include <mesos/v1/mesos.hpp>
 
+#include <process/address.hpp>
 #include <process/clock.hpp>
+#include <process/gtest.hpp>
 #include <process/owned.hpp>
+#include <process/socket.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/nothing.hpp>
@@ -32,6 +35,7 @@
 #include <stout/os/getcwd.hpp>
 
 #include "checks/checker.hpp"
+#include "checks/prober.hpp"
 
 #include "slave/containerizer/fetcher.hpp"
 
@@ -52,6 +56,8 @@ using mesos::v1::scheduler::Mesos;
 using process::Future;
 using process::Owned;
 
+using process::network::inet::Socket;
+
 using std::pair;
 using std::string;
 using std::vector;
@@ -2243,6 +2249,51 @@ TEST_F(CheckTest, CheckStatusInfoValidation)
   }
 }
 
+
+// Verifies that the in-process prober reports whether a TCP connection
+// can be established and the status code of an HTTP response.
+TEST_F(CheckTest, Prober)
+{
+  Try<Owned<checks::Prober>> prober = checks::Prober::create(None());
+  ASSERT_SOME(prober);
+
+  // The prober speaks plain TCP, even if libprocess defaults to SSL.
+  Try<Socket> server =
+    Socket::create(process::network::internal::SocketImpl::Kind::POLL);
+  ASSERT_SOME(server);
+
+  Try<process::network::inet::Address> address =
+    server->bind(process::network::inet::Address::LOOPBACK_ANY());
+  ASSERT_SOME(address);
+  ASSERT_SOME(server->listen(1));
+
+  Future<Socket> accepted = server->accept();
+
+  AWAIT_READY(prober.get()->tcp(address->port));
+  AWAIT_READY(accepted);
+
+  accepted = server->accept();
+
+  Future<int> code = prober.get()->http(address->port, "/health");
+
+  AWAIT_READY(accepted);
+
+  Socket client = accepted.get();
+
+  Future<string> request = client.recv();
+  AWAIT_READY(request);
+  EXPECT_TRUE(strings::startsWith(request.get(), "GET /health HTTP/1.1\r\n"));
+
+  AWAIT_READY(client.send("HTTP/1.1 503 Service Unavailable\r\n\r\n"));
+
+  AWAIT_EXPECT_EQ(503, code);
+
+  // Once the server is closed, nothing listens on the port anymore.
+  server = Error("Closed");
+
+  AWAIT_FAILED(prober.get()->tcp(address->port));
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
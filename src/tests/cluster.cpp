@@ -243,7 +243,8 @@ Try<process::Owned<Master>> Master::start(
     master->storage.reset(new mesos::state::InMemoryStorage());
   } else if (flags.registry == "replicated_log") {
 #ifndef __WINDOWS__
-    master->storage.reset(new mesos::state::LogStorage(master->log.get()));
+    master->storage.reset(new mesos::state::LogStorage(
+        master->log.get(), 0, flags.registry_log_write_window));
 #else
     return Error("Windows does not support replicated log");
 #endif // __WINDOWS__
@@ -1049,6 +1049,123 @@ TEST_F(CgroupsAnyHierarchyWithPerfEventTest, ROOT_CGROUPS_PERF_PerfTest)
 }
 
 
+// Tests that perf::Counters counts the events of a cgroup directly,
+// i.e., without a 'perf' binary.
+TEST_F(CgroupsAnyHierarchyWithPerfEventTest, ROOT_CGROUPS_PerfCounters)
+{
+  string hierarchy = path::join(baseHierarchy, "perf_event");
+
+  // Only events with a generic kernel encoding can be counted.
+  EXPECT_ERROR(perf::Counters::create(
+      {"task-clock", "cycles:u"}, hierarchy, 1024));
+
+  Try<long> cpus = os::cpus();
+  ASSERT_SOME(cpus);
+
+  // The cgroup needs a counter for each event on each CPU, one fewer
+  // than that does not suffice.
+  const size_t needed = 2 * cpus.get();
+
+  Try<Owned<perf::Counters>> counters = perf::Counters::create(
+      {"task-clock", "context-switches"}, hierarchy, needed - 1);
+
+  ASSERT_SOME(counters);
+
+  ASSERT_SOME(cgroups::create(hierarchy, TEST_CGROUPS_ROOT));
+
+  EXPECT_ERROR(counters.get()->add(
+      TEST_CGROUPS_ROOT,
+      path::join(hierarchy, TEST_CGROUPS_ROOT)));
+
+  counters = perf::Counters::create(
+      {"task-clock", "context-switches"}, hierarchy, needed);
+
+  ASSERT_SOME(counters);
+
+  int pipes[2];
+  int dummy;
+  ASSERT_NE(-1, ::pipe(pipes));
+
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+
+  if (pid == 0) {
+    // In child process.
+    ::close(pipes[1]);
+
+    // Wait until parent has assigned us to the cgroup.
+    ssize_t len;
+    while ((len = ::read(pipes[0], &dummy, sizeof(dummy))) == -1 &&
+           errno == EINTR);
+    ASSERT_EQ((ssize_t) sizeof(dummy), len);
+    ::close(pipes[0]);
+
+    while (true) {
+      // Don't sleep so there is something to count.
+    }
+
+    ABORT("Child should not reach here");
+  }
+
+  // In parent.
+  ::close(pipes[0]);
+
+  ASSERT_SOME(counters.get()->add(
+      TEST_CGROUPS_ROOT,
+      path::join(hierarchy, TEST_CGROUPS_ROOT)));
+
+  // Put child into the test cgroup.
+  ASSERT_SOME(cgroups::assign(hierarchy, TEST_CGROUPS_ROOT, pid));
+
+  ssize_t len;
+  while ((len = ::write(pipes[1], &dummy, sizeof(dummy))) == -1 &&
+         errno == EINTR);
+  ASSERT_EQ((ssize_t) sizeof(dummy), len);
+  ::close(pipes[1]);
+
+  os::sleep(Milliseconds(500));
+
+  hashmap<string, mesos::PerfStatistics> statistics = counters.get()->read();
+
+  ASSERT_TRUE(statistics.contains(TEST_CGROUPS_ROOT));
+  EXPECT_LT(0.0, statistics.at(TEST_CGROUPS_ROOT).duration());
+
+  ASSERT_TRUE(statistics.at(TEST_CGROUPS_ROOT).has_task_clock());
+  EXPECT_LT(0.0, statistics.at(TEST_CGROUPS_ROOT).task_clock());
+  ASSERT_TRUE(statistics.at(TEST_CGROUPS_ROOT).has_context_switches());
+
+  const double timestamp = statistics.at(TEST_CGROUPS_ROOT).timestamp();
+  const double duration = statistics.at(TEST_CGROUPS_ROOT).duration();
+
+  // The next read only covers the time since the previous one.
+  os::sleep(Milliseconds(500));
+
+  statistics = counters.get()->read();
+
+  ASSERT_TRUE(statistics.contains(TEST_CGROUPS_ROOT));
+  EXPECT_DOUBLE_EQ(
+      timestamp + duration,
+      statistics.at(TEST_CGROUPS_ROOT).timestamp());
+  EXPECT_LT(0.0, statistics.at(TEST_CGROUPS_ROOT).task_clock());
+  EXPECT_GE(
+      statistics.at(TEST_CGROUPS_ROOT).duration() * 1000 * 1.1,
+      statistics.at(TEST_CGROUPS_ROOT).task_clock());
+
+  counters.get()->remove(TEST_CGROUPS_ROOT);
+  EXPECT_TRUE(counters.get()->read().empty());
+
+  // Kill the child process.
+  ASSERT_NE(-1, ::kill(pid, SIGKILL));
+
+  // Wait for the child process.
+  AWAIT_EXPECT_WTERMSIG_EQ(SIGKILL, reap(pid));
+
+  // Destroy the cgroup.
+  Future<Nothing> destroy = cgroups::destroy(hierarchy, TEST_CGROUPS_ROOT);
+  AWAIT_READY(destroy);
+}
+
+
 class CgroupsAnyHierarchyMemoryPressureTest
   : public CgroupsAnyHierarchyTest
 {
@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
 #include <list>
 #include <string>
 #include <vector>
@@ -22,7 +23,10 @@
 
 #include <process/future.hpp>
 #include <process/gtest.hpp>
+#include <process/http.hpp>
+#include <process/loop.hpp>
 #include <process/owned.hpp>
+#include <process/socket.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/duration.hpp>
@@ -31,7 +35,12 @@
 
 #include <stout/os/constants.hpp>
 
+#include <stout/tests/utils.hpp>
+
 #include "docker/docker.hpp"
+#ifndef __WINDOWS__
+#include "docker/engine.hpp"
+#endif // __WINDOWS__
 
 #include "mesos/resources.hpp"
 
@@ -41,6 +50,10 @@
 
 using namespace process;
 
+#ifndef __WINDOWS__
+namespace unix = process::network::unix;
+#endif // __WINDOWS__
+
 using std::list;
 using std::string;
 using std::vector;
@@ -988,6 +1001,249 @@ TEST_F(DockerTest, ROOT_DOCKER_ConflictingVolumeDrivers)
   ASSERT_ERROR(runOptions);
 }
 
+#ifndef __WINDOWS__
+// Tests the Engine API client of docker against a stub daemon, so
+// they do not require docker to be installed.
+class DockerEngineTest : public TemporaryDirectoryTest
+{
+protected:
+  virtual void TearDown()
+  {
+    accepting.discard();
+
+    TemporaryDirectoryTest::TearDown();
+  }
+
+  // Serves the Engine API on a unix socket in the sandbox using the
+  // given handler, and returns the path of the socket.
+  Try<string> serve(
+      const std::function<Future<http::Response>(const http::Request&)>& f)
+  {
+    Try<unix::Socket> server = unix::Socket::create();
+    if (server.isError()) {
+      return Error(server.error());
+    }
+
+    const string path = path::join(sandbox.get(), "docker.sock");
+
+    Try<unix::Address> address = unix::Address::create(path);
+    if (address.isError()) {
+      return Error(address.error());
+    }
+
+    Try<unix::Address> bind = server->bind(address.get());
+    if (bind.isError()) {
+      return Error(bind.error());
+    }
+
+    Try<Nothing> listen = server->listen(16);
+    if (listen.isError()) {
+      return Error(listen.error());
+    }
+
+    std::atomic<int>* connections = &this->connections;
+
+    accepting = loop(
+        None(),
+        [=]() mutable {
+          return server->accept();
+        },
+        [=](const unix::Socket& socket) -> ControlFlow<Nothing> {
+          ++(*connections);
+          http::serve(socket, f);
+          return Continue();
+        });
+
+    return path;
+  }
+
+  // Returns the body of a container inspect response.
+  static string container(const string& name, bool started)
+  {
+    return strings::format(
+        "{"
+        "  \"Id\": \"%s-id\","
+        "  \"Name\": \"/%s\","
+        "  \"State\": {"
+        "    \"Pid\": %d,"
+        "    \"StartedAt\": \"%s\""
+        "  },"
+        "  \"NetworkSettings\": {"
+        "    \"IPAddress\": \"\""
+        "  }"
+        "}",
+        name,
+        name,
+        started ? 42 : 0,
+        started ? "2017-07-01T00:00:00Z" : "0001-01-01T00:00:00Z").get();
+  }
+
+  std::atomic<int> connections{0};
+  Future<Nothing> accepting;
+};
+
+
+// Verifies that inspects are served over a single reused connection.
+TEST_F(DockerEngineTest, Inspect)
+{
+  Try<string> socket = serve([](const http::Request& request)
+      -> Future<http::Response> {
+    if (request.method == "GET" &&
+        request.url.path == "/containers/mesos-1/json") {
+      return http::OK(container("mesos-1", true));
+    }
+
+    return http::NotFound();
+  });
+
+  ASSERT_SOME(socket);
+
+  Try<Owned<Docker>> docker =
+    DockerEngine::create("docker", socket.get(), false);
+  ASSERT_SOME(docker);
+
+  for (int i = 0; i < 3; i++) {
+    Future<Docker::Container> container = docker.get()->inspect("mesos-1");
+    AWAIT_READY(container);
+
+    EXPECT_EQ("mesos-1-id", container->id);
+    EXPECT_EQ("/mesos-1", container->name);
+    EXPECT_SOME_EQ(42, container->pid);
+    EXPECT_TRUE(container->started);
+  }
+
+  EXPECT_EQ(1, connections.load());
+
+  AWAIT_FAILED(docker.get()->inspect("mesos-2"));
+}
+
+
+// Verifies that an inspect waiting for a container to start is
+// completed by a start event rather than by polling.
+TEST_F(DockerEngineTest, InspectWaitsForStartEvent)
+{
+  std::shared_ptr<std::atomic<bool>> started(new std::atomic<bool>(false));
+  std::shared_ptr<Promise<Nothing>> inspected(new Promise<Nothing>());
+  http::Pipe events;
+
+  Try<string> socket = serve([=](const http::Request& request)
+      -> Future<http::Response> {
+    if (request.url.path == "/containers/mesos-1/json") {
+      http::Response response = http::OK(container("mesos-1", *started));
+      inspected->set(Nothing());
+      return response;
+    }
+
+    if (request.url.path == "/events" &&
+        request.url.query.contains("filters")) {
+      http::Response response = http::OK();
+      response.type = http::Response::PIPE;
+      response.reader = events.reader();
+      return response;
+    }
+
+    return http::NotFound();
+  });
+
+  ASSERT_SOME(socket);
+
+  Try<Owned<Docker>> docker =
+    DockerEngine::create("docker", socket.get(), false);
+  ASSERT_SOME(docker);
+
+  // Use a retry interval long enough that the container can only be
+  // found started through the event stream.
+  Future<Docker::Container> container =
+    docker.get()->inspect("mesos-1", Days(1));
+
+  AWAIT_READY(inspected->future());
+  EXPECT_TRUE(container.isPending());
+
+  *started = true;
+
+  http::Pipe::Writer writer = events.writer();
+  writer.write("{\"status\":\"start\",\"id\":\"mesos-1-id\"}\n");
+
+  AWAIT_READY(container);
+  EXPECT_TRUE(container->started);
+  EXPECT_SOME_EQ(42, container->pid);
+}
+
+
+TEST_F(DockerEngineTest, Ps)
+{
+  Try<string> socket = serve([](const http::Request& request)
+      -> Future<http::Response> {
+    if (request.url.path == "/containers/json") {
+      if (request.url.query.get("all") != Some("1")) {
+        return http::BadRequest();
+      }
+
+      return http::OK(
+          "["
+          "  {\"Id\": \"mesos-1-id\", \"Names\": [\"/mesos-1\"]},"
+          "  {\"Id\": \"other-mesos-id\", \"Names\": [\"/other-mesos\"]}"
+          "]");
+    }
+
+    if (request.url.path == "/containers/mesos-1/json") {
+      return http::OK(container("mesos-1", true));
+    }
+
+    return http::NotFound();
+  });
+
+  ASSERT_SOME(socket);
+
+  Try<Owned<Docker>> docker =
+    DockerEngine::create("docker", socket.get(), false);
+  ASSERT_SOME(docker);
+
+  Future<list<Docker::Container>> containers =
+    docker.get()->ps(true, "mesos-");
+
+  AWAIT_READY(containers);
+  ASSERT_EQ(1u, containers->size());
+  EXPECT_EQ("mesos-1-id", containers->front().id);
+}
+
+
+TEST_F(DockerEngineTest, StopKillRemove)
+{
+  std::shared_ptr<std::vector<string>> requests(new std::vector<string>());
+
+  Try<string> socket = serve([=](const http::Request& request)
+      -> Future<http::Response> {
+    string line = request.method + " " + request.url.path;
+
+    foreachpair (const string& key, const string& value, request.url.query) {
+      line += " " + key + "=" + value;
+    }
+
+    requests->push_back(line);
+
+    return http::Response(http::Status::NO_CONTENT);
+  });
+
+  ASSERT_SOME(socket);
+
+  Try<Owned<Docker>> docker =
+    DockerEngine::create("docker", socket.get(), false);
+  ASSERT_SOME(docker);
+
+  AWAIT_READY(docker.get()->kill("mesos-1", SIGTERM));
+  AWAIT_READY(docker.get()->stop("mesos-1", Seconds(5), true));
+
+  vector<string> expected = {
+    "POST /containers/mesos-1/kill signal=" + stringify(SIGTERM),
+    "POST /containers/mesos-1/stop t=5",
+    "DELETE /containers/mesos-1 v=1"
+  };
+
+  EXPECT_EQ(expected, *requests);
+}
+#endif // __WINDOWS__
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
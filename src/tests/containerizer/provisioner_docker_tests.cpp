@@ -23,16 +23,22 @@
 #include <stout/path.hpp>
 #include <stout/stringify.hpp>
 
+#include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/owned.hpp>
+#include <process/shared.hpp>
 
 #include <mesos/docker/spec.hpp>
 
+#include <mesos/uri/fetcher.hpp>
+
 #ifdef __linux__
 #include "linux/fs.hpp"
 #endif
 
+#include "common/command_utils.hpp"
+
 #include "slave/containerizer/mesos/provisioner/constants.hpp"
 #include "slave/containerizer/mesos/provisioner/paths.hpp"
 
@@ -55,13 +61,17 @@ namespace paths = mesos::internal::slave::docker::paths;
 namespace slave = mesos::internal::slave;
 namespace spec = ::docker::spec;
 
+using std::set;
 using std::string;
 using std::vector;
 
+using process::Clock;
+using process::Failure;
 using process::Future;
 using process::Owned;
 using process::PID;
 using process::Promise;
+using process::Shared;
 
 using master::Master;
 
@@ -368,6 +378,285 @@ TEST_F(ProvisionerDockerLocalStoreTest, PullingSameImageSimutanuously)
 }
 
 
+// A URI fetcher plugin that serves the manifest of an image from
+// memory and leaves the download of its blobs to the test.
+class MockRegistryFetcherPlugin : public uri::Fetcher::Plugin
+{
+public:
+  explicit MockRegistryFetcherPlugin(const string& _manifest)
+    : manifest(_manifest) {}
+
+  virtual ~MockRegistryFetcherPlugin() {}
+
+  virtual set<string> schemes() const
+  {
+    return {"docker-manifest", "docker-blob"};
+  }
+
+  virtual string name() const
+  {
+    return "mock-registry";
+  }
+
+  virtual Future<Nothing> fetch(
+      const URI& uri,
+      const string& directory) const
+  {
+    if (uri.scheme() == "docker-blob") {
+      // The blob sum is passed as the query of the blob URI.
+      return fetchBlob(uri.query(), directory);
+    }
+
+    Try<Nothing> write =
+      os::write(path::join(directory, "manifest"), manifest);
+
+    if (write.isError()) {
+      return Failure(write.error());
+    }
+
+    return Nothing();
+  }
+
+  MOCK_CONST_METHOD2(
+      fetchBlob,
+      Future<Nothing>(const string&, const string&));
+
+private:
+  const string manifest;
+};
+
+
+class ProvisionerDockerRegistryPullerTest : public TemporaryDirectoryTest
+{
+protected:
+  // Creates the tarball of a layer that contains the given file, and
+  // returns its blob sum. The tarball is kept in 'blobs' by its sum.
+  Future<string> createBlob(const string& file)
+  {
+    const string rootfs = path::join(os::getcwd(), "layers", file);
+    const string blobs = path::join(os::getcwd(), "blobs");
+    const string tar = path::join(blobs, file + ".tar");
+
+    Try<Nothing> mkdir = os::mkdir(rootfs);
+    if (mkdir.isError()) {
+      return Failure(mkdir.error());
+    }
+
+    mkdir = os::mkdir(blobs);
+    if (mkdir.isError()) {
+      return Failure(mkdir.error());
+    }
+
+    Try<Nothing> write = os::write(path::join(rootfs, file), file);
+    if (write.isError()) {
+      return Failure(write.error());
+    }
+
+    return command::tar(Path("."), Path(tar), Path(rootfs))
+      .then([tar]() { return command::sha256(Path(tar)); })
+      .then([blobs, tar](const string& checksum) -> Future<string> {
+        const string blobSum = "sha256:" + checksum;
+
+        Try<Nothing> rename = os::rename(tar, path::join(blobs, blobSum));
+        if (rename.isError()) {
+          return Failure(rename.error());
+        }
+
+        return blobSum;
+      });
+  }
+
+  // Copies the tarball with the given blob sum to where the registry
+  // puller expects the download of 'name' in 'directory'.
+  Try<Nothing> download(
+      const string& blobSum,
+      const string& directory,
+      const string& name)
+  {
+    Try<string> tar = os::read(path::join(os::getcwd(), "blobs", blobSum));
+    if (tar.isError()) {
+      return Error(tar.error());
+    }
+
+    return os::write(path::join(directory, name), tar.get());
+  }
+
+  // Returns the manifest of an image with a layer for each of the
+  // given blob sums, starting with the leaf layer.
+  string createManifest(const vector<string>& blobSums)
+  {
+    JSON::Array fsLayers;
+    JSON::Array history;
+
+    for (size_t i = 0; i < blobSums.size(); i++) {
+      JSON::Object fsLayer;
+      fsLayer.values["blobSum"] = blobSums[i];
+      fsLayers.values.push_back(fsLayer);
+
+      JSON::Object v1;
+      v1.values["id"] = "layer" + stringify(i);
+      if (i + 1 < blobSums.size()) {
+        v1.values["parent"] = "layer" + stringify(i + 1);
+      }
+
+      JSON::Object v1Compatibility;
+      v1Compatibility.values["v1Compatibility"] = stringify(v1);
+      history.values.push_back(v1Compatibility);
+    }
+
+    JSON::Object manifest;
+    manifest.values["name"] = "library/test";
+    manifest.values["tag"] = "latest";
+    manifest.values["architecture"] = "amd64";
+    manifest.values["schemaVersion"] = 1;
+    manifest.values["fsLayers"] = fsLayers;
+    manifest.values["history"] = history;
+
+    return stringify(manifest);
+  }
+
+  Future<vector<string>> pull(
+      const slave::Flags& flags,
+      MockRegistryFetcherPlugin* plugin)
+  {
+    vector<Owned<uri::Fetcher::Plugin>> plugins;
+    plugins.push_back(Owned<uri::Fetcher::Plugin>(plugin));
+
+    Try<Owned<Puller>> _puller = RegistryPuller::create(
+        flags,
+        Shared<uri::Fetcher>(new uri::Fetcher(plugins)));
+
+    if (_puller.isError()) {
+      return Failure(_puller.error());
+    }
+
+    puller = _puller.get();
+
+    Try<spec::ImageReference> reference = spec::parseImageReference("test");
+    if (reference.isError()) {
+      return Failure(reference.error());
+    }
+
+    Try<Nothing> mkdir = os::mkdir(directory());
+    if (mkdir.isError()) {
+      return Failure(mkdir.error());
+    }
+
+    return puller->pull(reference.get(), directory(), COPY_BACKEND);
+  }
+
+  string directory()
+  {
+    return path::join(os::getcwd(), "staging");
+  }
+
+  Owned<Puller> puller;
+};
+
+
+// This test verifies that a pull fails if the content of a blob does
+// not match its digest, and that the blob is not extracted.
+TEST_F(ProvisionerDockerRegistryPullerTest, DigestMismatch)
+{
+  Future<string> blobSum = createBlob("foo");
+  AWAIT_READY(blobSum);
+
+  const string digest = "sha256:" + string(64, '0');
+
+  MockRegistryFetcherPlugin* plugin =
+    new MockRegistryFetcherPlugin(createManifest({digest}));
+
+  Future<Nothing> fetchBlob;
+  Promise<Nothing> promise;
+
+  EXPECT_CALL(*plugin, fetchBlob(digest, _))
+    .WillOnce(testing::DoAll(FutureSatisfy(&fetchBlob),
+                             Return(promise.future())));
+
+  slave::Flags flags;
+  flags.docker_store_dir = path::join(os::getcwd(), "store");
+
+  Future<vector<string>> layers = pull(flags, plugin);
+
+  AWAIT_READY(fetchBlob);
+
+  ASSERT_SOME(download(blobSum.get(), directory(), digest));
+  promise.set(Nothing());
+
+  AWAIT_FAILED(layers);
+  EXPECT_TRUE(strings::contains(layers.failure(), "does not match"));
+
+  EXPECT_FALSE(os::exists(path::join(directory(), "layer0")));
+}
+
+
+// This test verifies that no more than '--docker_pull_concurrency'
+// blobs are downloaded at once, and that the next blob is downloaded
+// as soon as one is done.
+TEST_F(ProvisionerDockerRegistryPullerTest, PullConcurrency)
+{
+  vector<string> blobSums;
+  foreach (const string& file, vector<string>({"foo", "bar", "baz"})) {
+    Future<string> blobSum = createBlob(file);
+    AWAIT_READY(blobSum);
+    blobSums.push_back(blobSum.get());
+  }
+
+  MockRegistryFetcherPlugin* plugin =
+    new MockRegistryFetcherPlugin(createManifest(blobSums));
+
+  Future<string> blob1;
+  Future<string> blob2;
+  Future<string> blob3;
+  Promise<Nothing> promise1;
+  Promise<Nothing> promise2;
+  Promise<Nothing> promise3;
+
+  EXPECT_CALL(*plugin, fetchBlob(_, _))
+    .WillOnce(testing::DoAll(FutureArg<0>(&blob1),
+                             Return(promise1.future())))
+    .WillOnce(testing::DoAll(FutureArg<0>(&blob2),
+                             Return(promise2.future())))
+    .WillOnce(testing::DoAll(FutureArg<0>(&blob3),
+                             Return(promise3.future())));
+
+  slave::Flags flags;
+  flags.docker_store_dir = path::join(os::getcwd(), "store");
+  flags.docker_pull_concurrency = 2;
+
+  Future<vector<string>> layers = pull(flags, plugin);
+
+  AWAIT_READY(blob1);
+  AWAIT_READY(blob2);
+
+  // The third blob waits for one of the first two downloads.
+  Clock::pause();
+  Clock::settle();
+  EXPECT_TRUE(blob3.isPending());
+  Clock::resume();
+
+  ASSERT_SOME(download(blob1.get(), directory(), blob1.get()));
+  promise1.set(Nothing());
+
+  AWAIT_READY(blob3);
+
+  ASSERT_SOME(download(blob2.get(), directory(), blob2.get()));
+  promise2.set(Nothing());
+
+  ASSERT_SOME(download(blob3.get(), directory(), blob3.get()));
+  promise3.set(Nothing());
+
+  AWAIT_READY(layers);
+  EXPECT_EQ(vector<string>({"layer2", "layer1", "layer0"}), layers.get());
+
+  foreach (const string& layer, layers.get()) {
+    EXPECT_TRUE(os::exists(paths::getImageLayerRootfsPath(
+        path::join(directory(), layer),
+        COPY_BACKEND)));
+  }
+}
+
+
 #ifdef __linux__
 class ProvisionerDockerTest
   : public MesosTest,
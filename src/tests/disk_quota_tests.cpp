@@ -169,6 +169,93 @@ TEST_F(DiskUsageCollectorTest, ExcludeRelativePath)
   Future<Bytes> usage2 = collector.usage(".", {file});
   EXPECT_GE(usage2.get(), Kilobytes(128));
 }
+
+
+// This test verifies that subsequent checks of the same directory
+// (which are tracked incrementally on Linux) reflect the changes made
+// in between, and ignore the excluded directories.
+TEST_F(DiskUsageCollectorTest, Changes)
+{
+  string dir = path::join(os::getcwd(), "dir");
+  string volume = path::join(os::getcwd(), "volume");
+
+  ASSERT_SOME(os::mkdir(dir));
+  ASSERT_SOME(os::mkdir(volume));
+
+  ASSERT_SOME(os::write(
+      path::join(os::getcwd(), "file1"),
+      string(Kilobytes(64).bytes(), 'x')));
+
+  DiskUsageCollector collector(Milliseconds(1));
+
+  Future<Bytes> usage1 = collector.usage(os::getcwd(), {volume});
+  AWAIT_READY(usage1);
+  EXPECT_GE(usage1.get(), Kilobytes(64));
+  EXPECT_LT(usage1.get(), Kilobytes(128));
+
+  // Add a file in a subdirectory and one in the excluded directory.
+  ASSERT_SOME(os::write(
+      path::join(dir, "file2"),
+      string(Kilobytes(256).bytes(), 'y')));
+
+  ASSERT_SOME(os::write(
+      path::join(volume, "file3"),
+      string(Kilobytes(512).bytes(), 'z')));
+
+  Future<Bytes> usage2 = collector.usage(os::getcwd(), {volume});
+  AWAIT_READY(usage2);
+  EXPECT_GE(usage2.get(), Kilobytes(320));
+  EXPECT_LT(usage2.get(), Kilobytes(512));
+
+  // Remove the subdirectory.
+  ASSERT_SOME(os::rmdir(dir));
+
+  Future<Bytes> usage3 = collector.usage(os::getcwd(), {volume});
+  AWAIT_READY(usage3);
+  EXPECT_GE(usage3.get(), Kilobytes(64));
+  EXPECT_LT(usage3.get(), Kilobytes(128));
+}
+
+
+// This test verifies the usage of a directory with more subdirectories
+// than are walked at a time, and with more subdirectories than the
+// collector watches, in which case it falls back to 'du'.
+TEST_F(DiskUsageCollectorTest, ManyDirectories)
+{
+  for (int i = 0; i < 200; i++) {
+    string dir = path::join(os::getcwd(), "dir" + stringify(i));
+
+    ASSERT_SOME(os::mkdir(dir));
+    ASSERT_SOME(os::write(
+        path::join(dir, "file"),
+        string(Kilobytes(16).bytes(), 'x')));
+  }
+
+  DiskUsageCollector tracking(Milliseconds(1));
+  DiskUsageCollector limited(Milliseconds(1), 100);
+
+  Future<Bytes> usage1 = tracking.usage(os::getcwd(), {});
+  Future<Bytes> usage2 = limited.usage(os::getcwd(), {});
+
+  AWAIT_READY(usage1);
+  AWAIT_READY(usage2);
+
+  EXPECT_GE(usage1.get(), Kilobytes(16 * 200));
+  EXPECT_GE(usage2.get(), Kilobytes(16 * 200));
+
+  ASSERT_SOME(os::write(
+      path::join(os::getcwd(), "dir0", "file"),
+      string(Kilobytes(512).bytes(), 'y')));
+
+  Future<Bytes> usage3 = tracking.usage(os::getcwd(), {});
+  Future<Bytes> usage4 = limited.usage(os::getcwd(), {});
+
+  AWAIT_READY(usage3);
+  AWAIT_READY(usage4);
+
+  EXPECT_GE(usage3.get(), Kilobytes(16 * 199 + 512));
+  EXPECT_GE(usage4.get(), Kilobytes(16 * 199 + 512));
+}
 #endif
 
 
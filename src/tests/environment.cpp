@@ -611,6 +611,54 @@ private:
 };
 
 
+class ReflinkFilter : public TestFilter
+{
+public:
+  ReflinkFilter()
+  {
+#ifdef __linux__
+    // Test sandboxes are created in the temporary directory, so probe
+    // whether a file can be cloned there.
+    Try<string> directory = os::mkdtemp();
+    if (directory.isError()) {
+      reflinkError = Error(directory.error());
+    } else {
+      const string probe = path::join(directory.get(), "probe");
+
+      Try<Nothing> clone = os::write(probe, "probe");
+      if (clone.isSome()) {
+        clone = fs::clone(probe, probe + ".reflink");
+      }
+
+      if (clone.isError()) {
+        reflinkError = Error(clone.error());
+      }
+
+      os::rmdir(directory.get());
+    }
+#else
+    reflinkError = Error("Reflink tests not supported on non-Linux systems");
+#endif // __linux__
+
+    if (reflinkError.isSome()) {
+      std::cerr
+        << "-------------------------------------------------------------\n"
+        << "We cannot run any reflink tests because:\n"
+        << reflinkError->message << "\n"
+        << "-------------------------------------------------------------\n";
+    }
+  }
+
+  bool disable(const ::testing::TestInfo* test) const
+  {
+    return matches(test, "REFLINK_") && reflinkError.isSome();
+  }
+
+private:
+  Option<Error> reflinkError;
+};
+
+
 class RootFilter : public TestFilter
 {
 public:
@@ -680,6 +728,7 @@ Environment::Environment(const Flags& _flags)
             std::make_shared<OverlayFSFilter>(),
             std::make_shared<PerfCPUCyclesFilter>(),
             std::make_shared<PerfFilter>(),
+            std::make_shared<ReflinkFilter>(),
             std::make_shared<RootFilter>(),
             std::make_shared<UnzipFilter>(),
             std::make_shared<XfsFilter>()}),
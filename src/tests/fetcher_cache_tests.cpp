@@ -1400,6 +1400,65 @@ TEST_F(FetcherCacheTest, SimpleEviction)
 }
 
 
+// Tests that cache entries for different URIs with identical content
+// end up sharing one cache file, whose space is only accounted once.
+TEST_F(FetcherCacheTest, LocalCachedDuplicateContent)
+{
+  startSlave();
+  driver->start();
+
+  for (size_t i = 0; i < 2; i++) {
+    string commandFilename = "cmd" + stringify(i);
+    string command = commandFilename + " " + taskName(i);
+
+    commandPath = path::join(assetsDirectory, commandFilename);
+    ASSERT_SOME(os::write(commandPath, COMMAND_SCRIPT));
+
+    CommandInfo::URI uri;
+    uri.set_value(commandPath);
+    uri.set_executable(true);
+    uri.set_cache(true);
+
+    CommandInfo commandInfo;
+    commandInfo.set_value("./" + command);
+    commandInfo.add_uris()->CopyFrom(uri);
+
+    const Try<Task> task = launchTask(commandInfo, i);
+    ASSERT_SOME(task);
+
+    AWAIT_READY(awaitFinished(task.get()));
+
+    EXPECT_TRUE(isExecutable(
+        path::join(task->runDirectory.string(), commandFilename)));
+  }
+
+  EXPECT_EQ(2u, fetcherProcess->cacheSize());
+
+  // The content digest is computed after the download completes, so
+  // wait for the second entry to give up its space.
+  const Bytes expected = flags.fetcher_cache_size - COMMAND_SCRIPT.size();
+
+  Duration waited = Duration::zero();
+  while (fetcherProcess->availableCacheSpace() != expected &&
+         waited < Seconds(15)) {
+    os::sleep(Milliseconds(100));
+    waited += Milliseconds(100);
+  }
+
+  EXPECT_EQ(expected, fetcherProcess->availableCacheSpace());
+
+  const Try<list<Path>> cacheFiles = fetcherProcess->cacheFiles(slaveId, flags);
+  ASSERT_SOME(cacheFiles);
+  ASSERT_EQ(2u, cacheFiles->size());
+
+  Try<ino_t> inode1 = os::stat::inode(cacheFiles->front().string());
+  Try<ino_t> inode2 = os::stat::inode(cacheFiles->back().string());
+  ASSERT_SOME(inode1);
+  ASSERT_SOME(inode2);
+  EXPECT_EQ(inode1.get(), inode2.get());
+}
+
+
 // Tests cache eviction fallback to bypassing the cache. A first task
 // runs normally. Then a second succeeds using eviction. Then a third
 // task fails to evict, but still gets executed bypassing the cache.
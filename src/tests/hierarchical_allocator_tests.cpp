@@ -14,10 +14,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <atomic>
 #include <iostream>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -28,6 +30,7 @@
 #include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
+#include <process/id.hpp>
 #include <process/queue.hpp>
 
 #include <stout/duration.hpp>
@@ -56,6 +59,7 @@ using mesos::internal::master::MIN_CPUS;
 using mesos::internal::master::MIN_MEM;
 
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+using mesos::internal::master::allocator::HierarchicalParallelDRFAllocator;
 
 using mesos::internal::protobuf::createLabel;
 
@@ -902,6 +906,113 @@ TEST_F(HierarchicalAllocatorTest, OfferFilter)
 }
 
 
+// This test ensures that declining the same resources repeatedly does
+// not accumulate offer filters: a filter covered by an existing one is
+// skipped, and a filter covering an existing one replaces it.
+TEST_F(HierarchicalAllocatorTest, RedundantOfferFilters)
+{
+  Clock::pause();
+
+  const string ROLE{"role"};
+  const string activeOfferFilters = "allocator/mesos/offer_filters/active";
+  const string activeRoleOfferFilters =
+    "allocator/mesos/offer_filters/roles/" + ROLE + "/active";
+
+  initialize();
+
+  FrameworkInfo framework = createFrameworkInfo({ROLE});
+  allocator->addFramework(framework.id(), framework, {}, true);
+
+  SlaveInfo agent = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(
+      agent.id(),
+      agent,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent.resources(),
+      {});
+
+  Allocation expected = Allocation(
+      framework.id(),
+      {{ROLE, {{agent.id(), agent.resources()}}}});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_EXPECT_EQ(expected, allocation);
+
+  Duration filterTimeout = flags.allocation_interval * 2;
+  Filters offerFilter;
+  offerFilter.set_refuse_seconds(filterTimeout.secs());
+
+  const Resources half = Resources::parse("cpus:1;mem:512").get();
+
+  // Decline both halves of the offer with the same filter. The second
+  // filter is covered by the first one and is skipped.
+  allocator->recoverResources(
+      framework.id(),
+      agent.id(),
+      allocatedResources(half, ROLE),
+      offerFilter);
+
+  allocator->recoverResources(
+      framework.id(),
+      agent.id(),
+      allocatedResources(half, ROLE),
+      offerFilter);
+
+  Clock::settle();
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(1, metrics.values[activeOfferFilters]);
+  EXPECT_EQ(1, metrics.values[activeRoleOfferFilters]);
+
+  // A filter for half of the agent does not filter all of it, so the
+  // next batch allocation offers the whole agent again.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  AWAIT_EXPECT_EQ(expected, allocations.get());
+
+  // Decline the whole agent. This filter covers the existing one for
+  // longer, and replaces it.
+  allocator->recoverResources(
+      framework.id(),
+      agent.id(),
+      allocatedResources(agent.resources(), ROLE),
+      offerFilter);
+
+  Clock::settle();
+
+  metrics = Metrics();
+
+  EXPECT_EQ(1, metrics.values[activeOfferFilters]);
+  EXPECT_EQ(1, metrics.values[activeRoleOfferFilters]);
+
+  // There should be no allocation due to the offer filter, including
+  // once the replaced filter would have expired.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  allocation = allocations.get();
+  EXPECT_TRUE(allocation.isPending());
+
+  metrics = Metrics();
+
+  EXPECT_EQ(1, metrics.values[activeOfferFilters]);
+
+  // The filter times out and the next batch allocation occurs.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  AWAIT_EXPECT_EQ(expected, allocation);
+
+  metrics = Metrics();
+
+  EXPECT_EQ(0, metrics.values[activeOfferFilters]);
+  EXPECT_EQ(0, metrics.values[activeRoleOfferFilters]);
+}
+
+
 // This test ensures that an offer filter is not removed earlier than
 // the next batch allocation. See MESOS-4302 for more information.
 //
@@ -3772,6 +3883,118 @@ TEST_F_TEMP_DISABLED_ON_WINDOWS(
   metrics = Metrics();
 
   EXPECT_TRUE(metrics.contains(expected));
+
+  // Reviving offers removes the filters of the framework.
+  allocator->reviveOffers(framework3.id(), {});
+
+  Clock::settle();
+
+  expected.values = {
+      {"allocator/mesos/offer_filters/active", 2},
+      {"allocator/mesos/offer_filters/roles/roleA/active", 1},
+      {"allocator/mesos/offer_filters/roles/roleB/active", 1},
+  };
+
+  metrics = Metrics();
+
+  EXPECT_TRUE(metrics.contains(expected));
+}
+
+
+// This test ensures that the per-role offer filter gauge is kept
+// while the role has offer filters, even once the role is no longer
+// tracked by the allocator, so that the gauge stays accurate when the
+// role is tracked again and the filters expire.
+TEST_F_TEMP_DISABLED_ON_WINDOWS(
+    HierarchicalAllocatorTest,
+    ActiveOfferFiltersMetricsOutliveRole)
+{
+  Clock::pause();
+
+  initialize();
+
+  SlaveInfo agent = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(
+      agent.id(),
+      agent,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent.resources(),
+      {});
+
+  FrameworkInfo framework1 = createFrameworkInfo({"roleA"});
+  allocator->addFramework(framework1.id(), framework1, {}, true);
+
+  Allocation expectedAllocation = Allocation(
+      framework1.id(),
+      {{"roleA", {{agent.id(), agent.resources()}}}});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_EXPECT_EQ(expectedAllocation, allocation);
+
+  // The framework leaves "roleA" while it still has resources
+  // allocated to it. The role is no longer tracked once the framework
+  // declines them, but the filter for "roleA" remains.
+  framework1.set_roles(0, "roleB");
+  allocator->updateFramework(framework1.id(), framework1);
+
+  Duration filterTimeout = flags.allocation_interval * 2;
+  Filters offerFilter;
+  offerFilter.set_refuse_seconds(filterTimeout.secs());
+
+  allocator->recoverResources(
+      framework1.id(),
+      agent.id(),
+      allocation->resources.at("roleA").at(agent.id()),
+      offerFilter);
+
+  Clock::settle();
+
+  JSON::Object expected;
+  expected.values = {
+      {"allocator/mesos/offer_filters/active", 1},
+      {"allocator/mesos/offer_filters/roles/roleA/active", 1},
+  };
+
+  JSON::Value metrics = Metrics();
+
+  EXPECT_TRUE(metrics.contains(expected));
+
+  // Tracking the role again keeps the count of its filters.
+  FrameworkInfo framework2 = createFrameworkInfo({"roleA"});
+  allocator->addFramework(framework2.id(), framework2, {}, true);
+
+  Clock::settle();
+
+  metrics = Metrics();
+
+  EXPECT_TRUE(metrics.contains(expected));
+
+  // Ensure the offer filter times out (2x the allocation interval).
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  expected.values = {
+      {"allocator/mesos/offer_filters/active", 0},
+      {"allocator/mesos/offer_filters/roles/roleA/active", 0},
+  };
+
+  metrics = Metrics();
+
+  EXPECT_TRUE(metrics.contains(expected));
+
+  // Without filters, the gauge is removed along with the role.
+  allocator->removeFramework(framework2.id());
+
+  Clock::settle();
+
+  JSON::Object values = Metrics();
+
+  EXPECT_EQ(
+      0u,
+      values.values.count("allocator/mesos/offer_filters/roles/roleA/active"));
 }
 
 
@@ -4687,6 +4910,136 @@ TEST_F(HierarchicalAllocatorTest, DISABLED_NestedQuotaAccounting)
 }
 
 
+// The number of threads of the parallel allocator in the tests below,
+// which is fixed so that allocation runs get split into shards even
+// on machines with a single CPU.
+constexpr size_t ALLOCATION_TEST_THREADS = 4;
+
+
+// Like `HierarchicalParallelDRFAllocatorProcess`, but with a fixed
+// number of threads rather than one per CPU.
+class TestParallelDRFAllocatorProcess
+  : public master::allocator::HierarchicalAllocatorProcess<
+        master::allocator::DRFSorter,
+        master::allocator::DRFSorter,
+        master::allocator::DRFSorter>
+{
+public:
+  TestParallelDRFAllocatorProcess()
+    : ProcessBase(process::ID::generate("hierarchical-allocator")),
+      master::allocator::HierarchicalAllocatorProcess<
+          master::allocator::DRFSorter,
+          master::allocator::DRFSorter,
+          master::allocator::DRFSorter>(ALLOCATION_TEST_THREADS) {}
+};
+
+
+typedef master::allocator::MesosAllocator<TestParallelDRFAllocatorProcess>
+  TestParallelDRFAllocator;
+
+
+class HierarchicalParallelAllocatorTest : public HierarchicalAllocatorTestBase
+{
+protected:
+  HierarchicalParallelAllocatorTest()
+  {
+    delete allocator;
+    allocator = createAllocator<TestParallelDRFAllocator>();
+  }
+};
+
+
+// Checks that an allocation run over enough agents to be split
+// across threads offers every agent exactly once and still shares
+// the cluster fairly between roles.
+TEST_F(HierarchicalParallelAllocatorTest, OffersAllAgentsFairly)
+{
+  Clock::pause();
+
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> offers;
+
+  auto offerCallback = [&offers](
+      const FrameworkID& frameworkId,
+      const hashmap<string, hashmap<SlaveID, Resources>>& resources_)
+  {
+    foreachvalue (const auto& slaveResources, resources_) {
+      foreachpair (const SlaveID& slaveId,
+                   const Resources& resources,
+                   slaveResources) {
+        offers[frameworkId][slaveId] += resources;
+      }
+    }
+  };
+
+  initialize(master::Flags(), offerCallback);
+
+  FrameworkInfo framework1 = createFrameworkInfo({"role1"});
+  allocator->addFramework(framework1.id(), framework1, {}, true);
+
+  FrameworkInfo framework2 = createFrameworkInfo({"role2"});
+  allocator->addFramework(framework2.id(), framework2, {}, true);
+
+  // Use enough agents for the fair share stage to be split across
+  // all of the threads.
+  const size_t slaveCount =
+    ALLOCATION_TEST_THREADS * master::MIN_AGENTS_PER_ALLOCATION_SHARD;
+
+  for (size_t i = 0; i < slaveCount; i++) {
+    SlaveInfo slave = createSlaveInfo("cpus:1;mem:512;disk:0");
+    allocator->addSlave(
+        slave.id(),
+        slave,
+        AGENT_CAPABILITIES(),
+        None(),
+        slave.resources(),
+        {});
+  }
+
+  Clock::settle();
+
+  // Decline all offers without a filter so that the next batch
+  // allocation considers every agent in a single run.
+  foreachpair (const FrameworkID& frameworkId,
+               const auto& slaveResources,
+               offers) {
+    foreachpair (const SlaveID& slaveId,
+                 const Resources& resources,
+                 slaveResources) {
+      Filters filters;
+      filters.set_refuse_seconds(0);
+
+      allocator->recoverResources(frameworkId, slaveId, resources, filters);
+    }
+  }
+
+  Clock::settle();
+  offers.clear();
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  ASSERT_TRUE(offers.contains(framework1.id()));
+  ASSERT_TRUE(offers.contains(framework2.id()));
+
+  const hashmap<SlaveID, Resources>& offers1 = offers.at(framework1.id());
+  const hashmap<SlaveID, Resources>& offers2 = offers.at(framework2.id());
+
+  // Every agent is offered to exactly one of the frameworks.
+  EXPECT_EQ(slaveCount, offers1.size() + offers2.size());
+
+  foreachkey (const SlaveID& slaveId, offers1) {
+    EXPECT_FALSE(offers2.contains(slaveId));
+  }
+
+  // Each thread works from a snapshot of the shares taken at the
+  // start of the run, so the split may be off by one agent per thread.
+  const size_t slack = ALLOCATION_TEST_THREADS + 1;
+
+  EXPECT_GE(offers1.size() + slack, slaveCount / 2);
+  EXPECT_GE(offers2.size() + slack, slaveCount / 2);
+}
+
+
 class HierarchicalAllocatorTestWithParam
   : public HierarchicalAllocatorTestBase,
     public WithParamInterface<bool> {};
@@ -5757,6 +6110,144 @@ TEST_P(HierarchicalAllocator_BENCHMARK_Test, AllocatorBacklog)
        << " allocation runs" << endl;
 }
 
+
+class HierarchicalParallelAllocator_BENCHMARK_Test
+  : public HierarchicalAllocatorTestBase,
+    public WithParamInterface<size_t>
+{
+protected:
+  // Returns the duration of a batch allocation run over all agents
+  // using an allocator of type `T`.
+  template <typename T>
+  Duration allocationRun(size_t slaveCount, size_t frameworkCount)
+  {
+    delete allocator;
+    allocator = createAllocator<T>();
+
+    struct OfferedResources
+    {
+      FrameworkID   frameworkId;
+      SlaveID       slaveId;
+      Resources     resources;
+    };
+
+    vector<OfferedResources> offers;
+
+    auto offerCallback = [&offers](
+        const FrameworkID& frameworkId,
+        const hashmap<string, hashmap<SlaveID, Resources>>& resources_)
+    {
+      foreachkey (const string& role, resources_) {
+        foreachpair (const SlaveID& slaveId,
+                     const Resources& resources,
+                     resources_.at(role)) {
+          offers.push_back(OfferedResources{frameworkId, slaveId, resources});
+        }
+      }
+    };
+
+    initialize(master::Flags(), offerCallback);
+
+    // Spread the frameworks across a handful of roles.
+    for (size_t i = 0; i < frameworkCount; i++) {
+      FrameworkInfo framework =
+        createFrameworkInfo({"role" + stringify(i % 10)});
+      allocator->addFramework(framework.id(), framework, {}, true);
+    }
+
+    Clock::settle();
+
+    const Resources agentResources = Resources::parse(
+        "cpus:24;mem:4096;disk:4096;ports:[31000-32000]").get();
+
+    for (size_t i = 0; i < slaveCount; i++) {
+      SlaveInfo slave = createSlaveInfo(agentResources);
+      allocator->addSlave(
+          slave.id(),
+          slave,
+          AGENT_CAPABILITIES(),
+          None(),
+          slave.resources(),
+          {});
+    }
+
+    Clock::settle();
+
+    // Return all offered resources without a filter so that the next
+    // batch allocation has to consider every agent again.
+    foreach (const OfferedResources& offer, offers) {
+      Filters filters;
+      filters.set_refuse_seconds(0);
+
+      allocator->recoverResources(
+          offer.frameworkId, offer.slaveId, offer.resources, filters);
+    }
+
+    Clock::settle();
+    offers.clear();
+
+    Stopwatch watch;
+    watch.start();
+
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    watch.stop();
+
+    EXPECT_EQ(slaveCount, offers.size());
+
+    return watch.elapsed();
+  }
+};
+
+
+// The parallel allocator benchmark is parameterized by the number of
+// frameworks, and runs over an increasing number of agents each.
+INSTANTIATE_TEST_CASE_P(
+    FrameworkCount,
+    HierarchicalParallelAllocator_BENCHMARK_Test,
+    ::testing::Values(100U, 1000U));
+
+
+// Compares the duration of a batch allocation run over all agents
+// between the serial and the parallel DRF allocators, for a growing
+// number of agents so that the crossover point shows.
+TEST_P(HierarchicalParallelAllocator_BENCHMARK_Test, AllocationRun)
+{
+  size_t frameworkCount = GetParam();
+
+  const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+  const vector<size_t> slaveCounts =
+    {500U, 1000U, 2000U, 5000U, 10000U, 20000U, 50000U};
+
+  Clock::pause();
+
+  cout << "Using " << frameworkCount << " frameworks and up to "
+       << threads << " threads" << endl;
+
+  foreach (size_t slaveCount, slaveCounts) {
+    // See `HierarchicalAllocatorProcess::allocate()`.
+    const size_t shardCount = std::max(
+        static_cast<size_t>(1),
+        std::min(
+            threads,
+            slaveCount / master::MIN_AGENTS_PER_ALLOCATION_SHARD));
+
+    Duration serial =
+      allocationRun<HierarchicalDRFAllocator>(slaveCount, frameworkCount);
+
+    Duration parallel = allocationRun<HierarchicalParallelDRFAllocator>(
+        slaveCount, frameworkCount);
+
+    cout << slaveCount << " agents: serial allocate() took " << serial
+         << ", parallel allocate() took " << parallel << " with "
+         << shardCount << " shard(s)" << endl;
+  }
+
+  Clock::resume();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -19,12 +19,14 @@
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
 #include <mesos/log/log.hpp>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -65,14 +67,18 @@ using namespace mesos::internal::log;
 
 using namespace process;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::set;
 using std::string;
+using std::vector;
 
 using testing::_;
 using testing::Eq;
 using testing::Invoke;
 using testing::Return;
+using testing::WithParamInterface;
 
 using mesos::log::Log;
 
@@ -321,6 +327,75 @@ TYPED_TEST(LogStorageTest, TruncateWithManyHoles)
 }
 
 
+// This test verifies that the state recovered by the storage reflects
+// all the actions persisted before, including actions overwritten
+// after the index of the log has been checkpointed.
+TYPED_TEST(LogStorageTest, Restore)
+{
+  const string path = os::getcwd() + "/.log";
+
+  // Enough actions to checkpoint the index several times.
+  const uint64_t positions = 5000;
+
+  {
+    TypeParam storage;
+    ASSERT_SOME(storage.restore(path));
+
+    Metadata metadata;
+    metadata.set_status(Metadata::VOTING);
+    metadata.set_promised(1);
+
+    ASSERT_SOME(storage.persist(metadata));
+
+    // Write each position unlearned first and learn it with the next
+    // write, like a replica does for a sequence of appends.
+    for (uint64_t position = 0; position < positions; position++) {
+      Action action;
+      action.set_position(position);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(stringify(position));
+
+      ASSERT_SOME(storage.persist(action));
+
+      if (position > 0) {
+        Action learned;
+        learned.set_position(position - 1);
+        learned.set_promised(1);
+        learned.set_performed(1);
+        learned.set_learned(true);
+        learned.set_type(Action::APPEND);
+        learned.mutable_append()->set_bytes(stringify(position - 1));
+
+        ASSERT_SOME(storage.persist(learned));
+      }
+    }
+  }
+
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  EXPECT_EQ(Metadata::VOTING, state->metadata.status());
+  EXPECT_EQ(1u, state->metadata.promised());
+  EXPECT_EQ(0u, state->begin);
+  EXPECT_EQ(positions - 1, state->end);
+
+  IntervalSet<uint64_t> learned;
+  learned += (Bound<uint64_t>::closed(0),
+              Bound<uint64_t>::open(positions - 1));
+
+  EXPECT_EQ(learned, state->learned);
+  EXPECT_EQ(IntervalSet<uint64_t>(positions - 1), state->unlearned);
+
+  Try<Action> action = storage.read(positions - 1);
+  ASSERT_SOME(action);
+  EXPECT_FALSE(action->has_learned());
+}
+
+
 class ReplicaTest : public TemporaryDirectoryTest
 {
 protected:
@@ -572,6 +647,154 @@ TEST_F(ReplicaTest, NonVoting)
 }
 
 
+// This test verifies that with group commit enabled a replica only
+// acknowledges writes once the batch containing them is persisted,
+// which happens either when the window elapses or when the batch is
+// full.
+TEST_F(ReplicaTest, GroupCommit)
+{
+  const string path = os::getcwd() + "/.log";
+  initializer.flags.path = path;
+  ASSERT_SOME(initializer.execute());
+
+  const Duration window = Seconds(1);
+  const size_t maxActions = 4;
+
+  Replica replica(path, Log::GroupCommit{window, maxActions});
+
+  const uint64_t proposal = 1;
+
+  PromiseRequest promiseRequest;
+  promiseRequest.set_proposal(proposal);
+
+  Future<PromiseResponse> promiseResponse =
+    protocol::promise(replica.pid(), promiseRequest);
+
+  AWAIT_READY(promiseResponse);
+  EXPECT_EQ(PromiseResponse::ACCEPT, promiseResponse->type());
+
+  auto write = [&](uint64_t position) {
+    WriteRequest request;
+    request.set_proposal(proposal);
+    request.set_position(position);
+    request.set_type(Action::APPEND);
+    request.mutable_append()->set_bytes(stringify(position));
+
+    return protocol::write(replica.pid(), request);
+  };
+
+  Clock::pause();
+
+  // Fewer writes than fit in a batch are held until the window ends.
+  list<Future<WriteResponse>> responses;
+  for (uint64_t position = 1; position < maxActions; position++) {
+    responses.push_back(write(position));
+  }
+
+  Clock::settle();
+
+  foreach (const Future<WriteResponse>& response, responses) {
+    EXPECT_TRUE(response.isPending());
+  }
+
+  Clock::advance(window);
+
+  foreach (const Future<WriteResponse>& response, responses) {
+    AWAIT_READY(response);
+    EXPECT_EQ(WriteResponse::ACCEPT, response->type());
+  }
+
+  // A full batch is persisted without waiting for the window.
+  responses.clear();
+  for (uint64_t position = maxActions; position < 2 * maxActions; position++) {
+    responses.push_back(write(position));
+  }
+
+  foreach (const Future<WriteResponse>& response, responses) {
+    AWAIT_READY(response);
+    EXPECT_EQ(WriteResponse::ACCEPT, response->type());
+  }
+
+  Clock::resume();
+
+  Future<list<Action>> actions = replica.read(1, 2 * maxActions - 1);
+
+  AWAIT_READY(actions);
+  ASSERT_EQ(2 * maxActions - 1, actions->size());
+
+  foreach (const Action& action, actions.get()) {
+    ASSERT_TRUE(action.has_type());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+}
+
+
+class Replica_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t>
+{
+protected:
+  tool::Initialize initializer;
+};
+
+
+// The replica benchmark is parameterized by the maximum number of
+// actions in a group commit; 1 persists every write on its own.
+INSTANTIATE_TEST_CASE_P(
+    GroupCommitMaxActions,
+    Replica_BENCHMARK_Test,
+    ::testing::Values(1U, 8U, 64U, 256U));
+
+
+// Measures the throughput of concurrent writes to a single replica,
+// each of which has to be durable before it is acknowledged.
+TEST_P(Replica_BENCHMARK_Test, ConcurrentWrites)
+{
+  const string path = os::getcwd() + "/.log";
+  initializer.flags.path = path;
+  ASSERT_SOME(initializer.execute());
+
+  const size_t maxActions = GetParam();
+
+  Option<Log::GroupCommit> groupCommit;
+  if (maxActions > 1) {
+    groupCommit = Log::GroupCommit{Milliseconds(1), maxActions};
+  }
+
+  Replica replica(path, groupCommit);
+
+  const uint64_t proposal = 1;
+
+  PromiseRequest promiseRequest;
+  promiseRequest.set_proposal(proposal);
+
+  AWAIT_READY(protocol::promise(replica.pid(), promiseRequest));
+
+  const uint64_t writes = 4096;
+  const string bytes(1024, 'x');
+
+  Stopwatch watch;
+  watch.start();
+
+  list<Future<WriteResponse>> responses;
+  for (uint64_t position = 1; position <= writes; position++) {
+    WriteRequest request;
+    request.set_proposal(proposal);
+    request.set_position(position);
+    request.set_type(Action::APPEND);
+    request.mutable_append()->set_bytes(bytes);
+
+    responses.push_back(protocol::write(replica.pid(), request));
+  }
+
+  AWAIT_READY_FOR(collect(responses), Minutes(5));
+
+  cout << "Persisted " << writes << " writes with at most " << maxActions
+       << " per sync in " << watch.elapsed() << endl;
+}
+
+
 class CoordinatorTest : public TemporaryDirectoryTest
 {
 protected:
@@ -1205,6 +1428,127 @@ TEST_F(CoordinatorTest, MultipleAppends)
 }
 
 
+// This test verifies that a coordinator with a window keeps several
+// appends in flight and completes them in order of their positions.
+TEST_F(CoordinatorTest, PipelinedAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network, 4);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  list<Future<Option<uint64_t>>> appends;
+  for (uint64_t position = 1; position <= 10; position++) {
+    appends.push_back(coord.append(stringify(position)));
+  }
+
+  // An explicit batch is appended after the individual entries.
+  vector<string> batch = {"11", "12", "13"};
+  Future<Option<uint64_t>> appending = coord.append(batch);
+
+  uint64_t position = 1;
+  foreach (const Future<Option<uint64_t>>& append, appends) {
+    AWAIT_READY(append);
+    EXPECT_SOME_EQ(position++, append.get());
+  }
+
+  AWAIT_READY(appending);
+  EXPECT_SOME_EQ(13u, appending.get());
+
+  {
+    Future<list<Action>> actions = replica1->read(1, 13);
+    AWAIT_READY(actions);
+    EXPECT_EQ(13u, actions->size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
+class Coordinator_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t>
+{
+protected:
+  tool::Initialize initializer;
+};
+
+
+// The coordinator benchmark is parameterized by the number of writes
+// the coordinator keeps in flight.
+INSTANTIATE_TEST_CASE_P(
+    Window,
+    Coordinator_BENCHMARK_Test,
+    ::testing::Values(1U, 4U, 16U, 64U));
+
+
+// Measures the throughput of appends to a log with three replicas in
+// this process, all of which are issued up front.
+TEST_P(Coordinator_BENCHMARK_Test, Appends)
+{
+  set<UPID> pids;
+  vector<Shared<Replica>> replicas;
+
+  for (int i = 0; i < 3; i++) {
+    const string path = os::getcwd() + "/.log" + stringify(i);
+    initializer.flags.path = path;
+    ASSERT_SOME(initializer.execute());
+
+    replicas.push_back(Shared<Replica>(new Replica(path)));
+    pids.insert(replicas.back()->pid());
+  }
+
+  Shared<Network> network(new Network(pids));
+
+  const size_t window = GetParam();
+
+  Coordinator coord(2, replicas.front(), network, window);
+
+  Future<Option<uint64_t>> electing = coord.elect();
+  AWAIT_READY(electing);
+  ASSERT_SOME(electing.get());
+
+  const size_t appends = 1000;
+  const string bytes(1024, 'x');
+
+  Stopwatch watch;
+  watch.start();
+
+  list<Future<Option<uint64_t>>> appending;
+  for (size_t i = 0; i < appends; i++) {
+    appending.push_back(coord.append(bytes));
+  }
+
+  AWAIT_READY_FOR(collect(appending), Minutes(5));
+
+  cout << "Appended " << appends << " entries with up to " << window
+       << " in flight in " << watch.elapsed() << endl;
+}
+
+
 TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -56,6 +56,8 @@ using google::protobuf::RepeatedPtrField;
 
 using mesos::allocator::Allocator;
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+using mesos::internal::master::allocator::HierarchicalIncrementalDRFAllocator;
+using mesos::internal::master::allocator::HierarchicalParallelDRFAllocator;
 
 using mesos::internal::master::Master;
 
@@ -148,6 +150,8 @@ template <typename T>
 class MasterAllocatorTest : public MesosTest {};
 
 typedef ::testing::Types<HierarchicalDRFAllocator,
+                         HierarchicalIncrementalDRFAllocator,
+                         HierarchicalParallelDRFAllocator,
                          tests::Module<Allocator, TestDRFAllocator>>
   AllocatorTypes;
 
@@ -50,6 +50,7 @@
 #include "common/protobuf_utils.hpp"
 
 #include "master/flags.hpp"
+#include "master/lemon_MILP_bt.hpp"
 #include "master/master.hpp"
 
 #include "master/allocator/mesos/allocator.hpp"
@@ -73,6 +74,9 @@
 #include "tests/resources_utils.hpp"
 #include "tests/utils.hpp"
 
+using chameleon::BTLinearModel;
+using chameleon::MILPSolverProcess;
+
 using mesos::internal::master::Master;
 
 using mesos::internal::master::allocator::MesosAllocatorProcess;
@@ -104,6 +108,7 @@ using process::http::OK;
 using process::http::Response;
 using process::http::Unauthorized;
 
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -4289,6 +4294,252 @@ TEST_F(MasterTest, StateEndpointAgentCapabilities)
 }
 
 
+// This test ensures that the master's /state endpoint tags its
+// responses, answers conditional requests for an unchanged state with
+// `304 Not Modified`, and serves the state as protobuf on request.
+TEST_F(MasterTest, StateEndpointEntityTag)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_EQ(1u, response->headers.count("ETag"));
+
+  const string etag = response->headers.at("ETag");
+
+  process::http::Headers headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+  headers["If-None-Match"] = etag;
+
+  response = process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Response(process::http::Status::NOT_MODIFIED).status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(etag, "ETag", response);
+
+  // Registering an agent changes the state, hence its entity tag.
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get()->pid, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  response = process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_EQ(1u, response->headers.count("ETag"));
+  EXPECT_NE(etag, response->headers.at("ETag"));
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> slaves = parse->find<JSON::Array>("slaves");
+  ASSERT_SOME(slaves);
+  EXPECT_EQ(1u, slaves->values.size());
+
+  // The protobuf representation is the response to `GET_STATE`.
+  headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+  headers["Accept"] = APPLICATION_PROTOBUF;
+
+  response = process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      APPLICATION_PROTOBUF, "Content-Type", response);
+
+  Try<v1::master::Response> state =
+    deserialize<v1::master::Response>(ContentType::PROTOBUF, response->body);
+
+  ASSERT_SOME(state);
+  ASSERT_EQ(v1::master::Response::GET_STATE, state->type());
+  ASSERT_EQ(1, state->get_state().get_agents().agents_size());
+  EXPECT_EQ(
+      evolve(slaveRegisteredMessage->slave_id()),
+      state->get_state().get_agents().agents(0).agent_info().id());
+}
+
+
+// This test ensures that the master's /state endpoint, which is only
+// updated with the parts of the state that changed, reflects changes
+// to each of them: the global fields, the agents, the frameworks,
+// their tasks, their finished tasks and the completed frameworks.
+TEST_F(MasterTest, StateEndpointSectionChanges)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Option<string> etag;
+
+  // Returns the current state, expecting it to have a different
+  // entity tag than the previous one.
+  auto state = [&master, &etag]() -> Try<JSON::Object> {
+    Future<Response> response = process::http::get(
+        master.get()->pid,
+        "state",
+        None(),
+        createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+    response.await(Seconds(15));
+
+    if (!response.isReady() || response->status != OK().status) {
+      return Error("Failed to get the state");
+    }
+
+    if (response->headers.count("ETag") != 1) {
+      return Error("Missing entity tag");
+    }
+
+    if (etag == response->headers.at("ETag")) {
+      return Error("Unchanged entity tag " + etag.get());
+    }
+
+    etag = response->headers.at("ETag");
+
+    return JSON::parse<JSON::Object>(response->body);
+  };
+
+  Try<JSON::Object> parse = state();
+  ASSERT_SOME(parse);
+
+  ASSERT_SOME_EQ(0u, parse->find<JSON::Number>("activated_slaves"));
+  EXPECT_NONE(parse->find<JSON::Object>("slaves[0]"));
+
+  // Adding an agent changes the agents and the global fields.
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get()->pid, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), &containerizer);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  parse = state();
+  ASSERT_SOME(parse);
+
+  ASSERT_SOME_EQ(1u, parse->find<JSON::Number>("activated_slaves"));
+  ASSERT_SOME_EQ(
+      JSON::String(slaveRegisteredMessage->slave_id().value()),
+      parse->find<JSON::String>("slaves[0].id"));
+
+  // Adding a framework changes the frameworks.
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+  AWAIT_READY(offers);
+  ASSERT_FALSE(offers->empty());
+
+  parse = state();
+  ASSERT_SOME(parse);
+
+  ASSERT_SOME_EQ(
+      JSON::String(frameworkId->value()),
+      parse->find<JSON::String>("frameworks[0].id"));
+
+  // Launching a task changes the tasks, the framework and the agent.
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status->state());
+
+  parse = state();
+  ASSERT_SOME(parse);
+
+  ASSERT_SOME_EQ(
+      JSON::String("TASK_RUNNING"),
+      parse->find<JSON::String>("frameworks[0].tasks[0].state"));
+  ASSERT_SOME_EQ(
+      JSON::String(DEFAULT_EXECUTOR_ID.value()),
+      parse->find<JSON::String>("frameworks[0].executors[0].executor_id"));
+
+  Result<JSON::Number> cpus =
+    parse->find<JSON::Number>("slaves[0].used_resources.cpus");
+
+  ASSERT_SOME(cpus);
+  EXPECT_LT(0.0, cpus->as<double>());
+
+  // Killing the task moves it to the framework's finished tasks.
+  EXPECT_CALL(exec, killTask(_, _))
+    .WillOnce(SendStatusUpdateFromTaskID(TASK_KILLED));
+
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  Future<Nothing> statusUpdateAcknowledgement =
+    FUTURE_DISPATCH(_, &Slave::_statusUpdateAcknowledgement);
+
+  driver.killTask(task.task_id());
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_KILLED, status->state());
+
+  AWAIT_READY(statusUpdateAcknowledgement);
+
+  parse = state();
+  ASSERT_SOME(parse);
+
+  EXPECT_NONE(parse->find<JSON::Object>("frameworks[0].tasks[0]"));
+  ASSERT_SOME_EQ(
+      JSON::String("TASK_KILLED"),
+      parse->find<JSON::String>("frameworks[0].completed_tasks[0].state"));
+
+  // Removing the framework moves it to the completed frameworks.
+  Future<ShutdownFrameworkMessage> shutdownFrameworkMessage =
+    FUTURE_PROTOBUF(ShutdownFrameworkMessage(), _, _);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  AWAIT_READY(shutdownFrameworkMessage);
+
+  parse = state();
+  ASSERT_SOME(parse);
+
+  EXPECT_NONE(parse->find<JSON::Object>("frameworks[0]"));
+  ASSERT_SOME_EQ(
+      JSON::String(frameworkId->value()),
+      parse->find<JSON::String>("completed_frameworks[0].id"));
+}
+
+
 // This ensures allocation role of task and its executor is exposed
 // in master's /state endpoint.
 TEST_F(MasterTest, StateEndpointAllocationRole)
@@ -7093,6 +7344,181 @@ TEST_F(MasterTest, IgnoreOldAgentReregistration)
   Clock::settle();
 }
 
+
+// Tests that the MILP solver keeps its model between solves: the
+// columns of a BT workload are added when it joins the problem, kept
+// while it stays and erased only once it leaves.
+TEST_F(MasterTest, MILPSolverReusesModel)
+{
+  MILPSolverProcess solver(MILPSolverProcess::Strategy::MILP);
+  PID<MILPSolverProcess> pid = process::spawn(solver);
+
+  Future<vector<BTLinearModel>> models = process::dispatch(
+      pid,
+      &MILPSolverProcess::repartition,
+      "repartition",
+      10,
+      10240,
+      vector<string>({"LDA", "TeraSort"}));
+
+  AWAIT_READY(models);
+
+  Future<Option<pair<int, int>>> lda =
+    process::dispatch(pid, &MILPSolverProcess::columns, "LDA");
+
+  Future<Option<pair<int, int>>> terasort =
+    process::dispatch(pid, &MILPSolverProcess::columns, "TeraSort");
+
+  AWAIT_READY(lda);
+  AWAIT_READY(terasort);
+  ASSERT_SOME(lda.get());
+  ASSERT_SOME(terasort.get());
+
+  // Solving again for the same workloads only rewrites the rows, so
+  // the next solve is warm-started from the columns of the last one.
+  models = process::dispatch(
+      pid,
+      &MILPSolverProcess::repartition,
+      "repartition",
+      12,
+      8192,
+      vector<string>({"LDA", "TeraSort"}));
+
+  AWAIT_READY(models);
+
+  Future<Option<pair<int, int>>> lda2 =
+    process::dispatch(pid, &MILPSolverProcess::columns, "LDA");
+
+  Future<Option<pair<int, int>>> terasort2 =
+    process::dispatch(pid, &MILPSolverProcess::columns, "TeraSort");
+
+  AWAIT_READY(lda2);
+  AWAIT_READY(terasort2);
+  EXPECT_EQ(lda.get(), lda2.get());
+  EXPECT_EQ(terasort.get(), terasort2.get());
+
+  // Replacing a workload only erases its own columns.
+  models = process::dispatch(
+      pid,
+      &MILPSolverProcess::repartition,
+      "repartition",
+      10,
+      10240,
+      vector<string>({"LDA", "SVM"}));
+
+  AWAIT_READY(models);
+
+  Future<Option<pair<int, int>>> lda3 =
+    process::dispatch(pid, &MILPSolverProcess::columns, "LDA");
+
+  Future<Option<pair<int, int>>> terasort3 =
+    process::dispatch(pid, &MILPSolverProcess::columns, "TeraSort");
+
+  Future<Option<pair<int, int>>> svm =
+    process::dispatch(pid, &MILPSolverProcess::columns, "SVM");
+
+  AWAIT_READY(lda3);
+  AWAIT_READY(terasort3);
+  AWAIT_READY(svm);
+  EXPECT_EQ(lda.get(), lda3.get());
+  EXPECT_NONE(terasort3.get());
+  EXPECT_SOME(svm.get());
+
+  process::terminate(solver);
+  process::wait(solver);
+}
+
+
+// Tests that a BT framework is held inactive, and therefore gets no
+// offers, until the resources have been repartitioned across the BT
+// frameworks in `Master::_repartition`.
+TEST_F(MasterTest, RepartitionActivatesBTFrameworks)
+{
+  Clock::pause();
+
+  master::Flags masterFlags = CreateMasterFlags();
+  Try<Owned<cluster::Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+
+  // Start two agents so that each framework gets offered one of them
+  // in the same allocation cycle.
+  Try<Owned<cluster::Slave>> slave1 = StartSlave(detector.get());
+  ASSERT_SOME(slave1);
+
+  Try<Owned<cluster::Slave>> slave2 = StartSlave(detector.get());
+  ASSERT_SOME(slave2);
+
+  FrameworkInfo frameworkInfo1 = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo1.set_name("WordCount");
+
+  MockScheduler sched1;
+  MesosSchedulerDriver driver1(
+      &sched1, frameworkInfo1, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered1;
+  EXPECT_CALL(sched1, registered(&driver1, _, _))
+    .WillOnce(FutureSatisfy(&registered1));
+
+  // The first BT framework is not added to the allocator yet.
+  EXPECT_CALL(sched1, resourceOffers(&driver1, _))
+    .Times(0);
+
+  driver1.start();
+
+  Clock::settle();
+
+  AWAIT_READY(registered1);
+
+  Clock::advance(masterFlags.allocation_interval);
+  Clock::settle();
+
+  FrameworkInfo frameworkInfo2 = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo2.set_name("TeraSort");
+
+  MockScheduler sched2;
+  MesosSchedulerDriver driver2(
+      &sched2, frameworkInfo2, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered2;
+  EXPECT_CALL(sched2, registered(&driver2, _, _))
+    .WillOnce(FutureSatisfy(&registered2));
+
+  Future<vector<Offer>> offers1;
+  EXPECT_CALL(sched1, resourceOffers(&driver1, _))
+    .WillOnce(FutureArg<1>(&offers1))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<vector<Offer>> offers2;
+  EXPECT_CALL(sched2, resourceOffers(&driver2, _))
+    .WillOnce(FutureArg<1>(&offers2))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  // With the second BT framework registered the solver repartitions
+  // the resources and both frameworks are activated.
+  driver2.start();
+
+  Clock::settle();
+
+  AWAIT_READY(registered2);
+
+  Clock::advance(masterFlags.allocation_interval);
+  Clock::settle();
+
+  AWAIT_READY(offers1);
+  EXPECT_NE(0u, offers1->size());
+
+  AWAIT_READY(offers2);
+  EXPECT_NE(0u, offers2->size());
+
+  driver1.stop();
+  driver1.join();
+
+  driver2.stop();
+  driver2.join();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -57,6 +57,8 @@
 #include "master/registrar.hpp"
 #include "master/weights.hpp"
 
+#include "messages/log.hpp"
+
 #include "tests/mesos.hpp"
 
 using namespace mesos::internal::master;
@@ -66,6 +68,7 @@ using namespace process;
 using mesos::log::Log;
 
 using mesos::internal::log::Replica;
+using mesos::internal::log::WriteRequest;
 
 using std::cout;
 using std::endl;
@@ -1068,6 +1071,143 @@ TEST_F(RegistrarTest, Bootstrap)
 }
 
 
+// Tests that the registrar recovers the operations which were only
+// persisted as deltas, and that it compacts them upon recovery.
+TEST_F(RegistrarTest, RecoverDeltas)
+{
+  vector<SlaveInfo> infos;
+  for (int i = 1; i <= 3; i++) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(stringify(i));
+    infos.push_back(info);
+  }
+
+  // Run 1 admits the agents, marks the first one unreachable and
+  // removes the second one. We do not wait for the operations in
+  // between, so that several stores are in flight.
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    foreach (const SlaveInfo& info, infos) {
+      registrar.apply(Owned<Operation>(new AdmitSlave(info)));
+    }
+
+    registrar.apply(
+        Owned<Operation>(
+            new MarkSlaveUnreachable(infos[0], protobuf::getCurrentTime())));
+
+    AWAIT_TRUE(
+        registrar.apply(Owned<Operation>(new RemoveSlave(infos[1]))));
+  }
+
+  // Runs 2 and 3 should see the same agents, run 3 only recovers the
+  // full registry stored by run 2.
+  for (int run = 2; run <= 3; run++) {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(1, registry->slaves().slaves().size());
+    EXPECT_EQ(infos[2], registry->slaves().slaves(0).info());
+
+    ASSERT_EQ(1, registry->unreachable().slaves().size());
+    EXPECT_EQ(infos[0].id(), registry->unreachable().slaves(0).id());
+  }
+}
+
+
+// Tests that an agent that becomes unreachable and then reachable again
+// with a new SlaveInfo, without waiting in between, is recovered with
+// the new SlaveInfo from the stored deltas.
+TEST_F(RegistrarTest, RecoverDeltasReachable)
+{
+  vector<SlaveInfo> infos;
+  for (int i = 1; i <= 3; i++) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(stringify(i));
+    infos.push_back(info);
+  }
+
+  SlaveInfo reregistered = infos[0];
+  reregistered.set_hostname("remotehost");
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(infos[0]))));
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(infos[1]))));
+
+    registrar.apply(
+        Owned<Operation>(
+            new MarkSlaveUnreachable(infos[0], protobuf::getCurrentTime())));
+
+    registrar.apply(Owned<Operation>(new AdmitSlave(infos[2])));
+
+    AWAIT_TRUE(
+        registrar.apply(Owned<Operation>(new MarkSlaveReachable(reregistered))));
+  }
+
+  Registrar registrar(flags, state);
+
+  Future<Registry> registry = registrar.recover(master);
+  AWAIT_READY(registry);
+
+  ASSERT_EQ(3, registry->slaves().slaves().size());
+  EXPECT_EQ(infos[1], registry->slaves().slaves(0).info());
+  EXPECT_EQ(infos[2], registry->slaves().slaves(1).info());
+  EXPECT_EQ(reregistered, registry->slaves().slaves(2).info());
+
+  EXPECT_EQ(0, registry->unreachable().slaves().size());
+}
+
+
+// Tests that the stores of concurrent registrar operations are written
+// to the replicated log together when the log storage is given a write
+// window larger than 1.
+TEST_F(RegistrarTest, WriteWindow)
+{
+  LogStorage storage(log, 0, MAX_REGISTRY_STORES_IN_FLIGHT);
+  State state(&storage);
+
+  Registrar registrar(flags, &state);
+  AWAIT_READY(registrar.recover(master));
+
+  SlaveInfo info1 = slave;
+
+  SlaveInfo info2;
+  info2.set_hostname("localhost");
+  info2.mutable_id()->set_value("2");
+
+  // Hold back the write of the first store at the second replica so
+  // that it cannot complete. The write of the second store must still
+  // be sent (expectations are matched in reverse order).
+  Future<WriteRequest> write2 =
+    FUTURE_PROTOBUF(WriteRequest(), _, Eq(replica2->pid()));
+
+  Future<WriteRequest> write1 =
+    DROP_PROTOBUF(WriteRequest(), _, Eq(replica2->pid()));
+
+  Future<bool> admit1 =
+    registrar.apply(Owned<Operation>(new AdmitSlave(info1)));
+
+  AWAIT_READY(write1);
+
+  Future<bool> admit2 =
+    registrar.apply(Owned<Operation>(new AdmitSlave(info2)));
+
+  AWAIT_READY(write2);
+  EXPECT_LT(write1->position(), write2->position());
+
+  EXPECT_TRUE(admit1.isPending());
+  EXPECT_TRUE(admit2.isPending());
+}
+
+
 class MockStorage : public Storage
 {
 public:
@@ -1371,6 +1511,79 @@ TEST_P(Registrar_BENCHMARK_Test, MarkUnreachableThenReachable)
 }
 
 
+// Test the performance of a small fraction of the registered slaves
+// repeatedly becoming unreachable and reachable again, which should
+// not depend on the total number of slaves in the registry.
+TEST_P(Registrar_BENCHMARK_Test, FlappingAgents)
+{
+  Registrar registrar(flags, state);
+  AWAIT_READY(registrar.recover(master));
+
+  Attributes attributes = Attributes::parse("foo:bar;baz:quux");
+  Resources resources =
+    Resources::parse("cpus(*):1.0;mem(*):512;disk(*):2048").get();
+
+  size_t slaveCount = GetParam();
+
+  // Create slaves.
+  vector<SlaveInfo> infos;
+  for (size_t i = 0; i < slaveCount; ++i) {
+    // Simulate real slave information.
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(
+        string("201310101658-2280333834-5050-48574-") + stringify(i));
+    info.mutable_resources()->MergeFrom(resources);
+    info.mutable_attributes()->MergeFrom(attributes);
+    infos.push_back(info);
+  }
+
+  // Admit slaves.
+  Stopwatch watch;
+  watch.start();
+  Future<bool> result;
+  foreach (const SlaveInfo& info, infos) {
+    result = registrar.apply(Owned<Operation>(new AdmitSlave(info)));
+  }
+  AWAIT_READY_FOR(result, Minutes(5));
+  LOG(INFO) << "Admitted " << slaveCount << " agents in " << watch.elapsed();
+
+  // Flap 100 randomly chosen slaves 10 times.
+  std::random_shuffle(infos.begin(), infos.end());
+
+  const size_t flappingCount = std::min<size_t>(100, slaveCount);
+  const size_t rounds = 10;
+
+  watch.start();
+  for (size_t round = 0; round < rounds; round++) {
+    TimeInfo unreachableTime = protobuf::getCurrentTime();
+
+    for (size_t i = 0; i < flappingCount; i++) {
+      result = registrar.apply(
+          Owned<Operation>(
+              new MarkSlaveUnreachable(infos[i], unreachableTime)));
+    }
+
+    for (size_t i = 0; i < flappingCount; i++) {
+      result = registrar.apply(
+          Owned<Operation>(new MarkSlaveReachable(infos[i])));
+    }
+  }
+  AWAIT_READY_FOR(result, Minutes(5));
+  cout << "Flapped " << flappingCount << " of " << slaveCount
+       << " agents " << rounds << " times in " << watch.elapsed() << endl;
+
+  // Recover slaves, which also applies the deltas stored since the
+  // last compaction.
+  Registrar registrar2(flags, state);
+  watch.start();
+  Future<Registry> registry = registrar2.recover(master);
+  AWAIT_READY(registry);
+  cout << "Recovered " << slaveCount << " agents ("
+       << Bytes(registry->ByteSize()) << ") in " << watch.elapsed() << endl;
+}
+
+
 // Test the performance of garbage collecting a large portion of the
 // unreachable list in a single operation. We use a fixed percentage
 // at the moment (50%).
@@ -1138,6 +1138,52 @@ TEST(ResourcesTest, ScalarSubtraction2)
 }
 
 
+// Checks that unreserved scalars are only combined with scalars that
+// have the same name and allocation, and never with reserved,
+// revocable or allocated scalars of the same name.
+TEST(ResourcesTest, ScalarArithmeticMixedMetadata)
+{
+  Resource cpus = Resources::parse("cpus", "1", "*").get();
+
+  Resource reserved = Resources::parse("cpus", "2", "role1").get();
+
+  Resource revocable = Resources::parse("cpus", "4", "*").get();
+  revocable.mutable_revocable();
+
+  Resource allocated = Resources::parse("cpus", "8", "*").get();
+  allocated.mutable_allocation_info()->set_role("role1");
+
+  Resources r;
+  r += cpus;
+  r += reserved;
+  r += revocable;
+  r += allocated;
+  r += cpus;
+
+  EXPECT_EQ(4u, r.size());
+  EXPECT_SOME_EQ(16.0, r.cpus());
+  EXPECT_SOME_EQ(2.0, r.unreserved().nonRevocable().filter(
+      [](const Resource& resource) {
+        return !resource.has_allocation_info();
+      }).cpus());
+
+  EXPECT_TRUE(r.contains(cpus));
+  EXPECT_TRUE(r.contains(allocated));
+  EXPECT_FALSE(r.contains(Resources(cpus) + cpus + cpus));
+
+  r -= allocated;
+  r -= cpus;
+
+  EXPECT_EQ(3u, r.size());
+  EXPECT_SOME_EQ(7.0, r.cpus());
+  EXPECT_FALSE(r.contains(allocated));
+
+  r -= cpus;
+
+  EXPECT_EQ(Resources(reserved) + revocable, r);
+}
+
+
 TEST(ResourcesTest, RangesEquals)
 {
   Resource ports1 = Resources::parse(
@@ -3118,10 +3164,18 @@ public:
     shared.resources = Resources::parse("cpus:1;mem:128").get() + disk;
     shared.totalOperations = 50000;
 
+    // Test a typical vector of scalars allocated to a role, as used
+    // throughout the allocator.
+    ScalarArithmeticParameter allocated;
+    allocated.resources = scalars.resources;
+    allocated.resources.allocate("role1");
+    allocated.totalOperations = 50000;
+
     parameters_.push_back(std::move(scalars));
     parameters_.push_back(std::move(reservations));
     parameters_.push_back(std::move(ranges));
     parameters_.push_back(std::move(shared));
+    parameters_.push_back(std::move(allocated));
 
     return parameters_;
   }
@@ -3204,6 +3258,58 @@ TEST_P(Resources_Scalar_Arithmetic_BENCHMARK_Test, Arithmetic)
 }
 
 
+// Measures arithmetic with individual `Resource` objects, e.g., when
+// summing up the resources of an offer or a task.
+TEST_P(Resources_Scalar_Arithmetic_BENCHMARK_Test, SingleResourceArithmetic)
+{
+  const Resources& resources = GetParam().resources;
+  size_t totalOperations = GetParam().totalOperations;
+
+  Resources total;
+  Stopwatch watch;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    foreach (const Resource& resource, resources) {
+      total += resource;
+    }
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed()
+       << " to perform " << totalOperations << " 'total += r' operations"
+       << " on each Resource of " << abbreviate(stringify(resources), 50)
+       << endl;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    foreach (const Resource& resource, resources) {
+      total -= resource;
+    }
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed()
+       << " to perform " << totalOperations << " 'total -= r' operations"
+       << " on each Resource of " << abbreviate(stringify(resources), 50)
+       << endl;
+
+  ASSERT_TRUE(total.empty()) << total;
+
+  total = resources;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    total.contains(resources);
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed()
+       << " to perform " << totalOperations << " 'total.contains(r)'"
+       << " operations on " << abbreviate(stringify(resources), 50) << endl;
+}
+
+
 class Resources_Filter_BENCHMARK_Test : public ::testing::Test {};
 
 
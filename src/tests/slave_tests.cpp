@@ -4072,6 +4072,115 @@ TEST_F(SlaveTest, ContainerizerUsageFailure)
 }
 
 
+// This test verifies that the agent reuses the statistics of a
+// container for `--container_usage_interval`.
+TEST_F(SlaveTest, ContainerUsageInterval)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+  StandaloneMasterDetector detector(master.get()->pid);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.container_usage_interval = Seconds(10);
+
+  MockSlave slave(flags, &detector, &containerizer);
+  spawn(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(_, _, _));
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  Future<vector<Offer>> offers;
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers->size());
+
+  const Offer& offer = offers.get()[0];
+
+  TaskInfo task = createTask(
+      offer.slave_id(),
+      Resources::parse("cpus:0.1;mem:32").get(),
+      SLEEP_COMMAND(1000),
+      exec.id);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offer.id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status->state());
+
+  Clock::pause();
+
+  ResourceStatistics statistics1;
+  statistics1.set_timestamp(Clock::now().secs());
+  statistics1.set_cpus_limit(1);
+
+  ResourceStatistics statistics2;
+  statistics2.set_timestamp(Clock::now().secs());
+  statistics2.set_cpus_limit(2);
+
+  EXPECT_CALL(containerizer, usage(_))
+    .WillOnce(Return(statistics1))
+    .WillOnce(Return(statistics2));
+
+  Future<ResourceUsage> usage = slave.usage();
+
+  AWAIT_READY(usage);
+  ASSERT_EQ(1, usage->executors_size());
+  ASSERT_TRUE(usage->executors(0).has_statistics());
+  EXPECT_EQ(1, usage->executors(0).statistics().cpus_limit());
+
+  // The statistics are reused within the interval.
+  Clock::advance(Seconds(5));
+
+  usage = slave.usage();
+
+  AWAIT_READY(usage);
+  ASSERT_EQ(1, usage->executors_size());
+  ASSERT_TRUE(usage->executors(0).has_statistics());
+  EXPECT_EQ(1, usage->executors(0).statistics().cpus_limit());
+
+  // And collected again after the interval.
+  Clock::advance(Seconds(5));
+
+  usage = slave.usage();
+
+  AWAIT_READY(usage);
+  ASSERT_EQ(1, usage->executors_size());
+  ASSERT_TRUE(usage->executors(0).has_statistics());
+  EXPECT_EQ(2, usage->executors(0).statistics().cpus_limit());
+
+  Clock::resume();
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  terminate(slave);
+  wait(slave);
+}
+
+
 // This test verifies that DiscoveryInfo and Port messages, set in TaskInfo,
 // are exposed over the slave state endpoint. The test launches a task with
 // the DiscoveryInfo and Port message fields populated. It then makes an HTTP
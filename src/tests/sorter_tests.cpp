@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include <iostream>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -30,6 +31,8 @@
 #include "tests/resources_utils.hpp"
 
 using mesos::internal::master::allocator::DRFSorter;
+using mesos::internal::master::allocator::IncrementalDRFSorter;
+using mesos::internal::master::allocator::Sorter;
 
 using std::cout;
 using std::endl;
@@ -873,6 +876,41 @@ TEST(SorterTest, RemoveLeafCollapseParentInactive)
 }
 
 
+// This test checks that when removing a client collapses an internal
+// node into an inactive leaf, the inactive leaf does not hide its
+// active siblings, even if it had a smaller share than they do.
+TEST(SorterTest, RemoveLeafCollapseParentInactiveSmallerShare)
+{
+  DRFSorter sorter;
+
+  SlaveID slaveId;
+  slaveId.set_value("agentId");
+
+  sorter.add(slaveId, Resources::parse("cpus:100;mem:100").get());
+
+  sorter.add("a");
+  sorter.activate("a");
+  sorter.allocated(
+      "a", slaveId, Resources::parse("cpus:1;mem:1").get());
+
+  sorter.add("b");
+  sorter.activate("b");
+  sorter.allocated(
+      "b", slaveId, Resources::parse("cpus:6;mem:6").get());
+
+  sorter.add("a/c");
+  sorter.activate("a/c");
+
+  sorter.deactivate("a");
+
+  EXPECT_EQ(vector<string>({"a/c", "b"}), sorter.sort());
+
+  sorter.remove("a/c");
+
+  EXPECT_EQ(vector<string>({"b"}), sorter.sort());
+}
+
+
 // This test checks that setting a weight on an internal node works
 // correctly.
 TEST(SorterTest, ChangeWeightOnSubtree)
@@ -1550,6 +1588,259 @@ TEST(SorterTest, RemoveSharedResources)
 }
 
 
+// This test checks that resources excluded from fair sharing do not
+// contribute to the dominant share of a client, including resources
+// that the sorter only sees after it has been initialized.
+TEST(SorterTest, FairnessExcludeResourceNames)
+{
+  DRFSorter sorter;
+  sorter.initialize(std::set<string>({"gpus"}));
+
+  SlaveID slaveId;
+  slaveId.set_value("agentId");
+
+  sorter.add(slaveId, Resources::parse("cpus:100;mem:100").get());
+
+  sorter.add("a");
+  sorter.activate("a");
+  sorter.allocated("a", slaveId, Resources::parse("cpus:5;mem:5").get());
+
+  sorter.add("b");
+  sorter.activate("b");
+  sorter.allocated("b", slaveId, Resources::parse("cpus:1;mem:1").get());
+
+  // shares: a = .05, b = .01
+  EXPECT_EQ(vector<string>({"b", "a"}), sorter.sort());
+
+  sorter.add(slaveId, Resources::parse("gpus:10").get());
+  sorter.allocated("b", slaveId, Resources::parse("gpus:10").get());
+
+  // shares: a = .05, b = .01 (gpus are excluded)
+  EXPECT_EQ(vector<string>({"b", "a"}), sorter.sort());
+
+  sorter.add(slaveId, Resources::parse("disk:100").get());
+  sorter.allocated("b", slaveId, Resources::parse("disk:10").get());
+
+  // shares: a = .05, b = .10
+  EXPECT_EQ(vector<string>({"a", "b"}), sorter.sort());
+}
+
+
+// This test checks that the incremental DRF sorter repositions the
+// clients whose allocations changed, including clients in nested
+// roles, without requiring a full resort of the tree.
+TEST(SorterTest, IncrementalDRFSorter)
+{
+  IncrementalDRFSorter sorter;
+
+  SlaveID slaveId;
+  slaveId.set_value("agentId");
+
+  sorter.add(slaveId, Resources::parse("cpus:100;mem:100").get());
+
+  sorter.add("a");
+  sorter.activate("a");
+  sorter.allocated("a", slaveId, Resources::parse("cpus:5;mem:5").get());
+
+  sorter.add("b/c");
+  sorter.activate("b/c");
+  sorter.allocated("b/c", slaveId, Resources::parse("cpus:3;mem:3").get());
+
+  sorter.add("b/d");
+  sorter.activate("b/d");
+  sorter.allocated("b/d", slaveId, Resources::parse("cpus:1;mem:1").get());
+
+  // shares: a = .05, b = .04 (b/c = .03, b/d = .01)
+  EXPECT_EQ(vector<string>({"b/d", "b/c", "a"}), sorter.sort());
+
+  sorter.allocated("b/d", slaveId, Resources::parse("cpus:3;mem:3").get());
+
+  // shares: a = .05, b = .07 (b/c = .03, b/d = .04)
+  EXPECT_EQ(vector<string>({"a", "b/c", "b/d"}), sorter.sort());
+
+  sorter.unallocated("a", slaveId, Resources::parse("cpus:5;mem:5").get());
+  sorter.add("e");
+  sorter.activate("e");
+  sorter.allocated("e", slaveId, Resources::parse("cpus:2;mem:2").get());
+
+  // shares: a = 0, b = .07, e = .02
+  EXPECT_EQ(vector<string>({"a", "e", "b/c", "b/d"}), sorter.sort());
+
+  sorter.deactivate("a");
+
+  EXPECT_EQ(vector<string>({"e", "b/c", "b/d"}), sorter.sort());
+
+  sorter.allocated("a", slaveId, Resources::parse("cpus:10;mem:10").get());
+  sorter.activate("a");
+
+  // shares: a = .10, b = .07, e = .02
+  EXPECT_EQ(vector<string>({"e", "b/c", "b/d", "a"}), sorter.sort());
+
+  // Changing the total resources changes all shares.
+  sorter.add(slaveId, Resources::parse("cpus:0;mem:100").get());
+  sorter.allocated("e", slaveId, Resources::parse("cpus:0;mem:20").get());
+
+  // shares: a = .10, b = .07, e = .11
+  EXPECT_EQ(vector<string>({"b/c", "b/d", "a", "e"}), sorter.sort());
+
+  sorter.remove("b/c");
+
+  // shares: a = .10, b = .04, e = .11
+  EXPECT_EQ(vector<string>({"b/d", "a", "e"}), sorter.sort());
+}
+
+
+// This test checks that the incremental DRF sorter produces the same
+// order as the DRF sorter under a sequence of (deterministic) client,
+// activation and allocation changes interleaved with sorts.
+TEST(SorterTest, IncrementalDRFSorterMatchesDRFSorter)
+{
+  DRFSorter drfSorter;
+  IncrementalDRFSorter incrementalSorter;
+
+  vector<Sorter*> sorters = {&drfSorter, &incrementalSorter};
+
+  SlaveID slaveId;
+  slaveId.set_value("agentId");
+
+  foreach (Sorter* sorter, sorters) {
+    sorter->add(slaveId, Resources::parse("cpus:1000;mem:1000").get());
+  }
+
+  const vector<string> clients = {
+    "a", "b", "a/b", "a/c", "a/c/d", "e/f", "e/g", "e", "h"};
+
+  foreach (Sorter* sorter, sorters) {
+    foreach (const string& client, clients) {
+      sorter->add(client);
+      sorter->activate(client);
+    }
+  }
+
+  for (size_t i = 0; i < 200; i++) {
+    const string& client = clients[(i * 7) % clients.size()];
+
+    const Resources resources = Resources::parse(
+        "cpus:" + stringify(i % 5 + 1) + ";mem:" + stringify(i % 3 + 1)).get();
+
+    foreach (Sorter* sorter, sorters) {
+      sorter->allocated(client, slaveId, resources);
+
+      if (i % 11 == 0) {
+        sorter->unallocated(client, slaveId, resources);
+      }
+
+      if (i % 13 == 0) {
+        sorter->deactivate(client);
+      } else if (i % 5 == 0) {
+        sorter->activate(clients[i % clients.size()]);
+      }
+    }
+
+    if (i % 3 == 0) {
+      EXPECT_EQ(drfSorter.sort(), incrementalSorter.sort());
+    }
+  }
+
+  // Removing clients collapses internal nodes back into leaves.
+  foreach (Sorter* sorter, sorters) {
+    sorter->remove("a/c/d");
+    sorter->remove("e/f");
+    sorter->remove("a/b");
+  }
+
+  EXPECT_EQ(drfSorter.sort(), incrementalSorter.sort());
+}
+
+
+// Returns the client paths that `order()` points to.
+static vector<string> order(Sorter* sorter)
+{
+  vector<string> result;
+
+  foreach (const string* clientPath, sorter->order()) {
+    result.push_back(*clientPath);
+  }
+
+  return result;
+}
+
+
+// This test checks that `order()` matches `sort()` and that it is
+// only rebuilt after a change that can affect it.
+TEST(SorterTest, Order)
+{
+  DRFSorter drfSorter;
+  IncrementalDRFSorter incrementalSorter;
+
+  vector<DRFSorter*> sorters = {&drfSorter, &incrementalSorter};
+
+  SlaveID slaveId;
+  slaveId.set_value("agentId");
+
+  foreach (DRFSorter* sorter, sorters) {
+    sorter->add(slaveId, Resources::parse("cpus:100;mem:100").get());
+
+    sorter->add("a");
+    sorter->activate("a");
+    sorter->allocated("a", slaveId, Resources::parse("cpus:5;mem:5").get());
+
+    sorter->add("b/c");
+    sorter->activate("b/c");
+    sorter->allocated("b/c", slaveId, Resources::parse("cpus:3;mem:3").get());
+
+    // shares: a = .05, b/c = .03
+    EXPECT_EQ(vector<string>({"b/c", "a"}), order(sorter));
+    EXPECT_EQ(sorter->sort(), order(sorter));
+
+    // Without any changes, the order is not rebuilt.
+    size_t rebuilds = sorter->rebuilds();
+    sorter->order();
+    sorter->order();
+    EXPECT_EQ(rebuilds, sorter->rebuilds());
+
+    // An allocation change makes the next call rebuild it once.
+    sorter->allocated("a", slaveId, Resources::parse("cpus:0.5").get());
+    sorter->order();
+    sorter->order();
+    EXPECT_EQ(rebuilds + 1, sorter->rebuilds());
+
+    sorter->unallocated("a", slaveId, Resources::parse("cpus:0.5").get());
+
+    // The order being walked is not affected by allocations made
+    // while walking it; they are reflected by the next call.
+    foreach (const string* clientPath, sorter->order()) {
+      sorter->allocated(
+          *clientPath, slaveId, Resources::parse("cpus:5;mem:5").get());
+    }
+
+    // shares: a = .10, b/c = .08
+    EXPECT_EQ(vector<string>({"b/c", "a"}), order(sorter));
+
+    sorter->allocated("b/c", slaveId, Resources::parse("cpus:5;mem:5").get());
+
+    // shares: a = .10, b/c = .13
+    EXPECT_EQ(vector<string>({"a", "b/c"}), order(sorter));
+
+    sorter->deactivate("a");
+    EXPECT_EQ(vector<string>({"b/c"}), order(sorter));
+
+    sorter->activate("a");
+    sorter->add("b");
+    sorter->activate("b");
+
+    // shares: a = .10, b = .13 (b/. = 0, b/c = .13)
+    EXPECT_EQ(vector<string>({"a", "b", "b/c"}), order(sorter));
+
+    sorter->remove("b/c");
+
+    // shares: a = .10, b = 0
+    EXPECT_EQ(vector<string>({"b", "a"}), order(sorter));
+    EXPECT_EQ(sorter->sort(), order(sorter));
+  }
+}
+
+
 class Sorter_BENCHMARK_Test
   : public ::testing::Test,
     public ::testing::WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
@@ -1877,6 +2168,108 @@ TEST_P(HierarchicalSorter_BENCHMARK_Test, FullSort)
        << watch.elapsed() << endl;
 }
 
+
+class IncrementalSorter_BENCHMARK_Test
+  : public ::testing::Test,
+    public ::testing::WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
+
+
+// The incremental sorter benchmark tests are parameterized by the
+// number of clients and the number of clients whose allocations
+// change between two sorts.
+INSTANTIATE_TEST_CASE_P(
+    ClientAndChangedClientCount,
+    IncrementalSorter_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(1000U, 5000U, 10000U),
+      ::testing::Values(1U, 10U, 100U, 1000U))
+    );
+
+
+// Returns the total time spent sorting `sorter` over a number of
+// rounds, where each round allocates to `changedCount` clients
+// (round-robin) before sorting.
+static Duration sortWithChurn(
+    Sorter* sorter,
+    const vector<string>& clients,
+    const SlaveID& slaveId,
+    size_t changedCount,
+    size_t rounds)
+{
+  const Resources allocated = Resources::parse("cpus:1;mem:1").get();
+
+  Duration elapsed = Duration::zero();
+  Stopwatch watch;
+
+  size_t clientIndex = 0;
+  for (size_t round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < changedCount; i++) {
+      const string& client = clients[clientIndex++ % clients.size()];
+      sorter->allocated(client, slaveId, allocated);
+    }
+
+    watch.start();
+    sorter->sort();
+    watch.stop();
+
+    elapsed += watch.elapsed();
+  }
+
+  return elapsed;
+}
+
+
+// This benchmark compares the cost of sorting a large number of
+// clients when only a few of their allocations change between two
+// sorts, using the DRF sorter and the incremental DRF sorter.
+TEST_P(IncrementalSorter_BENCHMARK_Test, SortWithChurn)
+{
+  const size_t clientCount = std::tr1::get<0>(GetParam());
+  const size_t changedCount = std::tr1::get<1>(GetParam());
+  const size_t rounds = 100;
+
+  cout << "Using " << clientCount << " clients and "
+       << changedCount << " changed clients per sort" << endl;
+
+  SlaveID slaveId;
+  slaveId.set_value("agent");
+
+  vector<string> clients;
+  clients.reserve(clientCount);
+
+  for (size_t i = 0; i < clientCount; i++) {
+    clients.push_back(stringify(i));
+  }
+
+  DRFSorter drfSorter;
+  IncrementalDRFSorter incrementalSorter;
+
+  vector<std::pair<string, Sorter*>> sorters = {
+    {"DRF sorter", &drfSorter},
+    {"Incremental DRF sorter", &incrementalSorter}};
+
+  foreach (auto& sorter, sorters) {
+    sorter.second->add(
+        slaveId, Resources::parse("cpus:1000000;mem:1000000").get());
+
+    foreach (const string& client, clients) {
+      sorter.second->add(client);
+      sorter.second->activate(client);
+    }
+
+    // The initial sort is a full sort for both sorters.
+    sorter.second->sort();
+
+    const Duration elapsed = sortWithChurn(
+        sorter.second, clients, slaveId, changedCount, rounds);
+
+    cout << sorter.first << " took " << elapsed << " for " << rounds
+         << " sorts of " << clientCount << " clients" << endl;
+  }
+
+  EXPECT_EQ(drfSorter.sort(), incrementalSorter.sort());
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
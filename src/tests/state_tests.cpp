@@ -327,6 +327,34 @@ void Names(State* state)
 }
 
 
+void CreateAndStore(State* state)
+{
+  // Use the untyped state, which stores raw values.
+  mesos::state::State* untyped = state;
+
+  mesos::state::Variable variable = untyped->create("slaves");
+
+  Future<Option<mesos::state::Variable>> future1 =
+    untyped->store(variable.mutate("localhost"));
+
+  AWAIT_READY(future1);
+  ASSERT_SOME(future1.get());
+
+  Future<mesos::state::Variable> future2 = untyped->fetch("slaves");
+  AWAIT_READY(future2);
+  EXPECT_EQ("localhost", future2->value());
+
+  // Storing a created variable fails if the variable exists already.
+  future1 = untyped->store(untyped->create("slaves").mutate("remotehost"));
+  AWAIT_READY(future1);
+  EXPECT_NONE(future1.get());
+
+  future2 = untyped->fetch("slaves");
+  AWAIT_READY(future2);
+  EXPECT_EQ("localhost", future2->value());
+}
+
+
 class InMemoryStateTest : public ::testing::Test
 {
 public:
@@ -394,6 +422,12 @@ TEST_F(InMemoryStateTest, Names)
 }
 
 
+TEST_F(InMemoryStateTest, CreateAndStore)
+{
+  CreateAndStore(state);
+}
+
+
 class LevelDBStateTest : public TemporaryDirectoryTest
 {
 public:
@@ -471,6 +505,12 @@ TEST_F(LevelDBStateTest, Names)
 }
 
 
+TEST_F(LevelDBStateTest, CreateAndStore)
+{
+  CreateAndStore(state);
+}
+
+
 class LogStateTest : public TemporaryDirectoryTest
 {
 public:
@@ -570,6 +610,12 @@ TEST_F(LogStateTest, Names)
 }
 
 
+TEST_F(LogStateTest, CreateAndStore)
+{
+  CreateAndStore(state);
+}
+
+
 Future<Option<Variable<Slaves>>> timeout(
     Future<Option<Variable<Slaves>>> future)
 {
@@ -691,6 +737,46 @@ TEST_F(LogStateTest, Diff)
 }
 
 
+// Tests that stores of different variables can be in flight at the
+// same time, while a store that races with a store of the same
+// variable still sees the version written by the first one.
+TEST_F(LogStateTest, ConcurrentStores)
+{
+  Future<Variable<Slaves>> future1 = state->fetch<Slaves>("slaves1");
+  Future<Variable<Slaves>> future2 = state->fetch<Slaves>("slaves2");
+  AWAIT_READY(future1);
+  AWAIT_READY(future2);
+
+  Slaves slaves;
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost");
+
+  Variable<Slaves> variable1 = future1->mutate(slaves);
+  Variable<Slaves> variable2 = future2->mutate(slaves);
+
+  Future<Option<Variable<Slaves>>> store1 = state->store(variable1);
+  Future<Option<Variable<Slaves>>> store2 = state->store(variable2);
+
+  // Same version as 'store1', so this must fail once 'store1' is done.
+  Future<Option<Variable<Slaves>>> store3 = state->store(variable1);
+
+  AWAIT_READY(store1);
+  AWAIT_READY(store2);
+  AWAIT_READY(store3);
+
+  ASSERT_SOME(store1.get());
+  ASSERT_SOME(store2.get());
+  EXPECT_NONE(store3.get());
+
+  future1 = state->fetch<Slaves>("slaves1");
+  future2 = state->fetch<Slaves>("slaves2");
+  AWAIT_READY(future1);
+  AWAIT_READY(future2);
+
+  EXPECT_EQ(1, future1->get().slaves().size());
+  EXPECT_EQ(1, future2->get().slaves().size());
+}
+
+
 #ifdef MESOS_HAS_JAVA
 class ZooKeeperStateTest : public tests::ZooKeeperTest
 {
@@ -762,6 +848,12 @@ TEST_F(ZooKeeperStateTest, Names)
 {
   Names(state);
 }
+
+
+TEST_F(ZooKeeperStateTest, CreateAndStore)
+{
+  CreateAndStore(state);
+}
 #endif // MESOS_HAS_JAVA
 
 } // namespace tests {